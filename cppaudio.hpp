@@ -5,12 +5,25 @@
 // http://www.viva64.com
 #pragma once
 #include "./portaudio/include/portaudio.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
 #include <vector>
 
 #ifdef _WIN32
@@ -46,9 +59,11 @@ template <typename T> struct NoCopy
 };
 struct PaStatics : NoCopy<PaStatics>, ComInit
 {
+    // Deferred: each host api is only initialized when something here first
+    // touches it, so picking ALSA never waits on a JACK server probe.
     PaStatics()
     {
-        Pa_Initialize();
+        Pa_InitializeDeferred();
         ctr++;
     }
     virtual ~PaStatics()
@@ -68,6 +83,50 @@ struct PaStatics : NoCopy<PaStatics>, ComInit
 };
 } // namespace detail
 
+namespace detail
+{
+// PortAudio is C: an allocation failure is reported as nullptr, not thrown
+inline void *ResourceAllocate(unsigned long size, void *userData)
+{
+    try
+    {
+        return static_cast<std::pmr::memory_resource *>(userData)->allocate(
+            size, alignof(std::max_align_t));
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+inline void ResourceFree(void *block, unsigned long size, void *userData)
+{
+    static_cast<std::pmr::memory_resource *>(userData)->deallocate(
+        block, size, alignof(std::max_align_t));
+}
+} // namespace detail
+
+/*/
+    Has PortAudio allocate its streams, buffers and device lists from a
+    std::pmr::memory_resource, e.g. one drawing on a shared, locked budget.
+    Memory PortAudio already holds is freed to whatever allocated it, so this
+    can be called at any time, but resource must outlive everything it hands
+    out: keep it until the streams opened meanwhile are closed. nullptr goes
+    back to the system allocator. With realTime, PortAudio also touches and
+    mlocks each block as it is allocated, so its memory never page faults in
+    the audio thread.
+/*/
+inline void UseMemoryResource(std::pmr::memory_resource *resource,
+                              bool realTime = false)
+{
+    const PaAllocatorFlags flags =
+        realTime ? paRealTimeAllocator : paNoAllocatorFlag;
+    const PaError err =
+        resource ? Pa_SetAllocator(&detail::ResourceAllocate,
+                                   &detail::ResourceFree, resource, flags)
+                 : Pa_SetAllocator(nullptr, nullptr, nullptr, flags);
+    if (err != paNoError) throw std::runtime_error(Pa_GetErrorText(err));
+}
+
 /*/
 typedef int PaStreamCallback(
     const void *input, void *output,
@@ -101,7 +160,7 @@ enum class StreamCallbackFlags : unsigned int
      stream callback is using too much CPU time.
      @see PaStreamCallbackFlags
     */
-    OutputUnderflow = paOutputOverflow,
+    OutputUnderflow = paOutputUnderflow,
 
     /** Indicates that output data will be discarded because no room is
      available.
@@ -148,33 +207,138 @@ struct IODetails
     SampleFormats format{SampleFormats::Default};
 };
 
-template <typename T> struct IOParams
+// Maps a C++ sample type onto the PortAudio sample format that carries it.
+// There is no native 24-bit type, so paInt24 is not reachable from here.
+template <typename T> struct SampleFormatOf;
+template <> struct SampleFormatOf<float>
+{
+    static auto constexpr value = SampleFormats::Float32;
+};
+template <> struct SampleFormatOf<int32_t>
+{
+    static auto constexpr value = SampleFormats::Int32;
+};
+template <> struct SampleFormatOf<int16_t>
+{
+    static auto constexpr value = SampleFormats::Int16;
+};
+template <> struct SampleFormatOf<int8_t>
+{
+    static auto constexpr value = SampleFormats::Int8;
+};
+template <> struct SampleFormatOf<uint8_t>
+{
+    static auto constexpr value = SampleFormats::UInt8;
+};
+
+// One interleaved frame: a sample for each channel.
+template <typename T, unsigned int Channels> using Frame = std::array<T, Channels>;
+
+// A non-owning view over interleaved frames, as handed to us by PortAudio.
+// T may be const-qualified for input buffers.
+template <typename T, unsigned int Channels> class FrameSpan
+{
+    using frame_type =
+        std::conditional_t<std::is_const_v<T>,
+                           const Frame<std::remove_const_t<T>, Channels>,
+                           Frame<T, Channels>>;
+    static_assert(sizeof(frame_type) == sizeof(T) * Channels,
+                  "Frame must be tightly packed to alias an interleaved buffer");
+
+    frame_type *m_frames = nullptr;
+    unsigned long m_size = 0;
+
+  public:
+    FrameSpan() noexcept = default;
+    FrameSpan(T *samples, unsigned long frameCount) noexcept
+        : m_frames(reinterpret_cast<frame_type *>(samples)),
+          m_size(samples ? frameCount : 0)
+    {
+    }
+
+    unsigned long size() const noexcept { return m_size; }
+    bool empty() const noexcept { return m_size == 0; }
+    static constexpr unsigned int channels() noexcept { return Channels; }
+    frame_type &operator[](unsigned long i) const noexcept
+    {
+        return m_frames[i];
+    }
+    frame_type *begin() const noexcept { return m_frames; }
+    frame_type *end() const noexcept { return m_frames + m_size; }
+    // the raw, interleaved samples: size() * channels() of them
+    T *samples() const noexcept { return reinterpret_cast<T *>(m_frames); }
+};
+
+template <typename T, unsigned int Channels = 2> struct IOParams
 {
-    const T *inputBuffer = nullptr;
-    const T *outputBuffer = nullptr;
+    FrameSpan<const T, Channels> input;
+    FrameSpan<T, Channels> output;
     const unsigned long frameCount = 0;
-    const IODetails audioDetails = {};
+    const IODetails &audioDetails;
     const StreamCallbackTimeInfo *timeInfo = nullptr;
 
     StreamCallbackFlags statusFlags = {};
 };
 
-class SystemDevice
+namespace detail
+{
+// Owns a copy of the device name: PortAudio frees its own when the device
+// list is rescanned, while snapshots of the old list may still be in use.
+struct DeviceRecord
 {
     PaDeviceInfo info;
-    int m_global_device_index = 0;
+    int globalIndex;
+    std::uint64_t generation; // of the snapshot it belongs to, 0 for none
+    std::string name;
+
+    DeviceRecord(const PaDeviceInfo &i, int index, std::uint64_t gen)
+        : info(i), globalIndex(index), generation(gen), name(i.name)
+    {
+        info.name = name.c_str();
+    }
+    DeviceRecord(const DeviceRecord &rhs)
+        : DeviceRecord(rhs.info, rhs.globalIndex, rhs.generation)
+    {
+    }
+    DeviceRecord(DeviceRecord &&rhs) noexcept
+        : info(rhs.info), globalIndex(rhs.globalIndex),
+          generation(rhs.generation), name(std::move(rhs.name))
+    {
+        info.name = name.c_str();
+    }
+    DeviceRecord &operator=(const DeviceRecord &) = delete;
+};
+} // namespace detail
+
+// A view of one device in a DeviceRegistry snapshot, which it keeps alive.
+// Copying one copies a shared_ptr, never the device info.
+class SystemDevice
+{
+    std::shared_ptr<const detail::DeviceRecord> m_rec;
 
   public:
+    explicit SystemDevice(std::shared_ptr<const detail::DeviceRecord> rec) noexcept
+        : m_rec(std::move(rec))
+    {
+    }
+    // a device of its own, outside any registry snapshot
     SystemDevice(const PaDeviceInfo *info, int global_device_index)
-        : info(*info), m_global_device_index(global_device_index)
+        : m_rec(std::make_shared<const detail::DeviceRecord>(
+              *info, global_device_index, 0))
     {
     }
 
-    const std::string_view name() const noexcept { return info.name; }
-    const PaDeviceInfo &Info() const noexcept { return info; }
-    int GlobalDeviceIndex() const noexcept { return m_global_device_index; };
-    bool CanInput() const noexcept { return info.maxInputChannels > 0; }
-    bool CanOutput() const noexcept { return info.maxOutputChannels > 0; }
+    const std::string_view name() const noexcept { return m_rec->info.name; }
+    const PaDeviceInfo &Info() const noexcept { return m_rec->info; }
+    // Only meaningful in the registry snapshot the device came from: see
+    // DeviceRegistry::Resolve().
+    int GlobalDeviceIndex() const noexcept { return m_rec->globalIndex; };
+    std::uint64_t Generation() const noexcept { return m_rec->generation; }
+    bool CanInput() const noexcept { return m_rec->info.maxInputChannels > 0; }
+    bool CanOutput() const noexcept
+    {
+        return m_rec->info.maxOutputChannels > 0;
+    }
     bool CanDuplex() const noexcept { return CanInput() && CanOutput(); }
 };
 enum class Direction
@@ -185,7 +349,393 @@ enum class Direction
     duplex = (input | output)
 };
 
+/*/
+    How output samples are dithered when PortAudio reduces their word length
+    for the device. The noise shaped modes apply to Float32 streams on 16 and
+    8 bit devices; other conversions use Triangular.
+    @see paDitherOff, paDitherNoiseShapingFirstOrder
+/*/
+enum class DitherMode : PaStreamFlags
+{
+    None = paDitherOff,
+    Triangular = paNoFlag,
+    NoiseShapedFirstOrder = paDitherNoiseShapingFirstOrder,
+    NoiseShapedSecondOrder = paDitherNoiseShapingSecondOrder,
+    NoiseShapedHighOrder = paDitherNoiseShapingHighOrder
+};
+
 using SystemDeviceList = std::vector<SystemDevice>;
+
+namespace detail
+{
+// The devices of one host api as PortAudio reported them when the table was
+// built. Never modified once published.
+struct ApiTable
+{
+    PaHostApiInfo info{};
+    std::vector<DeviceRecord> devices;
+    std::vector<std::size_t> byName; // indices into devices, sorted by name
+
+    ApiTable(PaHostApiIndex api, std::uint64_t generation)
+    {
+        if (const auto i = Pa_GetHostApiInfo(api)) info = *i;
+        devices.reserve(info.deviceCount > 0 ? info.deviceCount : 0);
+        for (int k = 0; k < info.deviceCount; ++k)
+        {
+            const auto idx = Pa_HostApiDeviceIndexToDeviceIndex(api, k);
+            if (const auto d = Pa_GetDeviceInfo(idx))
+            {
+                devices.emplace_back(*d, idx, generation);
+            }
+        }
+        for (std::size_t k = 0; k < devices.size(); ++k) byName.push_back(k);
+        std::sort(byName.begin(), byName.end(),
+                  [this](std::size_t a, std::size_t b) {
+                      return std::string_view(devices[a].info.name) <
+                          std::string_view(devices[b].info.name);
+                  });
+    }
+    const DeviceRecord *Find(std::string_view name) const noexcept
+    {
+        const auto it = std::lower_bound(
+            byName.begin(), byName.end(), name,
+            [this](std::size_t k, std::string_view n) {
+                return std::string_view(devices[k].info.name) < n;
+            });
+        return it != byName.end() && devices[*it].info.name == name
+            ? &devices[*it]
+            : nullptr;
+    }
+    // PortAudio numbers a host api's devices consecutively
+    const DeviceRecord *FindGlobal(int globalIndex) const noexcept
+    {
+        if (devices.empty()) return nullptr;
+        const auto k = globalIndex - devices.front().globalIndex;
+        return k >= 0 && k < (int)devices.size() &&
+                devices[k].globalIndex == globalIndex
+            ? &devices[k]
+            : nullptr;
+    }
+};
+
+// One Pa_IsFormatSupported question, about one direction of a device
+struct FormatQuery
+{
+    PaDeviceIndex device;
+    bool input;
+    PaSampleFormat format;
+    int channels;
+    double samplerate;
+
+    bool operator==(const FormatQuery &rhs) const noexcept
+    {
+        return device == rhs.device && input == rhs.input &&
+            format == rhs.format && channels == rhs.channels &&
+            samplerate == rhs.samplerate;
+    }
+};
+struct FormatQueryHash
+{
+    std::size_t operator()(const FormatQuery &q) const noexcept
+    {
+        std::size_t h = std::hash<double>()(q.samplerate);
+        for (const std::size_t v : {(std::size_t)q.device, (std::size_t)q.input,
+                                    (std::size_t)q.format,
+                                    (std::size_t)q.channels})
+        {
+            h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+};
+} // namespace detail
+
+// The devices of one host api in a registry snapshot. Iterating yields
+// SystemDevice views; nothing is allocated or copied.
+class DeviceRange
+{
+    std::shared_ptr<const detail::ApiTable> m_table;
+
+    SystemDevice view(const detail::DeviceRecord *rec) const noexcept
+    {
+        return SystemDevice(
+            std::shared_ptr<const detail::DeviceRecord>(m_table, rec));
+    }
+
+  public:
+    class iterator
+    {
+        const DeviceRange *m_range = nullptr;
+        std::size_t m_pos = 0;
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = SystemDevice;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = SystemDevice;
+
+        iterator() = default;
+        iterator(const DeviceRange *range, std::size_t pos) noexcept
+            : m_range(range), m_pos(pos)
+        {
+        }
+        SystemDevice operator*() const noexcept { return (*m_range)[m_pos]; }
+        iterator &operator++() noexcept
+        {
+            ++m_pos;
+            return *this;
+        }
+        iterator operator++(int) noexcept
+        {
+            auto tmp = *this;
+            ++m_pos;
+            return tmp;
+        }
+        bool operator==(const iterator &rhs) const noexcept
+        {
+            return m_pos == rhs.m_pos;
+        }
+        bool operator!=(const iterator &rhs) const noexcept
+        {
+            return m_pos != rhs.m_pos;
+        }
+    };
+
+    DeviceRange() = default;
+    explicit DeviceRange(std::shared_ptr<const detail::ApiTable> table) noexcept
+        : m_table(std::move(table))
+    {
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_table ? m_table->devices.size() : 0;
+    }
+    bool empty() const noexcept { return size() == 0; }
+    SystemDevice operator[](std::size_t i) const noexcept
+    {
+        return view(&m_table->devices[i]);
+    }
+    SystemDevice at(std::size_t i) const
+    {
+        if (i >= size()) throw std::out_of_range("DeviceRange::at");
+        return (*this)[i];
+    }
+    iterator begin() const noexcept { return iterator(this, 0); }
+    iterator end() const noexcept { return iterator(this, size()); }
+
+    std::optional<SystemDevice> Find(std::string_view name) const noexcept
+    {
+        const auto rec = m_table ? m_table->Find(name) : nullptr;
+        return rec ? std::optional<SystemDevice>(view(rec)) : std::nullopt;
+    }
+    std::optional<SystemDevice> FindGlobal(int globalIndex) const noexcept
+    {
+        const auto rec = m_table ? m_table->FindGlobal(globalIndex) : nullptr;
+        return rec ? std::optional<SystemDevice>(view(rec)) : std::nullopt;
+    }
+};
+
+/*/
+    An immutable snapshot of the host apis and their devices, shared by every
+    HostApi, DeviceEnum and SystemDevice. Refresh() rescans, builds a new
+    snapshot and swaps it in atomically; views of the old one keep it alive
+    for as long as they are held. A host api's device table is built under
+    Lock() the first time it is asked for, so a snapshot only initializes the
+    host apis it is asked about. Each table carries the generation of the
+    device list it was built from: asked for after a Refresh(), an old
+    snapshot hands out the current one's table.
+
+    Nothing rescans behind the caller's back. When PortAudio reports that
+    devices have come or gone, the registry calls the change listener and
+    Stale() turns true; Current() keeps answering from the snapshot it has
+    until someone calls Refresh(). Open streams carry on regardless.
+
+    A rescan frees PortAudio's device list, so Refresh() and every question
+    cppaudio puts to PortAudio about a device are serialized by one registry
+    lock. Hold Lock() across looking up a device index and using it.
+
+    Format queries are put to PortAudio once per snapshot and the answers
+    kept, so negotiating a stream format costs a lookup per combination
+    tried. The next snapshot asks afresh.
+/*/
+class DeviceRegistry
+{
+    std::uint64_t m_generation;
+    std::vector<PaHostApiTypeId> m_types;
+    // built on first use under Lock(), then never replaced
+    mutable std::vector<std::shared_ptr<const detail::ApiTable>> m_tables;
+    // filled in under Lock()
+    mutable std::unordered_map<detail::FormatQuery, PaError,
+                               detail::FormatQueryHash>
+        m_formats;
+
+    static inline std::recursive_mutex s_lock;
+    static inline std::shared_ptr<const DeviceRegistry> s_current;
+    static inline std::atomic<bool> s_stale{false};
+    static inline std::mutex s_listenerLock;
+    static inline std::function<void()> s_listener;
+
+    // called on a PortAudio thread
+    static void DevicesChanged(void *)
+    {
+        s_stale = true;
+        std::lock_guard<std::mutex> lock(s_listenerLock);
+        if (s_listener) s_listener();
+    }
+
+  public:
+    // Only Current() and Refresh() should make one, under Lock().
+    explicit DeviceRegistry(std::uint64_t generation)
+        : m_generation(generation)
+    {
+        const auto lock = Lock();
+        const auto count = Pa_GetHostApiCount();
+        for (PaHostApiIndex i = 0; i < count; ++i)
+        {
+            PaHostApiTypeId type = paInDevelopment;
+            Pa_GetHostApiTypeId(i, &type);
+            m_types.push_back(type);
+        }
+        m_tables.resize(m_types.size());
+    }
+
+    // Recursive, so holding it while calling into the registry is fine.
+    static std::unique_lock<std::recursive_mutex> Lock()
+    {
+        return std::unique_lock<std::recursive_mutex>(s_lock);
+    }
+    // The snapshot in use; only the first call scans.
+    static std::shared_ptr<const DeviceRegistry> Current()
+    {
+        if (auto reg = std::atomic_load(&s_current)) return reg;
+        const auto lock = Lock();
+        if (auto reg = std::atomic_load(&s_current)) return reg;
+        Pa_SetDevicesChangedCallback(nullptr, &DevicesChanged);
+        auto fresh = std::make_shared<const DeviceRegistry>(1);
+        std::atomic_store(&s_current, fresh);
+        return fresh;
+    }
+    // Rescans PortAudio's devices and replaces the current snapshot. If the
+    // rescan fails, the new snapshot shows the devices PortAudio still has.
+    static std::shared_ptr<const DeviceRegistry> Refresh()
+    {
+        const auto lock = Lock();
+        const auto prev = Current();
+        // a change reported during the rescan marks the new snapshot stale
+        s_stale = false;
+        Pa_UpdateAvailableDeviceList();
+        auto next = std::make_shared<const DeviceRegistry>(
+            prev->m_generation + 1);
+        std::atomic_store(&s_current, next);
+        return next;
+    }
+    // Whether devices have come or gone since the current snapshot was taken.
+    static bool Stale() noexcept { return s_stale; }
+    // Called on a PortAudio thread whenever devices come or go, so it must
+    // not call into PortAudio or cppaudio itself: have another thread call
+    // Refresh() instead.
+    static void SetChangeListener(std::function<void()> listener)
+    {
+        std::lock_guard<std::mutex> lock(s_listenerLock);
+        s_listener = std::move(listener);
+    }
+
+    std::uint64_t Generation() const noexcept { return m_generation; }
+    PaHostApiIndex ApiCount() const noexcept
+    {
+        return (PaHostApiIndex)m_types.size();
+    }
+    PaHostApiTypeId ApiType(PaHostApiIndex api) const
+    {
+        return m_types.at(api);
+    }
+    // Initializes the host api the first time it is asked for.
+    std::shared_ptr<const detail::ApiTable> Table(PaHostApiIndex api) const
+    {
+        const auto lock = Lock();
+        auto &table = m_tables.at(api);
+        if (!table)
+        {
+            const auto current = Current();
+            table = current.get() == this
+                ? std::make_shared<const detail::ApiTable>(api, m_generation)
+                : current->Table(api);
+        }
+        return table;
+    }
+    const PaHostApiInfo &ApiInfo(PaHostApiIndex api) const
+    {
+        return Table(api)->info;
+    }
+    DeviceRange Devices(PaHostApiIndex api) const
+    {
+        return DeviceRange(Table(api));
+    }
+    // Looked up in the table of the host api PortAudio lists the device
+    // under, which the index came from and so is already initialized. Device
+    // indices are those of the current device list, so asked of a snapshot
+    // that has since been replaced, the current one answers.
+    std::optional<SystemDevice> Device(PaDeviceIndex globalIndex) const
+    {
+        const auto lock = Lock();
+        const auto current = Current();
+        if (current.get() != this) return current->Device(globalIndex);
+        const auto info = Pa_GetDeviceInfo(globalIndex);
+        if (!info || info->hostApi < 0 || info->hostApi >= ApiCount())
+            return std::nullopt;
+        return Devices(info->hostApi).FindGlobal(globalIndex);
+    }
+    // Looks through every host api, initializing them all.
+    std::optional<SystemDevice> FindDevice(std::string_view name) const
+    {
+        for (PaHostApiIndex api = 0; api < ApiCount(); ++api)
+        {
+            if (auto d = Devices(api).Find(name)) return d;
+        }
+        return std::nullopt;
+    }
+    // The same device in this snapshot, found by host api and name, or none
+    // if it has gone: device indices change when devices are rescanned.
+    std::optional<SystemDevice> Resolve(const SystemDevice &device) const
+    {
+        if (device.Generation() == m_generation) return device;
+        const auto api = device.Info().hostApi;
+        if (api < 0 || api >= ApiCount()) return std::nullopt;
+        return Devices(api).Find(device.name());
+    }
+    // Pa_IsFormatSupported for a device used for input or for output. A busy
+    // device may be free next time, so that answer is not kept. Asked of a
+    // snapshot that has since been replaced, the current one answers.
+    PaError IsFormatSupported(const SystemDevice &device, Direction dir,
+                              SampleFormats format, int channels,
+                              double samplerate) const
+    {
+        assert(dir == Direction::input || dir == Direction::output);
+        const auto lock = Lock();
+        const auto current = Current();
+        if (current.get() != this)
+        {
+            return current->IsFormatSupported(device, dir, format, channels,
+                                              samplerate);
+        }
+        const auto resolved = Resolve(device);
+        if (!resolved.has_value()) return paInvalidDevice;
+        const detail::FormatQuery q{resolved->GlobalDeviceIndex(),
+                                    dir == Direction::input, format.value,
+                                    channels, samplerate};
+        const auto it = m_formats.find(q);
+        if (it != m_formats.end()) return it->second;
+        const PaStreamParameters p{q.device, channels, q.format, 0, nullptr};
+        const PaError err = q.input
+            ? Pa_IsFormatSupported(&p, nullptr, samplerate)
+            : Pa_IsFormatSupported(nullptr, &p, samplerate);
+        if (err != paDeviceUnavailable) m_formats.emplace(q, err);
+        return err;
+    }
+};
+
 class Device
 {
     SystemDevice m_sysDevice;
@@ -195,6 +745,7 @@ class Device
     // the *desired* direction you want the device to operate in.
     Direction m_direction = Direction::unknown;
     SampleFormats m_fmt{SampleFormats::Float32};
+    DitherMode m_dither = DitherMode::Triangular;
 
     void setCurrentDirection(Direction dir)
     {
@@ -281,6 +832,9 @@ class Device
     }
     bool IsDuplex() const noexcept { return m_direction == Direction::duplex; }
     SampleFormats sampleFormat() const noexcept { return m_fmt; }
+    DitherMode ditherMode() const noexcept { return m_dither; }
+    // applies to streams opened on this device from now on
+    void setDitherMode(DitherMode mode) noexcept { m_dither = mode; }
     void setDefaultOutParams()
     {
         auto &p = m_outParams;
@@ -302,48 +856,740 @@ class Device
         p.suggestedLatency = m_sysDevice.Info().defaultHighInputLatency;
     }
 
+    // The device's index now, which may differ from the one it was listed
+    // with if devices have been rescanned since. Only good while
+    // DeviceRegistry::Lock() is held.
+    PaDeviceIndex CurrentIndex() const
+    {
+        const auto device = DeviceRegistry::Current()->Resolve(m_sysDevice);
+        if (!device.has_value())
+        {
+            throw std::runtime_error("device is no longer available");
+        }
+        return device->GlobalDeviceIndex();
+    }
+
+    // Whether the device takes the format in each direction it is used in.
+    bool Supports(SampleFormats format, int channels, double samplerate) const
+    {
+        const auto reg = DeviceRegistry::Current();
+        for (const auto dir : {Direction::input, Direction::output})
+        {
+            if (dir == Direction::input ? !IsInput() : !IsOutput()) continue;
+            if (reg->IsFormatSupported(m_sysDevice, dir, format, channels,
+                                       samplerate) != paFormatIsSupported)
+                return false;
+        }
+        return true;
+    }
+
+    // The sample formats the device takes without conversion in each
+    // direction it is used in, with NonInterleaved set if it only takes
+    // non-interleaved buffers. Empty if its host api doesn't say.
+    SampleFormats NativeFormats() const
+    {
+        const auto lock = DeviceRegistry::Lock();
+        const auto index = CurrentIndex();
+        PaSampleFormat formats = ~paNonInterleaved, nonInterleaved = 0;
+        bool asked = false;
+        for (const auto dir : {Direction::input, Direction::output})
+        {
+            if (dir == Direction::input ? !IsInput() : !IsOutput()) continue;
+            PaSampleFormat f = 0;
+            const auto err = Pa_GetDeviceNativeSampleFormats(
+                index, dir == Direction::input, &f);
+            if (err != paNoError)
+            {
+                throw std::runtime_error(Pa_GetErrorText(err));
+            }
+            formats &= f;
+            nonInterleaved |= f & paNonInterleaved;
+            asked = true;
+        }
+        return SampleFormats{asked ? formats | nonInterleaved : 0};
+    }
+    // Whether a stream of SampleT opens on this device without a sample
+    // format conversion.
+    template <typename SampleT> bool TakesNatively() const
+    {
+        const auto native = NativeFormats().value;
+        return (native & SampleFormatOf<SampleT>::value) &&
+            !(native & paNonInterleaved);
+    }
+
     bool hasOutputParams() const noexcept { return m_outParams.device >= 0; }
     bool hasInputParams() const noexcept { return m_inParams.device >= 0; }
+    const PaStreamParameters &OutParams() const noexcept { return m_outParams; }
+    const PaStreamParameters &InParams() const noexcept { return m_inParams; }
 };
 
-class HostApi;
-class DeviceEnum
+// Callback timing statistics: count, over-budget count and load percentiles,
+// where a load of 1.0 is a callback that took as long as its buffer lasts.
+using StreamStats = PaStreamCallbackStats;
+
+enum class SchedulingPolicy
 {
-    friend class HostApi;
-    detail::PaStatics *m_pa = nullptr;
-    mutable SystemDeviceList m_deviceList;
-    const PaHostApiInfo *m_api;
+    Default = paSchedulingDefault,
+    Fifo = paSchedulingFifo,
+    RoundRobin = paSchedulingRoundRobin,
+    Deadline = paSchedulingDeadline
+};
+
+/*/
+    How a stream's callback thread is scheduled and which CPUs it runs on,
+    applied by the thread itself before the first callback, each time the
+    stream starts. Honoured by the ALSA, OSS and offline host apis.
+
+    Under Deadline the buffer period is the thread's period and deadline, and
+    runtimeFraction of it its runtime. With fallback set, a policy that isn't
+    permitted gets as close as it can (Deadline to Fifo, a lower priority,
+    then a lower nice value) instead of making Start() throw. Linux won't
+    pin a Deadline thread to cpus: that combination runs as Fifo with
+    fallback set, and makes SetThreadPolicy() throw without it.
+    @see Pa_SetStreamThreadPolicy
+/*/
+struct ThreadPolicy
+{
+    SchedulingPolicy policy = SchedulingPolicy::Default;
+    int priority = 0; // 1 to 99 under Fifo and RoundRobin, 0 for mid range
+    double runtimeFraction = 0; // 0 for half
+    std::vector<int> cpus;      // none for any
+    bool fallback = true;
+
+    PaThreadPolicy native() const
+    {
+        if (cpus.size() > paMaxThreadPolicyCpus)
+            throw std::runtime_error("too many CPUs in thread policy");
+        PaThreadPolicy p{};
+        p.policy = static_cast<PaThreadSchedulingPolicy>(policy);
+        p.priority = priority;
+        p.runtimeFraction = runtimeFraction;
+        p.cpuCount = static_cast<int>(cpus.size());
+        std::copy(cpus.begin(), cpus.end(), p.cpus);
+        p.flags = fallback ? paThreadPolicyFallback : 0;
+        return p;
+    }
+};
+
+/*/
+    An open PortAudio stream whose callback is the user's callable, called
+    directly from a static trampoline. The callable's type is part of the
+    Stream's type, so there is no std::function, no virtual call and no heap
+    allocation between PortAudio and the user's code.
+
+    The callable receives an IOParams<SampleT, Channels>& and may return
+    either void (keep going) or an int (paContinue, paComplete, paAbort).
+
+    PortAudio holds a pointer to the Stream, so it can be neither copied nor
+    moved. Use OpenStream(), which relies on guaranteed copy elision.
+/*/
+template <typename SampleT, unsigned int Channels, typename CB>
+class Stream : detail::NoCopy<Stream<SampleT, Channels, CB>>
+{
+    static_assert(Channels > 0, "A stream needs at least one channel");
+    using params_type = IOParams<SampleT, Channels>;
+
+    CB m_cb;
+    PaStream *m_stream = nullptr;
+    IODetails m_details;
+
+    static void check(PaError err)
+    {
+        if (err != paNoError) throw std::runtime_error(Pa_GetErrorText(err));
+    }
+
+    static int callback(const void *input, void *output,
+                        unsigned long frameCount,
+                        const PaStreamCallbackTimeInfo *timeInfo,
+                        PaStreamCallbackFlags statusFlags, void *userData)
+    {
+        auto *pthis = static_cast<Stream *>(userData);
+        params_type params{
+            {static_cast<const SampleT *>(input), frameCount},
+            {static_cast<SampleT *>(output), frameCount},
+            frameCount,
+            pthis->m_details,
+            timeInfo,
+            static_cast<StreamCallbackFlags>(statusFlags)};
+
+        if constexpr (std::is_void_v<std::invoke_result_t<CB &, params_type &>>)
+        {
+            pthis->m_cb(params);
+            return paContinue;
+        }
+        else
+        {
+            return static_cast<int>(pthis->m_cb(params));
+        }
+    }
+
+  public:
+    Stream(const Device &device, CB &&cb, double samplerate = 0,
+           unsigned long framesPerBuffer = paFramesPerBufferUnspecified,
+           PaStreamFlags flags = paNoFlag)
+        : m_cb(std::forward<CB>(cb))
+    {
+        static_assert(
+            std::is_invocable_v<CB &, params_type &>,
+            "Stream callback must be callable with IOParams<SampleT, Channels>&");
+
+        const auto lock = DeviceRegistry::Lock();
+        PaStreamParameters in = device.InParams();
+        PaStreamParameters out = device.OutParams();
+        in.device = out.device = device.CurrentIndex();
+        in.channelCount = out.channelCount = Channels;
+        in.sampleFormat = out.sampleFormat = SampleFormatOf<SampleT>::value;
+
+        if (samplerate <= 0) samplerate = device.Info().defaultSampleRate;
+        m_details.samplerate = static_cast<unsigned int>(samplerate);
+        m_details.nch = Channels;
+        m_details.format.value = SampleFormatOf<SampleT>::value;
+        flags |= static_cast<PaStreamFlags>(device.ditherMode());
+
+        check(Pa_OpenStream(&m_stream,
+                            device.hasInputParams() && device.IsInput() ? &in
+                                                                        : nullptr,
+                            device.hasOutputParams() && device.IsOutput()
+                                ? &out
+                                : nullptr,
+                            samplerate, framesPerBuffer, flags, &callback,
+                            this));
+    }
+    ~Stream()
+    {
+        if (m_stream) Pa_CloseStream(m_stream);
+    }
+
+    void Start() { check(Pa_StartStream(m_stream)); }
+    void Stop() { check(Pa_StopStream(m_stream)); }
+    void Abort() { check(Pa_AbortStream(m_stream)); }
+    bool IsActive() const noexcept { return Pa_IsStreamActive(m_stream) == 1; }
+    bool IsStopped() const noexcept
+    {
+        return Pa_IsStreamStopped(m_stream) == 1;
+    }
+    const IODetails &audioDetails() const noexcept { return m_details; }
+    PaStream *handle() const noexcept { return m_stream; }
+    // The callable, which may only be replaced while the stream is stopped.
+    CB &callable() noexcept { return m_cb; }
+
+    // Callback load since the stream was opened. Cheap, and safe to poll
+    // while the stream runs.
+    double CpuLoad() const noexcept { return Pa_GetStreamCpuLoad(m_stream); }
+    StreamStats Stats() const
+    {
+        StreamStats stats;
+        check(Pa_GetStreamCallbackStats(m_stream, &stats));
+        return stats;
+    }
+
+    // Takes effect from the next Start(); the stream must be stopped.
+    void SetThreadPolicy(const ThreadPolicy &policy)
+    {
+        const auto p = policy.native();
+        check(Pa_SetStreamThreadPolicy(m_stream, &p));
+    }
+};
+
+// Opens a Stream of Channels x SampleT on device, calling cb for each buffer:
+//     auto s = cppaudio::OpenStream<float, 2>(dev, [](auto &io) {...});
+template <typename SampleT, unsigned int Channels, typename CB>
+Stream<SampleT, Channels, CB>
+OpenStream(const Device &device, CB &&cb, double samplerate = 0,
+           unsigned long framesPerBuffer = paFramesPerBufferUnspecified,
+           PaStreamFlags flags = paNoFlag)
+{
+    return Stream<SampleT, Channels, CB>(device, std::forward<CB>(cb),
+                                         samplerate, framesPerBuffer, flags);
+}
+
+/*/
+    A Stream of whichever sample type the device takes natively, so that
+    PortAudio only ever copies samples between the device and the callback
+    and never converts them. The callable is instantiated for every type a
+    native format can have (float, int32_t, int16_t, int8_t, uint8_t), so it
+    is typically a generic lambda taking auto &io; the best quality native
+    format the device has is the one opened. Throws if the device has none of
+    those or only takes non-interleaved buffers.
+
+    Like Stream it can be neither copied nor moved: use OpenNativeStream().
+/*/
+template <unsigned int Channels, typename CB>
+class NativeStream : detail::NoCopy<NativeStream<Channels, CB>>
+{
+    using variant_type =
+        std::variant<Stream<float, Channels, CB>, Stream<int32_t, Channels, CB>,
+                     Stream<int16_t, Channels, CB>,
+                     Stream<int8_t, Channels, CB>,
+                     Stream<uint8_t, Channels, CB>>;
+    variant_type m_stream;
+
+    template <typename SampleT, typename... Args>
+    static variant_type open(Args &&...args)
+    {
+        return variant_type(std::in_place_type<Stream<SampleT, Channels, CB>>,
+                            std::forward<Args>(args)...);
+    }
+    static variant_type open(const Device &device, CB &&cb, double samplerate,
+                             unsigned long framesPerBuffer,
+                             PaStreamFlags flags)
+    {
+        const auto native = device.NativeFormats().value;
+        if (native & paNonInterleaved)
+        {
+            throw std::runtime_error(
+                "device only takes non-interleaved buffers");
+        }
+        if (native & paFloat32)
+            return open<float>(device, std::forward<CB>(cb), samplerate,
+                               framesPerBuffer, flags);
+        if (native & paInt32)
+            return open<int32_t>(device, std::forward<CB>(cb), samplerate,
+                                 framesPerBuffer, flags);
+        if (native & paInt16)
+            return open<int16_t>(device, std::forward<CB>(cb), samplerate,
+                                 framesPerBuffer, flags);
+        if (native & paInt8)
+            return open<int8_t>(device, std::forward<CB>(cb), samplerate,
+                                framesPerBuffer, flags);
+        if (native & paUInt8)
+            return open<uint8_t>(device, std::forward<CB>(cb), samplerate,
+                                 framesPerBuffer, flags);
+        throw std::runtime_error(
+            "device has no native sample format a stream can carry");
+    }
+
+  public:
+    NativeStream(const Device &device, CB &&cb, double samplerate = 0,
+                 unsigned long framesPerBuffer = paFramesPerBufferUnspecified,
+                 PaStreamFlags flags = paNoFlag)
+        : m_stream(open(device, std::forward<CB>(cb), samplerate,
+                        framesPerBuffer, flags))
+    {
+    }
+
+    // Calls f with the Stream that was opened
+    template <typename F> decltype(auto) Visit(F &&f)
+    {
+        return std::visit(std::forward<F>(f), m_stream);
+    }
+    template <typename F> decltype(auto) Visit(F &&f) const
+    {
+        return std::visit(std::forward<F>(f), m_stream);
+    }
+
+    void Start()
+    {
+        Visit([](auto &s) { s.Start(); });
+    }
+    void Stop()
+    {
+        Visit([](auto &s) { s.Stop(); });
+    }
+    void Abort()
+    {
+        Visit([](auto &s) { s.Abort(); });
+    }
+    bool IsActive() const noexcept
+    {
+        return Visit([](const auto &s) { return s.IsActive(); });
+    }
+    bool IsStopped() const noexcept
+    {
+        return Visit([](const auto &s) { return s.IsStopped(); });
+    }
+    const IODetails &audioDetails() const noexcept
+    {
+        return Visit([](const auto &s) -> const IODetails & {
+            return s.audioDetails();
+        });
+    }
+    SampleFormats sampleFormat() const noexcept
+    {
+        return audioDetails().format;
+    }
+    PaStream *handle() const noexcept
+    {
+        return Visit([](const auto &s) { return s.handle(); });
+    }
+    double CpuLoad() const noexcept
+    {
+        return Visit([](const auto &s) { return s.CpuLoad(); });
+    }
+    StreamStats Stats() const
+    {
+        return Visit([](const auto &s) { return s.Stats(); });
+    }
+    void SetThreadPolicy(const ThreadPolicy &policy)
+    {
+        Visit([&policy](auto &s) { s.SetThreadPolicy(policy); });
+    }
+};
+
+// Opens a NativeStream of Channels on device:
+//     auto s = cppaudio::OpenNativeStream<8>(dev, [](auto &io) {...});
+template <unsigned int Channels, typename CB>
+NativeStream<Channels, CB>
+OpenNativeStream(const Device &device, CB &&cb, double samplerate = 0,
+                 unsigned long framesPerBuffer = paFramesPerBufferUnspecified,
+                 PaStreamFlags flags = paNoFlag)
+{
+    return NativeStream<Channels, CB>(device, std::forward<CB>(cb), samplerate,
+                                      framesPerBuffer, flags);
+}
+
+namespace detail
+{
+// The callable of a pooled stream: whatever was handed to Acquire(), called
+// through a plain function pointer. Until then, and after a release, the
+// stream only outputs silence.
+template <typename SampleT, unsigned int Channels> struct PooledCallback
+{
+    using params_type = IOParams<SampleT, Channels>;
+    int (*invoke)(void *target, params_type &params) = nullptr;
+    void *target = nullptr;
+
+    int operator()(params_type &params)
+    {
+        if (invoke) return invoke(target, params);
+        for (auto &frame : params.output) frame.fill(SampleT{});
+        return paComplete;
+    }
+};
+} // namespace detail
+
+/*/
+    Streams opened ahead of time for the profiles (device, rate, buffer size
+    and, through the pool's type, sample format and channels) an application
+    declares, so that getting a running stream is just a start: no
+    allocation, no device negotiation. Acquire() hands out a Lease on a free
+    stream of a profile, started with the given callable; dropping the Lease
+    aborts the stream and returns it to the pool. Switching device is
+    acquiring from another profile.
+
+    The callable is referenced, not copied, and must outlive the Lease. The
+    pool must outlive its Leases. Declare(), Acquire() and Release() may be
+    called from any thread: a Lease holds on to its profile, which stays put
+    however many more are declared.
+/*/
+template <typename SampleT, unsigned int Channels> class StreamPool
+{
+    using callback_type = detail::PooledCallback<SampleT, Channels>;
+    using stream_type = Stream<SampleT, Channels, callback_type>;
+
+    struct Profile
+    {
+        // fixed once declared, so a Lease reads it without the lock
+        std::vector<std::unique_ptr<stream_type>> streams;
+        std::vector<std::size_t> free; // indices into streams, under m_mtx
+    };
+    std::vector<std::unique_ptr<Profile>> m_profiles;
+    std::mutex m_mtx;
 
-    DeviceEnum(detail::PaStatics &pa, const PaHostApiInfo *api)
-        : m_pa(&pa), m_api(api)
+    void release(Profile &profile, std::size_t index) noexcept
     {
+        auto &s = *profile.streams[index];
+        if (!s.IsStopped()) Pa_AbortStream(s.handle());
+        s.callable() = callback_type{};
+        std::lock_guard<std::mutex> lock(m_mtx);
+        profile.free.push_back(index); // never beyond capacity
     }
-    const SystemDeviceList &Devices() const
+
+  public:
+    using params_type = IOParams<SampleT, Channels>;
+
+    // A started stream of the pool, returned to it when the Lease goes.
+    class Lease
     {
-        if (m_deviceList.empty())
+        friend class StreamPool;
+        StreamPool *m_pool = nullptr;
+        Profile *m_profile = nullptr;
+        std::size_t m_index = 0;
+
+        Lease(StreamPool *pool, Profile *profile, std::size_t index)
+            : m_pool(pool), m_profile(profile), m_index(index)
+        {
+        }
+
+      public:
+        Lease() = default;
+        Lease(Lease &&other) noexcept
+            : m_pool(std::exchange(other.m_pool, nullptr)),
+              m_profile(other.m_profile), m_index(other.m_index)
+        {
+        }
+        Lease &operator=(Lease &&other) noexcept
+        {
+            if (this != &other)
+            {
+                Release();
+                m_pool = std::exchange(other.m_pool, nullptr);
+                m_profile = other.m_profile;
+                m_index = other.m_index;
+            }
+            return *this;
+        }
+        ~Lease() { Release(); }
+
+        explicit operator bool() const noexcept { return m_pool != nullptr; }
+        stream_type &stream() const noexcept
         {
-            DeviceEnum *pthis = const_cast<DeviceEnum *>(this);
-            pthis->populate();
+            return *m_profile->streams[m_index];
         }
-        return m_deviceList;
+        // Plays out what is buffered before returning the stream; dropping
+        // the Lease aborts it.
+        void Stop() { stream().Stop(); }
+        void Release() noexcept
+        {
+            if (m_pool)
+                std::exchange(m_pool, nullptr)->release(*m_profile, m_index);
+        }
+    };
+
+    StreamPool() = default;
+    StreamPool(const StreamPool &) = delete;
+    StreamPool &operator=(const StreamPool &) = delete;
+
+    // Opens count streams for a profile, returning the profile's id for
+    // Acquire(). Throws if a stream doesn't open.
+    std::size_t Declare(const Device &device, std::size_t count,
+                        double samplerate = 0,
+                        unsigned long framesPerBuffer =
+                            paFramesPerBufferUnspecified,
+                        PaStreamFlags flags = paNoFlag)
+    {
+        auto profile = std::make_unique<Profile>();
+        profile->streams.reserve(count);
+        profile->free.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            profile->streams.push_back(std::make_unique<stream_type>(
+                device, callback_type{}, samplerate, framesPerBuffer, flags));
+            profile->free.push_back(count - 1 - i);
+        }
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_profiles.push_back(std::move(profile));
+        return m_profiles.size() - 1;
     }
 
-    void populate()
+    std::size_t Available(std::size_t profile)
     {
-        m_deviceList.clear();
-        const auto myapiIndex = Pa_HostApiTypeIdToHostApiIndex(m_api->type);
-        for (auto i = 0; i < m_pa->DeviceCount(); ++i)
+        std::lock_guard<std::mutex> lock(m_mtx);
+        return m_profiles.at(profile)->free.size();
+    }
+
+    // Starts a free stream of the profile calling cb, like Stream does; an
+    // empty optional if all of them are leased.
+    template <typename CB>
+    std::optional<Lease> Acquire(std::size_t profile, CB &cb)
+    {
+        static_assert(
+            std::is_invocable_v<CB &, params_type &>,
+            "Stream callback must be callable with IOParams<SampleT, Channels>&");
+        Profile *p;
+        std::size_t index;
         {
-            auto info = Pa_GetDeviceInfo(i);
-            if (info->hostApi == myapiIndex)
+            std::lock_guard<std::mutex> lock(m_mtx);
+            p = m_profiles.at(profile).get();
+            if (p->free.empty()) return std::nullopt;
+            index = p->free.back();
+            p->free.pop_back();
+        }
+        Lease lease(this, p, index);
+
+        auto &callable = lease.stream().callable();
+        callable.target = &cb;
+        callable.invoke = [](void *target, params_type &params) -> int {
+            auto &f = *static_cast<CB *>(target);
+            using result_type = std::invoke_result_t<CB &, params_type &>;
+            if constexpr (std::is_void_v<result_type>)
+            {
+                f(params);
+                return paContinue;
+            }
+            else
             {
-                m_deviceList.emplace_back(SystemDevice(info, i));
+                return static_cast<int>(f(params));
             }
+        };
+        lease.stream().Start();
+        return lease;
+    }
+};
+
+namespace detail
+{
+// Separate hot atomics by at least this much to avoid false sharing.
+// std::hardware_destructive_interference_size is not reliably available.
+static constexpr std::size_t CacheLineSize = 64;
+} // namespace detail
+
+// The (at most) two contiguous pieces of a SpscRing that a read or write
+// spans, for zero-copy access. size2 is non-zero only when the range wraps.
+template <typename T> struct RingRegions
+{
+    T *data1 = nullptr;
+    std::size_t size1 = 0;
+    T *data2 = nullptr;
+    std::size_t size2 = 0;
+    std::size_t size() const noexcept { return size1 + size2; }
+};
+
+/*/
+    Lock-free, single producer / single consumer ring of Frames, for moving
+    audio between the callback and another thread. The C++ counterpart of
+    PaUtilRingBuffer, with the same two-region zero-copy API, but:
+      - the write and read indices live on separate cache lines, so the
+        producer and consumer do not invalidate each other on every access;
+      - each side keeps a cached copy of the other side's index and only
+        re-reads the shared one when the cache says there isn't enough room;
+      - indices are published with release stores and observed with acquire
+        loads, once per Write/Read or Advance*, however many frames it moves.
+    Capacity is rounded up to a power of two. Storage is allocated once, in
+    the constructor; nothing after that allocates.
+/*/
+template <typename FrameT> class SpscRing : detail::NoCopy<SpscRing<FrameT>>
+{
+    static_assert(std::is_trivially_copyable_v<FrameT>,
+                  "SpscRing frames are copied as raw memory");
+
+    struct alignas(detail::CacheLineSize) ProducerSide
+    {
+        std::atomic<std::size_t> write{0};
+        std::size_t cachedRead = 0;
+    };
+    struct alignas(detail::CacheLineSize) ConsumerSide
+    {
+        std::atomic<std::size_t> read{0};
+        std::size_t cachedWrite = 0;
+    };
+
+    ProducerSide m_prod;
+    ConsumerSide m_cons;
+    std::vector<FrameT> m_buf;
+    std::size_t m_mask = 0;
+
+    static std::size_t roundUpPow2(std::size_t n) noexcept
+    {
+        std::size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    RingRegions<FrameT> regions(std::size_t index, std::size_t count) noexcept
+    {
+        RingRegions<FrameT> r;
+        const std::size_t pos = index & m_mask;
+        const std::size_t first = std::min(count, m_buf.size() - pos);
+        r.data1 = m_buf.data() + pos;
+        r.size1 = first;
+        if (count > first)
+        {
+            r.data2 = m_buf.data();
+            r.size2 = count - first;
         }
+        return r;
     }
 
   public:
-    auto Count() const noexcept { return m_pa->DeviceCount(); }
+    explicit SpscRing(std::size_t capacity)
+        : m_buf(roundUpPow2(capacity ? capacity : 1))
+    {
+        m_mask = m_buf.size() - 1;
+    }
+
+    std::size_t Capacity() const noexcept { return m_buf.size(); }
+
+    // Producer side.
+    std::size_t WriteAvailable() noexcept
+    {
+        const auto w = m_prod.write.load(std::memory_order_relaxed);
+        m_prod.cachedRead = m_cons.read.load(std::memory_order_acquire);
+        return Capacity() - (w - m_prod.cachedRead);
+    }
+    RingRegions<FrameT> GetWriteRegions(std::size_t count) noexcept
+    {
+        const auto w = m_prod.write.load(std::memory_order_relaxed);
+        if (Capacity() - (w - m_prod.cachedRead) < count)
+        {
+            m_prod.cachedRead = m_cons.read.load(std::memory_order_acquire);
+        }
+        const auto room = Capacity() - (w - m_prod.cachedRead);
+        return regions(w, std::min(count, room));
+    }
+    // Publishes count frames written through GetWriteRegions.
+    void AdvanceWriteIndex(std::size_t count) noexcept
+    {
+        const auto w = m_prod.write.load(std::memory_order_relaxed);
+        m_prod.write.store(w + count, std::memory_order_release);
+    }
+    std::size_t Write(const FrameT *data, std::size_t count) noexcept
+    {
+        const auto r = GetWriteRegions(count);
+        std::copy_n(data, r.size1, r.data1);
+        std::copy_n(data + r.size1, r.size2, r.data2);
+        AdvanceWriteIndex(r.size());
+        return r.size();
+    }
+
+    // Consumer side.
+    std::size_t ReadAvailable() noexcept
+    {
+        const auto rd = m_cons.read.load(std::memory_order_relaxed);
+        m_cons.cachedWrite = m_prod.write.load(std::memory_order_acquire);
+        return m_cons.cachedWrite - rd;
+    }
+    RingRegions<FrameT> GetReadRegions(std::size_t count) noexcept
+    {
+        const auto rd = m_cons.read.load(std::memory_order_relaxed);
+        if (m_cons.cachedWrite - rd < count)
+        {
+            m_cons.cachedWrite = m_prod.write.load(std::memory_order_acquire);
+        }
+        return regions(rd, std::min(count, m_cons.cachedWrite - rd));
+    }
+    // Releases count frames read through GetReadRegions back to the producer.
+    void AdvanceReadIndex(std::size_t count) noexcept
+    {
+        const auto rd = m_cons.read.load(std::memory_order_relaxed);
+        m_cons.read.store(rd + count, std::memory_order_release);
+    }
+    std::size_t Read(FrameT *data, std::size_t count) noexcept
+    {
+        const auto r = GetReadRegions(count);
+        std::copy_n(r.data1, r.size1, data);
+        std::copy_n(r.data2, r.size2, data + r.size1);
+        AdvanceReadIndex(r.size());
+        return r.size();
+    }
+
+    // Only call when neither side is running, like PaUtil_FlushRingBuffer.
+    void Flush() noexcept
+    {
+        m_prod.write.store(0, std::memory_order_relaxed);
+        m_prod.cachedRead = 0;
+        m_cons.read.store(0, std::memory_order_relaxed);
+        m_cons.cachedWrite = 0;
+    }
+};
+
+class HostApi;
+// One host api's devices in a registry snapshot.
+class DeviceEnum
+{
+    friend class HostApi;
+    std::shared_ptr<const DeviceRegistry> m_reg;
+    PaHostApiIndex m_apiIndex;
+
+    DeviceEnum(std::shared_ptr<const DeviceRegistry> reg,
+               PaHostApiIndex apiIndex)
+        : m_reg(std::move(reg)), m_apiIndex(apiIndex)
+    {
+    }
+    DeviceRange Devices() const { return m_reg->Devices(m_apiIndex); }
+
+  public:
+    auto Count() const { return (int)Devices().size(); }
 };
 
 enum class HostIds
@@ -361,13 +1607,16 @@ enum class HostIds
     WDMKS = 11,
     JACK = 12,
     WASAPI = 13,
-    AudioScienceHPI = 14
+    AudioScienceHPI = 14,
+    Offline = 15 // no hardware: renders as fast as possible, or paced
 };
 
+// indexed by HostIds; 6 was never assigned
 static const std::vector<std::string> HostIdNames = {
-    "InDevelopment", "DirectSound", "MME",         "ASIO", "SoundManager",
-    "CoreAudio",     "OSS",         "ALSA",        "AL",   "BeOS",
-    "WDKMS",         "JACK",        "AudioScience"};
+    "InDevelopment", "DirectSound", "MME",    "ASIO", "SoundManager",
+    "CoreAudio",     "",            "OSS",    "ALSA", "AL",
+    "BeOS",          "WDKMS",       "JACK",   "WASAPI", "AudioScience",
+    "Offline"};
 
 [[maybe_unused]] static inline const std::string_view
 HostIdToString(const HostIds hostId)
@@ -388,46 +1637,43 @@ class HostApi
     friend class audio;
     DeviceEnum m_enum;
     HostIds m_hostid;
-    PaHostApiInfo info;
+    PaHostApiIndex m_index;
 
   public:
-    HostApi(const PaHostApiInfo *info, detail::PaStatics &pa, HostIds hostId)
-        : m_enum(pa, info), m_hostid(hostId), info(*info)
-    {
-    }
-    HostApi(const HostApi &rhs)
-        : m_enum(rhs.m_enum), m_hostid(rhs.m_hostid), info(rhs.info)
-    {
-    }
-
-    HostApi &operator=(const HostApi &rhs)
+    // a view of host api index in the registry snapshot reg
+    HostApi(std::shared_ptr<const DeviceRegistry> reg, PaHostApiIndex index)
+        : m_enum(reg, index), m_hostid((HostIds)reg->ApiType(index)),
+          m_index(index)
     {
-        m_enum = rhs.m_enum;
-        m_hostid = rhs.m_hostid;
-        info = rhs.info;
-        return *this;
     }
 
     using HostApiList = std::vector<HostApi>;
 
-    std::string_view name() const noexcept { return info.name; }
-    const auto &Devices() const noexcept { return m_enum.Devices(); }
+    // name(), Info() and Devices() initialize the host api on first use;
+    // HostId() does not.
+    std::string_view name() const { return Info().name; }
+    DeviceRange Devices() const { return m_enum.Devices(); }
     HostIds HostId() const noexcept { return m_hostid; }
-    const PaHostApiInfo &Info() const noexcept { return info; }
+    const PaHostApiInfo &Info() const
+    {
+        return m_enum.m_reg->ApiInfo(m_index);
+    }
+    // false if the backend failed to initialize, or is not present here
+    bool Available() const noexcept
+    {
+        return Pa_HostApiTypeIdToHostApiIndex((PaHostApiTypeId)m_hostid) ==
+            m_index;
+    }
     const std::optional<SystemDevice> DefaultOutputDevice() const
     {
-
-        const auto glob_idx = info.defaultOutputDevice;
-        for (const auto &sd : m_enum.Devices())
+        const auto devices = Devices();
+        if (auto sd = devices.FindGlobal(Info().defaultOutputDevice))
         {
-            if (sd.GlobalDeviceIndex() == glob_idx)
-            {
-                return sd;
-            }
+            return sd;
         }
         // wasn't found, accept the first?
-        if (Devices().size() > 0)
-            return Devices().at(0);
+        if (devices.size() > 0)
+            return devices.at(0);
         else
             return std::optional<SystemDevice>();
     }
@@ -438,22 +1684,19 @@ class ApiEnumerator
     friend class audio;
     HostApiList m_apis;
     detail::PaStatics &m_pa;
-    HostApi DefaultHostApi() const noexcept
+    HostApi DefaultHostApi() const
     {
-        auto index = Pa_GetDefaultHostApi();
-        auto info = Pa_GetHostApiInfo(index);
-        return HostApi(info, m_pa, (HostIds)info->type);
+        return HostApi(DeviceRegistry::Current(), Pa_GetDefaultHostApi());
     }
     ApiEnumerator(detail::PaStatics &pa) : m_pa(pa) { do_enum(); }
+    // Views of the current snapshot, which leave host apis uninitialized.
     void do_enum()
     {
+        const auto reg = DeviceRegistry::Current();
         m_apis.clear();
-        for (auto i = 0; i < m_pa.ApiCount(); ++i)
+        for (PaHostApiIndex i = 0; i < reg->ApiCount(); ++i)
         {
-            auto info = Pa_GetHostApiInfo(i);
-            HostIds mytype = (HostIds)info->type;
-            HostApi a(info, m_pa, mytype);
-            m_apis.push_back(a);
+            m_apis.emplace_back(reg, i);
         }
     }
 };
@@ -464,7 +1707,7 @@ class audio
 {
     static inline detail::PaStatics m_pa;
     ApiEnumerator m_enum;
-    HostApiResult m_api_current = m_enum.DefaultHostApi();
+    HostApiResult m_api_current;
 
   public:
     audio() : m_enum(m_pa)
@@ -498,23 +1741,27 @@ class audio
     {
         return detail::PaStatics::build_info();
     }
+    // Looked up in the current registry snapshot, which also supplies the
+    // device's host api: nothing is re-enumerated.
     const SystemDeviceResult DefaultOutputDevice()
     {
-        auto idx = Pa_GetDefaultOutputDevice();
-        auto info = Pa_GetDeviceInfo(idx);
-        m_enum.do_enum(); // make sure we have all apis
-        m_api_current = m_enum.m_apis.at(info->hostApi);
-        assert(m_enum.m_apis.size() < (unsigned int)idx);
-        return m_api_current->DefaultOutputDevice();
+        const auto lock = DeviceRegistry::Lock();
+        const auto reg = DeviceRegistry::Current();
+        auto device = reg->Device(Pa_GetDefaultOutputDevice());
+        if (device.has_value())
+        {
+            m_api_current = HostApi(reg, device->Info().hostApi);
+        }
+        return device;
     }
     const Device DefaultOutputDeviceInstance()
     {
-        auto idx = Pa_GetDefaultOutputDevice();
-        auto info = Pa_GetDeviceInfo(idx);
-        m_enum.do_enum(); // make sure we have all apis
-        m_api_current = m_enum.m_apis.at(info->hostApi);
-        assert(m_enum.m_apis.size() < (unsigned int)idx);
-        return Device(*m_api_current->DefaultOutputDevice());
+        const auto device = DefaultOutputDevice();
+        if (!device.has_value())
+        {
+            throw std::runtime_error("no default output device");
+        }
+        return Device(*device);
     }
     const HostApiList hostApis() const noexcept { return m_enum.m_apis; }
     const HostApiResult &CurrentApi() const noexcept { return m_api_current; }
@@ -525,7 +1772,7 @@ class audio
     {
         for (const auto &a : hostApis())
         {
-            if (a.HostId() == hostId)
+            if (a.HostId() == hostId && a.Available())
             {
                 return HostApi(a);
             }
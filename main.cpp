@@ -6,43 +6,324 @@
 
 #include "cppaudio.hpp"
 #include <cassert>
+#include <cmath>
 #include <iostream>
 
 using namespace std;
 
-namespace SAMPLETYPES
+void play_tone()
 {
-using INT16 = short;
-using FLOAT32 = float;
-using DOUBLE32 = DOUBLE;
-} // namespace SAMPLETYPES
 
-template <typename SAMPLETYPE, typename CB> struct Stream
+    cppaudio::audio a;
+    auto myDevice = a.DefaultOutputDeviceInstance();
+    double phase = 0;
+    auto mystream = cppaudio::OpenStream<float, 2>(
+        myDevice, [&phase](cppaudio::IOParams<float, 2> &params) {
+            const double step =
+                2.0 * M_PI * 440.0 / params.audioDetails.samplerate;
+            for (auto &frame : params.output)
+            {
+                const auto v = static_cast<float>(0.2 * sin(phase));
+                frame = {v, v};
+                phase += step;
+            }
+            if (phase > 2.0 * M_PI) phase = fmod(phase, 2.0 * M_PI);
+        });
+    mystream.Start();
+    cppaudio::sleep(1000);
+    mystream.Stop();
+    cout << endl;
+}
+
+// An output device of the offline host api: its default one, or the one named.
+cppaudio::Device OfflineOutput(std::string_view name = {})
 {
-    Stream(CB &&cb, cppaudio::Device &d)
-        : m_cb(std::forward<CB>(cb)), m_device(d){};
+    cppaudio::audio a(cppaudio::HostIds::Offline);
+    const auto device = name.empty() ? a.CurrentApi()->DefaultOutputDevice()
+                                     : a.CurrentApi()->Devices().Find(name);
+    assert(device);
+    return cppaudio::Device(*device, cppaudio::Direction::output);
+}
 
-    Stream(SAMPLETYPE, cppaudio::Device &device, CB &&cb)
-        : Stream(std::forward<CB>(cb), device)
+// Counts the blocks allocated from it, which come from new and delete.
+struct CountingResource : std::pmr::memory_resource
+{
+    long allocations = 0, outstanding = 0;
+    void *do_allocate(std::size_t bytes, std::size_t align) override
+    {
+        ++allocations;
+        ++outstanding;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t align) override
     {
+        --outstanding;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+    bool do_is_equal(const memory_resource &o) const noexcept override
+    {
+        return this == &o;
     }
-    CB m_cb;
-    template <typename T> void call(const T &t) { m_cb(t); }
-    cppaudio::Device &m_device;
 };
 
-void play_tone()
+// Picking a host api initializes it alone: PortAudio only hands out indices
+// for the devices of host apis it has initialized. Runs before anything else
+// has touched the others.
+void test_lazy_init()
 {
+    cppaudio::audio a(cppaudio::HostIds::Offline);
+    const auto devices = a.CurrentApi()->Devices();
+    assert(!devices.empty());
+    const auto offline = Pa_HostApiTypeIdToHostApiIndex(paOffline);
+    PaDeviceIndex listed = 0;
+    for (; const auto info = Pa_GetDeviceInfo(listed); ++listed)
+    {
+        assert(info->hostApi == offline);
+    }
+    assert((std::size_t)listed == devices.size());
+}
 
-    cppaudio::audio a;
-    auto myDevice = a.DefaultOutputDeviceInstance();
-    auto mystream = Stream(float(), myDevice, [](auto &params) {
-        cout << params << endl;
-        return 0;
+// The offline host api needs no sound card, and free runs by default,
+// so a short wall clock wait renders well over real time. It is only built
+// on request: configure PortAudio with -DPA_USE_OFFLINE=ON for these tests.
+void test_offline()
+{
+    cppaudio::audio a(cppaudio::HostIds::Offline);
+    assert(cppaudio::HostIdToString(a.CurrentApi()->HostId()) == "Offline");
+    assert(a.CurrentApi()->Available());
+    assert(a.CurrentApi()->Devices().size() ==
+           (size_t)a.CurrentApi()->Info().deviceCount);
+    for (const auto &api : a.hostApis())
+    {
+        assert(!api.Available() || (cppaudio::HostIds)api.Info().type == api.HostId());
+    }
+    auto myDevice = cppaudio::Device(*a.CurrentApi()->DefaultOutputDevice(),
+                                     cppaudio::Direction::output);
+    unsigned long frames = 0;
+    auto mystream = cppaudio::OpenStream<float, 2>(
+        myDevice, [&frames](cppaudio::IOParams<float, 2> &params) {
+            for (auto &frame : params.output) frame = {0.0f, 0.0f};
+            frames += params.output.size();
+        });
+    mystream.Start();
+    cppaudio::sleep(100);
+    mystream.Stop();
+    assert(frames > myDevice.Info().defaultSampleRate / 10);
+
+    auto stats = mystream.Stats();
+    assert(stats.callbackCount > 0);
+    assert(stats.p99Load <= stats.p999Load && stats.p999Load <= stats.maxLoad);
+}
+
+// Queries are answered from one shared snapshot; a refresh swaps in a new
+// one without disturbing views of the old.
+void test_registry()
+{
+    cppaudio::audio a(cppaudio::HostIds::Offline);
+    const auto reg = cppaudio::DeviceRegistry::Current();
+    assert(reg == cppaudio::DeviceRegistry::Current());
+    const auto devices = a.CurrentApi()->Devices();
+    assert(!devices.empty());
+    assert(&devices[0].Info() == &a.CurrentApi()->Devices()[0].Info());
+
+    const auto byName = reg->FindDevice(devices[0].name());
+    assert(byName && byName->GlobalDeviceIndex() ==
+           devices[0].GlobalDeviceIndex());
+    assert(!devices.Find("no such device"));
+    const auto byIndex = reg->Device(devices[0].GlobalDeviceIndex());
+    assert(byIndex && &byIndex->Info() == &devices[0].Info());
+
+    const auto next = cppaudio::DeviceRegistry::Refresh();
+    assert(next->Generation() == reg->Generation() + 1);
+    assert(cppaudio::DeviceRegistry::Current() == next);
+    assert(!cppaudio::DeviceRegistry::Stale());
+    assert(devices[0].name() == next->FindDevice(devices[0].name())->name());
+
+    // a device from the old snapshot still opens, by its index in the new one
+    const auto resolved = next->Resolve(devices[0]);
+    assert(resolved && resolved->Generation() == next->Generation());
+    assert(cppaudio::Device(devices[0]).CurrentIndex() ==
+           resolved->GlobalDeviceIndex());
+}
+
+// Format answers are kept per registry snapshot, and asked again of the
+// device as it is listed after a refresh.
+void test_format_queries()
+{
+    using cppaudio::SampleFormats;
+    cppaudio::audio a(cppaudio::HostIds::Offline);
+    const auto int16 = a.CurrentApi()->Devices().Find("Offline Int16");
+    assert(int16);
+    const cppaudio::Device d(*int16, cppaudio::Direction::output);
+    assert(d.Supports({SampleFormats::Int16}, 2, 44100));
+    assert(d.Supports({SampleFormats::Float32}, 2, 44100)); // converted
+    assert(!d.Supports({SampleFormats::Int16}, 3, 44100));
+    assert(!d.Supports({SampleFormats::Int16}, 2, 384000));
+
+    const auto reg = cppaudio::DeviceRegistry::Current();
+    assert(reg->IsFormatSupported(*int16, cppaudio::Direction::output,
+                                  {SampleFormats::Int16}, 3,
+                                  44100) == paInvalidChannelCount);
+    cppaudio::DeviceRegistry::Refresh();
+    assert(d.Supports({SampleFormats::Int16}, 2, 48000));
+    // the replaced snapshot defers to the current one
+    assert(reg->IsFormatSupported(*int16, cppaudio::Direction::output,
+                                  {SampleFormats::Int16}, 2,
+                                  48000) == paFormatIsSupported);
+}
+
+// A native stream runs the callback on the device's own sample type.
+void test_native_stream()
+{
+    const auto d = OfflineOutput("Offline Int16");
+    assert(d.NativeFormats() == cppaudio::SampleFormats::Int16);
+    assert(d.TakesNatively<int16_t>() && !d.TakesNatively<float>());
+
+    std::size_t sampleSize = 0;
+    unsigned long frames = 0;
+    auto s = cppaudio::OpenNativeStream<2>(d, [&](auto &io) {
+        for (auto &frame : io.output) frame.fill(0);
+        sampleSize = sizeof(io.output[0][0]);
+        frames += io.output.size();
     });
-    // mystream.call("Hello wanka!"s);
-    // mystream.call(42);
-    cout << endl;
+    assert(s.sampleFormat() == cppaudio::SampleFormats::Int16);
+    s.Start();
+    cppaudio::sleep(50);
+    s.Stop();
+    assert(frames > 0 && sampleSize == sizeof(int16_t));
+}
+
+// Streams opened while a memory resource is installed allocate from it, and
+// give it all back when they close.
+void test_memory_resource()
+{
+    CountingResource counting;
+    const auto d = OfflineOutput();
+    const auto silence = [](cppaudio::IOParams<float, 2> &params) {
+        for (auto &frame : params.output) frame = {0.0f, 0.0f};
+    };
+    cppaudio::UseMemoryResource(&counting);
+    {
+        auto s = cppaudio::OpenStream<float, 2>(d, silence);
+        assert(counting.outstanding > 0);
+        s.Start();
+        cppaudio::sleep(20);
+        s.Stop();
+    }
+    assert(counting.outstanding == 0);
+
+    // locking may be refused here, the stream runs regardless
+    cppaudio::UseMemoryResource(nullptr, true);
+    {
+        auto s = cppaudio::OpenStream<float, 2>(d, silence);
+        s.Start();
+        cppaudio::sleep(20);
+        s.Stop();
+    }
+    cppaudio::UseMemoryResource(nullptr);
+}
+
+// The callback thread applies its policy before the first callback, and a
+// policy that can't be applied stops the stream from starting.
+void test_thread_policy()
+{
+    const auto d = OfflineOutput();
+    unsigned long frames = 0;
+    auto s = cppaudio::OpenStream<float, 2>(
+        d, [&frames](cppaudio::IOParams<float, 2> &params) {
+            for (auto &frame : params.output) frame = {0.0f, 0.0f};
+            frames += params.output.size();
+        });
+
+    cppaudio::ThreadPolicy policy;
+    policy.priority = 100;
+    bool threw = false;
+    try
+    {
+        s.SetThreadPolicy(policy);
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+#ifdef __linux__
+    policy.priority = 0;
+    policy.cpus = {1023}; // beyond any CPU there is
+    policy.fallback = false;
+    s.SetThreadPolicy(policy);
+    threw = false;
+    try
+    {
+        s.Start();
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    assert(threw && frames == 0);
+#endif
+
+    // a pinned Deadline thread could never be had
+    policy.policy = cppaudio::SchedulingPolicy::Deadline;
+    policy.cpus = {0};
+    policy.fallback = false;
+    threw = false;
+    try
+    {
+        s.SetThreadPolicy(policy);
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    // whatever isn't permitted here is relaxed, the stream runs regardless
+    policy.fallback = true;
+    s.SetThreadPolicy(policy);
+    s.Start();
+    cppaudio::sleep(20);
+    s.Stop();
+    assert(frames > 0);
+}
+
+// Streams are opened once, when declared; leasing and returning them only
+// starts and stops them.
+void test_stream_pool()
+{
+    CountingResource counting;
+    const auto d = OfflineOutput();
+    const auto int16 = OfflineOutput("Offline Int16");
+    cppaudio::UseMemoryResource(&counting);
+    {
+        cppaudio::StreamPool<float, 2> pool;
+        const auto first = pool.Declare(d, 2, 48000, 256);
+        const auto second = pool.Declare(int16, 1, 44100);
+        const long opened = counting.allocations;
+
+        std::atomic<unsigned long> frames{0};
+        auto play = [&frames](cppaudio::IOParams<float, 2> &params) {
+            for (auto &frame : params.output) frame = {0.0f, 0.0f};
+            frames += params.output.size();
+        };
+        for (int round = 0; round < 3; ++round)
+        {
+            auto x = pool.Acquire(first, play);
+            auto y = pool.Acquire(first, play);
+            assert(x && y && !pool.Acquire(first, play));
+            assert(x->stream().audioDetails().samplerate == 48000);
+            auto z = pool.Acquire(second, play); // another device
+            assert(z && pool.Available(second) == 0);
+            cppaudio::sleep(10);
+            x->Stop();
+        }
+        assert(pool.Available(first) == 2 && pool.Available(second) == 1);
+        assert(frames > 0 && counting.allocations == opened);
+    }
+    assert(counting.outstanding == 0);
+    cppaudio::UseMemoryResource(nullptr);
 }
 
 void test_output_device_prepare()
@@ -67,6 +348,37 @@ void test_output_device_prepare()
     assert(mydevice.sampleFormat() == cppaudio::SampleFormats::Float32);
 }
 
+void test_spsc_ring()
+{
+    using frame = cppaudio::Frame<float, 2>;
+    cppaudio::SpscRing<frame> ring(6);
+    assert(ring.Capacity() == 8);
+    assert(ring.ReadAvailable() == 0);
+    assert(ring.WriteAvailable() == 8);
+
+    frame in[8], out[8];
+    for (int i = 0; i < 8; ++i) in[i] = {float(i), float(-i)};
+
+    // move the indices along so the next write wraps
+    assert(ring.Write(in, 5) == 5);
+    assert(ring.Read(out, 5) == 5);
+    assert(out[4][1] == -4.0f);
+
+    auto w = ring.GetWriteRegions(6);
+    assert(w.size1 == 3 && w.size2 == 3);
+    std::copy_n(in, w.size1, w.data1);
+    std::copy_n(in + w.size1, w.size2, w.data2);
+    assert(ring.ReadAvailable() == 0); // nothing published yet
+    ring.AdvanceWriteIndex(w.size());
+    assert(ring.ReadAvailable() == 6);
+    assert(ring.Write(in, 8) == 2); // full after two more
+
+    auto r = ring.GetReadRegions(8);
+    assert(r.size() == 8 && r.data1[0][0] == 0.0f && r.data2[0][0] == 3.0f);
+    ring.AdvanceReadIndex(r.size());
+    assert(ring.ReadAvailable() == 0);
+}
+
 void test_api(cppaudio::audio &audio)
 {
 #ifdef _WIN32
@@ -96,6 +408,15 @@ void test_api(cppaudio::audio &audio)
 
 int main()
 {
+    test_spsc_ring();
+    test_lazy_init();
+    test_offline();
+    test_registry();
+    test_format_queries();
+    test_native_stream();
+    test_memory_resource();
+    test_thread_policy();
+    test_stream_pool();
     play_tone();
     exit(0);
     cppaudio::audio audio;
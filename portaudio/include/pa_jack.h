@@ -70,6 +70,18 @@ PaError PaJack_SetClientName( const char* name );
  */
 PaError PaJack_GetClientName(const char** clientName);
 
+/** Set the number of worker threads, besides JACK's process thread, that streams are processed on.
+ *
+ * Each stream is given to the worker with the fewest streams when it is opened and stays with it until it is closed,
+ * so a stream callback is always called from the same thread, though possibly not JACK's process thread. The workers
+ * run at the priority of the process thread, which doesn't let JACK's cycle finish before every stream is processed.
+ * With the default of 0 all streams are processed on the process thread, one after another. Must be called before
+ * Pa_Initialize to take effect.
+ * @param numThreads The number of worker threads.
+ * @return paNoError, or paInvalidFlag if numThreads is negative.
+ */
+PaError PaJack_SetProcessThreads( int numThreads );
+
 #ifdef __cplusplus
 }
 #endif
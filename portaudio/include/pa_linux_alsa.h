@@ -70,6 +70,22 @@ void PaAlsa_InitializeStreamInfo( PaAlsaStreamInfo *info );
  **/
 void PaAlsa_EnableRealtimeScheduling( PaStream *s, int enable );
 
+/** Instruct whether the stream callback should work directly in ALSA's mmapped hardware buffers.
+ *
+ * When enabled the callback's input and output pointers point into the device's mmap areas, and the buffer
+ * processor, which otherwise converts and copies every period, is skipped. This saves two copies per period on
+ * devices with many channels. Periods that ALSA can not hand over in one contiguous piece of the expected size
+ * are still processed normally.
+ *
+ * The stream must be a stopped callback stream whose sample format, interleaving and channel count are exactly
+ * those the device was opened with, on devices that support mmap. framesPerBuffer must be
+ * paFramesPerBufferUnspecified or equal to the ALSA period size.
+ *
+ * @return paNoError, or paSampleFormatNotSupported, paInvalidChannelCount or paInvalidFlag if the stream does
+ * not meet the requirements above.
+ **/
+PaError PaAlsa_EnableZeroCopy( PaStream *s, int enable );
+
 #if 0
 void PaAlsa_EnableWatchdog( PaStream *s, int enable );
 #endif
@@ -80,6 +96,34 @@ PaError PaAlsa_GetStreamInputCard( PaStream *s, int *card );
 /** Get the ALSA-lib card index of this stream's output device. */
 PaError PaAlsa_GetStreamOutputCard( PaStream *s, int *card );
 
+/** Capabilities of an ALSA device in one direction, see PaAlsa_GetDeviceCapabilities. */
+typedef struct PaAlsaDeviceCapabilities
+{
+    int minChannels;
+    int maxChannels;
+    PaSampleFormat sampleFormats;   /**< The sample formats the device takes without conversion */
+    double minSampleRate;
+    double maxSampleRate;
+    unsigned long minPeriodFrames;
+    unsigned long maxPeriodFrames;
+    unsigned long minBufferFrames;
+    unsigned long maxBufferFrames;
+}
+PaAlsaDeviceCapabilities;
+
+/** Get the capabilities of an ALSA device for capture or playback.
+ *
+ * The device is opened on the first capability query or Pa_IsFormatSupported call for it and that direction, and
+ * its capabilities are remembered, so later queries don't open it again. Pa_IsFormatSupported answers from the same
+ * record for the standard sample rates (8000 to 384000 Hz) and up to 32 channels. The record is discarded when the
+ * device list is updated.
+ * @param device A device of the ALSA host API.
+ * @param isInput Nonzero for the capture capabilities, zero for playback.
+ * @return paNoError, paInvalidDevice if the device is not an ALSA device, paInvalidChannelCount if it has no channels
+ * in that direction, or paDeviceUnavailable if it can't be opened.
+ */
+PaError PaAlsa_GetDeviceCapabilities( PaDeviceIndex device, int isInput, PaAlsaDeviceCapabilities *capabilities );
+
 /** Set the number of periods (buffer fragments) to configure devices with.
  *
  * By default the number of periods is 4, this is the lowest number of periods that works well on
@@ -93,6 +137,19 @@ PaError PaAlsa_SetNumPeriods( int numPeriods );
  */
 PaError PaAlsa_SetRetriesBusy( int retries );
 
+/** Set the maximum number of threads used to probe devices while building the device list.
+ *
+ * Sound cards are probed concurrently, the devices of one card and plugin devices one at a time. Zero probes every
+ * device on the calling thread, without a timeout. The default is 8. Must be called before Pa_Initialize to take
+ * effect.
+ */
+PaError PaAlsa_SetProbeThreads( int numThreads );
+
+/** Set how long probing a device (or the devices of one card) may take, in seconds, before the device is left out
+ * of the device list. The default is 2 seconds. Must be called before Pa_Initialize to take effect.
+ */
+PaError PaAlsa_SetProbeTimeout( double seconds );
+
 /** Set the path and name of ALSA library file if PortAudio is configured to load it dynamically (see
  *  PA_ALSA_DYNAMIC). This setting will overwrite the default name set by PA_ALSA_PATHNAME define.
  * @param pathName Full path with filename. Only filename can be used, but dlopen() will lookup default
@@ -100,6 +157,18 @@ PaError PaAlsa_SetRetriesBusy( int retries );
  */
 void PaAlsa_SetLibraryPathName( const char *pathName );
 
+/** Instruct whether device capabilities should be remembered across processes.
+ *
+ * When enabled, the capabilities probed for each device (channel counts, default latencies and
+ * sample rate) are kept in $XDG_CACHE_HOME/portaudio/alsa-devices (~/.cache/portaudio/alsa-devices
+ * if XDG_CACHE_HOME is unset), and devices whose /proc/asound information and ALSA configuration
+ * are unchanged are not opened again during enumeration. The cache is discarded when the kernel,
+ * ALSA driver or alsa-lib version changes. Setting the environment variable PA_ALSA_DEVICE_CACHE
+ * to 0 or 1 overrides this setting. Must be called before Pa_Initialize to take effect.
+ * @param enable Nonzero to enable the cache, zero (the default) to disable it.
+ */
+PaError PaAlsa_EnableDeviceCache( int enable );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,117 @@
+#ifndef PA_OFFLINE_H
+#define PA_OFFLINE_H
+
+/*
+ * $Id:
+ * PortAudio Portable Real-Time Audio Library
+ * Offline (no hardware) host API extensions
+ *
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ *  @ingroup public_header
+ *  @brief Offline host API extension header file.
+ *
+ *  The offline host API drives streams without any audio hardware. Its
+ *  virtual devices capture silence and discard what they play, so callbacks
+ *  can run as fast as the machine allows (batch rendering, benchmarks) or be
+ *  paced to a simulated clock.
+ */
+
+#include "portaudio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Description of one virtual device exposed by the offline host API.
+ @see PaOffline_SetDevices
+*/
+typedef struct PaOfflineDeviceInfo
+{
+    const char *name;
+    int maxInputChannels;
+    int maxOutputChannels;
+    double defaultSampleRate;
+    double minSampleRate;               /**< lowest rate IsFormatSupported accepts */
+    double maxSampleRate;               /**< highest rate IsFormatSupported accepts */
+    PaSampleFormat nativeSampleFormats; /**< formats of the simulated host buffers */
+} PaOfflineDeviceInfo;
+
+
+/** Set the virtual devices the offline host API exposes.
+
+ This function must be called before Pa_Initialize, otherwise it won't have
+ any effect until PortAudio is next initialized. The array is not copied, it
+ must remain valid until Pa_Initialize returns. Passing a NULL array or a
+ count of zero restores the default devices: "Offline Float32" (8 in,
+ 8 out, 48000 Hz, paFloat32/paInt32/paInt24/paInt16) and "Offline Int16"
+ (2 in, 2 out, 44100 Hz, paInt16).
+*/
+PaError PaOffline_SetDevices( const PaOfflineDeviceInfo *devices, int deviceCount );
+
+
+/** How an offline stream advances its clock. */
+typedef enum PaOfflinePacing
+{
+    paOfflineFreeRunning=0, /**< process buffers back to back, as fast as possible */
+    paOfflinePaced=1        /**< sleep so that stream time follows the wall clock scaled by clockRate */
+} PaOfflinePacing;
+
+
+/** Offline-specific stream info, passed in PaStreamParameters::hostApiSpecificStreamInfo.
+ Streams opened without it are free running.
+*/
+typedef struct PaOfflineStreamInfo
+{
+    unsigned long size;             /**< sizeof(PaOfflineStreamInfo) */
+    PaHostApiTypeId hostApiType;    /**< paOffline */
+    unsigned long version;          /**< 1 */
+
+    PaOfflinePacing pacing;
+    double clockRate;               /**< simulated seconds per wall clock second when paced, 1.0 is real time */
+} PaOfflineStreamInfo;
+
+
+/** Initialize a PaOfflineStreamInfo structure for a stream with the given pacing,
+ running at real time when paced.
+*/
+void PaOffline_InitializeStreamInfo( PaOfflineStreamInfo *info, PaOfflinePacing pacing );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -151,7 +151,8 @@ typedef enum PaErrorCode
     paCanNotReadFromAnOutputOnlyStream,
     paCanNotWriteToAnInputOnlyStream,
     paIncompatibleStreamHostApi,
-    paBadBufferPtr
+    paBadBufferPtr,
+    paThreadPolicyFailed
 } PaErrorCode;
 
 
@@ -183,6 +184,40 @@ const char *Pa_GetErrorText( PaError errorCode );
 PaError Pa_Initialize( void );
 
 
+/** Library initialization function that defers host API initialization.
+ Behaves like Pa_Initialize(), except that each host API is only initialized
+ (devices enumerated, servers contacted) when it is first used, so an
+ application that only uses one host API does not pay for the others.
+
+ A host API is initialized by the first call to Pa_GetHostApiInfo(),
+ Pa_HostApiTypeIdToHostApiIndex() or Pa_HostApiDeviceIndexToDeviceIndex()
+ for it, or when a stream is opened with a host API specific device
+ specification for it. Pa_GetDefaultHostApi(), Pa_GetDefaultInputDevice() and
+ Pa_GetDefaultOutputDevice() initialize host APIs in order until the default
+ host API is found, and Pa_GetDeviceCount() initializes all of them.
+ Pa_GetHostApiTypeId() never initializes a host API.
+
+ Differences from Pa_Initialize():
+ - Pa_GetHostApiCount() counts every compiled-in host API. One that fails to
+   initialize, or is not available on this system, remains listed with no
+   devices and is not found by Pa_HostApiTypeIdToHostApiIndex(). Errors from
+   its initialization are returned by the call that triggered it.
+ - Device indices are assigned in the order host APIs are initialized.
+   Indices already handed out remain valid when further host APIs are
+   initialized.
+
+ If PortAudio is already initialized this call only increments the
+ initialization count, keeping the existing mode, and must be matched by a call
+ to Pa_Terminate() like Pa_Initialize().
+
+ @return paNoError if successful, otherwise an error code indicating the cause
+ of failure.
+
+ @see Pa_Initialize, Pa_Terminate, Pa_GetHostApiTypeId
+*/
+PaError Pa_InitializeDeferred( void );
+
+
 /** Library termination function - call this when finished using PortAudio.
  This function deallocates all resources allocated by PortAudio since it was
  initialized by a call to Pa_Initialize(). In cases where Pa_Initialise() has
@@ -203,6 +238,76 @@ PaError Pa_Terminate( void );
 
 
 
+/** Functions of type PaAllocateMemoryCallback allocate the memory PortAudio
+ uses for its device lists, streams and buffers. They must return a block of at
+ least size bytes, aligned like one returned by malloc(), or NULL.
+
+ PortAudio allocates memory while opening streams and listing devices, never
+ from a stream callback.
+
+ @see Pa_SetAllocator, PaFreeMemoryCallback
+*/
+typedef void *PaAllocateMemoryCallback( unsigned long size, void *userData );
+
+
+/** Functions of type PaFreeMemoryCallback release a block allocated by the
+ matching PaAllocateMemoryCallback.
+
+ @param block The block.
+
+ @param size The size it was allocated with.
+
+ @see Pa_SetAllocator, PaAllocateMemoryCallback
+*/
+typedef void PaFreeMemoryCallback( void *block, unsigned long size, void *userData );
+
+
+/** Flags used to control how PortAudio allocates memory, see Pa_SetAllocator(). */
+typedef unsigned long PaAllocatorFlags;
+
+
+#define paNoAllocatorFlag          ((PaAllocatorFlags) 0)
+
+/** Touch every page of each block as it is allocated and lock it into
+ physical memory (mlock() or VirtualLock()), so that the audio thread never
+ takes a page fault on memory PortAudio allocated. Locking fails silently if
+ the process may not lock more memory; the pages are still touched. When a
+ block is freed the pages it had to itself are unlocked; a page it shared
+ with other blocks stays locked.
+*/
+#define paRealTimeAllocator        ((PaAllocatorFlags) 0x00000001)
+
+
+/** Install the functions PortAudio allocates its memory with.
+
+ The allocator is used for every block allocated after the call; blocks
+ allocated before it are freed with the functions that allocated them. It can
+ therefore be installed before Pa_Initialize(), so that PortAudio allocates
+ nothing else, or at any point afterwards, but not while another thread is
+ calling PortAudio. Up to 16 different allocators may be installed over the
+ life of a process.
+
+ @param allocateMemory The allocation function, or NULL to use the system's.
+
+ @param freeMemory The matching release function, NULL if allocateMemory is.
+
+ @param userData A pointer passed to both functions. It must remain valid
+ until every block they allocated has been freed, at the latest when
+ Pa_Terminate() returns.
+
+ @param flags paNoAllocatorFlag or paRealTimeAllocator.
+
+ @return paNoError, paNullCallback if only one of the functions is given,
+ paInvalidFlag if flags contains unknown flags, or paInsufficientMemory if too
+ many allocators have been installed.
+
+ @see PaAllocateMemoryCallback, PaFreeMemoryCallback
+*/
+PaError Pa_SetAllocator( PaAllocateMemoryCallback *allocateMemory,
+        PaFreeMemoryCallback *freeMemory, void *userData, PaAllocatorFlags flags );
+
+
+
 /** The type used to refer to audio devices. Values of this type usually
  range from 0 to (Pa_GetDeviceCount()-1), and may also take on the PaNoDevice
  and paUseHostApiSpecificDeviceSpecification values.
@@ -287,7 +392,8 @@ typedef enum PaHostApiTypeId
     paWDMKS=11,
     paJACK=12,
     paWASAPI=13,
-    paAudioScienceHPI=14
+    paAudioScienceHPI=14,
+    paOffline=15
 } PaHostApiTypeId;
 
 
@@ -358,6 +464,20 @@ const PaHostApiInfo * Pa_GetHostApiInfo( PaHostApiIndex hostApi );
 PaHostApiIndex Pa_HostApiTypeIdToHostApiIndex( PaHostApiTypeId type );
 
 
+/** Retrieve the type of a host API without initializing it.
+
+ @param hostApi A valid host API index ranging from 0 to (Pa_GetHostApiCount()-1)
+
+ @param type Receives the unique identifier of the host API.
+
+ @return paNoError if successful, otherwise paInvalidHostApi if hostApi is out of
+ range, or another PaErrorCode if PortAudio is not initialized or type is NULL.
+
+ @see Pa_InitializeDeferred
+*/
+PaError Pa_GetHostApiTypeId( PaHostApiIndex hostApi, PaHostApiTypeId *type );
+
+
 /** Convert a host-API-specific device index to standard PortAudio device index.
  This function may be used in conjunction with the deviceCount field of
  PaHostApiInfo to enumerate all devices for the specified host API.
@@ -526,13 +646,59 @@ typedef struct PaDeviceInfo
 
  @note PortAudio manages the memory referenced by the returned pointer,
  the client must not manipulate or free the memory. The pointer is only
- guaranteed to be valid between calls to Pa_Initialize() and Pa_Terminate().
+ guaranteed to be valid between calls to Pa_Initialize() and Pa_Terminate(),
+ and until the next call to Pa_UpdateAvailableDeviceList().
 
  @see PaDeviceInfo, PaDeviceIndex
 */
 const PaDeviceInfo* Pa_GetDeviceInfo( PaDeviceIndex device );
 
 
+/** Rescan the devices of the host APIs that support it, picking up devices
+ that have been added or removed since they were initialized, without
+ terminating PortAudio. Open streams are not affected. Host APIs that can not
+ rescan keep their devices, and host APIs that have not been initialized yet
+ (see Pa_InitializeDeferred()) are left alone.
+
+ Device indices may change, and PaDeviceInfo pointers obtained before the call
+ are no longer valid after it. If a rescan fails the device list is left as it
+ was.
+
+ @return paNoError on success, otherwise an error code indicating the cause of
+ the failure.
+
+ @see Pa_SetDevicesChangedCallback
+*/
+PaError Pa_UpdateAvailableDeviceList( void );
+
+
+/** Functions of type PaDevicesChangedCallback are called when a host API
+ notices that devices have been added or removed. The callback runs on a thread
+ belonging to the host API, and must not call PortAudio: it should arrange for
+ Pa_UpdateAvailableDeviceList() to be called elsewhere.
+
+ @param userData The userData parameter supplied to Pa_SetDevicesChangedCallback()
+
+ @see Pa_SetDevicesChangedCallback
+*/
+typedef void PaDevicesChangedCallback( void *userData );
+
+
+/** Register a callback to be called when devices are added or removed.
+ Currently only the ALSA host API reports such changes. The callback is cleared
+ by Pa_Terminate().
+
+ @param userData A pointer passed to devicesChangedCallback.
+
+ @param devicesChangedCallback The callback, or NULL to remove it.
+
+ @return paNoError on success, or paNotInitialized.
+
+ @see PaDevicesChangedCallback, Pa_UpdateAvailableDeviceList
+*/
+PaError Pa_SetDevicesChangedCallback( void *userData, PaDevicesChangedCallback* devicesChangedCallback );
+
+
 /** Parameters for one direction (input or output) of a stream.
 */
 typedef struct PaStreamParameters
@@ -611,6 +777,32 @@ PaError Pa_IsFormatSupported( const PaStreamParameters *inputParameters,
                               double sampleRate );
 
 
+/** Retrieve the sample formats a device takes without conversion.
+
+ A stream whose sampleFormat is one of these, interleaved or not as the device
+ takes it, is opened without a sample format conversion: its buffers are only
+ copied between the host API and the callback, or not at all where the host
+ API supports working in the device's own buffers.
+
+ @param device The device to query.
+
+ @param isInput Nonzero for the formats the device captures in, zero for the
+ formats it plays back in.
+
+ @param sampleFormats Receives the native sample formats, with paNonInterleaved
+ set if the device takes non-interleaved buffers only. Receives 0 if the host
+ API doesn't report native formats.
+
+ @return paNoError on success, paInvalidDevice if device is not a valid device
+ index, paInvalidChannelCount if the device has no channels in that direction,
+ or paDeviceUnavailable if the host API could not open the device to find out.
+
+ @see Pa_IsFormatSupported, PaSampleFormat
+*/
+PaError Pa_GetDeviceNativeSampleFormats( PaDeviceIndex device, int isInput,
+                                         PaSampleFormat *sampleFormats );
+
+
 
 /* Streaming types and functions */
 
@@ -648,7 +840,8 @@ typedef void PaStream;
 
  @see Pa_OpenStream, Pa_OpenDefaultStream
  @see paNoFlag, paClipOff, paDitherOff, paNeverDropInput,
-  paPrimeOutputBuffersUsingStreamCallback, paPlatformSpecificFlags
+  paPrimeOutputBuffersUsingStreamCallback, paDitherNoiseShapingFirstOrder,
+  paPlatformSpecificFlags
 */
 typedef unsigned long PaStreamFlags;
 
@@ -684,6 +877,31 @@ typedef unsigned long PaStreamFlags;
 */
 #define   paPrimeOutputBuffersUsingStreamCallback ((PaStreamFlags) 0x00000008)
 
+/** Shape the dither and quantization noise of output samples with an error
+ feedback filter, moving it towards frequencies where it is less audible.
+ Noise shaping applies when paFloat32 output samples are converted to paInt16,
+ paInt8 or paUInt8 for the host; other conversions use the default triangular
+ dither. The noise shaping order is selected by one of the following values,
+ which may not be combined with paDitherOff:
+
+ paDitherNoiseShapingFirstOrder: first order, 6 dB/octave high pass shaping.
+
+ paDitherNoiseShapingSecondOrder: second order shaping.
+
+ paDitherNoiseShapingHighOrder: fifth order psychoacoustically weighted
+ shaping, designed for sample rates of 44.1 kHz and above.
+
+ @see PaStreamFlags, paDitherNoiseShapingMask
+*/
+#define   paDitherNoiseShapingFirstOrder  ((PaStreamFlags) 0x00000010)
+#define   paDitherNoiseShapingSecondOrder ((PaStreamFlags) 0x00000020)
+#define   paDitherNoiseShapingHighOrder   ((PaStreamFlags) 0x00000030)
+
+/** A mask specifying the noise shaping order bits.
+ @see paDitherNoiseShapingFirstOrder
+*/
+#define   paDitherNoiseShapingMask        ((PaStreamFlags) 0x00000030)
+
 /** A mask specifying the platform specific bits.
  @see PaStreamFlags
 */
@@ -1125,6 +1343,125 @@ PaTime Pa_GetStreamTime( PaStream *stream );
 double Pa_GetStreamCpuLoad( PaStream* stream );
 
 
+/** Timing statistics for the callbacks of a stream, collected alongside the
+ CPU load. Each callback's load is its duration divided by the duration of the
+ audio it processed, so 1.0 means the callback used its whole buffer period.
+
+ Percentiles come from a histogram with 8 logarithmic buckets per octave of
+ load and are the upper edge of the bucket they fall in, so they can read up
+ to 1/8 high but never low. Statistics accumulate from when the stream is
+ opened.
+
+ @see Pa_GetStreamCallbackStats
+*/
+typedef struct PaStreamCallbackStats
+{
+    unsigned long callbackCount;    /**< callbacks measured */
+    unsigned long overBudgetCount;  /**< callbacks with a load above 1.0 */
+    double averageLoad;             /**< the value Pa_GetStreamCpuLoad() returns */
+    double maxLoad;
+    double p99Load;
+    double p999Load;
+} PaStreamCallbackStats;
+
+
+/** Retrieve callback timing statistics for the specified stream.
+
+ This function may be called from any thread, including while the stream is
+ running. It does not block the stream callback, so the values may be
+ a callback or so out of step with each other. All counts are zero for a
+ blocking read/write stream, or if the host API does not measure its
+ callbacks.
+
+ @param stream The stream to query.
+
+ @param stats Receives the statistics.
+
+ @return paNoError on success, or a PaErrorCode if the stream is not valid.
+*/
+PaError Pa_GetStreamCallbackStats( PaStream *stream, PaStreamCallbackStats *stats );
+
+
+/** Scheduling policies for the thread a stream's callback runs on.
+
+ @see PaThreadPolicy
+*/
+typedef enum PaThreadSchedulingPolicy
+{
+    paSchedulingDefault = 0,    /**< Whatever the host API does without a policy */
+    paSchedulingFifo,           /**< Real-time, first in first out (SCHED_FIFO) */
+    paSchedulingRoundRobin,     /**< Real-time, round robin (SCHED_RR) */
+    paSchedulingDeadline        /**< Earliest deadline first (SCHED_DEADLINE), with the buffer period as deadline */
+} PaThreadSchedulingPolicy;
+
+
+/** The largest number of CPUs a PaThreadPolicy can name. */
+#define paMaxThreadPolicyCpus (64)
+
+
+/** Flags for PaThreadPolicy.
+
+ @see paThreadPolicyFallback
+*/
+typedef unsigned long PaThreadPolicyFlags;
+
+/** If the policy can't be applied in full, get as close as permitted instead
+ of failing: SCHED_DEADLINE falls back to SCHED_FIFO, the priority is lowered
+ to what RLIMIT_RTPRIO allows, and without any real-time priority the thread
+ runs at the lowest nice value RLIMIT_NICE allows. An affinity that can't be
+ set is ignored. This doesn't involve rtkit or any other daemon.
+*/
+#define paThreadPolicyFallback ((PaThreadPolicyFlags) 0x01)
+
+
+/** How the thread a stream's callback runs on is scheduled, and on which CPUs.
+
+ @see Pa_SetStreamThreadPolicy
+*/
+typedef struct PaThreadPolicy
+{
+    PaThreadSchedulingPolicy policy;
+
+    /** The real-time priority for paSchedulingFifo and paSchedulingRoundRobin,
+     from 1 to 99. 0 picks the middle of the range the system allows. */
+    int priority;
+
+    /** The fraction of each buffer period the thread may run for, under
+     paSchedulingDeadline. 0 means 0.5. */
+    double runtimeFraction;
+
+    /** The CPUs the thread may run on, none for any CPU. The thread is pinned
+     before the stream callback is first called. Linux won't run a pinned
+     thread under SCHED_DEADLINE, so paSchedulingDeadline with CPUs is only
+     accepted with paThreadPolicyFallback, and then runs as paSchedulingFifo. */
+    int cpuCount;
+    int cpus[paMaxThreadPolicyCpus];
+
+    PaThreadPolicyFlags flags;
+} PaThreadPolicy;
+
+
+/** Set how the callback thread of a stream is scheduled, from the next time it
+ is started.
+
+ The ALSA, OSS and offline host APIs honour the policy; it is applied by the
+ callback thread itself, before the stream callback is first called. Other host
+ APIs run callbacks on threads they don't create, and ignore it. Without a
+ policy, host APIs schedule their threads as they always have.
+
+ @param stream A stopped callback stream.
+
+ @param policy The policy, which is copied, or NULL to remove it.
+
+ @return paNoError, paStreamIsNotStopped if the stream is running, or
+ paInvalidFlag if the policy holds out of range values or pins a
+ paSchedulingDeadline thread without paThreadPolicyFallback. If the policy
+ can't be applied and paThreadPolicyFallback isn't set, Pa_StartStream() fails
+ with paThreadPolicyFailed.
+*/
+PaError Pa_SetStreamThreadPolicy( PaStream *stream, const PaThreadPolicy *policy );
+
+
 /** Read samples from an input stream. The function doesn't return until
  the entire buffer has been filled - this may involve waiting for the operating
  system to supply the data.
@@ -44,83 +44,113 @@
 */
 
 
+#include <stddef.h> /* size_t */
+#include <string.h> /* memset() */
+
 #include "pa_allocation.h"
 #include "pa_util.h"
 
 
 /*
-    Maintain 3 singly linked lists...
-    linkBlocks: the buffers used to allocate the links
-    spareLinks: links available for use in the allocations list
-    allocations: the buffers currently allocated using PaUtil_ContextAllocateMemory()
-
-    Link block size is doubled every time new links are allocated.
+    The blocks of a group are carved, one after the other, from a singly
+    linked list of regions. New blocks come from the first region; when it
+    is full a new first region is allocated, twice the size of the last one
+    up to PA_MAX_REGION_SIZE_. Blocks too big to share a region get a region
+    of their own, which is linked in after the first one.
+
+    Each region starts with a PaUtilAllocationRegion header, and counts its
+    live blocks. Freeing the block allocated last rolls the region back, and
+    a region whose blocks have all been freed is released (or, if it is the
+    first region, reused).
+
+    Regions reserved with PaUtil_ReserveGroupMemory() come straight from
+    PaUtil_AllocateRegion() when it can, the others from
+    PaUtil_AllocateMemory().
 */
 
 
-#define PA_INITIAL_LINK_COUNT_    16
+#define PA_INITIAL_REGION_SIZE_     (4096)
+#define PA_MAX_REGION_SIZE_         (65536)
 
-struct PaUtilAllocationGroupLink
+#define PA_ALIGN_( n ) \
+    (((n) + PA_ALLOCATION_ALIGNMENT - 1) & ~(long)(PA_ALLOCATION_ALIGNMENT - 1))
+
+struct PaUtilAllocationRegion
 {
-    struct PaUtilAllocationGroupLink *next;
-    void *buffer;
+    struct PaUtilAllocationRegion *next;
+    void *memory;       /* what was allocated, the header is aligned within it */
+    long size;          /* bytes from the header to the end of the region */
+    long used;          /* bytes from the header to the next free byte */
+    long lastBlock;     /* offset of the block allocated last */
+    long liveBlocks;
+    int isSystemRegion; /* allocated with PaUtil_AllocateRegion() */
+    long systemSize;
 };
 
+#define PA_REGION_HEADER_SIZE_ PA_ALIGN_( (long)sizeof(struct PaUtilAllocationRegion) )
+
+
 /*
-    Allocate a block of links. The first link will have it's buffer member
-    pointing to the block, and it's next member set to <nextBlock>. The remaining
-    links will have NULL buffer members, and each link will point to
-    the next link except the last, which will point to <nextSpare>
+    Allocate a region with room for <size> bytes of blocks, with
+    PaUtil_AllocateRegion() if <isSystemRegion> is nonzero. Regions allocated
+    with PaUtil_AllocateMemory() are only as aligned as it guarantees, so
+    PA_ALLOCATION_ALIGNMENT extra bytes are allocated to align the header.
 */
-static struct PaUtilAllocationGroupLink *AllocateLinks( long count,
-        struct PaUtilAllocationGroupLink *nextBlock,
-        struct PaUtilAllocationGroupLink *nextSpare )
+static struct PaUtilAllocationRegion *AllocateRegion( long size, int isSystemRegion, unsigned long flags )
 {
-    struct PaUtilAllocationGroupLink *result;
-    int i;
+    struct PaUtilAllocationRegion *result;
+    long systemSize = PA_REGION_HEADER_SIZE_ + size;
+    void *memory;
 
-    result = (struct PaUtilAllocationGroupLink *)PaUtil_AllocateMemory(
-            sizeof(struct PaUtilAllocationGroupLink) * count );
-    if( result )
+    if( isSystemRegion )
     {
-        /* the block link */
-        result[0].buffer = result;
-        result[0].next = nextBlock;
+        memory = PaUtil_AllocateRegion( &systemSize, flags );
+        if( !memory )
+            return 0;
 
-        /* the spare links */
-        for( i=1; i<count; ++i )
-        {
-            result[i].buffer = 0;
-            result[i].next = &result[i+1];
-        }
-        result[count-1].next = nextSpare;
+        result = (struct PaUtilAllocationRegion *)memory;
     }
+    else
+    {
+        memory = PaUtil_AllocateMemory( systemSize + PA_ALLOCATION_ALIGNMENT );
+        if( !memory )
+            return 0;
+
+        result = (struct PaUtilAllocationRegion *)((char *)memory +
+                (PA_ALLOCATION_ALIGNMENT - (size_t)memory % PA_ALLOCATION_ALIGNMENT) % PA_ALLOCATION_ALIGNMENT);
+    }
+
+    result->next = 0;
+    result->memory = memory;
+    result->size = systemSize;
+    result->used = PA_REGION_HEADER_SIZE_;
+    result->lastBlock = PA_REGION_HEADER_SIZE_;
+    result->liveBlocks = 0;
+    result->isSystemRegion = isSystemRegion;
+    result->systemSize = systemSize;
 
     return result;
 }
 
 
-PaUtilAllocationGroup* PaUtil_CreateAllocationGroup( void )
+static void FreeRegion( struct PaUtilAllocationRegion *region )
 {
-    PaUtilAllocationGroup* result = 0;
-    struct PaUtilAllocationGroupLink *links;
+    if( region->isSystemRegion )
+        PaUtil_FreeRegion( region->memory, region->systemSize );
+    else
+        PaUtil_FreeMemory( region->memory );
+}
+
 
+PaUtilAllocationGroup* PaUtil_CreateAllocationGroup( void )
+{
+    PaUtilAllocationGroup* result;
 
-    links = AllocateLinks( PA_INITIAL_LINK_COUNT_, 0, 0 );
-    if( links != 0 )
+    result = (PaUtilAllocationGroup*)PaUtil_AllocateMemory( sizeof(PaUtilAllocationGroup) );
+    if( result )
     {
-        result = (PaUtilAllocationGroup*)PaUtil_AllocateMemory( sizeof(PaUtilAllocationGroup) );
-        if( result )
-        {
-            result->linkCount = PA_INITIAL_LINK_COUNT_;
-            result->linkBlocks = &links[0];
-            result->spareLinks = &links[1];
-            result->allocations = 0;
-        }
-        else
-        {
-            PaUtil_FreeMemory( links );
-        }
+        result->regions = 0;
+        result->nextRegionSize = PA_INITIAL_REGION_SIZE_;
     }
 
     return result;
@@ -129,115 +159,139 @@ PaUtilAllocationGroup* PaUtil_CreateAllocationGroup( void )
 
 void PaUtil_DestroyAllocationGroup( PaUtilAllocationGroup* group )
 {
-    struct PaUtilAllocationGroupLink *current = group->linkBlocks;
-    struct PaUtilAllocationGroupLink *next;
+    PaUtil_FreeMemory( group );
+}
 
-    while( current )
+
+PaError PaUtil_ReserveGroupMemory( PaUtilAllocationGroup* group, long size,
+        int blockCount, unsigned long flags )
+{
+    struct PaUtilAllocationRegion *region;
+
+    size += (long)blockCount * PA_ALLOCATION_ALIGNMENT;
+
+    region = AllocateRegion( size, 1, flags );
+    if( !region )
     {
-        next = current->next;
-        PaUtil_FreeMemory( current->buffer );
-        current = next;
+        /* with an allocator installed by Pa_SetAllocator() all memory comes from it */
+        region = AllocateRegion( size, 0, 0 );
+        if( !region )
+            return paInsufficientMemory;
+
+        if( flags & paUtilRegionPrefault )
+            memset( (char *)region + PA_REGION_HEADER_SIZE_, 0, region->size - PA_REGION_HEADER_SIZE_ );
     }
 
-    PaUtil_FreeMemory( group );
+    region->next = group->regions;
+    group->regions = region;
+
+    return paNoError;
 }
 
 
 void* PaUtil_GroupAllocateMemory( PaUtilAllocationGroup* group, long size )
 {
-    struct PaUtilAllocationGroupLink *links, *link;
-    void *result = 0;
+    struct PaUtilAllocationRegion *region = group->regions;
+    long blockSize = PA_ALIGN_( size > 0 ? size : 1 );
+    void *result;
 
-    /* allocate more links if necessary */
-    if( !group->spareLinks )
+    if( !region || region->size - region->used < blockSize )
     {
-        /* double the link count on each block allocation */
-        links = AllocateLinks( group->linkCount, group->linkBlocks, group->spareLinks );
-        if( links )
+        if( blockSize > group->nextRegionSize / 2 )
         {
-            group->linkCount += group->linkCount;
-            group->linkBlocks = &links[0];
-            group->spareLinks = &links[1];
-        }
-    }
+            /* a region of its own, the first region may still have room for smaller blocks */
+            region = AllocateRegion( blockSize, 0, 0 );
+            if( !region )
+                return 0;
 
-    if( group->spareLinks )
-    {
-        result = PaUtil_AllocateMemory( size );
-        if( result )
+            if( group->regions )
+            {
+                region->next = group->regions->next;
+                group->regions->next = region;
+            }
+            else
+            {
+                group->regions = region;
+            }
+        }
+        else
         {
-            link = group->spareLinks;
-            group->spareLinks = link->next;
+            region = AllocateRegion( group->nextRegionSize - PA_REGION_HEADER_SIZE_, 0, 0 );
+            if( !region )
+                return 0;
 
-            link->buffer = result;
-            link->next = group->allocations;
+            region->next = group->regions;
+            group->regions = region;
 
-            group->allocations = link;
+            if( group->nextRegionSize < PA_MAX_REGION_SIZE_ )
+                group->nextRegionSize += group->nextRegionSize;
         }
     }
 
+    result = (char *)region + region->used;
+    region->lastBlock = region->used;
+    region->used += blockSize;
+    region->liveBlocks += 1;
+
     return result;
 }
 
 
 void PaUtil_GroupFreeMemory( PaUtilAllocationGroup* group, void *buffer )
 {
-    struct PaUtilAllocationGroupLink *current = group->allocations;
-    struct PaUtilAllocationGroupLink *previous = 0;
+    struct PaUtilAllocationRegion *current = group->regions;
+    struct PaUtilAllocationRegion *previous = 0;
 
     if( buffer == 0 )
         return;
 
-    /* find the right link and remove it */
+    /* find the region holding the block */
     while( current )
     {
-        if( current->buffer == buffer )
+        if( (char *)buffer >= (char *)current + PA_REGION_HEADER_SIZE_
+                && (char *)buffer < (char *)current + current->used )
         {
-            if( previous )
-            {
-                previous->next = current->next;
-            }
-            else
+            if( (char *)buffer == (char *)current + current->lastBlock )
+                current->used = current->lastBlock;
+
+            current->liveBlocks -= 1;
+            if( current->liveBlocks == 0 )
             {
-                group->allocations = current->next;
+                if( previous )
+                {
+                    previous->next = current->next;
+                    FreeRegion( current );
+                }
+                else
+                {
+                    current->used = PA_REGION_HEADER_SIZE_;
+                    current->lastBlock = PA_REGION_HEADER_SIZE_;
+                }
             }
 
-            current->buffer = 0;
-            current->next = group->spareLinks;
-            group->spareLinks = current;
-
-            break;
+            return;
         }
 
         previous = current;
         current = current->next;
     }
 
-    PaUtil_FreeMemory( buffer ); /* free the memory whether we found it in the list or not */
+    PaUtil_FreeMemory( buffer ); /* not allocated through the group, free it anyway */
 }
 
 
 void PaUtil_FreeAllAllocations( PaUtilAllocationGroup* group )
 {
-    struct PaUtilAllocationGroupLink *current = group->allocations;
-    struct PaUtilAllocationGroupLink *previous = 0;
+    struct PaUtilAllocationRegion *current = group->regions;
+    struct PaUtilAllocationRegion *next;
 
-    /* free all buffers in the allocations list */
     while( current )
     {
-        PaUtil_FreeMemory( current->buffer );
-        current->buffer = 0;
-
-        previous = current;
-        current = current->next;
+        next = current->next;
+        FreeRegion( current );
+        current = next;
     }
 
-    /* link the former allocations list onto the front of the spareLinks list */
-    if( previous )
-    {
-        previous->next = group->spareLinks;
-        group->spareLinks = group->allocations;
-        group->allocations = 0;
-    }
+    group->regions = 0;
+    group->nextRegionSize = PA_INITIAL_REGION_SIZE_;
 }
-
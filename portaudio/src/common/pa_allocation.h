@@ -47,27 +47,40 @@
 
  An allocation group is useful for keeping track of multiple blocks
  of memory which are allocated at the same time (such as during initialization)
- and need to be deallocated at the same time. The allocation group maintains
- a list of allocated blocks, and can free all allocations at once. This
+ and need to be deallocated at the same time. The allocation group carves its
+ blocks out of a few large regions, and can free all allocations at once. This
  can be useful for cleaning up after a partially initialized object fails.
 
+ Blocks are aligned to PA_ALLOCATION_ALIGNMENT bytes, and blocks allocated one
+ after the other are adjacent in memory. A client which knows how much memory
+ it will need, such as a stream being opened, can reserve it up front with
+ PaUtil_ReserveGroupMemory so that all of its blocks share one region, which
+ may be backed by huge pages and faulted in before it is used.
+
  The allocation group implementation is built on top of the lower
  level allocation functions defined in pa_util.h
 */
 
 
+#include "portaudio.h"
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif /* __cplusplus */
 
 
+/** The alignment, in bytes, of every block allocated through an allocation
+ group. This is the cache line size, and the width of the widest SIMD
+ registers PortAudio's converters may use.
+*/
+#define PA_ALLOCATION_ALIGNMENT     (64)
+
+
 typedef struct
 {
-    long linkCount;
-    struct PaUtilAllocationGroupLink *linkBlocks;
-    struct PaUtilAllocationGroupLink *spareLinks;
-    struct PaUtilAllocationGroupLink *allocations;
+    struct PaUtilAllocationRegion *regions; /* blocks are carved from the first */
+    long nextRegionSize;
 }PaUtilAllocationGroup;
 
 
@@ -80,14 +93,33 @@ PaUtilAllocationGroup* PaUtil_CreateAllocationGroup( void );
 */
 void PaUtil_DestroyAllocationGroup( PaUtilAllocationGroup* group );
 
-/** Allocate a block of memory though an allocation group.
+/** Allocate a block of memory though an allocation group. The block is
+ aligned to PA_ALLOCATION_ALIGNMENT bytes.
 */
 void* PaUtil_GroupAllocateMemory( PaUtilAllocationGroup* group, long size );
 
+/** Reserve one contiguous region for the blocks allocated next through an
+ allocation group.
+
+ @param size The sum of the sizes of the blocks to be allocated.
+ @param blockCount The number of blocks, used to allow for their alignment.
+ @param flags paUtilRegionHugePages and/or paUtilRegionPrefault, see
+ PaUtil_AllocateRegion.
+
+ @return paNoError, or paInsufficientMemory if the region couldn't be
+ allocated. Blocks which don't fit the reservation are allocated as usual.
+*/
+PaError PaUtil_ReserveGroupMemory( PaUtilAllocationGroup* group, long size,
+        int blockCount, unsigned long flags );
+
 /** Free a block of memory that was previously allocated though an allocation
  group. Calling this function is a relatively time consuming operation.
  Under normal circumstances clients should call PaUtil_FreeAllAllocations to
- free all allocated blocks simultaneously.
+ free all allocated blocks simultaneously. Memory is returned to the system
+ once every block of its region has been freed; only freeing the block
+ allocated last lets its space be reused before then. Memory that is
+ replaced over and over, like a device list that is rescanned, should have
+ a group of its own that is freed with PaUtil_FreeAllAllocations.
  @see PaUtil_FreeAllAllocations
 */
 void PaUtil_GroupFreeMemory( PaUtilAllocationGroup* group, void *buffer );
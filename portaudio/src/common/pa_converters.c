@@ -238,6 +238,27 @@ PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
 
 /* -------------------------------------------------------------------------- */
 
+PaUtilConverter* PaUtil_SelectNoiseShapingConverter( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat )
+{
+    if( (sourceFormat & ~paNonInterleaved) != paFloat32 )
+        return 0;
+
+    switch( destinationFormat & ~paNonInterleaved )
+    {
+    case paInt16:
+        return paConverters.Float32_To_Int16_NoiseShaped;
+    case paInt8:
+        return paConverters.Float32_To_Int8_NoiseShaped;
+    case paUInt8:
+        return paConverters.Float32_To_UInt8_NoiseShaped;
+    default:
+        return 0;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
 #ifdef PA_NO_STANDARD_CONVERTERS
 
 /* -------------------------------------------------------------------------- */
@@ -268,6 +289,10 @@ PaUtilConverterTable paConverters = {
     0, /* PaUtilConverter *Float32_To_UInt8_Clip; */
     0, /* PaUtilConverter *Float32_To_UInt8_DitherClip; */
 
+    0, /* PaUtilConverter *Float32_To_Int16_NoiseShaped; */
+    0, /* PaUtilConverter *Float32_To_Int8_NoiseShaped; */
+    0, /* PaUtilConverter *Float32_To_UInt8_NoiseShaped; */
+
     0, /* PaUtilConverter *Int32_To_Float32; */
     0, /* PaUtilConverter *Int32_To_Int24; */
     0, /* PaUtilConverter *Int32_To_Int24_Dither; */
@@ -365,23 +390,31 @@ static void Float32_To_Int32_Dither(
 {
     float *src = (float*)sourceBuffer;
     PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* REVIEW */
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, n );
+
+        for( i=0; i<n; ++i )
+        {
+            /* REVIEW */
 #ifdef PA_USE_C99_LRINTF
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = ((float)*src * (2147483646.0f)) + dither;
-        *dest = lrintf(dithered - 0.5f);
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = ((float)*src * (2147483646.0f)) + dither[i];
+            *dest = lrintf(dithered - 0.5f);
 #else
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
-        *dest = (PaInt32) dithered;
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither[i];
+            *dest = (PaInt32) dithered;
 #endif
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= n;
     }
 }
 
@@ -423,26 +456,34 @@ static void Float32_To_Int32_DitherClip(
 {
     float *src = (float*)sourceBuffer;
     PaInt32 *dest =  (PaInt32*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* REVIEW */
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, n );
+
+        for( i=0; i<n; ++i )
+        {
+            /* REVIEW */
 #ifdef PA_USE_C99_LRINTF
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = ((float)*src * (2147483646.0f)) + dither;
-        PA_CLIP_( dithered, -2147483648.f, 2147483647.f  );
-        *dest = lrintf(dithered-0.5f);
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = ((float)*src * (2147483646.0f)) + dither[i];
+            PA_CLIP_( dithered, -2147483648.f, 2147483647.f  );
+            *dest = lrintf(dithered-0.5f);
 #else
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
-        PA_CLIP_( dithered, -2147483648., 2147483647.  );
-        *dest = (PaInt32) dithered;
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither[i];
+            PA_CLIP_( dithered, -2147483648., 2147483647.  );
+            *dest = (PaInt32) dithered;
 #endif
 
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= n;
     }
 }
 
@@ -490,29 +531,38 @@ static void Float32_To_Int24_Dither(
     float *src = (float*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
     PaInt32 temp;
+    float dither[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* convert to 32 bit and drop the low 8 bits */
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, n );
 
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
+        for( i=0; i<n; ++i )
+        {
+            /* convert to 32 bit and drop the low 8 bits */
 
-        temp = (PaInt32) dithered;
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither[i];
+
+            temp = (PaInt32) dithered;
 
 #if defined(PA_LITTLE_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 8);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 24);
+            dest[0] = (unsigned char)(temp >> 8);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 24);
 #elif defined(PA_BIG_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 24);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 8);
+            dest[0] = (unsigned char)(temp >> 24);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 8);
 #endif
 
-        src += sourceStride;
-        dest += destinationStride * 3;
+            src += sourceStride;
+            dest += destinationStride * 3;
+        }
+
+        count -= n;
     }
 }
 
@@ -561,30 +611,39 @@ static void Float32_To_Int24_DitherClip(
     float *src = (float*)sourceBuffer;
     unsigned char *dest = (unsigned char*)destinationBuffer;
     PaInt32 temp;
+    float dither[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
 
-    while( count-- )
+    while( count > 0 )
     {
-        /* convert to 32 bit and drop the low 8 bits */
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, n );
+
+        for( i=0; i<n; ++i )
+        {
+            /* convert to 32 bit and drop the low 8 bits */
 
-        double dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        double dithered = ((double)*src * (2147483646.0)) + dither;
-        PA_CLIP_( dithered, -2147483648., 2147483647.  );
+            /* use smaller scaler to prevent overflow when we add the dither */
+            double dithered = ((double)*src * (2147483646.0)) + dither[i];
+            PA_CLIP_( dithered, -2147483648., 2147483647.  );
 
-        temp = (PaInt32) dithered;
+            temp = (PaInt32) dithered;
 
 #if defined(PA_LITTLE_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 8);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 24);
+            dest[0] = (unsigned char)(temp >> 8);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 24);
 #elif defined(PA_BIG_ENDIAN)
-        dest[0] = (unsigned char)(temp >> 24);
-        dest[1] = (unsigned char)(temp >> 16);
-        dest[2] = (unsigned char)(temp >> 8);
+            dest[0] = (unsigned char)(temp >> 24);
+            dest[1] = (unsigned char)(temp >> 16);
+            dest[2] = (unsigned char)(temp >> 8);
 #endif
 
-        src += sourceStride;
-        dest += destinationStride * 3;
+            src += sourceStride;
+            dest += destinationStride * 3;
+        }
+
+        count -= n;
     }
 }
 
@@ -623,22 +682,30 @@ static void Float32_To_Int16_Dither(
 {
     float *src = (float*)sourceBuffer;
     PaInt16 *dest = (PaInt16*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
 
-    while( count-- )
+    while( count > 0 )
     {
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, n );
 
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (32766.0f)) + dither;
+        for( i=0; i<n; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (32766.0f)) + dither[i];
 
 #ifdef PA_USE_C99_LRINTF
-        *dest = lrintf(dithered-0.5f);
+            *dest = lrintf(dithered-0.5f);
 #else
-        *dest = (PaInt16) dithered;
+            *dest = (PaInt16) dithered;
 #endif
 
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= n;
     }
 }
 
@@ -677,24 +744,31 @@ static void Float32_To_Int16_DitherClip(
 {
     float *src = (float*)sourceBuffer;
     PaInt16 *dest =  (PaInt16*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    float dither[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
 
-    while( count-- )
+    while( count > 0 )
     {
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, n );
 
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (32766.0f)) + dither;
-        PaInt32 samp = (PaInt32) dithered;
-        PA_CLIP_( samp, -0x8000, 0x7FFF );
+        for( i=0; i<n; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (32766.0f)) + dither[i];
+            PaInt32 samp = (PaInt32) dithered;
+            PA_CLIP_( samp, -0x8000, 0x7FFF );
 #ifdef PA_USE_C99_LRINTF
-        *dest = lrintf(samp-0.5f);
+            *dest = lrintf(samp-0.5f);
 #else
-        *dest = (PaInt16) samp;
+            *dest = (PaInt16) samp;
 #endif
 
-        src += sourceStride;
-        dest += destinationStride;
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= n;
     }
 }
 
@@ -728,17 +802,26 @@ static void Float32_To_Int8_Dither(
 {
     float *src = (float*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
 
-    while( count-- )
+    while( count > 0 )
     {
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (126.0f)) + dither;
-        PaInt32 samp = (PaInt32) dithered;
-        *dest = (signed char) samp;
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, n );
 
-        src += sourceStride;
-        dest += destinationStride;
+        for( i=0; i<n; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (126.0f)) + dither[i];
+            PaInt32 samp = (PaInt32) dithered;
+            *dest = (signed char) samp;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= n;
     }
 }
 
@@ -773,19 +856,27 @@ static void Float32_To_Int8_DitherClip(
 {
     float *src = (float*)sourceBuffer;
     signed char *dest =  (signed char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    float dither[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
 
-    while( count-- )
+    while( count > 0 )
     {
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (126.0f)) + dither;
-        PaInt32 samp = (PaInt32) dithered;
-        PA_CLIP_( samp, -0x80, 0x7F );
-        *dest = (signed char) samp;
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, n );
 
-        src += sourceStride;
-        dest += destinationStride;
+        for( i=0; i<n; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (126.0f)) + dither[i];
+            PaInt32 samp = (PaInt32) dithered;
+            PA_CLIP_( samp, -0x80, 0x7F );
+            *dest = (signed char) samp;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= n;
     }
 }
 
@@ -819,17 +910,26 @@ static void Float32_To_UInt8_Dither(
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest =  (unsigned char*)destinationBuffer;
+    float dither[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
 
-    while( count-- )
+    while( count > 0 )
     {
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (126.0f)) + dither;
-        PaInt32 samp = (PaInt32) dithered;
-        *dest = (unsigned char) (128 + samp);
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, n );
 
-        src += sourceStride;
-        dest += destinationStride;
+        for( i=0; i<n; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (126.0f)) + dither[i];
+            PaInt32 samp = (PaInt32) dithered;
+            *dest = (unsigned char) (128 + samp);
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= n;
     }
 }
 
@@ -864,19 +964,165 @@ static void Float32_To_UInt8_DitherClip(
 {
     float *src = (float*)sourceBuffer;
     unsigned char *dest =  (unsigned char*)destinationBuffer;
-    (void)ditherGenerator; /* unused parameter */
+    float dither[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
 
-    while( count-- )
+    while( count > 0 )
     {
-        float dither  = PaUtil_GenerateFloatTriangularDither( ditherGenerator );
-        /* use smaller scaler to prevent overflow when we add the dither */
-        float dithered = (*src * (126.0f)) + dither;
-        PaInt32 samp = 128 + (PaInt32) dithered;
-        PA_CLIP_( samp, 0x0000, 0x00FF );
-        *dest = (unsigned char) samp;
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        PaUtil_GenerateFloatTriangularDitherBlock( ditherGenerator, dither, n );
+
+        for( i=0; i<n; ++i )
+        {
+            /* use smaller scaler to prevent overflow when we add the dither */
+            float dithered = (*src * (126.0f)) + dither[i];
+            PaInt32 samp = 128 + (PaInt32) dithered;
+            PA_CLIP_( samp, 0x0000, 0x00FF );
+            *dest = (unsigned char) samp;
+
+            src += sourceStride;
+            dest += destinationStride;
+        }
+
+        count -= n;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* The largest error fed back by the noise shapers, in output LSBs. Dither and
+   rounding never exceed 1.5 LSB, so this only limits the error from clipped
+   samples, which could otherwise drive the higher order filters unstable. */
+#define PA_NOISE_SHAPER_MAX_ERROR_   (2.0f)
 
+/* Quantize count samples to integers in [min, max] with noise shaped dither.
+   scale maps full scale float samples to the output word length. */
+static void NoiseShapeFloat32(
+    PaUtilNoiseShaper *shaper, PaInt32 *destination,
+    float *src, signed int sourceStride,
+    unsigned int count, float scale, PaInt32 min, PaInt32 max )
+{
+    float dither[PA_DITHER_BLOCK_SIZE];
+    const float *h = shaper->coefficients;
+    float *e = shaper->error;
+    int order = shaper->order;
+    unsigned int i;
+    int k;
+
+    PaUtil_GenerateFloatTriangularDitherBlock( &shaper->ditherGenerator, dither, count );
+
+    for( i=0; i<count; ++i )
+    {
+        float feedback = 0.0f;
+        float target, dithered, error;
+        PaInt32 quantized;
+
+        for( k=0; k<order; ++k )
+            feedback += h[k] * e[k];
+
+        target = (*src * scale) - feedback;
+        dithered = target + dither[i];
+        PA_CLIP_( dithered, (float)min, (float)max );
+
+        /* round to nearest; the offset keeps the truncated value non-negative */
+        quantized = (PaInt32)(dithered - (float)min + 0.5f) + min;
+
+        error = (float)quantized - target;
+        PA_CLIP_( error, -PA_NOISE_SHAPER_MAX_ERROR_, PA_NOISE_SHAPER_MAX_ERROR_ );
+
+        for( k=order-1; k>0; --k )
+            e[k] = e[k-1];
+        e[0] = error;
+
+        destination[i] = quantized;
         src += sourceStride;
-        dest += destinationStride;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int16_NoiseShaped(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest =  (PaInt16*)destinationBuffer;
+    PaUtilNoiseShaper *shaper = (PaUtilNoiseShaper*)ditherGenerator;
+    PaInt32 samples[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
+
+    while( count > 0 )
+    {
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        NoiseShapeFloat32( shaper, samples, src, sourceStride, n, 32767.0f, -0x8000, 0x7FFF );
+
+        for( i=0; i<n; ++i )
+        {
+            *dest = (PaInt16) samples[i];
+            dest += destinationStride;
+        }
+
+        src += n * sourceStride;
+        count -= n;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_Int8_NoiseShaped(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    signed char *dest =  (signed char*)destinationBuffer;
+    PaUtilNoiseShaper *shaper = (PaUtilNoiseShaper*)ditherGenerator;
+    PaInt32 samples[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
+
+    while( count > 0 )
+    {
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        NoiseShapeFloat32( shaper, samples, src, sourceStride, n, 127.0f, -0x80, 0x7F );
+
+        for( i=0; i<n; ++i )
+        {
+            *dest = (signed char) samples[i];
+            dest += destinationStride;
+        }
+
+        src += n * sourceStride;
+        count -= n;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void Float32_To_UInt8_NoiseShaped(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    unsigned char *dest =  (unsigned char*)destinationBuffer;
+    PaUtilNoiseShaper *shaper = (PaUtilNoiseShaper*)ditherGenerator;
+    PaInt32 samples[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
+
+    while( count > 0 )
+    {
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+        NoiseShapeFloat32( shaper, samples, src, sourceStride, n, 127.0f, -0x80, 0x7F );
+
+        for( i=0; i<n; ++i )
+        {
+            *dest = (unsigned char) (128 + samples[i]);
+            dest += destinationStride;
+        }
+
+        src += n * sourceStride;
+        count -= n;
     }
 }
 
@@ -1803,6 +2049,10 @@ PaUtilConverterTable paConverters = {
     Float32_To_UInt8_Clip,         /* PaUtilConverter *Float32_To_UInt8_Clip; */
     Float32_To_UInt8_DitherClip,   /* PaUtilConverter *Float32_To_UInt8_DitherClip; */
 
+    Float32_To_Int16_NoiseShaped,  /* PaUtilConverter *Float32_To_Int16_NoiseShaped; */
+    Float32_To_Int8_NoiseShaped,   /* PaUtilConverter *Float32_To_Int8_NoiseShaped; */
+    Float32_To_UInt8_NoiseShaped,  /* PaUtilConverter *Float32_To_UInt8_NoiseShaped; */
+
     Int32_To_Float32,              /* PaUtilConverter *Int32_To_Float32; */
     Int32_To_Int24,                /* PaUtilConverter *Int32_To_Int24; */
     Int32_To_Int24_Dither,         /* PaUtilConverter *Int32_To_Int24_Dither; */
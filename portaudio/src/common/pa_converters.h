@@ -108,6 +108,21 @@ PaUtilConverter* PaUtil_SelectConverter( PaSampleFormat sourceFormat,
         PaSampleFormat destinationFormat, PaStreamFlags flags );
 
 
+/** Find a noise shaping converter for the given source and destination
+    formats. Noise shaping converters always clip, and must be passed a
+    pointer to the ditherGenerator member of a PaUtilNoiseShaper which is
+    dedicated to the channel being converted.
+    @return
+    A pointer to a PaUtilConverter, or NULL if noise shaping is not available
+    for the given conversion, in which case PaUtil_SelectConverter() should
+    be used instead. Noise shaping is only provided for conversions from
+    paFloat32 to paInt16, paInt8 and paUInt8.
+    @see PaUtilNoiseShaper
+*/
+PaUtilConverter* PaUtil_SelectNoiseShapingConverter( PaSampleFormat sourceFormat,
+        PaSampleFormat destinationFormat );
+
+
 /** The generic buffer zeroer prototype. Buffer zeroers copy count zeros to
     destinationBuffer. The actual type of the data pointed to varys for
     different zeroer functions.
@@ -161,6 +176,10 @@ typedef struct{
     PaUtilConverter *Float32_To_UInt8_Clip;
     PaUtilConverter *Float32_To_UInt8_DitherClip;
 
+    PaUtilConverter *Float32_To_Int16_NoiseShaped;  /* ditherGenerator is a PaUtilNoiseShaper */
+    PaUtilConverter *Float32_To_Int8_NoiseShaped;   /* ditherGenerator is a PaUtilNoiseShaper */
+    PaUtilConverter *Float32_To_UInt8_NoiseShaped;  /* ditherGenerator is a PaUtilNoiseShaper */
+
     PaUtilConverter *Int32_To_Float32;
     PaUtilConverter *Int32_To_Int24;
     PaUtilConverter *Int32_To_Int24_Dither;
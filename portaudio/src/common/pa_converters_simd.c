@@ -0,0 +1,1210 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library SIMD sample conversion
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief SSE2/SSSE3/AVX2 and NEON converter kernels with run-time dispatch.
+
+ Each kernel produces bit-identical results to its scalar counterpart in
+ pa_converters.c for in-range input, with one exception: a full scale +1.0f
+ sample converted by Float32_To_Int32 scales to 2^31 in single precision,
+ which the kernel clamps to 0x7FFFFFFF while the scalar cast overflows
+ (undefined, and INT_MIN on x86). Out of range input to the non-clipping
+ Float32 to integer converters likewise saturates rather than wrapping.
+
+ The Float32_To_Int16 and Float32_To_Int32 kernels are only installed when
+ PA_USE_C99_LRINTF is not defined, since lrintf() rounds differently from the
+ truncating conversion the kernels implement.
+*/
+
+#include <stdlib.h> /* getenv() */
+#include <string.h>
+
+#include "pa_converters_simd.h"
+#include "pa_converters.h"
+#include "pa_dither.h"
+#include "pa_endianness.h"
+#include "pa_types.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PA_SIMD_X86_
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PA_SIMD_NEON_
+#include <arm_neon.h>
+#endif
+
+/* GCC and clang only allow intrinsics for instruction sets that the function
+   is compiled for, so kernels are tagged individually rather than building the
+   whole file with -mavx2. MSVC accepts the intrinsics unconditionally. */
+#if defined(__GNUC__) || defined(__clang__)
+#define PA_SIMD_TARGET_( isa ) __attribute__((target( isa )))
+#else
+#define PA_SIMD_TARGET_( isa )
+#endif
+
+
+static const float const_1_div_32768_ = 1.0f / 32768.f;
+static const float const_1_div_2147483648_ = 1.0f / 2147483648.f;
+
+
+/* The converters the kernels fall back to for strided buffers and left over
+   frames. Captured from paConverters by PaUtil_InitializeSimdConverters(). */
+static PaUtilConverter *scalarInt32_To_Float32_;
+static PaUtilConverter *scalarInt24_To_Float32_;
+static PaUtilConverter *scalarInt16_To_Float32_;
+static PaUtilConverter *scalarFloat32_To_Int16_;
+static PaUtilConverter *scalarFloat32_To_Int16_Clip_;
+static PaUtilConverter *scalarFloat32_To_Int16_Dither_;
+static PaUtilConverter *scalarFloat32_To_Int16_DitherClip_;
+static PaUtilConverter *scalarFloat32_To_Int32_;
+static PaUtilConverter *scalarFloat32_To_Int32_Clip_;
+
+
+/* Fill seed1 and seed2 with the next PA_DITHER_LANES values of the generator's
+   two random sequences, one per lane. Advancing every lane by
+   PA_DITHER_LCG_LANE_MUL/ADD then yields the following PA_DITHER_LANES values,
+   so the kernels consume exactly the sequence the scalar converters would. */
+static void LoadDitherLanes( const struct PaUtilTriangularDitherGenerator *ditherGenerator,
+        PaUint32 *seed1, PaUint32 *seed2 )
+{
+    PaUint32 s1 = ditherGenerator->randSeed1;
+    PaUint32 s2 = ditherGenerator->randSeed2;
+    int lane;
+
+    for( lane=0; lane<PA_DITHER_LANES; ++lane )
+    {
+        s1 = (s1 * PA_DITHER_LCG_MUL) + PA_DITHER_LCG_ADD;
+        s2 = (s2 * PA_DITHER_LCG_MUL) + PA_DITHER_LCG_ADD;
+        seed1[lane] = s1;
+        seed2[lane] = s2;
+    }
+}
+
+
+#if defined(PA_SIMD_X86_)
+
+/* -------------------------------------------------------------------------- */
+
+PA_SIMD_TARGET_( "sse2" )
+static void Int32_To_Float32_Sse2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        const __m128 scale = _mm_set1_ps( const_1_div_2147483648_ );
+
+        for( ; done + 4 <= count; done += 4 )
+        {
+            __m128i s = _mm_loadu_si128( (const __m128i*)(src + done) );
+            _mm_storeu_ps( dest + done, _mm_mul_ps( _mm_cvtepi32_ps( s ), scale ) );
+        }
+    }
+
+    if( done < count )
+        scalarInt32_To_Float32_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+PA_SIMD_TARGET_( "avx2" )
+static void Int32_To_Float32_Avx2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        const __m256 scale = _mm256_set1_ps( const_1_div_2147483648_ );
+
+        for( ; done + 8 <= count; done += 8 )
+        {
+            __m256i s = _mm256_loadu_si256( (const __m256i*)(src + done) );
+            _mm256_storeu_ps( dest + done, _mm256_mul_ps( _mm256_cvtepi32_ps( s ), scale ) );
+        }
+    }
+
+    if( done < count )
+        scalarInt32_To_Float32_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(PA_LITTLE_ENDIAN)
+
+/* moves the three bytes of each packed 24 bit sample into the top of a 32 bit
+   lane, leaving the low byte zero */
+#define PA_INT24_SHUFFLE_ \
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11
+
+PA_SIMD_TARGET_( "ssse3" )
+static void Int24_To_Float32_Ssse3(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        const __m128i shuffle = _mm_setr_epi8( PA_INT24_SHUFFLE_ );
+        const __m128 scale = _mm_set1_ps( const_1_div_2147483648_ );
+
+        /* each iteration loads 16 bytes but only consumes 12, so stop while
+           there are still two samples of slack beyond the last one converted */
+        for( ; done + 6 <= count; done += 4 )
+        {
+            __m128i s = _mm_loadu_si128( (const __m128i*)(src + done * 3) );
+            s = _mm_shuffle_epi8( s, shuffle );
+            _mm_storeu_ps( dest + done, _mm_mul_ps( _mm_cvtepi32_ps( s ), scale ) );
+        }
+    }
+
+    if( done < count )
+        scalarInt24_To_Float32_( dest + done, destinationStride,
+                src + done * 3, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+PA_SIMD_TARGET_( "avx2" )
+static void Int24_To_Float32_Avx2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        const __m256i shuffle = _mm256_setr_epi8( PA_INT24_SHUFFLE_, PA_INT24_SHUFFLE_ );
+        const __m256 scale = _mm256_set1_ps( const_1_div_2147483648_ );
+
+        /* the upper lane is loaded from byte 12, reading 4 bytes past the
+           eighth sample */
+        for( ; done + 10 <= count; done += 8 )
+        {
+            const unsigned char *p = src + done * 3;
+            __m256i s = _mm256_castsi128_si256( _mm_loadu_si128( (const __m128i*)p ) );
+            s = _mm256_inserti128_si256( s, _mm_loadu_si128( (const __m128i*)(p + 12) ), 1 );
+            s = _mm256_shuffle_epi8( s, shuffle );
+            _mm256_storeu_ps( dest + done, _mm256_mul_ps( _mm256_cvtepi32_ps( s ), scale ) );
+        }
+    }
+
+    if( done < count )
+        scalarInt24_To_Float32_( dest + done, destinationStride,
+                src + done * 3, sourceStride, count - done, ditherGenerator );
+}
+
+#endif /* PA_LITTLE_ENDIAN */
+
+/* -------------------------------------------------------------------------- */
+
+PA_SIMD_TARGET_( "sse2" )
+static void Int16_To_Float32_Sse2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        const __m128 scale = _mm_set1_ps( const_1_div_32768_ );
+
+        for( ; done + 8 <= count; done += 8 )
+        {
+            __m128i s = _mm_loadu_si128( (const __m128i*)(src + done) );
+            /* sign extend by placing each sample in the top half of a lane */
+            __m128i lo = _mm_srai_epi32( _mm_unpacklo_epi16( s, s ), 16 );
+            __m128i hi = _mm_srai_epi32( _mm_unpackhi_epi16( s, s ), 16 );
+            _mm_storeu_ps( dest + done, _mm_mul_ps( _mm_cvtepi32_ps( lo ), scale ) );
+            _mm_storeu_ps( dest + done + 4, _mm_mul_ps( _mm_cvtepi32_ps( hi ), scale ) );
+        }
+    }
+
+    if( done < count )
+        scalarInt16_To_Float32_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+PA_SIMD_TARGET_( "avx2" )
+static void Int16_To_Float32_Avx2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        const __m256 scale = _mm256_set1_ps( const_1_div_32768_ );
+
+        for( ; done + 8 <= count; done += 8 )
+        {
+            __m256i s = _mm256_cvtepi16_epi32( _mm_loadu_si128( (const __m128i*)(src + done) ) );
+            _mm256_storeu_ps( dest + done, _mm256_mul_ps( _mm256_cvtepi32_ps( s ), scale ) );
+        }
+    }
+
+    if( done < count )
+        scalarInt16_To_Float32_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+#if !defined(PA_USE_C99_LRINTF)
+
+/* Float32_To_Int16 and Float32_To_Int16_Clip differ only in their fallback:
+   the truncating conversion and saturating pack already clip. */
+
+PA_SIMD_TARGET_( "sse2" )
+static unsigned int Float32_To_Int16_Sse2Kernel(
+    PaInt16 *dest, const float *src, unsigned int count )
+{
+    const __m128 scale = _mm_set1_ps( 32767.0f );
+    unsigned int done = 0;
+
+    for( ; done + 8 <= count; done += 8 )
+    {
+        __m128i lo = _mm_cvttps_epi32( _mm_mul_ps( _mm_loadu_ps( src + done ), scale ) );
+        __m128i hi = _mm_cvttps_epi32( _mm_mul_ps( _mm_loadu_ps( src + done + 4 ), scale ) );
+        _mm_storeu_si128( (__m128i*)(dest + done), _mm_packs_epi32( lo, hi ) );
+    }
+
+    return done;
+}
+
+PA_SIMD_TARGET_( "sse2" )
+static void Float32_To_Int16_Sse2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_Sse2Kernel( dest, src, count );
+
+    if( done < count )
+        scalarFloat32_To_Int16_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+PA_SIMD_TARGET_( "sse2" )
+static void Float32_To_Int16_Clip_Sse2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_Sse2Kernel( dest, src, count );
+
+    if( done < count )
+        scalarFloat32_To_Int16_Clip_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+PA_SIMD_TARGET_( "avx2" )
+static unsigned int Float32_To_Int16_Avx2Kernel(
+    PaInt16 *dest, const float *src, unsigned int count )
+{
+    const __m256 scale = _mm256_set1_ps( 32767.0f );
+    unsigned int done = 0;
+
+    for( ; done + 16 <= count; done += 16 )
+    {
+        __m256i lo = _mm256_cvttps_epi32( _mm256_mul_ps( _mm256_loadu_ps( src + done ), scale ) );
+        __m256i hi = _mm256_cvttps_epi32( _mm256_mul_ps( _mm256_loadu_ps( src + done + 8 ), scale ) );
+        /* packs works within 128 bit lanes, so restore sample order afterwards */
+        __m256i packed = _mm256_permute4x64_epi64( _mm256_packs_epi32( lo, hi ), 0xD8 );
+        _mm256_storeu_si256( (__m256i*)(dest + done), packed );
+    }
+
+    return done;
+}
+
+PA_SIMD_TARGET_( "avx2" )
+static void Float32_To_Int16_Avx2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_Avx2Kernel( dest, src, count );
+
+    if( done < count )
+        scalarFloat32_To_Int16_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+PA_SIMD_TARGET_( "avx2" )
+static void Float32_To_Int16_Clip_Avx2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_Avx2Kernel( dest, src, count );
+
+    if( done < count )
+        scalarFloat32_To_Int16_Clip_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* The dithered converters run the dither generator's lanes in vector
+   registers alongside the conversion. The dither sequence is the same one the
+   scalar converters would have consumed, and Dither and DitherClip again
+   differ only in their fallback. */
+
+/* SSE2 has no 32 bit low multiply, so build one from the even and odd lane
+   64 bit products */
+PA_SIMD_TARGET_( "sse2" )
+static __m128i MulLo32_Sse2( __m128i a, __m128i b )
+{
+    __m128i even = _mm_mul_epu32( a, b );
+    __m128i odd = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+    return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ),
+            _mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+
+PA_SIMD_TARGET_( "sse2" )
+static unsigned int Float32_To_Int16_Dither_Sse2Kernel(
+    PaInt16 *dest, const float *src, unsigned int count,
+    struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    const __m128 scale = _mm_set1_ps( 32766.0f );
+    const __m128 ditherScale = _mm_set1_ps( PA_DITHER_FLOAT_SCALE );
+    const __m128i laneMul = _mm_set1_epi32( (int)PA_DITHER_LCG_LANE_MUL );
+    const __m128i laneAdd = _mm_set1_epi32( (int)PA_DITHER_LCG_LANE_ADD );
+    PaUint32 seed1[PA_DITHER_LANES], seed2[PA_DITHER_LANES];
+    __m128i s1lo, s1hi, s2lo, s2hi, prevHi;
+    unsigned int done = 0;
+
+    if( count < PA_DITHER_LANES )
+        return 0;
+
+    /* the eight lanes are held as a low and a high half */
+    LoadDitherLanes( ditherGenerator, seed1, seed2 );
+    s1lo = _mm_loadu_si128( (const __m128i*)seed1 );
+    s1hi = _mm_loadu_si128( (const __m128i*)(seed1 + 4) );
+    s2lo = _mm_loadu_si128( (const __m128i*)seed2 );
+    s2hi = _mm_loadu_si128( (const __m128i*)(seed2 + 4) );
+    prevHi = _mm_setr_epi32( 0, 0, 0, (int)ditherGenerator->previous );
+
+    for( ;; )
+    {
+        __m128i lo = _mm_add_epi32( _mm_srai_epi32( s1lo, PA_DITHER_SHIFT ), _mm_srai_epi32( s2lo, PA_DITHER_SHIFT ) );
+        __m128i hi = _mm_add_epi32( _mm_srai_epi32( s1hi, PA_DITHER_SHIFT ), _mm_srai_epi32( s2hi, PA_DITHER_SHIFT ) );
+        /* high pass filter: subtract each lane's predecessor in sample order */
+        __m128i hpLo = _mm_sub_epi32( lo, _mm_or_si128( _mm_slli_si128( lo, 4 ), _mm_srli_si128( prevHi, 12 ) ) );
+        __m128i hpHi = _mm_sub_epi32( hi, _mm_or_si128( _mm_slli_si128( hi, 4 ), _mm_srli_si128( lo, 12 ) ) );
+        __m128 a = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( src + done ), scale ),
+                _mm_mul_ps( _mm_cvtepi32_ps( hpLo ), ditherScale ) );
+        __m128 b = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( src + done + 4 ), scale ),
+                _mm_mul_ps( _mm_cvtepi32_ps( hpHi ), ditherScale ) );
+        _mm_storeu_si128( (__m128i*)(dest + done),
+                _mm_packs_epi32( _mm_cvttps_epi32( a ), _mm_cvttps_epi32( b ) ) );
+
+        done += PA_DITHER_LANES;
+        prevHi = hi;
+
+        if( count - done < PA_DITHER_LANES )
+        {
+            /* the last lane holds the most recent value of the serial sequence */
+            ditherGenerator->randSeed1 = (PaUint32)_mm_cvtsi128_si32( _mm_srli_si128( s1hi, 12 ) );
+            ditherGenerator->randSeed2 = (PaUint32)_mm_cvtsi128_si32( _mm_srli_si128( s2hi, 12 ) );
+            ditherGenerator->previous = (PaUint32)_mm_cvtsi128_si32( _mm_srli_si128( hi, 12 ) );
+            break;
+        }
+
+        s1lo = _mm_add_epi32( MulLo32_Sse2( s1lo, laneMul ), laneAdd );
+        s1hi = _mm_add_epi32( MulLo32_Sse2( s1hi, laneMul ), laneAdd );
+        s2lo = _mm_add_epi32( MulLo32_Sse2( s2lo, laneMul ), laneAdd );
+        s2hi = _mm_add_epi32( MulLo32_Sse2( s2hi, laneMul ), laneAdd );
+    }
+
+    return done;
+}
+
+PA_SIMD_TARGET_( "sse2" )
+static void Float32_To_Int16_Dither_Sse2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_Dither_Sse2Kernel( dest, src, count, ditherGenerator );
+
+    if( done < count )
+        scalarFloat32_To_Int16_Dither_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+PA_SIMD_TARGET_( "sse2" )
+static void Float32_To_Int16_DitherClip_Sse2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_Dither_Sse2Kernel( dest, src, count, ditherGenerator );
+
+    if( done < count )
+        scalarFloat32_To_Int16_DitherClip_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+/* Convert one group of PA_DITHER_LANES samples with the dither from seed1 and
+   seed2. previous carries the last dither value of the preceding group in
+   lane 0 and is updated for the next group. Returns the unfiltered values. */
+PA_SIMD_TARGET_( "avx2" )
+static __m256i Float32_To_Int16_Dither_Avx2Group(
+    PaInt16 *dest, const float *src, __m256i seed1, __m256i seed2, __m256i *previous )
+{
+    const __m256 scale = _mm256_set1_ps( 32766.0f );
+    const __m256 ditherScale = _mm256_set1_ps( PA_DITHER_FLOAT_SCALE );
+    const __m256i rotate = _mm256_setr_epi32( 7, 0, 1, 2, 3, 4, 5, 6 );
+
+    __m256i current = _mm256_add_epi32( _mm256_srai_epi32( seed1, PA_DITHER_SHIFT ),
+            _mm256_srai_epi32( seed2, PA_DITHER_SHIFT ) );
+    /* high pass filter: subtract each lane's predecessor in sample order */
+    __m256i rotated = _mm256_permutevar8x32_epi32( current, rotate );
+    __m256i highPass = _mm256_sub_epi32( current, _mm256_blend_epi32( rotated, *previous, 0x01 ) );
+    __m256 dithered = _mm256_add_ps( _mm256_mul_ps( _mm256_loadu_ps( src ), scale ),
+            _mm256_mul_ps( _mm256_cvtepi32_ps( highPass ), ditherScale ) );
+    __m256i samples = _mm256_cvttps_epi32( dithered );
+    _mm_storeu_si128( (__m128i*)dest, _mm_packs_epi32(
+            _mm256_castsi256_si128( samples ), _mm256_extracti128_si256( samples, 1 ) ) );
+
+    *previous = rotated;
+    return current;
+}
+
+/* Two groups of lanes are kept in flight, each advancing two groups at a time,
+   so that their multiplies overlap. */
+PA_SIMD_TARGET_( "avx2" )
+static unsigned int Float32_To_Int16_Dither_Avx2Kernel(
+    PaInt16 *dest, const float *src, unsigned int count,
+    struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    const __m256i laneMul = _mm256_set1_epi32( (int)PA_DITHER_LCG_LANE_MUL );
+    const __m256i laneAdd = _mm256_set1_epi32( (int)PA_DITHER_LCG_LANE_ADD );
+    const __m256i pairMul = _mm256_set1_epi32( (int)(PA_DITHER_LCG_LANE_MUL * PA_DITHER_LCG_LANE_MUL) );
+    const __m256i pairAdd = _mm256_set1_epi32(
+            (int)(PA_DITHER_LCG_LANE_ADD * PA_DITHER_LCG_LANE_MUL + PA_DITHER_LCG_LANE_ADD) );
+    PaUint32 seed1[PA_DITHER_LANES], seed2[PA_DITHER_LANES];
+    __m256i s1a, s2a, s1b, s2b, current, previous;
+    unsigned int done = 0;
+
+    if( count < PA_DITHER_LANES )
+        return 0;
+
+    LoadDitherLanes( ditherGenerator, seed1, seed2 );
+    s1a = _mm256_loadu_si256( (const __m256i*)seed1 );
+    s2a = _mm256_loadu_si256( (const __m256i*)seed2 );
+    s1b = _mm256_add_epi32( _mm256_mullo_epi32( s1a, laneMul ), laneAdd );
+    s2b = _mm256_add_epi32( _mm256_mullo_epi32( s2a, laneMul ), laneAdd );
+    previous = _mm256_set1_epi32( (int)ditherGenerator->previous );
+
+    for( ;; )
+    {
+        current = Float32_To_Int16_Dither_Avx2Group( dest + done, src + done, s1a, s2a, &previous );
+        done += PA_DITHER_LANES;
+        if( count - done < PA_DITHER_LANES )
+            break;
+
+        current = Float32_To_Int16_Dither_Avx2Group( dest + done, src + done, s1b, s2b, &previous );
+        done += PA_DITHER_LANES;
+        if( count - done < PA_DITHER_LANES )
+        {
+            s1a = s1b;
+            s2a = s2b;
+            break;
+        }
+
+        s1a = _mm256_add_epi32( _mm256_mullo_epi32( s1a, pairMul ), pairAdd );
+        s2a = _mm256_add_epi32( _mm256_mullo_epi32( s2a, pairMul ), pairAdd );
+        s1b = _mm256_add_epi32( _mm256_mullo_epi32( s1b, pairMul ), pairAdd );
+        s2b = _mm256_add_epi32( _mm256_mullo_epi32( s2b, pairMul ), pairAdd );
+    }
+
+    /* the last lane of the last group used holds the most recent value of the
+       serial sequence */
+    ditherGenerator->randSeed1 = (PaUint32)_mm256_extract_epi32( s1a, 7 );
+    ditherGenerator->randSeed2 = (PaUint32)_mm256_extract_epi32( s2a, 7 );
+    ditherGenerator->previous = (PaUint32)_mm256_extract_epi32( current, 7 );
+
+    return done;
+}
+
+PA_SIMD_TARGET_( "avx2" )
+static void Float32_To_Int16_Dither_Avx2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_Dither_Avx2Kernel( dest, src, count, ditherGenerator );
+
+    if( done < count )
+        scalarFloat32_To_Int16_Dither_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+PA_SIMD_TARGET_( "avx2" )
+static void Float32_To_Int16_DitherClip_Avx2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_Dither_Avx2Kernel( dest, src, count, ditherGenerator );
+
+    if( done < count )
+        scalarFloat32_To_Int16_DitherClip_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+/* -------------------------------------------------------------------------- */
+
+/* As in the scalar version the scaling happens in single precision (where
+   0x7FFFFFFF rounds to 2^31) and only the clipping in double precision, so
+   that full scale clips to 0x7FFFFFFF rather than overflowing. */
+
+PA_SIMD_TARGET_( "sse2" )
+static unsigned int Float32_To_Int32_Sse2Kernel(
+    PaInt32 *dest, const float *src, unsigned int count )
+{
+    const __m128 scale = _mm_set1_ps( (float) 0x7FFFFFFF );
+    const __m128d min = _mm_set1_pd( -2147483648. );
+    const __m128d max = _mm_set1_pd( 2147483647. );
+    unsigned int done = 0;
+
+    for( ; done + 4 <= count; done += 4 )
+    {
+        __m128 s = _mm_mul_ps( _mm_loadu_ps( src + done ), scale );
+        __m128d lo = _mm_cvtps_pd( s );
+        __m128d hi = _mm_cvtps_pd( _mm_movehl_ps( s, s ) );
+        lo = _mm_min_pd( _mm_max_pd( lo, min ), max );
+        hi = _mm_min_pd( _mm_max_pd( hi, min ), max );
+        _mm_storeu_si128( (__m128i*)(dest + done),
+                _mm_unpacklo_epi64( _mm_cvttpd_epi32( lo ), _mm_cvttpd_epi32( hi ) ) );
+    }
+
+    return done;
+}
+
+PA_SIMD_TARGET_( "sse2" )
+static void Float32_To_Int32_Sse2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int32_Sse2Kernel( dest, src, count );
+
+    if( done < count )
+        scalarFloat32_To_Int32_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+PA_SIMD_TARGET_( "sse2" )
+static void Float32_To_Int32_Clip_Sse2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int32_Sse2Kernel( dest, src, count );
+
+    if( done < count )
+        scalarFloat32_To_Int32_Clip_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+PA_SIMD_TARGET_( "avx2" )
+static unsigned int Float32_To_Int32_Avx2Kernel(
+    PaInt32 *dest, const float *src, unsigned int count )
+{
+    const __m256 scale = _mm256_set1_ps( (float) 0x7FFFFFFF );
+    const __m256d min = _mm256_set1_pd( -2147483648. );
+    const __m256d max = _mm256_set1_pd( 2147483647. );
+    unsigned int done = 0;
+
+    for( ; done + 8 <= count; done += 8 )
+    {
+        __m256 s = _mm256_mul_ps( _mm256_loadu_ps( src + done ), scale );
+        __m256d lo = _mm256_cvtps_pd( _mm256_castps256_ps128( s ) );
+        __m256d hi = _mm256_cvtps_pd( _mm256_extractf128_ps( s, 1 ) );
+        lo = _mm256_min_pd( _mm256_max_pd( lo, min ), max );
+        hi = _mm256_min_pd( _mm256_max_pd( hi, min ), max );
+        _mm_storeu_si128( (__m128i*)(dest + done), _mm256_cvttpd_epi32( lo ) );
+        _mm_storeu_si128( (__m128i*)(dest + done + 4), _mm256_cvttpd_epi32( hi ) );
+    }
+
+    return done;
+}
+
+PA_SIMD_TARGET_( "avx2" )
+static void Float32_To_Int32_Avx2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int32_Avx2Kernel( dest, src, count );
+
+    if( done < count )
+        scalarFloat32_To_Int32_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+PA_SIMD_TARGET_( "avx2" )
+static void Float32_To_Int32_Clip_Avx2(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt32 *dest = (PaInt32*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int32_Avx2Kernel( dest, src, count );
+
+    if( done < count )
+        scalarFloat32_To_Int32_Clip_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+#endif /* !PA_USE_C99_LRINTF */
+
+/* -------------------------------------------------------------------------- */
+
+static unsigned int DetectSimdCapabilities( void )
+{
+    unsigned int result = 0;
+
+#if defined(_MSC_VER)
+    int info[4];
+
+    __cpuid( info, 1 );
+    if( info[3] & (1 << 26) )
+        result |= paUtilSimdSse2;
+    if( info[2] & (1 << 9) )
+        result |= paUtilSimdSsse3;
+
+    /* AVX2 also requires the OS to save the upper halves of the ymm registers */
+    if( (info[2] & (1 << 27)) && (_xgetbv( 0 ) & 0x6) == 0x6 )
+    {
+        __cpuidex( info, 7, 0 );
+        if( info[1] & (1 << 5) )
+            result |= paUtilSimdAvx2;
+    }
+#else
+    /* __builtin_cpu_supports() checks OS support for the wider registers */
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "sse2" ) )
+        result |= paUtilSimdSse2;
+    if( __builtin_cpu_supports( "ssse3" ) )
+        result |= paUtilSimdSsse3;
+    if( __builtin_cpu_supports( "avx2" ) )
+        result |= paUtilSimdAvx2;
+#endif
+
+    return result;
+}
+
+#elif defined(PA_SIMD_NEON_)
+
+/* -------------------------------------------------------------------------- */
+
+static void Int32_To_Float32_Neon(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt32 *src = (PaInt32*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; done + 4 <= count; done += 4 )
+        {
+            float32x4_t f = vcvtq_f32_s32( vld1q_s32( (const int32_t*)(src + done) ) );
+            vst1q_f32( dest + done, vmulq_n_f32( f, const_1_div_2147483648_ ) );
+        }
+    }
+
+    if( done < count )
+        scalarInt32_To_Float32_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(PA_LITTLE_ENDIAN)
+
+static void Int24_To_Float32_Neon(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    unsigned char *src = (unsigned char*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        const uint8x16_t zero = vdupq_n_u8( 0 );
+
+        for( ; done + 16 <= count; done += 16 )
+        {
+            /* de-interleave the three bytes of 16 samples, then zip them back
+               together as (0, b0, b1, b2) 32 bit words */
+            uint8x16x3_t b = vld3q_u8( src + done * 3 );
+            uint8x16x2_t low = vzipq_u8( zero, b.val[0] );
+            uint8x16x2_t high = vzipq_u8( b.val[1], b.val[2] );
+            int i;
+
+            for( i=0; i<2; ++i )
+            {
+                uint16x8x2_t w = vzipq_u16( vreinterpretq_u16_u8( low.val[i] ),
+                        vreinterpretq_u16_u8( high.val[i] ) );
+                float32x4_t f0 = vcvtq_f32_s32( vreinterpretq_s32_u16( w.val[0] ) );
+                float32x4_t f1 = vcvtq_f32_s32( vreinterpretq_s32_u16( w.val[1] ) );
+                vst1q_f32( dest + done + i * 8, vmulq_n_f32( f0, const_1_div_2147483648_ ) );
+                vst1q_f32( dest + done + i * 8 + 4, vmulq_n_f32( f1, const_1_div_2147483648_ ) );
+            }
+        }
+    }
+
+    if( done < count )
+        scalarInt24_To_Float32_( dest + done, destinationStride,
+                src + done * 3, sourceStride, count - done, ditherGenerator );
+}
+
+#endif /* PA_LITTLE_ENDIAN */
+
+/* -------------------------------------------------------------------------- */
+
+static void Int16_To_Float32_Neon(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    PaInt16 *src = (PaInt16*)sourceBuffer;
+    float *dest = (float*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+    {
+        for( ; done + 4 <= count; done += 4 )
+        {
+            int32x4_t s = vmovl_s16( vld1_s16( (const int16_t*)(src + done) ) );
+            vst1q_f32( dest + done, vmulq_n_f32( vcvtq_f32_s32( s ), const_1_div_32768_ ) );
+        }
+    }
+
+    if( done < count )
+        scalarInt16_To_Float32_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+#if !defined(PA_USE_C99_LRINTF)
+
+static unsigned int Float32_To_Int16_NeonKernel(
+    PaInt16 *dest, const float *src, unsigned int count )
+{
+    unsigned int done = 0;
+
+    for( ; done + 8 <= count; done += 8 )
+    {
+        /* vcvtq truncates towards zero, vqmovn saturates */
+        int32x4_t lo = vcvtq_s32_f32( vmulq_n_f32( vld1q_f32( src + done ), 32767.0f ) );
+        int32x4_t hi = vcvtq_s32_f32( vmulq_n_f32( vld1q_f32( src + done + 4 ), 32767.0f ) );
+        vst1q_s16( (int16_t*)(dest + done), vcombine_s16( vqmovn_s32( lo ), vqmovn_s32( hi ) ) );
+    }
+
+    return done;
+}
+
+static void Float32_To_Int16_Neon(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_NeonKernel( dest, src, count );
+
+    if( done < count )
+        scalarFloat32_To_Int16_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+static void Float32_To_Int16_Clip_Neon(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_NeonKernel( dest, src, count );
+
+    if( done < count )
+        scalarFloat32_To_Int16_Clip_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+/* -------------------------------------------------------------------------- */
+
+static unsigned int Float32_To_Int16_Dither_NeonKernel(
+    PaInt16 *dest, const float *src, unsigned int count,
+    struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    const uint32x4_t laneMul = vdupq_n_u32( PA_DITHER_LCG_LANE_MUL );
+    const uint32x4_t laneAdd = vdupq_n_u32( PA_DITHER_LCG_LANE_ADD );
+    PaUint32 seed1[PA_DITHER_LANES], seed2[PA_DITHER_LANES];
+    uint32x4_t s1lo, s1hi, s2lo, s2hi;
+    int32x4_t prevHi;
+    unsigned int done = 0;
+
+    if( count < PA_DITHER_LANES )
+        return 0;
+
+    LoadDitherLanes( ditherGenerator, seed1, seed2 );
+    s1lo = vld1q_u32( (const uint32_t*)seed1 );
+    s1hi = vld1q_u32( (const uint32_t*)(seed1 + 4) );
+    s2lo = vld1q_u32( (const uint32_t*)seed2 );
+    s2hi = vld1q_u32( (const uint32_t*)(seed2 + 4) );
+    prevHi = vdupq_n_s32( (int32_t)ditherGenerator->previous );
+
+    for( ;; )
+    {
+        int32x4_t lo = vaddq_s32( vshrq_n_s32( vreinterpretq_s32_u32( s1lo ), PA_DITHER_SHIFT ),
+                vshrq_n_s32( vreinterpretq_s32_u32( s2lo ), PA_DITHER_SHIFT ) );
+        int32x4_t hi = vaddq_s32( vshrq_n_s32( vreinterpretq_s32_u32( s1hi ), PA_DITHER_SHIFT ),
+                vshrq_n_s32( vreinterpretq_s32_u32( s2hi ), PA_DITHER_SHIFT ) );
+        /* high pass filter: vextq shifts in the predecessor of each lane */
+        int32x4_t hpLo = vsubq_s32( lo, vextq_s32( prevHi, lo, 3 ) );
+        int32x4_t hpHi = vsubq_s32( hi, vextq_s32( lo, hi, 3 ) );
+        float32x4_t a = vaddq_f32( vmulq_n_f32( vld1q_f32( src + done ), 32766.0f ),
+                vmulq_n_f32( vcvtq_f32_s32( hpLo ), PA_DITHER_FLOAT_SCALE ) );
+        float32x4_t b = vaddq_f32( vmulq_n_f32( vld1q_f32( src + done + 4 ), 32766.0f ),
+                vmulq_n_f32( vcvtq_f32_s32( hpHi ), PA_DITHER_FLOAT_SCALE ) );
+        vst1q_s16( (int16_t*)(dest + done), vcombine_s16(
+                vqmovn_s32( vcvtq_s32_f32( a ) ), vqmovn_s32( vcvtq_s32_f32( b ) ) ) );
+
+        done += PA_DITHER_LANES;
+        prevHi = hi;
+
+        if( count - done < PA_DITHER_LANES )
+        {
+            ditherGenerator->randSeed1 = vgetq_lane_u32( s1hi, 3 );
+            ditherGenerator->randSeed2 = vgetq_lane_u32( s2hi, 3 );
+            ditherGenerator->previous = (PaUint32)vgetq_lane_s32( hi, 3 );
+            break;
+        }
+
+        s1lo = vmlaq_u32( laneAdd, s1lo, laneMul );
+        s1hi = vmlaq_u32( laneAdd, s1hi, laneMul );
+        s2lo = vmlaq_u32( laneAdd, s2lo, laneMul );
+        s2hi = vmlaq_u32( laneAdd, s2hi, laneMul );
+    }
+
+    return done;
+}
+
+static void Float32_To_Int16_Dither_Neon(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_Dither_NeonKernel( dest, src, count, ditherGenerator );
+
+    if( done < count )
+        scalarFloat32_To_Int16_Dither_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+static void Float32_To_Int16_DitherClip_Neon(
+    void *destinationBuffer, signed int destinationStride,
+    void *sourceBuffer, signed int sourceStride,
+    unsigned int count, struct PaUtilTriangularDitherGenerator *ditherGenerator )
+{
+    float *src = (float*)sourceBuffer;
+    PaInt16 *dest = (PaInt16*)destinationBuffer;
+    unsigned int done = 0;
+
+    if( sourceStride == 1 && destinationStride == 1 )
+        done = Float32_To_Int16_Dither_NeonKernel( dest, src, count, ditherGenerator );
+
+    if( done < count )
+        scalarFloat32_To_Int16_DitherClip_( dest + done, destinationStride,
+                src + done, sourceStride, count - done, ditherGenerator );
+}
+
+#endif /* !PA_USE_C99_LRINTF */
+
+static unsigned int DetectSimdCapabilities( void )
+{
+    /* NEON is part of the baseline wherever __ARM_NEON is defined */
+    return paUtilSimdNeon;
+}
+
+#else /* no SIMD support for this architecture */
+
+static unsigned int DetectSimdCapabilities( void )
+{
+    return 0;
+}
+
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+/* Clear capabilities above the level named by the PA_SIMD environment
+   variable. An unrecognised name leaves the capabilities unchanged. */
+static unsigned int ApplySimdLimit( unsigned int capabilities )
+{
+    const char *limit = getenv( "PA_SIMD" );
+
+    if( limit == NULL )
+        return capabilities;
+
+    if( strcmp( limit, "none" ) == 0 )
+        return 0;
+    else if( strcmp( limit, "sse2" ) == 0 )
+        return capabilities & paUtilSimdSse2;
+    else if( strcmp( limit, "ssse3" ) == 0 )
+        return capabilities & (paUtilSimdSse2 | paUtilSimdSsse3);
+    else if( strcmp( limit, "avx2" ) == 0 )
+        return capabilities & (paUtilSimdSse2 | paUtilSimdSsse3 | paUtilSimdAvx2);
+    else if( strcmp( limit, "neon" ) == 0 )
+        return capabilities & paUtilSimdNeon;
+
+    return capabilities;
+}
+
+
+static int simdCapabilitiesDetected_ = 0;
+static unsigned int simdCapabilities_ = 0;
+
+unsigned int PaUtil_GetSimdCapabilities( void )
+{
+    if( !simdCapabilitiesDetected_ )
+    {
+        simdCapabilities_ = ApplySimdLimit( DetectSimdCapabilities() );
+        simdCapabilitiesDetected_ = 1;
+    }
+
+    return simdCapabilities_;
+}
+
+
+static int simdConvertersInstalled_ = 0;
+
+void PaUtil_InitializeSimdConverters( void )
+{
+    unsigned int capabilities;
+
+    /* installing twice would make the kernels fall back to themselves */
+    if( simdConvertersInstalled_ )
+        return;
+    simdConvertersInstalled_ = 1;
+
+    capabilities = PaUtil_GetSimdCapabilities();
+
+    scalarInt32_To_Float32_ = paConverters.Int32_To_Float32;
+    scalarInt24_To_Float32_ = paConverters.Int24_To_Float32;
+    scalarInt16_To_Float32_ = paConverters.Int16_To_Float32;
+    scalarFloat32_To_Int16_ = paConverters.Float32_To_Int16;
+    scalarFloat32_To_Int16_Clip_ = paConverters.Float32_To_Int16_Clip;
+    scalarFloat32_To_Int16_Dither_ = paConverters.Float32_To_Int16_Dither;
+    scalarFloat32_To_Int16_DitherClip_ = paConverters.Float32_To_Int16_DitherClip;
+    scalarFloat32_To_Int32_ = paConverters.Float32_To_Int32;
+    scalarFloat32_To_Int32_Clip_ = paConverters.Float32_To_Int32_Clip;
+
+#if defined(PA_SIMD_X86_)
+    if( capabilities & paUtilSimdAvx2 )
+    {
+        paConverters.Int32_To_Float32 = Int32_To_Float32_Avx2;
+#if defined(PA_LITTLE_ENDIAN)
+        paConverters.Int24_To_Float32 = Int24_To_Float32_Avx2;
+#endif
+        paConverters.Int16_To_Float32 = Int16_To_Float32_Avx2;
+#if !defined(PA_USE_C99_LRINTF)
+        paConverters.Float32_To_Int16 = Float32_To_Int16_Avx2;
+        paConverters.Float32_To_Int16_Clip = Float32_To_Int16_Clip_Avx2;
+        paConverters.Float32_To_Int16_Dither = Float32_To_Int16_Dither_Avx2;
+        paConverters.Float32_To_Int16_DitherClip = Float32_To_Int16_DitherClip_Avx2;
+        paConverters.Float32_To_Int32 = Float32_To_Int32_Avx2;
+        paConverters.Float32_To_Int32_Clip = Float32_To_Int32_Clip_Avx2;
+#endif
+    }
+    else if( capabilities & paUtilSimdSse2 )
+    {
+        paConverters.Int32_To_Float32 = Int32_To_Float32_Sse2;
+#if defined(PA_LITTLE_ENDIAN)
+        if( capabilities & paUtilSimdSsse3 )
+            paConverters.Int24_To_Float32 = Int24_To_Float32_Ssse3;
+#endif
+        paConverters.Int16_To_Float32 = Int16_To_Float32_Sse2;
+#if !defined(PA_USE_C99_LRINTF)
+        paConverters.Float32_To_Int16 = Float32_To_Int16_Sse2;
+        paConverters.Float32_To_Int16_Clip = Float32_To_Int16_Clip_Sse2;
+        paConverters.Float32_To_Int16_Dither = Float32_To_Int16_Dither_Sse2;
+        paConverters.Float32_To_Int16_DitherClip = Float32_To_Int16_DitherClip_Sse2;
+        paConverters.Float32_To_Int32 = Float32_To_Int32_Sse2;
+        paConverters.Float32_To_Int32_Clip = Float32_To_Int32_Clip_Sse2;
+#endif
+    }
+#elif defined(PA_SIMD_NEON_)
+    if( capabilities & paUtilSimdNeon )
+    {
+        paConverters.Int32_To_Float32 = Int32_To_Float32_Neon;
+#if defined(PA_LITTLE_ENDIAN)
+        paConverters.Int24_To_Float32 = Int24_To_Float32_Neon;
+#endif
+        paConverters.Int16_To_Float32 = Int16_To_Float32_Neon;
+#if !defined(PA_USE_C99_LRINTF)
+        paConverters.Float32_To_Int16 = Float32_To_Int16_Neon;
+        paConverters.Float32_To_Int16_Clip = Float32_To_Int16_Clip_Neon;
+        paConverters.Float32_To_Int16_Dither = Float32_To_Int16_Dither_Neon;
+        paConverters.Float32_To_Int16_DitherClip = Float32_To_Int16_DitherClip_Neon;
+#endif
+    }
+#else
+    (void) capabilities;
+#endif
+}
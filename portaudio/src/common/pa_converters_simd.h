@@ -0,0 +1,97 @@
+#ifndef PA_CONVERTERS_SIMD_H
+#define PA_CONVERTERS_SIMD_H
+/*
+ * $Id$
+ * Portable Audio I/O Library SIMD sample conversion
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Phil Burk, Ross Bencina
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup common_src
+
+ @brief SSE2, AVX2 and NEON implementations of the most frequently used
+ sample converters, selected at run time according to the capabilities of
+ the host processor.
+
+ The SIMD kernels only handle buffers where both source and destination are
+ contiguous (stride 1). For any other stride, and for the frames left over at
+ the end of a buffer, they fall back to the converter that was installed in
+ paConverters before PaUtil_InitializeSimdConverters() was called.
+ The buffer processor presents interleaved host buffers to the converters as
+ one contiguous run whenever the host and user channel layouts match, so the
+ common interleaved case takes the SIMD path.
+
+ Setting the PA_SIMD environment variable to one of "none", "sse2", "ssse3",
+ "avx2" or "neon" caps the instruction set used, which is useful when
+ comparing kernels.
+*/
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+
+/** Instruction set extensions that PaUtil_GetSimdCapabilities() may report.
+*/
+typedef enum PaUtilSimdCapability
+{
+    paUtilSimdSse2  = 0x01,
+    paUtilSimdSsse3 = 0x02,
+    paUtilSimdAvx2  = 0x04,
+    paUtilSimdNeon  = 0x08
+} PaUtilSimdCapability;
+
+
+/** Return the logical OR of the PaUtilSimdCapability flags that are supported
+ by the processor and not disabled by the PA_SIMD environment variable.
+ The processor is only queried the first time this is called.
+*/
+unsigned int PaUtil_GetSimdCapabilities( void );
+
+
+/** Install SIMD converter functions into paConverters for the best instruction
+ set available. Converters previously installed (including any substituted by
+ the client) are kept as the fallback for strided buffers. Only the first call
+ has any effect; Pa_Initialize() calls this before initializing the host APIs.
+*/
+void PaUtil_InitializeSimdConverters( void );
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PA_CONVERTERS_SIMD_H */
@@ -53,16 +53,24 @@
 #include "pa_cpuload.h"
 
 #include <assert.h>
+#include <math.h>   /* frexp() */
 
 #include "pa_util.h"   /* for PaUtil_GetTime() */
 
 
 void PaUtil_InitializeCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer, double sampleRate )
 {
+    int i;
+
     assert( sampleRate > 0 );
 
     measurer->samplingPeriod = 1. / sampleRate;
     measurer->averageLoad = 0.;
+
+    measurer->maxLoad = 0.f;
+    measurer->overBudgetCount = 0;
+    for( i=0; i < PA_CPULOAD_BUCKET_COUNT; ++i )
+        measurer->histogram[i] = 0;
 }
 
 void PaUtil_ResetCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer )
@@ -76,9 +84,48 @@ void PaUtil_BeginCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer )
 }
 
 
+/* Bucket 0 holds loads below 2^PA_CPULOAD_MIN_OCTAVE. Each octave above that
+   is split linearly into PA_CPULOAD_BUCKETS_PER_OCTAVE buckets, and the last
+   bucket holds everything from 2^PA_CPULOAD_MAX_OCTAVE up. */
+static int LoadToBucket( double load )
+{
+    int exponent, bucket;
+    double mantissa = frexp( load, &exponent ); /* load = mantissa * 2^exponent, mantissa in [0.5, 1) */
+
+    if( load <= 0. )
+        return 0;
+
+    bucket = (exponent - 1 - PA_CPULOAD_MIN_OCTAVE) * PA_CPULOAD_BUCKETS_PER_OCTAVE
+            + (int)((mantissa * 2. - 1.) * PA_CPULOAD_BUCKETS_PER_OCTAVE) + 1;
+
+    if( bucket < 0 )
+        return 0;
+    if( bucket >= PA_CPULOAD_BUCKET_COUNT )
+        return PA_CPULOAD_BUCKET_COUNT - 1;
+    return bucket;
+}
+
+
+/* The highest load that LoadToBucket() puts in the bucket. */
+static double BucketUpperBound( int bucket )
+{
+    int octave, step;
+
+    if( bucket == 0 )
+        return ldexp( 1., PA_CPULOAD_MIN_OCTAVE );
+    if( bucket >= PA_CPULOAD_BUCKET_COUNT - 1 )
+        return HUGE_VAL;
+
+    octave = (bucket - 1) / PA_CPULOAD_BUCKETS_PER_OCTAVE + PA_CPULOAD_MIN_OCTAVE;
+    step = (bucket - 1) % PA_CPULOAD_BUCKETS_PER_OCTAVE + 1;
+    return ldexp( 1. + (double)step / PA_CPULOAD_BUCKETS_PER_OCTAVE, octave );
+}
+
+
 void PaUtil_EndCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer, unsigned long framesProcessed )
 {
     double measurementEndTime, secondsFor100Percent, measuredLoad;
+    int bucket;
 
     if( framesProcessed > 0 ){
         measurementEndTime = PaUtil_GetTime();
@@ -95,6 +142,14 @@ void PaUtil_EndCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer, unsigned lon
 
         measurer->averageLoad = (LOWPASS_COEFFICIENT_0 * measurer->averageLoad) +
                                 (LOWPASS_COEFFICIENT_1 * measuredLoad);
+
+        /* single writer: plain increments are enough for readers on other threads */
+        bucket = LoadToBucket( measuredLoad );
+        measurer->histogram[bucket] = measurer->histogram[bucket] + 1;
+        if( measuredLoad > 1. )
+            measurer->overBudgetCount = measurer->overBudgetCount + 1;
+        if( measuredLoad > measurer->maxLoad )
+            measurer->maxLoad = (float)measuredLoad;
     }
 }
 
@@ -103,3 +158,53 @@ double PaUtil_GetCpuLoad( PaUtilCpuLoadMeasurer* measurer )
 {
     return measurer->averageLoad;
 }
+
+
+void PaUtil_GetCpuLoadStats( PaUtilCpuLoadMeasurer* measurer, PaStreamCallbackStats *stats )
+{
+    unsigned long counts[ PA_CPULOAD_BUCKET_COUNT ];
+    unsigned long total = 0, seen, p99Rank, p999Rank;
+    int i;
+
+    /* copy first, so the percentiles are taken over one consistent total */
+    for( i=0; i < PA_CPULOAD_BUCKET_COUNT; ++i )
+    {
+        counts[i] = measurer->histogram[i];
+        total += counts[i];
+    }
+
+    stats->callbackCount = total;
+    stats->overBudgetCount = measurer->overBudgetCount;
+    stats->averageLoad = measurer->averageLoad;
+    stats->maxLoad = measurer->maxLoad;
+    stats->p99Load = 0.;
+    stats->p999Load = 0.;
+
+    if( total == 0 )
+        return;
+
+    /* rank of the sample at or below which the given fraction of samples lie */
+    p99Rank = total - total / 100;
+    p999Rank = total - total / 1000;
+
+    seen = 0;
+    for( i=0; i < PA_CPULOAD_BUCKET_COUNT; ++i )
+    {
+        unsigned long before = seen;
+        seen += counts[i];
+
+        if( before < p99Rank && seen >= p99Rank )
+            stats->p99Load = BucketUpperBound( i );
+        if( before < p999Rank && seen >= p999Rank )
+        {
+            stats->p999Load = BucketUpperBound( i );
+            break;
+        }
+    }
+
+    /* a bucket's upper edge can be above anything actually measured */
+    if( stats->p99Load > stats->maxLoad )
+        stats->p99Load = stats->maxLoad;
+    if( stats->p999Load > stats->maxLoad )
+        stats->p999Load = stats->maxLoad;
+}
@@ -47,24 +47,58 @@
 */
 
 
+#include "portaudio.h"
+
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif /* __cplusplus */
 
 
-typedef struct {
+/** The load histogram has this many buckets per octave, spread linearly
+ across the octave. */
+#define PA_CPULOAD_BUCKETS_PER_OCTAVE   (8)
+
+/** Loads below 2^PA_CPULOAD_MIN_OCTAVE share the first bucket. */
+#define PA_CPULOAD_MIN_OCTAVE           (-10)
+
+/** Loads of 2^PA_CPULOAD_MAX_OCTAVE and above share the last bucket. */
+#define PA_CPULOAD_MAX_OCTAVE           (4)
+
+#define PA_CPULOAD_BUCKET_COUNT \
+    ((PA_CPULOAD_MAX_OCTAVE - PA_CPULOAD_MIN_OCTAVE) * PA_CPULOAD_BUCKETS_PER_OCTAVE + 2)
+
+
+/** Measures the load of each callback. The average is kept for
+ Pa_GetStreamCpuLoad(), and every measurement is also counted in a histogram
+ for Pa_GetStreamCallbackStats().
+
+ Only the thread calling PaUtil_EndCpuLoadMeasurement() writes the counters,
+ and they only ever increase, so other threads read them without locking.
+*/
+typedef struct PaUtilCpuLoadMeasurer {
     double samplingPeriod;
     double measurementStartTime;
     double averageLoad;
+
+    volatile float maxLoad;
+    volatile unsigned long overBudgetCount;
+    volatile unsigned long histogram[ PA_CPULOAD_BUCKET_COUNT ];
 } PaUtilCpuLoadMeasurer; /**< @todo need better name than measurer */
 
 void PaUtil_InitializeCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer, double sampleRate );
 void PaUtil_BeginCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer );
 void PaUtil_EndCpuLoadMeasurement( PaUtilCpuLoadMeasurer* measurer, unsigned long framesProcessed );
+
+/** Reset the average load. The histogram is kept, so statistics cover the
+ whole life of the stream. */
 void PaUtil_ResetCpuLoadMeasurer( PaUtilCpuLoadMeasurer* measurer );
 double PaUtil_GetCpuLoad( PaUtilCpuLoadMeasurer* measurer );
 
+/** Fill stats from the histogram. Safe to call from any thread. */
+void PaUtil_GetCpuLoadStats( PaUtilCpuLoadMeasurer* measurer, PaStreamCallbackStats *stats );
+
 
 #ifdef __cplusplus
 }
@@ -67,8 +67,8 @@ PaInt32 PaUtil_Generate16BitTriangularDither( PaUtilTriangularDitherGenerator *s
     PaInt32 current, highPass;
 
     /* Generate two random numbers. */
-    state->randSeed1 = (state->randSeed1 * 196314165) + 907633515;
-    state->randSeed2 = (state->randSeed2 * 196314165) + 907633515;
+    state->randSeed1 = (state->randSeed1 * PA_DITHER_LCG_MUL) + PA_DITHER_LCG_ADD;
+    state->randSeed2 = (state->randSeed2 * PA_DITHER_LCG_MUL) + PA_DITHER_LCG_ADD;
 
     /* Generate triangular distribution about 0.
      * Shift before adding to prevent overflow which would skew the distribution.
@@ -95,8 +95,8 @@ float PaUtil_GenerateFloatTriangularDither( PaUtilTriangularDitherGenerator *sta
     PaInt32 current, highPass;
 
     /* Generate two random numbers. */
-    state->randSeed1 = (state->randSeed1 * 196314165) + 907633515;
-    state->randSeed2 = (state->randSeed2 * 196314165) + 907633515;
+    state->randSeed1 = (state->randSeed1 * PA_DITHER_LCG_MUL) + PA_DITHER_LCG_ADD;
+    state->randSeed2 = (state->randSeed2 * PA_DITHER_LCG_MUL) + PA_DITHER_LCG_ADD;
 
     /* Generate triangular distribution about 0.
      * Shift before adding to prevent overflow which would skew the distribution.
@@ -112,6 +112,133 @@ float PaUtil_GenerateFloatTriangularDither( PaUtilTriangularDitherGenerator *sta
 }
 
 
+void PaUtil_Generate16BitTriangularDitherBlock( PaUtilTriangularDitherGenerator *state,
+        PaInt32 *dither, unsigned int count )
+{
+    PaUint32 seed1[PA_DITHER_LANES], seed2[PA_DITHER_LANES];
+    PaInt32 current[PA_DITHER_LANES];
+    PaInt32 previous = (PaInt32)state->previous;
+    unsigned int i, lane, remaining;
+
+    if( count == 0 )
+        return;
+
+    /* Lane n starts on the n+1th value of the serial sequence, so that reading
+     * the lanes in turn reproduces PaUtil_Generate16BitTriangularDither().
+     */
+    seed1[0] = (state->randSeed1 * PA_DITHER_LCG_MUL) + PA_DITHER_LCG_ADD;
+    seed2[0] = (state->randSeed2 * PA_DITHER_LCG_MUL) + PA_DITHER_LCG_ADD;
+    for( lane=1; lane<PA_DITHER_LANES; ++lane )
+    {
+        seed1[lane] = (seed1[lane-1] * PA_DITHER_LCG_MUL) + PA_DITHER_LCG_ADD;
+        seed2[lane] = (seed2[lane-1] * PA_DITHER_LCG_MUL) + PA_DITHER_LCG_ADD;
+    }
+
+    /* Each iteration consumes one value from every lane. The last, possibly
+     * partial, group is handled below without advancing the lanes so that the
+     * serial state can be recovered from them.
+     */
+    for( i=0; i + PA_DITHER_LANES < count; i += PA_DITHER_LANES )
+    {
+        for( lane=0; lane<PA_DITHER_LANES; ++lane )
+        {
+            current[lane] = (((PaInt32)seed1[lane])>>DITHER_SHIFT_) +
+                            (((PaInt32)seed2[lane])>>DITHER_SHIFT_);
+            seed1[lane] = (seed1[lane] * PA_DITHER_LCG_LANE_MUL) + PA_DITHER_LCG_LANE_ADD;
+            seed2[lane] = (seed2[lane] * PA_DITHER_LCG_LANE_MUL) + PA_DITHER_LCG_LANE_ADD;
+        }
+
+        /* High pass filter across the interleaved lanes */
+        dither[i] = current[0] - previous;
+        for( lane=1; lane<PA_DITHER_LANES; ++lane )
+            dither[i + lane] = current[lane] - current[lane-1];
+        previous = current[PA_DITHER_LANES-1];
+    }
+
+    remaining = count - i;
+    for( lane=0; lane<remaining; ++lane )
+    {
+        PaInt32 value = (((PaInt32)seed1[lane])>>DITHER_SHIFT_) +
+                        (((PaInt32)seed2[lane])>>DITHER_SHIFT_);
+        dither[i + lane] = value - previous;
+        previous = value;
+    }
+
+    state->randSeed1 = seed1[remaining-1];
+    state->randSeed2 = seed2[remaining-1];
+    state->previous = (PaUint32)previous;
+}
+
+
+void PaUtil_GenerateFloatTriangularDitherBlock( PaUtilTriangularDitherGenerator *state,
+        float *dither, unsigned int count )
+{
+    PaInt32 highPass[PA_DITHER_BLOCK_SIZE];
+    unsigned int i, n;
+
+    while( count > 0 )
+    {
+        n = (count < PA_DITHER_BLOCK_SIZE) ? count : PA_DITHER_BLOCK_SIZE;
+
+        PaUtil_Generate16BitTriangularDitherBlock( state, highPass, n );
+        for( i=0; i<n; ++i )
+            dither[i] = ((float)highPass[i]) * const_float_dither_scale_;
+
+        dither += n;
+        count -= n;
+    }
+}
+
+
+/* Error feedback filter coefficients, h[k] weights the error of the sample
+ * k+1 samples ago. The noise transfer function is 1 - sum( h[k] z^-(k+1) ).
+ */
+static const float firstOrderNoiseShaping_[1] = { 1.0f };
+/* the second order filter from the musicdsp.org notes below, with s = 0.5 */
+static const float secondOrderNoiseShaping_[2] = { 1.0f, -0.5f };
+/* Lipshitz, Vanderkooy and Wannamaker, "Minimally Audible Noise Shaping",
+ * JAES vol 39 no 11, 1991: five tap E-weighted filter for 44.1 kHz
+ */
+static const float fifthOrderNoiseShaping_[5] = { 2.033f, -2.165f, 1.959f, -1.590f, 0.6149f };
+
+
+void PaUtil_InitializeNoiseShaper( PaUtilNoiseShaper *shaper, int order, unsigned int channel )
+{
+    PaUtil_InitializeTriangularDitherState( &shaper->ditherGenerator );
+
+    /* offset the seeds so that the channels' dither is uncorrelated */
+    shaper->ditherGenerator.randSeed1 += channel * 0x9E3779B9U;
+    shaper->ditherGenerator.randSeed2 += channel * 0x7F4A7C15U;
+
+    if( order >= 5 )
+    {
+        shaper->order = 5;
+        shaper->coefficients = fifthOrderNoiseShaping_;
+    }
+    else if( order >= 2 )
+    {
+        shaper->order = 2;
+        shaper->coefficients = secondOrderNoiseShaping_;
+    }
+    else
+    {
+        shaper->order = 1;
+        shaper->coefficients = firstOrderNoiseShaping_;
+    }
+
+    PaUtil_ResetNoiseShaper( shaper );
+}
+
+
+void PaUtil_ResetNoiseShaper( PaUtilNoiseShaper *shaper )
+{
+    int i;
+
+    for( i=0; i<PA_NOISE_SHAPER_MAX_ORDER; ++i )
+        shaper->error[i] = 0.0f;
+}
+
+
 /*
 The following alternate dither algorithms (from musicdsp.org) could be
 considered
@@ -99,6 +99,109 @@ PaInt32 PaUtil_Generate16BitTriangularDither( PaUtilTriangularDitherGenerator *d
 float PaUtil_GenerateFloatTriangularDither( PaUtilTriangularDitherGenerator *ditherState );
 
 
+/** Parameters of the dither generator, shared with the SIMD converters which
+ run the generator lanes in vector registers. Each lane advances by
+ PA_DITHER_LANES steps of x(n+1) = x(n) * PA_DITHER_LCG_MUL + PA_DITHER_LCG_ADD
+ at a time, which is a single step of the same form with
+ PA_DITHER_LCG_LANE_MUL = MUL^8 and
+ PA_DITHER_LCG_LANE_ADD = ADD * (MUL^7 + ... + MUL + 1), modulo 2^32.
+ Each 15 bit random value is the top of a seed shifted right by PA_DITHER_SHIFT
+ (one extra bit for the high pass filter), and float dither is scaled by
+ PA_DITHER_FLOAT_SCALE.
+*/
+#define PA_DITHER_LCG_MUL       (196314165U)
+#define PA_DITHER_LCG_ADD       (907633515U)
+#define PA_DITHER_LCG_LANE_MUL  (1298576737U)
+#define PA_DITHER_LCG_LANE_ADD  (381724904U)
+#define PA_DITHER_SHIFT         (18)
+#define PA_DITHER_FLOAT_SCALE   (1.0f / 32767)
+
+
+/** The number of independent generator lanes used by the block dither
+ functions. Blocks whose length is a multiple of PA_DITHER_LANES are generated
+ most efficiently.
+*/
+#define PA_DITHER_LANES (8)
+
+
+/** The block length converters use when generating dither into a buffer on
+ the stack.
+*/
+#define PA_DITHER_BLOCK_SIZE (64)
+
+
+/**
+ @brief Fill a buffer with dither values from the same distribution as
+ PaUtil_Generate16BitTriangularDither().
+
+ The values, and the resulting generator state, are identical to those of count
+ successive calls to PaUtil_Generate16BitTriangularDither(), so block and single
+ value generation may be freely mixed. The random sequence is split over
+ PA_DITHER_LANES generators that each advance PA_DITHER_LANES steps at a time,
+ which removes the serial dependency between neighbouring values and lets the
+ compiler vectorize the inner loop.
+
+ @param dither The buffer to fill, with room for at least count values.
+ @param count The number of values to generate.
+*/
+void PaUtil_Generate16BitTriangularDitherBlock( PaUtilTriangularDitherGenerator *ditherState,
+        PaInt32 *dither, unsigned int count );
+
+
+/**
+ @brief Fill a buffer with dither values from the same distribution as
+ PaUtil_GenerateFloatTriangularDither().
+
+ As with PaUtil_Generate16BitTriangularDitherBlock() the values match those of
+ count successive calls to PaUtil_GenerateFloatTriangularDither().
+
+ @param dither The buffer to fill, with room for at least count values.
+ @param count The number of values to generate.
+*/
+void PaUtil_GenerateFloatTriangularDitherBlock( PaUtilTriangularDitherGenerator *ditherState,
+        float *dither, unsigned int count );
+
+
+
+/** The highest order of error feedback filter supported by PaUtilNoiseShaper. */
+#define PA_NOISE_SHAPER_MAX_ORDER (5)
+
+
+/**
+ @brief Per channel state for noise shaped dither.
+
+ The quantization error of each output sample, including the dither, is fed
+ back through an FIR filter and subtracted from the following samples, which
+ moves the noise away from the frequencies where hearing is most sensitive.
+
+ Noise shaping converters receive a pointer to the ditherGenerator member in
+ their ditherGenerator parameter, and recover the enclosing PaUtilNoiseShaper
+ from it, which is why it must remain the first member.
+*/
+typedef struct PaUtilNoiseShaper{
+    PaUtilTriangularDitherGenerator ditherGenerator;
+    int order;
+    const float *coefficients;
+    float error[PA_NOISE_SHAPER_MAX_ORDER]; /**< most recent first */
+} PaUtilNoiseShaper;
+
+
+/**
+ @brief Initialize noise shaper state.
+
+ @param order 1 for a first order (6 dB/octave) high pass shaping filter,
+ 2 for the second order filter from musicdsp.org, or 5 for Lipshitz et al's
+ five tap E-weighted filter, which is designed for 44.1 kHz.
+ Other orders are rounded down to the nearest of these.
+ @param channel The index of the channel; each channel gets an uncorrelated
+ dither sequence.
+*/
+void PaUtil_InitializeNoiseShaper( PaUtilNoiseShaper *shaper, int order, unsigned int channel );
+
+
+/** @brief Clear the error history of a noise shaper, eg. when a stream is restarted. */
+void PaUtil_ResetNoiseShaper( PaUtilNoiseShaper *shaper );
+
 
 #ifdef __cplusplus
 }
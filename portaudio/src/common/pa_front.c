@@ -70,12 +70,15 @@
 
 #include "portaudio.h"
 #include "pa_util.h"
+#include "pa_converters_simd.h"
 #include "pa_endianness.h"
 #include "pa_types.h"
 #include "pa_hostapi.h"
 #include "pa_stream.h"
+#include "pa_cpuload.h"
 #include "pa_trace.h" /* still useful?*/
 #include "pa_debugprint.h"
+#include "pa_memorybarrier.h"
 
 #ifndef PA_GIT_REVISION
 #include "pa_gitrevision.h"
@@ -159,7 +162,48 @@ static int defaultHostApiIndex_ = 0;
 static int initializationCount_ = 0;
 static int deviceCount_ = 0;
 
-PaUtilStreamRepresentation *firstOpenStream_ = NULL;
+/* state of each host API slot when initialized with Pa_InitializeDeferred() */
+typedef enum
+{
+    HostApiPending,
+    HostApiInitializing,
+    HostApiReady,
+    HostApiUnavailable
+} HostApiState;
+
+static int deferredHostApis_ = 0;
+static HostApiState *hostApiStates_ = 0;
+static PaHostApiInfo *unavailableHostApiInfos_ = 0;
+
+static PaDevicesChangedCallback *devicesChangedCallback_ = 0;
+static void *devicesChangedUserData_ = 0;
+
+/* Open streams are kept in a table of slots, allocated in chunks that never move, so that streams can be looked up
+   without a lock while others are opened and closed. The PaStream* handed to the client is not the stream's address
+   but encodes its slot index and the slot's generation, which advances each time the slot is freed. Looking a handle
+   up only reads the table, so a handle to a closed stream is rejected without touching the stream's memory, even once
+   a new stream has its slot or its address. A generation repeats only after it wraps, which where pointers are 32 bits
+   takes 65535 reuses of one slot. */
+#define PA_OPEN_STREAM_CHUNK_SLOTS_ (64)
+#define PA_MAX_OPEN_STREAM_CHUNKS_  (1024)
+#define PA_MAX_OPEN_STREAMS_        (PA_OPEN_STREAM_CHUNK_SLOTS_ * PA_MAX_OPEN_STREAM_CHUNKS_)
+#define PA_MAX_OPEN_STREAM_GENERATION_ (((size_t)-1) / PA_MAX_OPEN_STREAMS_)
+
+#define PA_OPEN_STREAM_HANDLE_( index, generation )\
+    ((PaStream*)((size_t)(generation) * PA_MAX_OPEN_STREAMS_ + (size_t)(index)))
+
+typedef struct
+{
+    PaUtilStreamRepresentation *stream;
+    size_t generation;      /* never 0, so that no handle is NULL */
+    int nextFree;
+} OpenStreamSlot;
+
+static OpenStreamSlot *openStreamChunks_[PA_MAX_OPEN_STREAM_CHUNKS_];
+static int openStreamChunkCount_ = 0;
+static int firstFreeOpenStreamSlot_ = -1;
+/* The generation new slots start at, past any handed out before the table was last freed */
+static size_t firstOpenStreamGeneration_ = 1;
 
 
 #define PA_IS_INITIALISED_ (initializationCount_ != 0)
@@ -175,6 +219,13 @@ static int CountHostApiInitializers( void )
 }
 
 
+/* returns nonzero if hostApis_[hostApi] holds an initialized host API */
+static int HostApiIsReady( PaHostApiIndex hostApi )
+{
+    return !deferredHostApis_ || hostApiStates_[hostApi] == HostApiReady;
+}
+
+
 static void TerminateHostApis( void )
 {
     /* terminate in reverse order from initialization */
@@ -183,7 +234,8 @@ static void TerminateHostApis( void )
     while( hostApisCount_ > 0 )
     {
         --hostApisCount_;
-        hostApis_[hostApisCount_]->Terminate( hostApis_[hostApisCount_] );
+        if( HostApiIsReady( hostApisCount_ ) )
+            hostApis_[hostApisCount_]->Terminate( hostApis_[hostApisCount_] );
     }
     hostApisCount_ = 0;
     defaultHostApiIndex_ = 0;
@@ -193,14 +245,58 @@ static void TerminateHostApis( void )
         PaUtil_FreeMemory( hostApis_ );
     hostApis_ = 0;
 
+    if( hostApiStates_ != 0 )
+        PaUtil_FreeMemory( hostApiStates_ );
+    hostApiStates_ = 0;
+
+    if( unavailableHostApiInfos_ != 0 )
+        PaUtil_FreeMemory( unavailableHostApiInfos_ );
+    unavailableHostApiInfos_ = 0;
+
+    deferredHostApis_ = 0;
+
     PA_DEBUG(("TerminateHostApis out\n"));
 }
 
 
+/*
+    AttachHostApi() appends the devices of a freshly initialized host API to
+    the global device index range and converts its default devices to global
+    device indices.
+*/
+static void AttachHostApi( PaUtilHostApiRepresentation *hostApi )
+{
+    assert( hostApi->info.defaultInputDevice < hostApi->info.deviceCount );
+    assert( hostApi->info.defaultOutputDevice < hostApi->info.deviceCount );
+
+    hostApi->privatePaFrontInfo.baseDeviceIndex = deviceCount_;
+
+    if( hostApi->info.defaultInputDevice != paNoDevice )
+        hostApi->info.defaultInputDevice += deviceCount_;
+
+    if( hostApi->info.defaultOutputDevice != paNoDevice )
+        hostApi->info.defaultOutputDevice += deviceCount_;
+
+    deviceCount_ += hostApi->info.deviceCount;
+}
+
+
+/* DetachHostApi() converts the default devices of a host API back to host API
+    device indices, ready to be attached again. */
+static void DetachHostApi( PaUtilHostApiRepresentation *hostApi )
+{
+    if( hostApi->info.defaultInputDevice != paNoDevice )
+        hostApi->info.defaultInputDevice -= hostApi->privatePaFrontInfo.baseDeviceIndex;
+
+    if( hostApi->info.defaultOutputDevice != paNoDevice )
+        hostApi->info.defaultOutputDevice -= hostApi->privatePaFrontInfo.baseDeviceIndex;
+}
+
+
 static PaError InitializeHostApis( void )
 {
     PaError result = paNoError;
-    int i, initializerCount, baseDeviceIndex;
+    int i, initializerCount;
 
     initializerCount = CountHostApiInitializers();
 
@@ -215,7 +311,6 @@ static PaError InitializeHostApis( void )
     hostApisCount_ = 0;
     defaultHostApiIndex_ = -1; /* indicates that we haven't determined the default host API yet */
     deviceCount_ = 0;
-    baseDeviceIndex = 0;
 
     for( i=0; i< initializerCount; ++i )
     {
@@ -232,8 +327,6 @@ static PaError InitializeHostApis( void )
         if( hostApis_[hostApisCount_] )
         {
             PaUtilHostApiRepresentation* hostApi = hostApis_[hostApisCount_];
-            assert( hostApi->info.defaultInputDevice < hostApi->info.deviceCount );
-            assert( hostApi->info.defaultOutputDevice < hostApi->info.deviceCount );
 
             /* the first successfully initialized host API with a default input *or*
                output device is used as the default host API.
@@ -245,16 +338,7 @@ static PaError InitializeHostApis( void )
                 defaultHostApiIndex_ = hostApisCount_;
             }
 
-            hostApi->privatePaFrontInfo.baseDeviceIndex = baseDeviceIndex;
-
-            if( hostApi->info.defaultInputDevice != paNoDevice )
-                hostApi->info.defaultInputDevice += baseDeviceIndex;
-
-            if( hostApi->info.defaultOutputDevice != paNoDevice )
-                hostApi->info.defaultOutputDevice += baseDeviceIndex;
-
-            baseDeviceIndex += hostApi->info.deviceCount;
-            deviceCount_ += hostApi->info.deviceCount;
+            AttachHostApi( hostApi );
 
             ++hostApisCount_;
         }
@@ -272,6 +356,145 @@ error:
 }
 
 
+/*
+    InitializeDeferredHostApis() registers one slot per host API initializer
+    without calling any of them. A slot's host API index is its position in
+    paHostApiInitializers, whether or not the host API turns out to be
+    available. EnsureHostApi() runs the initializer on first use.
+*/
+static PaError InitializeDeferredHostApis( void )
+{
+    PaError result = paNoError;
+    int i, initializerCount;
+
+    initializerCount = CountHostApiInitializers();
+
+    deferredHostApis_ = 1;
+    hostApis_ = (PaUtilHostApiRepresentation**)PaUtil_AllocateMemory(
+            sizeof(PaUtilHostApiRepresentation*) * initializerCount );
+    hostApiStates_ = (HostApiState*)PaUtil_AllocateMemory(
+            sizeof(HostApiState) * initializerCount );
+    unavailableHostApiInfos_ = (PaHostApiInfo*)PaUtil_AllocateMemory(
+            sizeof(PaHostApiInfo) * initializerCount );
+    if( ( initializerCount > 0 )
+            && ( !hostApis_ || !hostApiStates_ || !unavailableHostApiInfos_ ) )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    for( i=0; i < initializerCount; ++i )
+    {
+        hostApis_[i] = NULL;
+        hostApiStates_[i] = HostApiPending;
+
+        unavailableHostApiInfos_[i].structVersion = 1;
+        unavailableHostApiInfos_[i].type = paHostApiInitializerTypes[i];
+        unavailableHostApiInfos_[i].name = "Unavailable";
+        unavailableHostApiInfos_[i].deviceCount = 0;
+        unavailableHostApiInfos_[i].defaultInputDevice = paNoDevice;
+        unavailableHostApiInfos_[i].defaultOutputDevice = paNoDevice;
+    }
+
+    hostApisCount_ = initializerCount;
+    defaultHostApiIndex_ = -1; /* determined on first use, see DefaultHostApi() */
+    deviceCount_ = 0;
+
+    return result;
+
+error:
+    hostApisCount_ = 0;
+    TerminateHostApis();
+    return result;
+}
+
+
+/*
+    EnsureHostApi() initializes a deferred host API the first time it is
+    used. Device indices of the new host API are appended after those of
+    previously initialized host APIs, so existing device indices remain valid.
+    Once an initializer fails, or reports that the host API is unavailable,
+    the slot stays unavailable until Pa_Terminate().
+*/
+static PaError EnsureHostApi( PaHostApiIndex hostApi )
+{
+    PaError result;
+
+    if( !deferredHostApis_ || hostApiStates_[hostApi] != HostApiPending )
+        return paNoError;
+
+    /* guards against the initializer looking itself up */
+    hostApiStates_[hostApi] = HostApiInitializing;
+
+    PA_DEBUG(( "before deferred paHostApiInitializers[%d].\n", hostApi ));
+
+    result = paHostApiInitializers[hostApi]( &hostApis_[hostApi], hostApi );
+
+    PA_DEBUG(( "after deferred paHostApiInitializers[%d].\n", hostApi ));
+
+    if( result == paNoError && hostApis_[hostApi] )
+    {
+        AttachHostApi( hostApis_[hostApi] );
+        hostApiStates_[hostApi] = HostApiReady;
+    }
+    else
+    {
+        hostApis_[hostApi] = NULL;
+        hostApiStates_[hostApi] = HostApiUnavailable;
+    }
+
+    return result;
+}
+
+
+static void EnsureAllHostApis( void )
+{
+    int i;
+
+    for( i=0; i < hostApisCount_; ++i )
+        EnsureHostApi( i );
+}
+
+
+/*
+    DefaultHostApi() returns the default host API index. In deferred mode the
+    host APIs are initialized in order until one with a default input or
+    output device is found, which selects the same host API as eager
+    initialization would.
+*/
+static PaHostApiIndex DefaultHostApi( void )
+{
+    int i;
+
+    if( deferredHostApis_ && defaultHostApiIndex_ == -1 )
+    {
+        for( i=0; i < hostApisCount_; ++i )
+        {
+            EnsureHostApi( i );
+            if( HostApiIsReady( i )
+                    && ( hostApis_[i]->info.defaultInputDevice != paNoDevice
+                        || hostApis_[i]->info.defaultOutputDevice != paNoDevice ) )
+            {
+                defaultHostApiIndex_ = i;
+                break;
+            }
+        }
+
+        /* if no host APIs have devices, the default host API is the first available host API */
+        for( i=0; i < hostApisCount_ && defaultHostApiIndex_ == -1; ++i )
+        {
+            if( HostApiIsReady( i ) )
+                defaultHostApiIndex_ = i;
+        }
+
+        if( defaultHostApiIndex_ == -1 )
+            defaultHostApiIndex_ = 0;
+    }
+
+    return defaultHostApiIndex_;
+}
+
+
 /*
     FindHostApi() finds the index of the host api to which
     <device> belongs and returns it. if <hostSpecificDeviceIndex> is
@@ -289,75 +512,153 @@ static int FindHostApi( PaDeviceIndex device, int *hostSpecificDeviceIndex )
     if( device < 0 )
         return -1;
 
-    while( i < hostApisCount_
-            && device >= hostApis_[i]->info.deviceCount )
+    /* host APIs initialized by EnsureHostApi() are not in index order, so
+        match each initialized host API's device range */
+    for( i=0; i < hostApisCount_; ++i )
     {
+        int baseDeviceIndex;
+
+        if( !HostApiIsReady( i ) )
+            continue;
+
+        baseDeviceIndex = (int)hostApis_[i]->privatePaFrontInfo.baseDeviceIndex;
+        if( device >= baseDeviceIndex && device < baseDeviceIndex + hostApis_[i]->info.deviceCount )
+        {
+            if( hostSpecificDeviceIndex )
+                *hostSpecificDeviceIndex = device - baseDeviceIndex;
 
-        device -= hostApis_[i]->info.deviceCount;
-        ++i;
+            return i;
+        }
     }
 
-    if( i >= hostApisCount_ )
-        return -1;
+    return -1;
+}
 
-    if( hostSpecificDeviceIndex )
-        *hostSpecificDeviceIndex = device;
 
-    return i;
+static OpenStreamSlot *GetOpenStreamSlot( int index )
+{
+    if( index < 0 || index >= openStreamChunkCount_ * PA_OPEN_STREAM_CHUNK_SLOTS_ )
+        return NULL;
+
+    PaUtil_ReadMemoryBarrier();     /* The chunk count before the chunk */
+    return &openStreamChunks_[index / PA_OPEN_STREAM_CHUNK_SLOTS_][index % PA_OPEN_STREAM_CHUNK_SLOTS_];
 }
 
 
-static void AddOpenStream( PaStream* stream )
+static size_t NextOpenStreamGeneration( size_t generation )
 {
-    ((PaUtilStreamRepresentation*)stream)->nextOpenStream = firstOpenStream_;
-    firstOpenStream_ = (PaUtilStreamRepresentation*)stream;
+    return generation < PA_MAX_OPEN_STREAM_GENERATION_ ? generation + 1 : 1;
 }
 
 
-static void RemoveOpenStream( PaStream* stream )
+/* Look up the open stream a client's handle refers to without dereferencing the handle, NULL if there is none */
+static PaUtilStreamRepresentation *FindOpenStream( PaStream* stream )
 {
-    PaUtilStreamRepresentation *previous = NULL;
-    PaUtilStreamRepresentation *current = firstOpenStream_;
+    const size_t handle = (size_t)stream;
+    const OpenStreamSlot *slot = GetOpenStreamSlot( (int)(handle % PA_MAX_OPEN_STREAMS_) );
 
-    while( current != NULL )
+    if( !slot || slot->generation != handle / PA_MAX_OPEN_STREAMS_ )
+        return NULL;
+
+    PaUtil_ReadMemoryBarrier();     /* The generation before the stream */
+    return slot->stream;
+}
+
+
+/* Add a stream the host api has opened to the table, returning the client's handle to it in *stream */
+static PaError AddOpenStream( PaStream** stream )
+{
+    PaUtilStreamRepresentation *streamRepresentation = PA_STREAM_REP( *stream );
+    OpenStreamSlot *slot;
+    int index;
+
+    if( firstFreeOpenStreamSlot_ < 0 )
     {
-        if( ((PaStream*)current) == stream )
-        {
-            if( previous == NULL )
-            {
-                firstOpenStream_ = current->nextOpenStream;
-            }
-            else
-            {
-                previous->nextOpenStream = current->nextOpenStream;
-            }
-            return;
-        }
-        else
+        OpenStreamSlot *chunk;
+        int first = openStreamChunkCount_ * PA_OPEN_STREAM_CHUNK_SLOTS_;
+
+        if( openStreamChunkCount_ == PA_MAX_OPEN_STREAM_CHUNKS_ )
+            return paInsufficientMemory;
+        chunk = (OpenStreamSlot*)PaUtil_AllocateMemory( sizeof(OpenStreamSlot) * PA_OPEN_STREAM_CHUNK_SLOTS_ );
+        if( !chunk )
+            return paInsufficientMemory;
+
+        for( index = 0; index < PA_OPEN_STREAM_CHUNK_SLOTS_; ++index )
         {
-            previous = current;
-            current = current->nextOpenStream;
+            chunk[index].stream = NULL;
+            chunk[index].generation = firstOpenStreamGeneration_;
+            chunk[index].nextFree = index + 1 < PA_OPEN_STREAM_CHUNK_SLOTS_ ? first + index + 1 : -1;
         }
+        openStreamChunks_[openStreamChunkCount_] = chunk;
+        PaUtil_WriteMemoryBarrier();    /* The chunk before the chunk count */
+        ++openStreamChunkCount_;
+        firstFreeOpenStreamSlot_ = first;
     }
+
+    index = firstFreeOpenStreamSlot_;
+    slot = GetOpenStreamSlot( index );
+    firstFreeOpenStreamSlot_ = slot->nextFree;
+
+    streamRepresentation->openStreamHandle = PA_OPEN_STREAM_HANDLE_( index, slot->generation );
+    PaUtil_WriteMemoryBarrier();    /* The stream's handle before the slot's stream */
+    slot->stream = streamRepresentation;
+    *stream = streamRepresentation->openStreamHandle;
+
+    return paNoError;
+}
+
+
+/* The handle must be valid. A lookup racing with this sees either the stream or NULL, and later ones the new
+   generation. */
+static void RemoveOpenStream( PaStream* stream )
+{
+    const int index = (int)((size_t)stream % PA_MAX_OPEN_STREAMS_);
+    OpenStreamSlot *slot = GetOpenStreamSlot( index );
+
+    slot->stream->openStreamHandle = NULL;
+    slot->stream = NULL;
+    PaUtil_WriteMemoryBarrier();    /* Cleared before the handle stops matching */
+    slot->generation = NextOpenStreamGeneration( slot->generation );
+    slot->nextFree = firstFreeOpenStreamSlot_;
+    firstFreeOpenStreamSlot_ = index;
 }
 
 
 static void CloseOpenStreams( void )
 {
+    int chunk, i;
+
     /* we call Pa_CloseStream() here to ensure that the same destruction
         logic is used for automatically closed streams */
 
-    while( firstOpenStream_ != NULL )
-        Pa_CloseStream( firstOpenStream_ );
+    for( chunk = 0; chunk < openStreamChunkCount_; ++chunk )
+    {
+        for( i = 0; i < PA_OPEN_STREAM_CHUNK_SLOTS_; ++i )
+        {
+            if( openStreamChunks_[chunk][i].stream )
+                Pa_CloseStream( openStreamChunks_[chunk][i].stream->openStreamHandle );
+        }
+    }
+
+    /* handles from before Pa_Terminate() must not match slots allocated after the next Pa_Initialize() */
+    for( chunk = 0; chunk < openStreamChunkCount_; ++chunk )
+    {
+        for( i = 0; i < PA_OPEN_STREAM_CHUNK_SLOTS_; ++i )
+        {
+            if( openStreamChunks_[chunk][i].generation >= firstOpenStreamGeneration_ )
+                firstOpenStreamGeneration_ = NextOpenStreamGeneration( openStreamChunks_[chunk][i].generation );
+        }
+        PaUtil_FreeMemory( openStreamChunks_[chunk] );
+    }
+    openStreamChunkCount_ = 0;
+    firstFreeOpenStreamSlot_ = -1;
 }
 
 
-PaError Pa_Initialize( void )
+static PaError Initialize( int deferHostApis )
 {
     PaError result;
 
-    PA_LOGAPI_ENTER( "Pa_Initialize" );
-
     if( PA_IS_INITIALISED_ )
     {
         ++initializationCount_;
@@ -369,19 +670,46 @@ PaError Pa_Initialize( void )
         PA_VALIDATE_ENDIANNESS;
 
         PaUtil_InitializeClock();
+        PaUtil_InitializeSimdConverters();
         PaUtil_ResetTraceMessages();
 
-        result = InitializeHostApis();
+        result = deferHostApis ? InitializeDeferredHostApis() : InitializeHostApis();
         if( result == paNoError )
             ++initializationCount_;
     }
 
+    return result;
+}
+
+
+PaError Pa_Initialize( void )
+{
+    PaError result;
+
+    PA_LOGAPI_ENTER( "Pa_Initialize" );
+
+    result = Initialize( 0 );
+
     PA_LOGAPI_EXIT_PAERROR( "Pa_Initialize", result );
 
     return result;
 }
 
 
+PaError Pa_InitializeDeferred( void )
+{
+    PaError result;
+
+    PA_LOGAPI_ENTER( "Pa_InitializeDeferred" );
+
+    result = Initialize( 1 );
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_InitializeDeferred", result );
+
+    return result;
+}
+
+
 PaError Pa_Terminate( void )
 {
     PaError result;
@@ -397,7 +725,14 @@ PaError Pa_Terminate( void )
 
             TerminateHostApis();
 
+            devicesChangedCallback_ = 0;
+            devicesChangedUserData_ = 0;
+
             PaUtil_DumpTraceMessages();
+#if PA_TRACE_EVENTS
+            if( getenv( "PA_TRACE_EVENTS_FILE" ) )
+                PaUtil_DumpTraceEvents( getenv( "PA_TRACE_EVENTS_FILE" ) );
+#endif
         }
         --initializationCount_;
         result = paNoError;
@@ -413,6 +748,75 @@ PaError Pa_Terminate( void )
 }
 
 
+/* Allocators are kept for the life of the process, since blocks they
+    allocated may outlive their replacement */
+#define PA_MAX_ALLOCATORS_  16
+
+static PaUtilAllocator allocators_[PA_MAX_ALLOCATORS_];
+static int allocatorCount_ = 0;
+
+
+PaError Pa_SetAllocator( PaAllocateMemoryCallback *allocateMemory,
+        PaFreeMemoryCallback *freeMemory, void *userData, PaAllocatorFlags flags )
+{
+    PaError result = paNoError;
+    PaUtilAllocator *allocator = NULL;
+    int i;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetAllocator" );
+    PA_LOGAPI(("\tPaAllocateMemoryCallback *allocateMemory: 0x%p\n", allocateMemory ));
+    PA_LOGAPI(("\tPaFreeMemoryCallback *freeMemory: 0x%p\n", freeMemory ));
+    PA_LOGAPI(("\tvoid *userData: 0x%p\n", userData ));
+    PA_LOGAPI(("\tPaAllocatorFlags flags: 0x%lx\n", flags ));
+
+    if( (allocateMemory == NULL) != (freeMemory == NULL) )
+    {
+        result = paNullCallback;
+    }
+    else if( flags & ~paRealTimeAllocator )
+    {
+        result = paInvalidFlag;
+    }
+    else if( allocateMemory == NULL && flags == paNoAllocatorFlag )
+    {
+        PaUtil_SetAllocator( NULL );
+    }
+    else
+    {
+        if( allocateMemory == NULL )
+            userData = NULL;
+
+        for( i=0; i < allocatorCount_; ++i )
+        {
+            if( allocators_[i].allocate == allocateMemory && allocators_[i].free == freeMemory
+                    && allocators_[i].userData == userData && allocators_[i].flags == flags )
+            {
+                allocator = &allocators_[i];
+                break;
+            }
+        }
+
+        if( allocator == NULL && allocatorCount_ < PA_MAX_ALLOCATORS_ )
+        {
+            allocator = &allocators_[allocatorCount_++];
+            allocator->allocate = allocateMemory;
+            allocator->free = freeMemory;
+            allocator->userData = userData;
+            allocator->flags = flags;
+        }
+
+        if( allocator != NULL )
+            PaUtil_SetAllocator( allocator );
+        else
+            result = paInsufficientMemory;
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetAllocator", result );
+
+    return result;
+}
+
+
 const PaHostErrorInfo* Pa_GetLastHostErrorInfo( void )
 {
     return &lastHostErrorInfo_;
@@ -456,6 +860,7 @@ const char *Pa_GetErrorText( PaError errorCode )
     case paCanNotWriteToAnInputOnlyStream:      result = "Can't write to an input only stream"; break;
     case paIncompatibleStreamHostApi: result = "Incompatible stream host API"; break;
     case paBadBufferPtr:             result = "Bad buffer pointer"; break;
+    case paThreadPolicyFailed:       result = "Thread scheduling policy could not be applied"; break;
     default:
         if( errorCode > 0 )
             result = "Invalid error code (value greater than zero)";
@@ -485,7 +890,18 @@ PaHostApiIndex Pa_HostApiTypeIdToHostApiIndex( PaHostApiTypeId type )
 
         for( i=0; i < hostApisCount_; ++i )
         {
-            if( hostApis_[i]->info.type == type )
+            if( deferredHostApis_ )
+            {
+                if( paHostApiInitializerTypes[i] != type )
+                    continue;
+
+                result = EnsureHostApi( i );
+                if( result != paNoError )
+                    break;
+                result = paHostApiNotFound;
+            }
+
+            if( HostApiIsReady( i ) && hostApis_[i]->info.type == type )
             {
                 result = i;
                 break;
@@ -515,7 +931,10 @@ PaError PaUtil_GetHostApiRepresentation( struct PaUtilHostApiRepresentation **ho
 
         for( i=0; i < hostApisCount_; ++i )
         {
-            if( hostApis_[i]->info.type == type )
+            if( deferredHostApis_ && paHostApiInitializerTypes[i] == type )
+                EnsureHostApi( i );
+
+            if( HostApiIsReady( i ) && hostApis_[i]->info.type == type )
             {
                 *hostApi = hostApis_[i];
                 result = paNoError;
@@ -571,6 +990,39 @@ PaHostApiIndex Pa_GetHostApiCount( void )
 }
 
 
+PaError Pa_GetHostApiTypeId( PaHostApiIndex hostApi, PaHostApiTypeId *type )
+{
+    PaError result;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_GetHostApiTypeId" );
+    PA_LOGAPI(("\tPaHostApiIndex hostApi: %d\n", hostApi ));
+    PA_LOGAPI(("\tPaHostApiTypeId *type: 0x%p\n", type ));
+
+    if( !PA_IS_INITIALISED_ )
+    {
+        result = paNotInitialized;
+    }
+    else if( hostApi < 0 || hostApi >= hostApisCount_ )
+    {
+        result = paInvalidHostApi;
+    }
+    else if( type == NULL )
+    {
+        result = paBadBufferPtr;
+    }
+    else
+    {
+        /* deliberately does not initialize a deferred host API */
+        *type = deferredHostApis_ ? paHostApiInitializerTypes[hostApi] : hostApis_[hostApi]->info.type;
+        result = paNoError;
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_GetHostApiTypeId", result );
+
+    return result;
+}
+
+
 PaHostApiIndex Pa_GetDefaultHostApi( void )
 {
     int result;
@@ -583,7 +1035,7 @@ PaHostApiIndex Pa_GetDefaultHostApi( void )
     }
     else
     {
-        result = defaultHostApiIndex_;
+        result = DefaultHostApi();
 
         /* internal consistency check: make sure that the default host api
          index is within range */
@@ -625,7 +1077,8 @@ const PaHostApiInfo* Pa_GetHostApiInfo( PaHostApiIndex hostApi )
     }
     else
     {
-        info = &hostApis_[hostApi]->info;
+        EnsureHostApi( hostApi );
+        info = HostApiIsReady( hostApi ) ? &hostApis_[hostApi]->info : &unavailableHostApiInfos_[hostApi];
 
         PA_LOGAPI(("Pa_GetHostApiInfo returned:\n" ));
         PA_LOGAPI(("\tPaHostApiInfo*: 0x%p\n", info ));
@@ -661,7 +1114,9 @@ PaDeviceIndex Pa_HostApiDeviceIndexToDeviceIndex( PaHostApiIndex hostApi, int ho
         }
         else
         {
-            if( hostApiDeviceIndex < 0 ||
+            EnsureHostApi( hostApi );
+
+            if( !HostApiIsReady( hostApi ) || hostApiDeviceIndex < 0 ||
                     hostApiDeviceIndex >= hostApis_[hostApi]->info.deviceCount )
             {
                 result = paInvalidDevice;
@@ -691,6 +1146,7 @@ PaDeviceIndex Pa_GetDeviceCount( void )
     }
     else
     {
+        EnsureAllHostApis();
         result = deviceCount_;
     }
 
@@ -708,7 +1164,7 @@ PaDeviceIndex Pa_GetDefaultInputDevice( void )
     PA_LOGAPI_ENTER( "Pa_GetDefaultInputDevice" );
 
     hostApi = Pa_GetDefaultHostApi();
-    if( hostApi < 0 )
+    if( hostApi < 0 || !HostApiIsReady( hostApi ) )
     {
         result = paNoDevice;
     }
@@ -731,7 +1187,7 @@ PaDeviceIndex Pa_GetDefaultOutputDevice( void )
     PA_LOGAPI_ENTER( "Pa_GetDefaultOutputDevice" );
 
     hostApi = Pa_GetDefaultHostApi();
-    if( hostApi < 0 )
+    if( hostApi < 0 || !HostApiIsReady( hostApi ) )
     {
         result = paNoDevice;
     }
@@ -785,6 +1241,122 @@ const PaDeviceInfo* Pa_GetDeviceInfo( PaDeviceIndex device )
 }
 
 
+PaError Pa_UpdateAvailableDeviceList( void )
+{
+    PaError result = paNoError;
+    void **scanResults = 0;
+    int *deviceCounts = 0;
+    int i;
+
+    PA_LOGAPI_ENTER( "Pa_UpdateAvailableDeviceList" );
+
+    if( !PA_IS_INITIALISED_ )
+    {
+        result = paNotInitialized;
+        goto done;
+    }
+
+    scanResults = (void**)PaUtil_AllocateMemory( sizeof(void*) * hostApisCount_ );
+    deviceCounts = (int*)PaUtil_AllocateMemory( sizeof(int) * hostApisCount_ );
+    if( !scanResults || !deviceCounts )
+    {
+        result = paInsufficientMemory;
+        goto done;
+    }
+
+    /* scan every host API before committing any, so that a failed scan leaves
+        the device list as it was */
+    for( i = 0; i < hostApisCount_; ++i )
+    {
+        PaUtilHostApiRepresentation *hostApi = hostApis_[i];
+
+        scanResults[i] = 0;
+        deviceCounts[i] = 0;
+        if( result != paNoError || !HostApiIsReady( i ) || !hostApi->ScanDeviceInfos )
+            continue;
+
+        result = hostApi->ScanDeviceInfos( hostApi, i, &scanResults[i], &deviceCounts[i] );
+        if( result != paNoError )
+            scanResults[i] = 0;
+    }
+
+    if( result != paNoError )
+    {
+        for( i = 0; i < hostApisCount_; ++i )
+        {
+            if( scanResults[i] )
+                hostApis_[i]->DisposeDeviceInfos( hostApis_[i], scanResults[i], deviceCounts[i] );
+        }
+        goto done;
+    }
+
+    /* host APIs that have not been initialized yet are attached after these,
+        as usual */
+    deviceCount_ = 0;
+    for( i = 0; i < hostApisCount_; ++i )
+    {
+        PaUtilHostApiRepresentation *hostApi = hostApis_[i];
+
+        if( !HostApiIsReady( i ) )
+            continue;
+
+        DetachHostApi( hostApi );
+        if( scanResults[i] )
+            hostApi->CommitDeviceInfos( hostApi, i, scanResults[i], deviceCounts[i] );
+        AttachHostApi( hostApi );
+    }
+
+done:
+    if( scanResults )
+        PaUtil_FreeMemory( scanResults );
+    if( deviceCounts )
+        PaUtil_FreeMemory( deviceCounts );
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_UpdateAvailableDeviceList", result );
+
+    return result;
+}
+
+
+PaError Pa_SetDevicesChangedCallback( void *userData, PaDevicesChangedCallback* devicesChangedCallback )
+{
+    PaError result = paNoError;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetDevicesChangedCallback" );
+    PA_LOGAPI(("\tvoid *userData: 0x%p\n", userData ));
+    PA_LOGAPI(("\tPaDevicesChangedCallback* devicesChangedCallback: 0x%p\n", devicesChangedCallback ));
+
+    if( !PA_IS_INITIALISED_ )
+    {
+        result = paNotInitialized;
+    }
+    else
+    {
+        /* clear the callback first, so that a host API thread never pairs it
+            with the wrong userData */
+        devicesChangedCallback_ = 0;
+        PaUtil_FullMemoryBarrier();
+        devicesChangedUserData_ = userData;
+        PaUtil_FullMemoryBarrier();
+        devicesChangedCallback_ = devicesChangedCallback;
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetDevicesChangedCallback", result );
+
+    return result;
+}
+
+
+void PaUtil_DevicesChanged( void )
+{
+    PaDevicesChangedCallback *callback = devicesChangedCallback_;
+
+    PaUtil_ReadMemoryBarrier();
+    if( callback )
+        callback( devicesChangedUserData_ );
+}
+
+
 /*
     SampleFormatIsValid() returns 1 if sampleFormat is a sample format
     defined in portaudio.h, or 0 otherwise.
@@ -905,7 +1477,7 @@ static PaError ValidateOpenStreamParameters(
                 inputHostApiIndex = Pa_HostApiTypeIdToHostApiIndex(
                         ((PaUtilHostApiSpecificStreamInfoHeader*)inputParameters->hostApiSpecificStreamInfo)->hostApiType );
 
-                if( inputHostApiIndex != -1 )
+                if( inputHostApiIndex >= 0 )
                 {
                     *hostApiInputDevice = paUseHostApiSpecificDeviceSpecification;
                     *hostApi = hostApis_[inputHostApiIndex];
@@ -956,7 +1528,7 @@ static PaError ValidateOpenStreamParameters(
                 outputHostApiIndex = Pa_HostApiTypeIdToHostApiIndex(
                         ((PaUtilHostApiSpecificStreamInfoHeader*)outputParameters->hostApiSpecificStreamInfo)->hostApiType );
 
-                if( outputHostApiIndex != -1 )
+                if( outputHostApiIndex >= 0 )
                 {
                     *hostApiOutputDevice = paUseHostApiSpecificDeviceSpecification;
                     *hostApi = hostApis_[outputHostApiIndex];
@@ -1009,7 +1581,11 @@ static PaError ValidateOpenStreamParameters(
     if( (sampleRate < 1000.0) || (sampleRate > 384000.0) )
         return paInvalidSampleRate;
 
-    if( ((streamFlags & ~paPlatformSpecificFlags) & ~(paClipOff | paDitherOff | paNeverDropInput | paPrimeOutputBuffersUsingStreamCallback ) ) != 0 )
+    if( ((streamFlags & ~paPlatformSpecificFlags) & ~(paClipOff | paDitherOff | paNeverDropInput | paPrimeOutputBuffersUsingStreamCallback | paDitherNoiseShapingMask ) ) != 0 )
+        return paInvalidFlag;
+
+    /* noise shaping is a kind of dither */
+    if( (streamFlags & paDitherNoiseShapingMask) && (streamFlags & paDitherOff) )
         return paInvalidFlag;
 
     if( streamFlags & paNeverDropInput )
@@ -1135,6 +1711,54 @@ PaError Pa_IsFormatSupported( const PaStreamParameters *inputParameters,
 }
 
 
+PaError Pa_GetDeviceNativeSampleFormats( PaDeviceIndex device, int isInput,
+                                         PaSampleFormat *sampleFormats )
+{
+    PaError result = paNoError;
+    PaUtilHostApiRepresentation *hostApi;
+    const PaDeviceInfo *deviceInfo;
+    int hostSpecificDeviceIndex;
+    int hostApiIndex;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_GetDeviceNativeSampleFormats" );
+    PA_LOGAPI(("\tPaDeviceIndex device: %d\n", device ));
+    PA_LOGAPI(("\tint isInput: %d\n", isInput ));
+
+    *sampleFormats = 0;
+
+    if( !PA_IS_INITIALISED_ )
+    {
+        result = paNotInitialized;
+        goto done;
+    }
+
+    hostApiIndex = FindHostApi( device, &hostSpecificDeviceIndex );
+    if( hostApiIndex < 0 )
+    {
+        result = paInvalidDevice;
+        goto done;
+    }
+
+    hostApi = hostApis_[hostApiIndex];
+    deviceInfo = hostApi->deviceInfos[ hostSpecificDeviceIndex ];
+    if( ( isInput ? deviceInfo->maxInputChannels : deviceInfo->maxOutputChannels ) <= 0 )
+    {
+        result = paInvalidChannelCount;
+        goto done;
+    }
+
+    if( hostApi->GetNativeSampleFormats )
+        result = hostApi->GetNativeSampleFormats( hostApi, hostSpecificDeviceIndex, isInput, sampleFormats );
+
+done:
+    PA_LOGAPI(("Pa_GetDeviceNativeSampleFormats returned:\n" ));
+    PA_LOGAPI(("\tPaSampleFormat *sampleFormats: 0x%lx\n", (unsigned long)*sampleFormats ));
+    PA_LOGAPI_EXIT_PAERROR( "Pa_GetDeviceNativeSampleFormats", result );
+
+    return result;
+}
+
+
 PaError Pa_OpenStream( PaStream** stream,
                        const PaStreamParameters *inputParameters,
                        const PaStreamParameters *outputParameters,
@@ -1258,7 +1882,14 @@ PaError Pa_OpenStream( PaStream** stream,
                                   sampleRate, framesPerBuffer, streamFlags, streamCallback, userData );
 
     if( result == paNoError )
-        AddOpenStream( *stream );
+    {
+        result = AddOpenStream( stream );
+        if( result != paNoError )
+        {
+            PA_STREAM_INTERFACE(*stream)->Close( *stream );
+            *stream = NULL;
+        }
+    }
 
 
     PA_LOGAPI(("Pa_OpenStream returned:\n" ));
@@ -1352,45 +1983,69 @@ PaError Pa_OpenDefaultStream( PaStream** stream,
 }
 
 
-PaError PaUtil_ValidateStreamPointer( PaStream* stream )
+PaError PaUtil_GetStreamRepresentation( PaStream* stream, PaUtilStreamRepresentation **streamRepresentation )
 {
+    PaUtilStreamRepresentation *found;
+
     if( !PA_IS_INITIALISED_ ) return paNotInitialized;
 
     if( stream == NULL ) return paBadStreamPtr;
 
-    if( ((PaUtilStreamRepresentation*)stream)->magic != PA_STREAM_MAGIC )
+    /* A stream that was closed no longer holds its slot, and the slot has moved on to the next generation */
+    found = FindOpenStream( stream );
+    if( !found || found->magic != PA_STREAM_MAGIC )
         return paBadStreamPtr;
 
+    *streamRepresentation = found;
     return paNoError;
 }
 
 
+PaError PaUtil_ValidateStreamPointer( PaStream* stream )
+{
+    PaUtilStreamRepresentation *streamRepresentation;
+
+    return PaUtil_GetStreamRepresentation( stream, &streamRepresentation );
+}
+
+
+/* Resolve a client's handle to the stream the host api opened, which is what its stream interface takes */
+static PaError GetHostStream( PaStream* stream, PaStream** hostStream )
+{
+    PaUtilStreamRepresentation *streamRepresentation = NULL;
+    PaError result = PaUtil_GetStreamRepresentation( stream, &streamRepresentation );
+
+    *hostStream = streamRepresentation;
+    return result;
+}
+
+
 PaError Pa_CloseStream( PaStream* stream )
 {
     PaUtilStreamInterface *interface;
-    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_CloseStream" );
     PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
 
-    /* always remove the open stream from our list, even if this function
-        eventually returns an error. Otherwise CloseOpenStreams() will
-        get stuck in an infinite loop */
-    RemoveOpenStream( stream ); /* be sure to call this _before_ closing the stream */
-
     if( result == paNoError )
     {
-        interface = PA_STREAM_INTERFACE(stream);
+        /* always remove a valid stream from the table, even if this function
+            eventually returns an error, so it is never closed twice */
+        RemoveOpenStream( stream ); /* be sure to call this _before_ closing the stream */
+
+        interface = PA_STREAM_INTERFACE(hostStream);
 
         /* abort the stream if it isn't stopped */
-        result = interface->IsStopped( stream );
+        result = interface->IsStopped( hostStream );
         if( result == 1 )
             result = paNoError;
         else if( result == 0 )
-            result = interface->Abort( stream );
+            result = interface->Abort( hostStream );
 
         if( result == paNoError )                 /** @todo REVIEW: shouldn't we close anyway? see: http://www.portaudio.com/trac/ticket/115 */
-            result = interface->Close( stream );
+            result = interface->Close( hostStream );
     }
 
     PA_LOGAPI_EXIT_PAERROR( "Pa_CloseStream", result );
@@ -1401,7 +2056,8 @@ PaError Pa_CloseStream( PaStream* stream )
 
 PaError Pa_SetStreamFinishedCallback( PaStream *stream, PaStreamFinishedCallback* streamFinishedCallback )
 {
-    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamFinishedCallback" );
     PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
@@ -1409,14 +2065,14 @@ PaError Pa_SetStreamFinishedCallback( PaStream *stream, PaStreamFinishedCallback
 
     if( result == paNoError )
     {
-        result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+        result = PA_STREAM_INTERFACE(hostStream)->IsStopped( hostStream );
         if( result == 0 )
         {
             result = paStreamIsNotStopped ;
         }
         if( result == 1 )
         {
-            PA_STREAM_REP( stream )->streamFinishedCallback = streamFinishedCallback;
+            PA_STREAM_REP( hostStream )->streamFinishedCallback = streamFinishedCallback;
             result = paNoError;
         }
     }
@@ -1430,21 +2086,22 @@ PaError Pa_SetStreamFinishedCallback( PaStream *stream, PaStreamFinishedCallback
 
 PaError Pa_StartStream( PaStream *stream )
 {
-    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_StartStream" );
     PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
 
     if( result == paNoError )
     {
-        result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+        result = PA_STREAM_INTERFACE(hostStream)->IsStopped( hostStream );
         if( result == 0 )
         {
             result = paStreamIsNotStopped ;
         }
         else if( result == 1 )
         {
-            result = PA_STREAM_INTERFACE(stream)->Start( stream );
+            result = PA_STREAM_INTERFACE(hostStream)->Start( hostStream );
         }
     }
 
@@ -1456,17 +2113,18 @@ PaError Pa_StartStream( PaStream *stream )
 
 PaError Pa_StopStream( PaStream *stream )
 {
-    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_StopStream" );
     PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
 
     if( result == paNoError )
     {
-        result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+        result = PA_STREAM_INTERFACE(hostStream)->IsStopped( hostStream );
         if( result == 0 )
         {
-            result = PA_STREAM_INTERFACE(stream)->Stop( stream );
+            result = PA_STREAM_INTERFACE(hostStream)->Stop( hostStream );
         }
         else if( result == 1 )
         {
@@ -1482,17 +2140,18 @@ PaError Pa_StopStream( PaStream *stream )
 
 PaError Pa_AbortStream( PaStream *stream )
 {
-    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_AbortStream" );
     PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
 
     if( result == paNoError )
     {
-        result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+        result = PA_STREAM_INTERFACE(hostStream)->IsStopped( hostStream );
         if( result == 0 )
         {
-            result = PA_STREAM_INTERFACE(stream)->Abort( stream );
+            result = PA_STREAM_INTERFACE(hostStream)->Abort( hostStream );
         }
         else if( result == 1 )
         {
@@ -1508,13 +2167,14 @@ PaError Pa_AbortStream( PaStream *stream )
 
 PaError Pa_IsStreamStopped( PaStream *stream )
 {
-    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_IsStreamStopped" );
     PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
 
     if( result == paNoError )
-        result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+        result = PA_STREAM_INTERFACE(hostStream)->IsStopped( hostStream );
 
     PA_LOGAPI_EXIT_PAERROR( "Pa_IsStreamStopped", result );
 
@@ -1524,13 +2184,14 @@ PaError Pa_IsStreamStopped( PaStream *stream )
 
 PaError Pa_IsStreamActive( PaStream *stream )
 {
-    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_IsStreamActive" );
     PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
 
     if( result == paNoError )
-        result = PA_STREAM_INTERFACE(stream)->IsActive( stream );
+        result = PA_STREAM_INTERFACE(hostStream)->IsActive( hostStream );
 
 
     PA_LOGAPI_EXIT_PAERROR( "Pa_IsStreamActive", result );
@@ -1541,7 +2202,8 @@ PaError Pa_IsStreamActive( PaStream *stream )
 
 const PaStreamInfo* Pa_GetStreamInfo( PaStream *stream )
 {
-    PaError error = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError error = GetHostStream( stream, &hostStream );
     const PaStreamInfo *result;
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamInfo" );
@@ -1557,7 +2219,7 @@ const PaStreamInfo* Pa_GetStreamInfo( PaStream *stream )
     }
     else
     {
-        result = &PA_STREAM_REP( stream )->streamInfo;
+        result = &PA_STREAM_REP( hostStream )->streamInfo;
 
         PA_LOGAPI(("Pa_GetStreamInfo returned:\n" ));
         PA_LOGAPI(("\tconst PaStreamInfo*: 0x%p:\n", result ));
@@ -1577,7 +2239,8 @@ const PaStreamInfo* Pa_GetStreamInfo( PaStream *stream )
 
 PaTime Pa_GetStreamTime( PaStream *stream )
 {
-    PaError error = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError error = GetHostStream( stream, &hostStream );
     PaTime result;
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamTime" );
@@ -1593,7 +2256,7 @@ PaTime Pa_GetStreamTime( PaStream *stream )
     }
     else
     {
-        result = PA_STREAM_INTERFACE(stream)->GetTime( stream );
+        result = PA_STREAM_INTERFACE(hostStream)->GetTime( hostStream );
 
         PA_LOGAPI(("Pa_GetStreamTime returned:\n" ));
         PA_LOGAPI(("\tPaTime: %g\n", result ));
@@ -1606,7 +2269,8 @@ PaTime Pa_GetStreamTime( PaStream *stream )
 
 double Pa_GetStreamCpuLoad( PaStream* stream )
 {
-    PaError error = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError error = GetHostStream( stream, &hostStream );
     double result;
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamCpuLoad" );
@@ -1623,7 +2287,7 @@ double Pa_GetStreamCpuLoad( PaStream* stream )
     }
     else
     {
-        result = PA_STREAM_INTERFACE(stream)->GetCpuLoad( stream );
+        result = PA_STREAM_INTERFACE(hostStream)->GetCpuLoad( hostStream );
 
         PA_LOGAPI(("Pa_GetStreamCpuLoad returned:\n" ));
         PA_LOGAPI(("\tdouble: %g\n", result ));
@@ -1634,11 +2298,103 @@ double Pa_GetStreamCpuLoad( PaStream* stream )
 }
 
 
+PaError Pa_GetStreamCallbackStats( PaStream *stream, PaStreamCallbackStats *stats )
+{
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
+    PaUtilStreamRepresentation *streamRepresentation;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamCallbackStats" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tPaStreamCallbackStats* stats: 0x%p\n", stats ));
+
+    if( result == paNoError && stats == NULL )
+        result = paBadBufferPtr;
+
+    if( result == paNoError )
+    {
+        streamRepresentation = PA_STREAM_REP( hostStream );
+        if( streamRepresentation->cpuLoadMeasurer )
+        {
+            PaUtil_GetCpuLoadStats( streamRepresentation->cpuLoadMeasurer, stats );
+        }
+        else
+        {
+            memset( stats, 0, sizeof(PaStreamCallbackStats) );
+        }
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_GetStreamCallbackStats", result );
+
+    return result;
+}
+
+
+PaError Pa_SetStreamThreadPolicy( PaStream *stream, const PaThreadPolicy *policy )
+{
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
+    PaUtilStreamRepresentation *streamRepresentation;
+    int i;
+
+    PA_LOGAPI_ENTER_PARAMS( "Pa_SetStreamThreadPolicy" );
+    PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
+    PA_LOGAPI(("\tconst PaThreadPolicy* policy: 0x%p\n", policy ));
+
+    if( result == paNoError )
+    {
+        result = PA_STREAM_INTERFACE(hostStream)->IsStopped( hostStream );
+        if( result == 1 )
+            result = paNoError;
+        else if( result == 0 )
+            result = paStreamIsNotStopped;
+    }
+
+    if( result == paNoError && policy )
+    {
+        if( policy->policy < paSchedulingDefault || policy->policy > paSchedulingDeadline
+                || policy->priority < 0 || policy->priority > 99
+                || !(policy->runtimeFraction >= 0. && policy->runtimeFraction <= 1.)
+                || policy->cpuCount < 0 || policy->cpuCount > paMaxThreadPolicyCpus
+                || (policy->flags & ~paThreadPolicyFallback) )
+        {
+            result = paInvalidFlag;
+        }
+        else if( policy->policy == paSchedulingDeadline && policy->cpuCount > 0
+                && !(policy->flags & paThreadPolicyFallback) )
+        {
+            /* SCHED_DEADLINE refuses threads that can't run on every CPU, this could never be applied */
+            result = paInvalidFlag;
+        }
+
+        for( i = 0; result == paNoError && i < policy->cpuCount; ++i )
+        {
+            if( policy->cpus[i] < 0 )
+                result = paInvalidFlag;
+        }
+    }
+
+    if( result == paNoError )
+    {
+        streamRepresentation = PA_STREAM_REP( hostStream );
+        if( policy )
+            streamRepresentation->threadPolicy = *policy;
+        else
+            memset( &streamRepresentation->threadPolicy, 0, sizeof(PaThreadPolicy) );
+    }
+
+    PA_LOGAPI_EXIT_PAERROR( "Pa_SetStreamThreadPolicy", result );
+
+    return result;
+}
+
+
 PaError Pa_ReadStream( PaStream* stream,
                        void *buffer,
                        unsigned long frames )
 {
-    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_ReadStream" );
     PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
@@ -1656,10 +2412,10 @@ PaError Pa_ReadStream( PaStream* stream,
         }
         else
         {
-            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            result = PA_STREAM_INTERFACE(hostStream)->IsStopped( hostStream );
             if( result == 0 )
             {
-                result = PA_STREAM_INTERFACE(stream)->Read( stream, buffer, frames );
+                result = PA_STREAM_INTERFACE(hostStream)->Read( hostStream, buffer, frames );
             }
             else if( result == 1 )
             {
@@ -1678,7 +2434,8 @@ PaError Pa_WriteStream( PaStream* stream,
                         const void *buffer,
                         unsigned long frames )
 {
-    PaError result = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError result = GetHostStream( stream, &hostStream );
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_WriteStream" );
     PA_LOGAPI(("\tPaStream* stream: 0x%p\n", stream ));
@@ -1696,10 +2453,10 @@ PaError Pa_WriteStream( PaStream* stream,
         }
         else
         {
-            result = PA_STREAM_INTERFACE(stream)->IsStopped( stream );
+            result = PA_STREAM_INTERFACE(hostStream)->IsStopped( hostStream );
             if( result == 0 )
             {
-                result = PA_STREAM_INTERFACE(stream)->Write( stream, buffer, frames );
+                result = PA_STREAM_INTERFACE(hostStream)->Write( hostStream, buffer, frames );
             }
             else if( result == 1 )
             {
@@ -1715,7 +2472,8 @@ PaError Pa_WriteStream( PaStream* stream,
 
 signed long Pa_GetStreamReadAvailable( PaStream* stream )
 {
-    PaError error = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError error = GetHostStream( stream, &hostStream );
     signed long result;
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamReadAvailable" );
@@ -1731,7 +2489,7 @@ signed long Pa_GetStreamReadAvailable( PaStream* stream )
     }
     else
     {
-        result = PA_STREAM_INTERFACE(stream)->GetReadAvailable( stream );
+        result = PA_STREAM_INTERFACE(hostStream)->GetReadAvailable( hostStream );
 
         PA_LOGAPI(("Pa_GetStreamReadAvailable returned:\n" ));
         PA_LOGAPI(("\tPaError: %d ( %s )\n", result, Pa_GetErrorText( result ) ));
@@ -1744,7 +2502,8 @@ signed long Pa_GetStreamReadAvailable( PaStream* stream )
 
 signed long Pa_GetStreamWriteAvailable( PaStream* stream )
 {
-    PaError error = PaUtil_ValidateStreamPointer( stream );
+    PaStream *hostStream;
+    PaError error = GetHostStream( stream, &hostStream );
     signed long result;
 
     PA_LOGAPI_ENTER_PARAMS( "Pa_GetStreamWriteAvailable" );
@@ -1760,7 +2519,7 @@ signed long Pa_GetStreamWriteAvailable( PaStream* stream )
     }
     else
     {
-        result = PA_STREAM_INTERFACE(stream)->GetWriteAvailable( stream );
+        result = PA_STREAM_INTERFACE(hostStream)->GetWriteAvailable( hostStream );
 
         PA_LOGAPI(("Pa_GetStreamWriteAvailable returned:\n" ));
         PA_LOGAPI(("\tPaError: %d ( %s )\n", result, Pa_GetErrorText( result ) ));
@@ -107,7 +107,7 @@ are defaulted to 1.
 #endif
 
 /* Set default values for Unix based APIs. */
-#if defined(PA_NO_OSS) || defined(PA_NO_ALSA) || defined(PA_NO_JACK) || defined(PA_NO_COREAUDIO) || defined(PA_NO_SGI) || defined(PA_NO_ASIHPI)
+#if defined(PA_NO_OSS) || defined(PA_NO_ALSA) || defined(PA_NO_JACK) || defined(PA_NO_COREAUDIO) || defined(PA_NO_SGI) || defined(PA_NO_ASIHPI) || defined(PA_NO_OFFLINE)
 #error "Portaudio: PA_NO_<APINAME> is no longer supported, please remove definition and use PA_USE_<APINAME> instead"
 #endif
 
@@ -153,6 +153,13 @@ are defaulted to 1.
 #define PA_USE_ASIHPI 1
 #endif
 
+#ifndef PA_USE_OFFLINE
+#define PA_USE_OFFLINE 0
+#elif (PA_USE_OFFLINE != 0) && (PA_USE_OFFLINE != 1)
+#undef PA_USE_OFFLINE
+#define PA_USE_OFFLINE 1
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -322,6 +329,49 @@ typedef struct PaUtilHostApiRepresentation {
                                   const PaStreamParameters *inputParameters,
                                   const PaStreamParameters *outputParameters,
                                   double sampleRate );
+
+    /**
+        The following three functions let Pa_UpdateAvailableDeviceList() pick
+        up devices that were added or removed after initialization. A host API
+        that can not rescan its devices must set all three to NULL.
+
+        (*ScanDeviceInfos)() builds a new device list without touching the
+        current one, and returns it in an implementation defined form in
+        <scanResults>, with the number of devices it holds in <newDeviceCount>.
+
+        (*CommitDeviceInfos)() replaces info.deviceCount, info.defaultInputDevice,
+        info.defaultOutputDevice (as 0 based host api indices, as for the
+        initializer) and deviceInfos with those of a scan, and frees the
+        previous device list. It must not fail. Open streams must not depend on
+        the previous device list, which is gone once it returns.
+
+        (*DisposeDeviceInfos)() frees a scan that was not committed.
+    */
+    PaError (*ScanDeviceInfos)( struct PaUtilHostApiRepresentation *hostApi,
+                                PaHostApiIndex index,
+                                void **scanResults,
+                                int *newDeviceCount );
+
+    void (*CommitDeviceInfos)( struct PaUtilHostApiRepresentation *hostApi,
+                               PaHostApiIndex index,
+                               void *scanResults,
+                               int deviceCount );
+
+    void (*DisposeDeviceInfos)( struct PaUtilHostApiRepresentation *hostApi,
+                                void *scanResults,
+                                int deviceCount );
+
+    /**
+        Report the sample formats a device takes without conversion, with
+        paNonInterleaved set if it takes non-interleaved buffers only, for
+        Pa_GetDeviceNativeSampleFormats(). device is a host api device index,
+        and has at least one channel in the given direction. May be NULL, in
+        which case no native formats are reported.
+    */
+    PaError (*GetNativeSampleFormats)( struct PaUtilHostApiRepresentation *hostApi,
+                                       PaDeviceIndex device,
+                                       int isInput,
+                                       PaSampleFormat *sampleFormats );
 } PaUtilHostApiRepresentation;
 
 
@@ -356,6 +406,27 @@ typedef PaError PaUtilHostApiInitializer( PaUtilHostApiRepresentation**, PaHostA
 extern PaUtilHostApiInitializer *paHostApiInitializers[];
 
 
+/** paHostApiInitializerTypes lists the PaHostApiTypeId of each entry in
+ paHostApiInitializers, in the same order. pa_front.c uses it to identify host
+ APIs before they are initialized when PortAudio is initialized with
+ Pa_InitializeDeferred().
+
+ It is defined next to paHostApiInitializers, and the two arrays must be kept
+ in step.
+*/
+extern const PaHostApiTypeId paHostApiInitializerTypes[];
+
+
+/** Host APIs call PaUtil_DevicesChanged(), from any thread, when they notice
+ that devices have been added or removed. It calls the client's
+ PaDevicesChangedCallback, if one is set, and nothing else: the device list only
+ changes when the client calls Pa_UpdateAvailableDeviceList().
+
+ @see Pa_SetDevicesChangedCallback
+*/
+void PaUtil_DevicesChanged( void );
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
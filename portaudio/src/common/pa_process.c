@@ -49,6 +49,7 @@
 
 #include "pa_process.h"
 #include "pa_util.h"
+#include "pa_trace.h"
 
 
 #define PA_FRAMES_PER_TEMP_BUFFER_WHEN_HOST_BUFFER_SIZE_IS_UNKNOWN_    1024
@@ -87,6 +88,17 @@ static unsigned long CalculateFrameShift( unsigned long M, unsigned long N )
 }
 
 
+static int NoiseShapingOrder( PaStreamFlags streamFlags )
+{
+    switch( streamFlags & paDitherNoiseShapingMask )
+    {
+    case paDitherNoiseShapingFirstOrder:    return 1;
+    case paDitherNoiseShapingSecondOrder:   return 2;
+    default:                                return 5;
+    }
+}
+
+
 PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         int inputChannelCount, PaSampleFormat userInputSampleFormat,
         PaSampleFormat hostInputSampleFormat,
@@ -103,6 +115,8 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
     PaError bytesPerSample;
     unsigned long tempInputBufferSize, tempOutputBufferSize;
     PaStreamFlags tempInputStreamFlags;
+    long reservedSize;
+    int i;
 
     if( streamFlags & paNeverDropInput )
     {
@@ -117,6 +131,8 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
     bp->tempInputBufferPtrs = 0;
     bp->tempOutputBuffer = 0;
     bp->tempOutputBufferPtrs = 0;
+    bp->noiseShapers = 0;
+    bp->allocations = 0;
 
     bp->framesPerUserBuffer = framesPerUserBuffer;
     bp->framesPerHostBuffer = framesPerHostBuffer;
@@ -199,6 +215,38 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
     bp->framesInTempOutputBuffer = bp->initialFramesInTempOutputBuffer;
 
 
+    /* all the blocks allocated below share one region, faulted in now rather
+        than by the first calls to the callback */
+    bp->allocations = PaUtil_CreateAllocationGroup();
+    if( bp->allocations == 0 )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    reservedSize = 0;
+    if( inputChannelCount > 0 )
+    {
+        bytesPerSample = Pa_GetSampleSize( userInputSampleFormat );
+        reservedSize += bp->framesPerTempBuffer * (bytesPerSample > 0 ? bytesPerSample : 0) * inputChannelCount
+                + sizeof(void*) * inputChannelCount
+                + sizeof(PaUtilChannelDescriptor) * inputChannelCount * 2;
+    }
+    if( outputChannelCount > 0 )
+    {
+        bytesPerSample = Pa_GetSampleSize( userOutputSampleFormat );
+        reservedSize += bp->framesPerTempBuffer * (bytesPerSample > 0 ? bytesPerSample : 0) * outputChannelCount
+                + sizeof(void*) * outputChannelCount
+                + sizeof(PaUtilChannelDescriptor) * outputChannelCount * 2
+                + sizeof(PaUtilNoiseShaper) * outputChannelCount;
+    }
+
+    result = PaUtil_ReserveGroupMemory( bp->allocations, reservedSize, 7,
+            paUtilRegionHugePages | paUtilRegionPrefault );
+    if( result != paNoError )
+        goto error;
+
+
     if( inputChannelCount > 0 )
     {
         bytesPerSample = Pa_GetSampleSize( hostInputSampleFormat );
@@ -249,7 +297,7 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         tempInputBufferSize =
             bp->framesPerTempBuffer * bp->bytesPerUserInputSample * inputChannelCount;
 
-        bp->tempInputBuffer = PaUtil_AllocateMemory( tempInputBufferSize );
+        bp->tempInputBuffer = PaUtil_GroupAllocateMemory( bp->allocations, tempInputBufferSize );
         if( bp->tempInputBuffer == 0 )
         {
             result = paInsufficientMemory;
@@ -262,7 +310,7 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         if( userInputSampleFormat & paNonInterleaved )
         {
             bp->tempInputBufferPtrs =
-                (void **)PaUtil_AllocateMemory( sizeof(void*)*inputChannelCount );
+                (void **)PaUtil_GroupAllocateMemory( bp->allocations, sizeof(void*)*inputChannelCount );
             if( bp->tempInputBufferPtrs == 0 )
             {
                 result = paInsufficientMemory;
@@ -271,7 +319,7 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         }
 
         bp->hostInputChannels[0] = (PaUtilChannelDescriptor*)
-                PaUtil_AllocateMemory( sizeof(PaUtilChannelDescriptor) * inputChannelCount * 2);
+                PaUtil_GroupAllocateMemory( bp->allocations, sizeof(PaUtilChannelDescriptor) * inputChannelCount * 2);
         if( bp->hostInputChannels[0] == 0 )
         {
             result = paInsufficientMemory;
@@ -308,6 +356,30 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         bp->outputConverter =
             PaUtil_SelectConverter( userOutputSampleFormat, hostOutputSampleFormat, streamFlags );
 
+        if( streamFlags & paDitherNoiseShapingMask )
+        {
+            PaUtilConverter *noiseShapingConverter =
+                PaUtil_SelectNoiseShapingConverter( userOutputSampleFormat, hostOutputSampleFormat );
+
+            /* conversions without a noise shaping converter keep the
+                triangular dither converter selected above */
+            if( noiseShapingConverter )
+            {
+                bp->noiseShapers = (PaUtilNoiseShaper*)
+                        PaUtil_GroupAllocateMemory( bp->allocations, sizeof(PaUtilNoiseShaper) * outputChannelCount );
+                if( bp->noiseShapers == 0 )
+                {
+                    result = paInsufficientMemory;
+                    goto error;
+                }
+
+                for( i=0; i<outputChannelCount; ++i )
+                    PaUtil_InitializeNoiseShaper( &bp->noiseShapers[i], NoiseShapingOrder( streamFlags ), i );
+
+                bp->outputConverter = noiseShapingConverter;
+            }
+        }
+
         bp->outputZeroer = PaUtil_SelectZeroer( hostOutputSampleFormat );
 
         bp->userOutputIsInterleaved = (userOutputSampleFormat & paNonInterleaved)?0:1;
@@ -319,7 +391,7 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         tempOutputBufferSize =
                 bp->framesPerTempBuffer * bp->bytesPerUserOutputSample * outputChannelCount;
 
-        bp->tempOutputBuffer = PaUtil_AllocateMemory( tempOutputBufferSize );
+        bp->tempOutputBuffer = PaUtil_GroupAllocateMemory( bp->allocations, tempOutputBufferSize );
         if( bp->tempOutputBuffer == 0 )
         {
             result = paInsufficientMemory;
@@ -332,7 +404,7 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         if( userOutputSampleFormat & paNonInterleaved )
         {
             bp->tempOutputBufferPtrs =
-                (void **)PaUtil_AllocateMemory( sizeof(void*)*outputChannelCount );
+                (void **)PaUtil_GroupAllocateMemory( bp->allocations, sizeof(void*)*outputChannelCount );
             if( bp->tempOutputBufferPtrs == 0 )
             {
                 result = paInsufficientMemory;
@@ -341,7 +413,7 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
         }
 
         bp->hostOutputChannels[0] = (PaUtilChannelDescriptor*)
-                PaUtil_AllocateMemory( sizeof(PaUtilChannelDescriptor)*outputChannelCount * 2 );
+                PaUtil_GroupAllocateMemory( bp->allocations, sizeof(PaUtilChannelDescriptor)*outputChannelCount * 2 );
         if( bp->hostOutputChannels[0] == 0 )
         {
             result = paInsufficientMemory;
@@ -361,23 +433,12 @@ PaError PaUtil_InitializeBufferProcessor( PaUtilBufferProcessor* bp,
     return result;
 
 error:
-    if( bp->tempInputBuffer )
-        PaUtil_FreeMemory( bp->tempInputBuffer );
-
-    if( bp->tempInputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempInputBufferPtrs );
-
-    if( bp->hostInputChannels[0] )
-        PaUtil_FreeMemory( bp->hostInputChannels[0] );
-
-    if( bp->tempOutputBuffer )
-        PaUtil_FreeMemory( bp->tempOutputBuffer );
-
-    if( bp->tempOutputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempOutputBufferPtrs );
-
-    if( bp->hostOutputChannels[0] )
-        PaUtil_FreeMemory( bp->hostOutputChannels[0] );
+    if( bp->allocations )
+    {
+        PaUtil_FreeAllAllocations( bp->allocations );
+        PaUtil_DestroyAllocationGroup( bp->allocations );
+        bp->allocations = 0;
+    }
 
     return result;
 }
@@ -385,29 +446,19 @@ error:
 
 void PaUtil_TerminateBufferProcessor( PaUtilBufferProcessor* bp )
 {
-    if( bp->tempInputBuffer )
-        PaUtil_FreeMemory( bp->tempInputBuffer );
-
-    if( bp->tempInputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempInputBufferPtrs );
-
-    if( bp->hostInputChannels[0] )
-        PaUtil_FreeMemory( bp->hostInputChannels[0] );
-
-    if( bp->tempOutputBuffer )
-        PaUtil_FreeMemory( bp->tempOutputBuffer );
-
-    if( bp->tempOutputBufferPtrs )
-        PaUtil_FreeMemory( bp->tempOutputBufferPtrs );
-
-    if( bp->hostOutputChannels[0] )
-        PaUtil_FreeMemory( bp->hostOutputChannels[0] );
+    if( bp->allocations )
+    {
+        PaUtil_FreeAllAllocations( bp->allocations );
+        PaUtil_DestroyAllocationGroup( bp->allocations );
+        bp->allocations = 0;
+    }
 }
 
 
 void PaUtil_ResetBufferProcessor( PaUtilBufferProcessor* bp )
 {
     unsigned long tempInputBufferSize, tempOutputBufferSize;
+    unsigned int i;
 
     bp->framesInTempInputBuffer = bp->initialFramesInTempInputBuffer;
     bp->framesInTempOutputBuffer = bp->initialFramesInTempOutputBuffer;
@@ -425,6 +476,12 @@ void PaUtil_ResetBufferProcessor( PaUtilBufferProcessor* bp )
             bp->framesPerTempBuffer * bp->bytesPerUserOutputSample * bp->outputChannelCount;
         memset( bp->tempOutputBuffer, 0, tempOutputBufferSize );
     }
+
+    if( bp->noiseShapers )
+    {
+        for( i=0; i<bp->outputChannelCount; ++i )
+            PaUtil_ResetNoiseShaper( &bp->noiseShapers[i] );
+    }
 }
 
 
@@ -692,6 +749,44 @@ void PaUtil_BeginBufferProcessing( PaUtilBufferProcessor* bp,
 }
 
 
+/*
+    Returns non-zero if the channel descriptors describe a single interleaved
+    buffer holding exactly channelCount channels, in which case all channels
+    can be converted with one call of frameCount * channelCount samples at
+    stride 1. This lets SIMD converters see one contiguous run instead of
+    channelCount strided ones.
+*/
+static int IsContiguousInterleaved( PaUtilChannelDescriptor *channels,
+        unsigned int channelCount, unsigned int bytesPerSample )
+{
+    unsigned int i;
+
+    for( i=0; i<channelCount; ++i )
+    {
+        if( channels[i].stride != channelCount
+                || channels[i].data != ((unsigned char*)channels[0].data) + i * bytesPerSample )
+            return 0;
+    }
+
+    return 1;
+}
+
+
+/*
+    Returns the dither state to pass to the output converter for the given
+    channel: the channel's own noise shaper when noise shaping, otherwise the
+    generator shared by all channels.
+*/
+static struct PaUtilTriangularDitherGenerator *OutputDitherGenerator(
+        PaUtilBufferProcessor *bp, unsigned int channel )
+{
+    if( bp->noiseShapers )
+        return &bp->noiseShapers[channel].ditherGenerator;
+    else
+        return &bp->ditherGenerator;
+}
+
+
 /*
     NonAdaptingProcess() is a simple buffer copying adaptor that can handle
     both full and half duplex copies. It processes framesToProcess frames,
@@ -805,6 +900,22 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                                     frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
                         }
                     }
+                    else if( bp->userInputIsInterleaved
+                            && IsContiguousInterleaved( hostInputChannels, bp->inputChannelCount, bp->bytesPerHostInputSample ) )
+                    {
+                        /* host and user buffers are both interleaved with the same channel count,
+                            convert all channels as one run */
+                        bp->inputConverter( destBytePtr, 1,
+                                                hostInputChannels[0].data, 1,
+                                                frameCount * bp->inputChannelCount, &bp->ditherGenerator );
+
+                        for( i=0; i<bp->inputChannelCount; ++i )
+                        {
+                            /* advance src ptr for next iteration */
+                            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
+                                    frameCount * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
+                        }
+                    }
                     else
                     {
                         for( i=0; i<bp->inputChannelCount; ++i )
@@ -870,8 +981,10 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                 }
             }
 
+            PaUtil_TraceEvent( paTraceUserCallbackBegin, (int)frameCount, (int)bp->callbackStatusFlags );
             *streamCallbackResult = bp->streamCallback( userInput, userOutput,
                     frameCount, bp->timeInfo, bp->callbackStatusFlags, bp->userData );
+            PaUtil_TraceEvent( paTraceUserCallbackEnd, *streamCallbackResult, 0 );
 
             if( *streamCallbackResult == paAbort )
             {
@@ -896,6 +1009,22 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                                     frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
                         }
                     }
+                    else if( bp->userOutputIsInterleaved && !bp->noiseShapers
+                            && IsContiguousInterleaved( hostOutputChannels, bp->outputChannelCount, bp->bytesPerHostOutputSample ) )
+                    {
+                        /* host and user buffers are both interleaved with the same channel count,
+                            convert all channels as one run */
+                        bp->outputConverter(    hostOutputChannels[0].data, 1,
+                                                bp->tempOutputBuffer, 1,
+                                                frameCount * bp->outputChannelCount, &bp->ditherGenerator );
+
+                        for( i=0; i<bp->outputChannelCount; ++i )
+                        {
+                            /* advance dest ptr for next iteration */
+                            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
+                                    frameCount * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
+                        }
+                    }
                     else
                     {
 
@@ -917,7 +1046,7 @@ static unsigned long NonAdaptingProcess( PaUtilBufferProcessor *bp,
                             bp->outputConverter(    hostOutputChannels[i].data,
                                                     hostOutputChannels[i].stride,
                                                     srcBytePtr, srcSampleStrideSamples,
-                                                    frameCount, &bp->ditherGenerator );
+                                                    frameCount, OutputDitherGenerator( bp, i ) );
 
                             srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
 
@@ -1052,9 +1181,11 @@ static unsigned long AdaptingInputOnlyProcess( PaUtilBufferProcessor *bp,
             {
                 bp->timeInfo->outputBufferDacTime = 0;
 
+                PaUtil_TraceEvent( paTraceUserCallbackBegin, (int)bp->framesPerUserBuffer, (int)bp->callbackStatusFlags );
                 *streamCallbackResult = bp->streamCallback( userInput, userOutput,
                         bp->framesPerUserBuffer, bp->timeInfo,
                         bp->callbackStatusFlags, bp->userData );
+                PaUtil_TraceEvent( paTraceUserCallbackEnd, *streamCallbackResult, 0 );
 
                 bp->timeInfo->inputBufferAdcTime += bp->framesPerUserBuffer * bp->samplePeriod;
             }
@@ -1114,9 +1245,11 @@ static unsigned long AdaptingOutputOnlyProcess( PaUtilBufferProcessor *bp,
 
             bp->timeInfo->inputBufferAdcTime = 0;
 
+            PaUtil_TraceEvent( paTraceUserCallbackBegin, (int)bp->framesPerUserBuffer, (int)bp->callbackStatusFlags );
             *streamCallbackResult = bp->streamCallback( userInput, userOutput,
                     bp->framesPerUserBuffer, bp->timeInfo,
                     bp->callbackStatusFlags, bp->userData );
+            PaUtil_TraceEvent( paTraceUserCallbackEnd, *streamCallbackResult, 0 );
 
             if( *streamCallbackResult == paAbort )
             {
@@ -1160,7 +1293,7 @@ static unsigned long AdaptingOutputOnlyProcess( PaUtilBufferProcessor *bp,
                 bp->outputConverter(    hostOutputChannels[i].data,
                                         hostOutputChannels[i].stride,
                                         srcBytePtr, srcSampleStrideSamples,
-                                        frameCount, &bp->ditherGenerator );
+                                        frameCount, OutputDitherGenerator( bp, i ) );
 
                 srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
 
@@ -1258,7 +1391,7 @@ static void CopyTempOutputBuffersToHostOutputBuffers( PaUtilBufferProcessor *bp)
             bp->outputConverter(    hostOutputChannels[i].data,
                                     hostOutputChannels[i].stride,
                                     srcBytePtr, srcSampleStrideSamples,
-                                    frameCount, &bp->ditherGenerator );
+                                    frameCount, OutputDitherGenerator( bp, i ) );
 
             srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
 
@@ -1448,9 +1581,11 @@ static unsigned long AdaptingProcess( PaUtilBufferProcessor *bp,
 
                 /* call streamCallback */
 
+                PaUtil_TraceEvent( paTraceUserCallbackBegin, (int)bp->framesPerUserBuffer, (int)bp->callbackStatusFlags );
                 *streamCallbackResult = bp->streamCallback( userInput, userOutput,
                         bp->framesPerUserBuffer, bp->timeInfo,
                         bp->callbackStatusFlags, bp->userData );
+                PaUtil_TraceEvent( paTraceUserCallbackEnd, *streamCallbackResult, 0 );
 
                 bp->timeInfo->inputBufferAdcTime += bp->framesPerUserBuffer * bp->samplePeriod;
                 bp->timeInfo->outputBufferDacTime += bp->framesPerUserBuffer * bp->samplePeriod;
@@ -1680,18 +1815,35 @@ unsigned long PaUtil_CopyInput( PaUtilBufferProcessor* bp,
         destSampleStrideSamples = bp->inputChannelCount;
         destChannelStrideBytes = bp->bytesPerUserInputSample;
 
-        for( i=0; i<bp->inputChannelCount; ++i )
+        if( IsContiguousInterleaved( hostInputChannels, bp->inputChannelCount, bp->bytesPerHostInputSample ) )
         {
-            bp->inputConverter( destBytePtr, destSampleStrideSamples,
-                                hostInputChannels[i].data,
-                                hostInputChannels[i].stride,
-                                framesToCopy, &bp->ditherGenerator );
+            /* convert all channels as one run */
+            bp->inputConverter( destBytePtr, 1,
+                                hostInputChannels[0].data, 1,
+                                framesToCopy * bp->inputChannelCount, &bp->ditherGenerator );
+
+            for( i=0; i<bp->inputChannelCount; ++i )
+            {
+                /* advance source ptr for next iteration */
+                hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
+                        framesToCopy * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
+            }
+        }
+        else
+        {
+            for( i=0; i<bp->inputChannelCount; ++i )
+            {
+                bp->inputConverter( destBytePtr, destSampleStrideSamples,
+                                    hostInputChannels[i].data,
+                                    hostInputChannels[i].stride,
+                                    framesToCopy, &bp->ditherGenerator );
 
-            destBytePtr += destChannelStrideBytes;  /* skip to next dest channel */
+                destBytePtr += destChannelStrideBytes;  /* skip to next dest channel */
 
-            /* advance source ptr for next iteration */
-            hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
-                    framesToCopy * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
+                /* advance source ptr for next iteration */
+                hostInputChannels[i].data = ((unsigned char*)hostInputChannels[i].data) +
+                        framesToCopy * hostInputChannels[i].stride * bp->bytesPerHostInputSample;
+            }
         }
 
         /* advance callers dest pointer (buffer) */
@@ -1751,18 +1903,36 @@ unsigned long PaUtil_CopyOutput( PaUtilBufferProcessor* bp,
         srcSampleStrideSamples = bp->outputChannelCount;
         srcChannelStrideBytes = bp->bytesPerUserOutputSample;
 
-        for( i=0; i<bp->outputChannelCount; ++i )
+        if( !bp->noiseShapers
+                && IsContiguousInterleaved( hostOutputChannels, bp->outputChannelCount, bp->bytesPerHostOutputSample ) )
         {
-            bp->outputConverter(    hostOutputChannels[i].data,
-                                    hostOutputChannels[i].stride,
-                                    srcBytePtr, srcSampleStrideSamples,
-                                    framesToCopy, &bp->ditherGenerator );
+            /* convert all channels as one run */
+            bp->outputConverter(    hostOutputChannels[0].data, 1,
+                                    srcBytePtr, 1,
+                                    framesToCopy * bp->outputChannelCount, &bp->ditherGenerator );
 
-            srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
+            for( i=0; i<bp->outputChannelCount; ++i )
+            {
+                /* advance dest ptr for next iteration */
+                hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
+                        framesToCopy * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
+            }
+        }
+        else
+        {
+            for( i=0; i<bp->outputChannelCount; ++i )
+            {
+                bp->outputConverter(    hostOutputChannels[i].data,
+                                        hostOutputChannels[i].stride,
+                                        srcBytePtr, srcSampleStrideSamples,
+                                        framesToCopy, OutputDitherGenerator( bp, i ) );
 
-            /* advance dest ptr for next iteration */
-            hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
-                    framesToCopy * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
+                srcBytePtr += srcChannelStrideBytes;  /* skip to next source channel */
+
+                /* advance dest ptr for next iteration */
+                hostOutputChannels[i].data = ((unsigned char*)hostOutputChannels[i].data) +
+                        framesToCopy * hostOutputChannels[i].stride * bp->bytesPerHostOutputSample;
+            }
         }
 
         /* advance callers source pointer (buffer) */
@@ -1785,7 +1955,7 @@ unsigned long PaUtil_CopyOutput( PaUtilBufferProcessor* bp,
             bp->outputConverter(    hostOutputChannels[i].data,
                                     hostOutputChannels[i].stride,
                                     srcBytePtr, srcSampleStrideSamples,
-                                    framesToCopy, &bp->ditherGenerator );
+                                    framesToCopy, OutputDitherGenerator( bp, i ) );
 
 
             /* advance callers source pointer (nonInterleavedSrcPtrs[i]) */
@@ -203,6 +203,7 @@
 #include "portaudio.h"
 #include "pa_converters.h"
 #include "pa_dither.h"
+#include "pa_allocation.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -305,11 +306,14 @@ typedef struct {
                                                          */
 
     PaUtilTriangularDitherGenerator ditherGenerator;
+    PaUtilNoiseShaper *noiseShapers; /**< per output channel noise shaping state, NULL unless noise shaping is in use */
 
     double samplePeriod;
 
     PaStreamCallback *streamCallback;
     void *userData;
+
+    PaUtilAllocationGroup *allocations; /**< the temp buffers, channel descriptors and noise shapers, in one prefaulted region */
 } PaUtilBufferProcessor;
 
 
@@ -45,6 +45,8 @@
 */
 
 
+#include <string.h> /* memset() */
+
 #include "pa_stream.h"
 
 
@@ -83,7 +85,7 @@ void PaUtil_InitializeStreamRepresentation( PaUtilStreamRepresentation *streamRe
         void *userData )
 {
     streamRepresentation->magic = PA_STREAM_MAGIC;
-    streamRepresentation->nextOpenStream = 0;
+    streamRepresentation->openStreamHandle = NULL;
     streamRepresentation->streamInterface = streamInterface;
     streamRepresentation->streamCallback = streamCallback;
     streamRepresentation->streamFinishedCallback = 0;
@@ -93,6 +95,9 @@ void PaUtil_InitializeStreamRepresentation( PaUtilStreamRepresentation *streamRe
     streamRepresentation->streamInfo.inputLatency = 0.;
     streamRepresentation->streamInfo.outputLatency = 0.;
     streamRepresentation->streamInfo.sampleRate = 0.;
+
+    streamRepresentation->cpuLoadMeasurer = 0;
+    memset( &streamRepresentation->threadPolicy, 0, sizeof(PaThreadPolicy) );
 }
 
 
@@ -146,12 +146,14 @@ double PaUtil_DummyGetCpuLoad( PaStream* stream );
 */
 typedef struct PaUtilStreamRepresentation {
     unsigned long magic;    /**< set to PA_STREAM_MAGIC */
-    struct PaUtilStreamRepresentation *nextOpenStream; /**< field used by multi-api code */
+    PaStream *openStreamHandle; /**< the client's handle to the stream while it is open, else NULL */
     PaUtilStreamInterface *streamInterface;
     PaStreamCallback *streamCallback;
     PaStreamFinishedCallback *streamFinishedCallback;
     void *userData;
     PaStreamInfo streamInfo;
+    struct PaUtilCpuLoadMeasurer *cpuLoadMeasurer; /**< set by host APIs that measure their callbacks, used by Pa_GetStreamCallbackStats() */
+    PaThreadPolicy threadPolicy; /**< set by Pa_SetStreamThreadPolicy(), applied by host APIs that create callback threads */
 } PaUtilStreamRepresentation;
 
 
@@ -174,15 +176,36 @@ void PaUtil_InitializeStreamRepresentation(
 void PaUtil_TerminateStreamRepresentation( PaUtilStreamRepresentation *streamRepresentation );
 
 
-/** Check that the stream pointer is valid.
+/** Look up the stream a client's stream handle refers to.
 
- @return Returns paNoError if the stream pointer appears to be OK, otherwise
+ The PaStream* that Pa_OpenStream() returns is not the address of the stream
+ the host API opened, but a handle into pa_front's table of open streams. It is
+ checked against the table before anything is dereferenced, so a handle to a
+ stream that has been closed is rejected even if a new stream now has its
+ memory. Host API functions that take a PaStream* from the client must resolve
+ it with this function before using it.
+
+ @param streamRepresentation Receives the stream, as returned from the host
+ API's OpenStream(). Only set if the handle is valid.
+
+ @return Returns paNoError if the handle refers to an open stream, otherwise
+ returns an error indicating the cause of failure.
+*/
+PaError PaUtil_GetStreamRepresentation( PaStream *stream, PaUtilStreamRepresentation **streamRepresentation );
+
+
+/** Check that a client's stream handle refers to an open stream.
+
+ @return Returns paNoError if the stream handle is valid, otherwise
  returns an error indicating the cause of failure.
+
+ @see PaUtil_GetStreamRepresentation
 */
 PaError PaUtil_ValidateStreamPointer( PaStream *stream );
 
 
 /** Cast an opaque stream pointer into a pointer to a PaUtilStreamRepresentation.
+ Only for the stream pointers host APIs pass themselves, not for client handles.
 
  @see PaUtilStreamRepresentation
 */
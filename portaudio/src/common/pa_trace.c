@@ -52,6 +52,7 @@
 #include "pa_trace.h"
 #include "pa_util.h"
 #include "pa_debugprint.h"
+#include "pa_memorybarrier.h"
 
 #if PA_TRACE_REALTIME_EVENTS
 
@@ -227,7 +228,322 @@ void PaUtil_DiscardHighSpeedLog( LogHandle hLog )
     PaUtil_FreeMemory(pLog);
 }
 
+#endif /* PA_TRACE_REALTIME_EVENTS */
+
+
+#if PA_TRACE_EVENTS
+
+/************************************************************************/
+/* Per-thread binary event trace                                        */
+/************************************************************************/
+
+#if defined(__GNUC__)
+#define PA_TRACE_THREAD_LOCAL                   __thread
+#define PaUtil_TraceClaimRing( count )          __sync_fetch_and_add( (count), 1 )
+#define PaUtil_TraceTakeRing( inUse )           __sync_bool_compare_and_swap( (inUse), 0, 1 )
+#elif defined(_MSC_VER)
+#define PA_TRACE_THREAD_LOCAL                   __declspec(thread)
+#define PaUtil_TraceClaimRing( count )          (InterlockedIncrement( (count) ) - 1)
+#define PaUtil_TraceTakeRing( inUse )           (InterlockedCompareExchange( (inUse), 1, 0 ) == 0)
+#else
+#error "PA_TRACE_EVENTS needs thread local storage and an atomic increment for this compiler"
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if (PA_TRACE_EVENTS_PER_THREAD & (PA_TRACE_EVENTS_PER_THREAD - 1)) != 0
+#error "PA_TRACE_EVENTS_PER_THREAD must be a power of 2"
+#endif
+
+typedef struct PaUtilTraceRecord
+{
+    PaInt64 time;
+    int id;
+    int arg0;
+    int arg1;
+} PaUtilTraceRecord;
+
+/* Only the owning thread writes records and writeIndex. readIndex marks the
+   oldest event still wanted, and is only moved by PaUtil_ResetTraceEvents()
+   and when the ring is taken over. Both indices count events, and wrap onto
+   the ring by masking. A ring is released when its thread exits, and keeps
+   the thread's events until another thread needs it. */
+typedef struct PaUtilTraceRing
+{
+    volatile long inUse;
+    volatile unsigned long writeIndex;
+    volatile unsigned long readIndex;
+    const char * volatile threadName;
+    PaUtilTraceRecord records[ PA_TRACE_EVENTS_PER_THREAD ];
+} PaUtilTraceRing;
+
+static PaUtilTraceRing traceRings_[ PA_MAX_TRACE_THREADS ];
+static volatile long traceRingCount_ = 0;
+static PA_TRACE_THREAD_LOCAL PaUtilTraceRing *threadTraceRing_ = NULL;
+
+static const struct
+{
+    const char *name;
+    char phase;             /* Chrome trace event phase: 'B'egin, 'E'nd or 'i'nstant */
+    const char *arg0Name;   /* NULL if the argument is not exported */
+    const char *arg1Name;
+}
+traceEventInfo_[ paTraceEventIdCount ] =
+{
+    { "callback",               'B', "frames", NULL },
+    { "callback",               'E', "frames", NULL },
+    { "user callback",          'B', "frames", "flags" },
+    { "user callback",          'E', "result", NULL },
+    { "host buffer acquire",    'B', "frames", NULL },
+    { "host buffer acquire",    'E', "frames", NULL },
+    { "host buffer commit",     'B', "frames", NULL },
+    { "host buffer commit",     'E', "xrun", NULL },
+    { "xrun recovery",          'B', NULL, NULL },
+    { "xrun recovery",          'E', "error", NULL },
+    { "xrun",                   'i', NULL, NULL }
+};
+
+
+static void ReleaseTraceRing( void *ring )
+{
+    PaUtil_WriteMemoryBarrier();    /* The thread's last event before the release */
+    ((PaUtilTraceRing*)ring)->inUse = 0;
+}
+
+/* Thread exit hands the calling thread's ring back through a thread specific
+   value with a destructor */
+#ifdef _WIN32
+static DWORD traceRingKey_ = FLS_OUT_OF_INDEXES;
+static INIT_ONCE traceRingKeyOnce_ = INIT_ONCE_STATIC_INIT;
+
+static VOID WINAPI ReleaseTraceRingAtExit( PVOID ring )
+{
+    if( ring )
+        ReleaseTraceRing( ring );
+}
+
+static BOOL CALLBACK CreateTraceRingKey( PINIT_ONCE once, PVOID parameter, PVOID *context )
+{
+    (void) once;
+    (void) parameter;
+    (void) context;
+    traceRingKey_ = FlsAlloc( ReleaseTraceRingAtExit );
+    return TRUE;
+}
+
+static int SetThreadTraceRing( PaUtilTraceRing *ring )
+{
+    InitOnceExecuteOnce( &traceRingKeyOnce_, CreateTraceRingKey, NULL, NULL );
+    return traceRingKey_ != FLS_OUT_OF_INDEXES && FlsSetValue( traceRingKey_, ring );
+}
 #else
+static pthread_key_t traceRingKey_;
+static pthread_once_t traceRingKeyOnce_ = PTHREAD_ONCE_INIT;
+static int haveTraceRingKey_ = 0;
+
+static void CreateTraceRingKey( void )
+{
+    haveTraceRingKey_ = pthread_key_create( &traceRingKey_, ReleaseTraceRing ) == 0;
+}
+
+static int SetThreadTraceRing( PaUtilTraceRing *ring )
+{
+    pthread_once( &traceRingKeyOnce_, CreateTraceRingKey );
+    return haveTraceRingKey_ && pthread_setspecific( traceRingKey_, ring ) == 0;
+}
+#endif
+
+
+/* The calling thread's ring, claimed on its first event: a ring no thread has
+   used yet if there is one, else one whose thread has exited, dropping that
+   thread's events. Returns NULL while every ring is in use. */
+static PaUtilTraceRing *GetThreadTraceRing( void )
+{
+    PaUtilTraceRing *ring = threadTraceRing_;
+    long slot;
+
+    if( ring )
+        return ring;
+
+    /* a scan for released rings may already have taken the fresh slot, so it
+       is claimed the same way, and the scan is the fallback if that fails */
+    if( traceRingCount_ < PA_MAX_TRACE_THREADS
+            && (slot = PaUtil_TraceClaimRing( &traceRingCount_ )) < PA_MAX_TRACE_THREADS
+            && PaUtil_TraceTakeRing( &traceRings_[slot].inUse ) )
+    {
+        ring = &traceRings_[slot];
+    }
+    else
+    {
+        for( slot = 0; slot < PA_MAX_TRACE_THREADS; ++slot )
+        {
+            if( !traceRings_[slot].inUse && PaUtil_TraceTakeRing( &traceRings_[slot].inUse ) )
+            {
+                ring = &traceRings_[slot];
+                ring->threadName = NULL;
+                ring->readIndex = ring->writeIndex;
+                break;
+            }
+        }
+        if( !ring )
+            return NULL;
+    }
+
+    /* Without the destructor the ring is never released, but still used */
+    if( !SetThreadTraceRing( ring ) )
+    {
+        PA_DEBUG(( "GetThreadTraceRing: the ring won't be released at thread exit\n" ));
+    }
+    threadTraceRing_ = ring;
+    return ring;
+}
+
+
+void PaUtil_TraceEvent( PaUtilTraceEventId id, int arg0, int arg1 )
+{
+    PaUtilTraceRing *ring = GetThreadTraceRing();
+    PaUtilTraceRecord *record;
+    unsigned long index;
+
+    if( !ring )
+        return;
+
+    index = ring->writeIndex;
+    record = &ring->records[ index & (PA_TRACE_EVENTS_PER_THREAD - 1) ];
+    record->time = PaUtil_GetTimeNanoseconds();
+    record->id = id;
+    record->arg0 = arg0;
+    record->arg1 = arg1;
+
+    /* publish the record before the index that makes it visible */
+    PaUtil_WriteMemoryBarrier();
+    ring->writeIndex = index + 1;
+}
+
+
+void PaUtil_TraceSetThreadName( const char *name )
+{
+    PaUtilTraceRing *ring = GetThreadTraceRing();
+    if( ring )
+        ring->threadName = name;
+}
+
+
+void PaUtil_ResetTraceEvents( void )
+{
+    long i, ringCount = traceRingCount_;
+
+    if( ringCount > PA_MAX_TRACE_THREADS )
+        ringCount = PA_MAX_TRACE_THREADS;
+
+    for( i=0; i < ringCount; ++i )
+        traceRings_[i].readIndex = traceRings_[i].writeIndex;
+}
+
+
+/* The first event still held by the ring. */
+static unsigned long OldestTraceEvent( PaUtilTraceRing *ring, unsigned long writeIndex )
+{
+    unsigned long readIndex = ring->readIndex;
+
+    if( writeIndex - readIndex > PA_TRACE_EVENTS_PER_THREAD )
+        return writeIndex - PA_TRACE_EVENTS_PER_THREAD;
+    return readIndex;
+}
+
+
+int PaUtil_DumpTraceEvents( const char *fileName )
+{
+    FILE *f;
+    long i, ringCount = traceRingCount_;
+    PaInt64 startTime = 0;
+    int haveStartTime = 0, first = 1;
+
+    if( ringCount > PA_MAX_TRACE_THREADS )
+        ringCount = PA_MAX_TRACE_THREADS;
+
+    f = fopen( fileName, "w" );
+    if( f == NULL )
+    {
+        PA_DEBUG(( "PaUtil_DumpTraceEvents: could not open %s\n", fileName ));
+        return paInternalError;
+    }
+
+    /* timestamps in the file are relative to the earliest event */
+    for( i=0; i < ringCount; ++i )
+    {
+        PaUtilTraceRing *ring = &traceRings_[i];
+        unsigned long writeIndex = ring->writeIndex;
+        unsigned long oldest = OldestTraceEvent( ring, writeIndex );
+
+        PaUtil_ReadMemoryBarrier();
+        if( oldest != writeIndex )
+        {
+            PaInt64 t = ring->records[ oldest & (PA_TRACE_EVENTS_PER_THREAD - 1) ].time;
+            if( !haveStartTime || t < startTime )
+                startTime = t;
+            haveStartTime = 1;
+        }
+    }
+
+    fprintf( f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" );
+
+    for( i=0; i < ringCount; ++i )
+    {
+        PaUtilTraceRing *ring = &traceRings_[i];
+        unsigned long writeIndex = ring->writeIndex;
+        unsigned long index;
+
+        PaUtil_ReadMemoryBarrier();
+
+        if( ring->threadName )
+        {
+            fprintf( f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",", i + 1, ring->threadName );
+            first = 0;
+        }
+
+        for( index = OldestTraceEvent( ring, writeIndex ); index != writeIndex; ++index )
+        {
+            PaUtilTraceRecord record = ring->records[ index & (PA_TRACE_EVENTS_PER_THREAD - 1) ];
+
+            /* skip records the owning thread overwrote while we copied them */
+            PaUtil_ReadMemoryBarrier();
+            if( ring->writeIndex - index > PA_TRACE_EVENTS_PER_THREAD )
+                continue;
+            if( record.id < 0 || record.id >= paTraceEventIdCount )
+                continue;
+
+            fprintf( f, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%ld,\"ts\":%.3f",
+                    first ? "" : ",",
+                    traceEventInfo_[record.id].name, traceEventInfo_[record.id].phase, i + 1,
+                    (double)(record.time - startTime) * 1e-3 );
+            if( traceEventInfo_[record.id].phase == 'i' )
+                fprintf( f, ",\"s\":\"t\"" );
+            if( traceEventInfo_[record.id].arg1Name )
+                fprintf( f, ",\"args\":{\"%s\":%d,\"%s\":%d}", traceEventInfo_[record.id].arg0Name, record.arg0,
+                        traceEventInfo_[record.id].arg1Name, record.arg1 );
+            else if( traceEventInfo_[record.id].arg0Name )
+                fprintf( f, ",\"args\":{\"%s\":%d}", traceEventInfo_[record.id].arg0Name, record.arg0 );
+            fprintf( f, "}" );
+            first = 0;
+        }
+    }
+
+    fprintf( f, "\n]}\n" );
+    fclose( f );
+
+    return paNoError;
+}
+
+#endif /* PA_TRACE_EVENTS */
+
+
+#if !PA_TRACE_REALTIME_EVENTS && !PA_TRACE_EVENTS
 /* This stub was added so that this file will generate a symbol.
  * Otherwise linker/archiver programs will complain.
  */
@@ -235,4 +551,4 @@ int PaUtil_TraceStubToSatisfyLinker(void)
 {
     return 0;
 }
-#endif /* TRACE_REALTIME_EVENTS */
+#endif
@@ -63,6 +63,30 @@
 
  @fn PaUtil_DumpTraceMessages
  @brief Print all messages in the trace buffer to stdout and clear the trace buffer.
+
+ The event trace facility below is separate, and is active if
+ PA_TRACE_EVENTS is set to 1. Each thread that records an event gets its own
+ ring of binary records (a nanosecond timestamp, an event id and two ints),
+ so recording takes no lock and does no formatting. The rings can later be
+ written out as Chrome trace JSON, which chrome://tracing and the Perfetto UI
+ display as a per-thread timeline.
+
+ @fn PaUtil_TraceEvent
+ @brief Record an event in the calling thread's ring. Real-time safe. If the
+    ring is full the oldest event is overwritten.
+
+ @fn PaUtil_TraceSetThreadName
+ @brief Name the calling thread in the exported trace. The name must be a
+    string literal or otherwise outlive the trace.
+
+ @fn PaUtil_ResetTraceEvents
+ @brief Discard all events recorded so far.
+
+ @fn PaUtil_DumpTraceEvents
+ @brief Write all recorded events to fileName as Chrome trace JSON.
+    Should be called once the streams being traced have stopped; events
+    overwritten while the dump runs are skipped. Pa_Terminate() calls this
+    when the PA_TRACE_EVENTS_FILE environment variable names a file.
 */
 
 #ifndef PA_TRACE_REALTIME_EVENTS
@@ -73,12 +97,46 @@
 #define PA_MAX_TRACE_RECORDS      (2048)   /**< Maximum number of records stored in trace buffer */
 #endif
 
+#ifndef PA_TRACE_EVENTS
+#define PA_TRACE_EVENTS              (0)   /**< Set to 1 to enable the per-thread event trace functions defined below */
+#endif
+
+#ifndef PA_MAX_TRACE_THREADS
+#define PA_MAX_TRACE_THREADS        (16)   /**< Maximum number of threads with an event ring at once; events from further threads are dropped */
+#endif
+
+#ifndef PA_TRACE_EVENTS_PER_THREAD
+#define PA_TRACE_EVENTS_PER_THREAD (16384) /**< Size of each thread's event ring, must be a power of 2 */
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif /* __cplusplus */
 
 
+/** Events for PaUtil_TraceEvent(). Begin/End pairs show up as spans on the
+ timeline and must nest properly within a thread. The comments give the
+ meaning of the two int arguments.
+*/
+typedef enum PaUtilTraceEventId
+{
+    paTraceCallbackBegin = 0,       /**< one host buffer period: frames available, 0 */
+    paTraceCallbackEnd,             /**< frames processed, 0 */
+    paTraceUserCallbackBegin,       /**< the user's stream callback: frames, PaStreamCallbackFlags */
+    paTraceUserCallbackEnd,         /**< callback result, 0 */
+    paTraceHostBufferAcquireBegin,  /**< getting the host buffer: frames requested, 0 */
+    paTraceHostBufferAcquireEnd,    /**< frames acquired, 0 */
+    paTraceHostBufferCommitBegin,   /**< handing the host buffer back: frames, 0 */
+    paTraceHostBufferCommitEnd,     /**< 1 if an xrun was detected, 0 */
+    paTraceXrunRecoveryBegin,       /**< 0, 0 */
+    paTraceXrunRecoveryEnd,         /**< PaError, 0 */
+    paTraceXrun,                    /**< instant, an xrun reported by the host: 0, 0 */
+
+    paTraceEventIdCount
+} PaUtilTraceEventId;
+
+
 #if PA_TRACE_REALTIME_EVENTS
 
 void PaUtil_ResetTraceMessages();
@@ -110,6 +168,23 @@ void PaUtil_DiscardHighSpeedLog(LogHandle hLog);
 #endif
 
 
+#if PA_TRACE_EVENTS
+
+void PaUtil_TraceEvent( PaUtilTraceEventId id, int arg0, int arg1 );
+void PaUtil_TraceSetThreadName( const char *name );
+void PaUtil_ResetTraceEvents( void );
+int PaUtil_DumpTraceEvents( const char *fileName );
+
+#else
+
+#define PaUtil_TraceEvent(id,arg0,arg1) /* noop */
+#define PaUtil_TraceSetThreadName(name) /* noop */
+#define PaUtil_ResetTraceEvents() /* noop */
+#define PaUtil_DumpTraceEvents(fileName) (0)
+
+#endif
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
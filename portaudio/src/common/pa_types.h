@@ -89,6 +89,14 @@ typedef unsigned long PaUint32;
 #error pa_types.h was unable to determine which type to use for 32bit integers on the target platform
 #endif
 
+#if defined(_MSC_VER) && _MSC_VER < 1600
+typedef signed __int64 PaInt64;
+typedef unsigned __int64 PaUint64;
+#else
+typedef signed long long PaInt64;
+typedef unsigned long long PaUint64;
+#endif
+
 
 /* PA_VALIDATE_TYPE_SIZES compares the size of the integer types at runtime to
  ensure that PortAudio was configured correctly, and raises an assertion if
@@ -101,6 +109,7 @@ typedef unsigned long PaUint32;
         assert( "PortAudio: type sizes are not correct in pa_types.h" && sizeof( PaInt16 ) == 2 ); \
         assert( "PortAudio: type sizes are not correct in pa_types.h" && sizeof( PaUint32 ) == 4 ); \
         assert( "PortAudio: type sizes are not correct in pa_types.h" && sizeof( PaInt32 ) == 4 ); \
+        assert( "PortAudio: type sizes are not correct in pa_types.h" && sizeof( PaInt64 ) == 8 ); \
     }
 
 
@@ -50,6 +50,7 @@
 
 
 #include "portaudio.h"
+#include "pa_types.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -117,6 +118,24 @@ void PaUtil_SetLastHostErrorInfo( PaHostApiTypeId hostApiType, long errorCode,
  .c file
 */
 
+/** An allocator installed with Pa_SetAllocator(). allocate and free are NULL
+ for the system allocator. */
+typedef struct PaUtilAllocator
+{
+    PaAllocateMemoryCallback *allocate;
+    PaFreeMemoryCallback *free;
+    void *userData;
+    PaAllocatorFlags flags;
+} PaUtilAllocator;
+
+
+/** Make PaUtil_AllocateMemory() allocate through allocator, or through the
+ system allocator if allocator is NULL. Each block remembers the allocator it
+ came from, so allocator must remain valid until all of them have been freed.
+*/
+void PaUtil_SetAllocator( const PaUtilAllocator *allocator );
+
+
 /** Allocate size bytes, guaranteed to be aligned to a FIXME byte boundary */
 void *PaUtil_AllocateMemory( long size );
 
@@ -134,6 +153,28 @@ void PaUtil_FreeMemory( void *block );
 int PaUtil_CountCurrentlyAllocatedBlocks( void );
 
 
+/** Flags for PaUtil_AllocateRegion(). */
+#define paUtilRegionHugePages   (1) /**< Back the region with huge (large) pages if it is big enough and the system allows it */
+#define paUtilRegionPrefault    (2) /**< Fault in every page of the region before returning it */
+
+/** Allocate a region of at least *size bytes directly from the operating
+ system. The region is page aligned and zero filled, and its actual size is
+ returned in *size. Regions are counted by PaUtil_CountCurrentlyAllocatedBlocks.
+ With paRealTimeAllocator in effect the region is also prefaulted and locked.
+
+ @return The region, or NULL if it couldn't be allocated, or if an allocator
+ has been installed with Pa_SetAllocator(): memory must then come from
+ PaUtil_AllocateMemory().
+ @see PaUtil_FreeRegion
+*/
+void *PaUtil_AllocateRegion( long *size, unsigned long flags );
+
+
+/** Release a region allocated with PaUtil_AllocateRegion. size is the size
+ it returned. region may be NULL */
+void PaUtil_FreeRegion( void *region, long size );
+
+
 /** Initialize the clock used by PaUtil_GetTime(). Call this before calling
  PaUtil_GetTime.
 
@@ -143,12 +184,23 @@ void PaUtil_InitializeClock( void );
 
 
 /** Return the system time in seconds. Used to implement CPU load functions
+ and stream timestamps. Where the platform allows it the clock is monotonic:
+ it never jumps when the wall clock is set.
 
- @see PaUtil_InitializeClock
+ @see PaUtil_InitializeClock, PaUtil_GetTimeNanoseconds
 */
 double PaUtil_GetTime( void );
 
 
+/** Return the system time in nanoseconds, on the same timebase as
+ PaUtil_GetTime(). Use this where the resolution of a double would be lost
+ to the magnitude of the timebase, or where integer arithmetic is wanted.
+
+ @see PaUtil_InitializeClock, PaUtil_GetTime
+*/
+PaInt64 PaUtil_GetTimeNanoseconds( void );
+
+
 /* void Pa_Sleep( long msec );  must also be implemented in per-platform .c file */
 
 
@@ -61,6 +61,11 @@
 #include <signal.h>
 #include <time.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <sys/inotify.h>
+#include <errno.h>
+#include <unistd.h>
 #include <signal.h> /* For sig_atomic_t */
 #ifdef PA_ALSA_DYNAMIC
     #include <dlfcn.h> /* For dlXXX functions */
@@ -76,6 +81,7 @@
 #include "pa_process.h"
 #include "pa_endianness.h"
 #include "pa_debugprint.h"
+#include "pa_trace.h"
 
 #include "pa_linux_alsa.h"
 
@@ -128,6 +134,7 @@ _PA_DEFINE_FUNC(snd_pcm_hw_params_sizeof);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_malloc);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_free);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_any);
+_PA_DEFINE_FUNC(snd_pcm_hw_params_copy);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_set_access);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_set_format);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_set_channels);
@@ -154,6 +161,7 @@ _PA_DEFINE_FUNC(snd_pcm_hw_params_get_channels_max);
 
 _PA_DEFINE_FUNC(snd_pcm_hw_params_test_period_size);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_test_format);
+_PA_DEFINE_FUNC(snd_pcm_hw_params_test_channels);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_test_access);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_dump);
 _PA_DEFINE_FUNC(snd_pcm_hw_params);
@@ -163,6 +171,7 @@ _PA_DEFINE_FUNC(snd_pcm_hw_params_get_periods_max);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_set_period_size);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_get_period_size_min);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_get_period_size_max);
+_PA_DEFINE_FUNC(snd_pcm_hw_params_get_buffer_size_min);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_get_buffer_size_max);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_get_rate_min);
 _PA_DEFINE_FUNC(snd_pcm_hw_params_get_rate_max);
@@ -182,6 +191,9 @@ _PA_DEFINE_FUNC(snd_pcm_sw_params_set_silence_threshold);
 _PA_DEFINE_FUNC(snd_pcm_sw_params_set_silence_size);
 _PA_DEFINE_FUNC(snd_pcm_sw_params_set_xfer_align);
 _PA_DEFINE_FUNC(snd_pcm_sw_params_set_tstamp_mode);
+#if SND_LIB_VERSION >= ALSA_VERSION_INT( 1, 0, 29 )
+_PA_DEFINE_FUNC(snd_pcm_sw_params_set_tstamp_type);
+#endif
 #define alsa_snd_pcm_sw_params_alloca(ptr) __alsa_snd_alloca(ptr, snd_pcm_sw_params)
 
 _PA_DEFINE_FUNC(snd_pcm_info);
@@ -220,8 +232,10 @@ _PA_DEFINE_FUNC(snd_config_update_free_global);
 _PA_DEFINE_FUNC(snd_pcm_status);
 _PA_DEFINE_FUNC(snd_pcm_status_sizeof);
 _PA_DEFINE_FUNC(snd_pcm_status_get_tstamp);
+_PA_DEFINE_FUNC(snd_pcm_status_get_htstamp);
 _PA_DEFINE_FUNC(snd_pcm_status_get_state);
 _PA_DEFINE_FUNC(snd_pcm_status_get_trigger_tstamp);
+_PA_DEFINE_FUNC(snd_pcm_status_get_trigger_htstamp);
 _PA_DEFINE_FUNC(snd_pcm_status_get_delay);
 #define alsa_snd_pcm_status_alloca(ptr) __alsa_snd_alloca(ptr, snd_pcm_status)
 
@@ -411,6 +425,7 @@ static int PaAlsa_LoadLibrary()
     _PA_LOAD_FUNC(snd_pcm_hw_params_malloc);
     _PA_LOAD_FUNC(snd_pcm_hw_params_free);
     _PA_LOAD_FUNC(snd_pcm_hw_params_any);
+    _PA_LOAD_FUNC(snd_pcm_hw_params_copy);
     _PA_LOAD_FUNC(snd_pcm_hw_params_set_access);
     _PA_LOAD_FUNC(snd_pcm_hw_params_set_format);
     _PA_LOAD_FUNC(snd_pcm_hw_params_set_channels);
@@ -437,6 +452,7 @@ static int PaAlsa_LoadLibrary()
 
     _PA_LOAD_FUNC(snd_pcm_hw_params_test_period_size);
     _PA_LOAD_FUNC(snd_pcm_hw_params_test_format);
+    _PA_LOAD_FUNC(snd_pcm_hw_params_test_channels);
     _PA_LOAD_FUNC(snd_pcm_hw_params_test_access);
     _PA_LOAD_FUNC(snd_pcm_hw_params_dump);
     _PA_LOAD_FUNC(snd_pcm_hw_params);
@@ -446,6 +462,7 @@ static int PaAlsa_LoadLibrary()
     _PA_LOAD_FUNC(snd_pcm_hw_params_set_period_size);
     _PA_LOAD_FUNC(snd_pcm_hw_params_get_period_size_min);
     _PA_LOAD_FUNC(snd_pcm_hw_params_get_period_size_max);
+    _PA_LOAD_FUNC(snd_pcm_hw_params_get_buffer_size_min);
     _PA_LOAD_FUNC(snd_pcm_hw_params_get_buffer_size_max);
     _PA_LOAD_FUNC(snd_pcm_hw_params_get_rate_min);
     _PA_LOAD_FUNC(snd_pcm_hw_params_get_rate_max);
@@ -464,6 +481,9 @@ static int PaAlsa_LoadLibrary()
     _PA_LOAD_FUNC(snd_pcm_sw_params_set_silence_size);
     _PA_LOAD_FUNC(snd_pcm_sw_params_set_xfer_align);
     _PA_LOAD_FUNC(snd_pcm_sw_params_set_tstamp_mode);
+#if SND_LIB_VERSION >= ALSA_VERSION_INT( 1, 0, 29 )
+    _PA_LOAD_FUNC(snd_pcm_sw_params_set_tstamp_type);
+#endif
 
     _PA_LOAD_FUNC(snd_pcm_info);
     _PA_LOAD_FUNC(snd_pcm_info_sizeof);
@@ -499,8 +519,10 @@ static int PaAlsa_LoadLibrary()
     _PA_LOAD_FUNC(snd_pcm_status);
     _PA_LOAD_FUNC(snd_pcm_status_sizeof);
     _PA_LOAD_FUNC(snd_pcm_status_get_tstamp);
+    _PA_LOAD_FUNC(snd_pcm_status_get_htstamp);
     _PA_LOAD_FUNC(snd_pcm_status_get_state);
     _PA_LOAD_FUNC(snd_pcm_status_get_trigger_tstamp);
+    _PA_LOAD_FUNC(snd_pcm_status_get_trigger_htstamp);
     _PA_LOAD_FUNC(snd_pcm_status_get_delay);
 
     _PA_LOAD_FUNC(snd_card_next);
@@ -588,6 +610,8 @@ static void PaAlsa_CloseLibrary()
 
 static int numPeriods_ = 4;
 static int busyRetries_ = 100;
+static int probeThreads_ = PA_UNIX_PROBE_THREADS;
+static PaTime probeTimeout_ = PA_UNIX_PROBE_TIMEOUT;
 
 int PaAlsa_SetNumPeriods( int numPeriods )
 {
@@ -603,7 +627,7 @@ typedef enum
 
 typedef struct
 {
-    PaSampleFormat hostSampleFormat;
+    PaSampleFormat hostSampleFormat, userSampleFormat;
     int numUserChannels, numHostChannels;
     int userInterleaved, hostInterleaved;
     int canMmap;
@@ -618,11 +642,12 @@ typedef struct
     snd_pcm_format_t nativeFormat;
     unsigned int nfds;
     int ready;  /* Marked ready from poll */
-    void **userBuffers;
+    void **userBuffers;     /* Non-interleaved buffer pointers passed to ReadStream/WriteStream or the zero-copy callback */
     snd_pcm_uframes_t offset;
     StreamDirection streamDir;
 
     snd_pcm_channel_area_t *channelAreas;  /* Needed for channel adaption */
+    int tstampOnPaClock; /* Status timestamps are on the PaUtil_GetTime() timebase */
 } PaAlsaStreamComponent;
 
 /* Implementation specific stream structure */
@@ -639,6 +664,7 @@ typedef struct PaAlsaStream
     int callbackMode;              /* bool: are we running in callback mode? */
     int pcmsSynced;                /* Have we successfully synced pcms */
     int rtSched;
+    int zeroCopy;                  /* bool: call back directly on the mmapped buffers when possible */
 
     /* the callback thread uses these to poll the sound device(s), waiting
      * for data to be ready/available */
@@ -668,10 +694,15 @@ typedef struct PaAlsaHostApiRepresentation
     PaUtilStreamInterface callbackStreamInterface;
     PaUtilStreamInterface blockingStreamInterface;
 
-    PaUtilAllocationGroup *allocations;
+    PaUtilAllocationGroup *allocations;     /* The current device list */
 
     PaHostApiIndex hostApiIndex;
     PaUint32 alsaLibVersion; /* Retrieved from the library at run-time */
+
+    struct PaAlsaDeviceCache *deviceCache;  /* Capabilities of the devices seen so far */
+    struct PaAlsaDeviceMonitor *deviceMonitor;
+    PaUnixMutex capsMtx;                    /* Serializes building the caps matrices, see GetDeviceCaps */
+    PaUnixProbeTracker *probeTracker;       /* Probes that timed out, which may still be inside alsa-lib */
 }
 PaAlsaHostApiRepresentation;
 
@@ -682,9 +713,21 @@ typedef struct PaAlsaDeviceInfo
     int isPlug;
     int minInputChannels;
     int minOutputChannels;
+    struct PaAlsaDeviceCaps *caps[2];   /* Per StreamDirection, built on the first query, see GetDeviceCaps */
 }
 PaAlsaDeviceInfo;
 
+/* A device list as built by BuildDeviceList, which replaces the host API's device list when committed */
+typedef struct
+{
+    PaUtilAllocationGroup *allocations;
+    PaDeviceInfo **deviceInfos;
+    int deviceCount;
+    PaDeviceIndex defaultInputDevice;
+    PaDeviceIndex defaultOutputDevice;
+}
+PaAlsaDeviceList;
+
 /* prototypes for functions declared in this file */
 
 static void Terminate( struct PaUtilHostApiRepresentation *hostApi );
@@ -709,7 +752,20 @@ static PaError IsStreamStopped( PaStream *s );
 static PaError IsStreamActive( PaStream *stream );
 static PaTime GetStreamTime( PaStream *stream );
 static double GetStreamCpuLoad( PaStream* stream );
-static PaError BuildDeviceList( PaAlsaHostApiRepresentation *hostApi );
+static PaError ScanDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, PaHostApiIndex index,
+                                void **scanResults, int *newDeviceCount );
+static void CommitDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, PaHostApiIndex index,
+                               void *scanResults, int deviceCount );
+static void DisposeDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, void *scanResults, int deviceCount );
+static PaError GetNativeSampleFormats( struct PaUtilHostApiRepresentation *hostApi, PaDeviceIndex device, int isInput,
+        PaSampleFormat *sampleFormats );
+static PaError BuildDeviceList( PaAlsaHostApiRepresentation *hostApi, PaAlsaDeviceList *list );
+static void CommitDeviceList( PaAlsaHostApiRepresentation *alsaApi, PaAlsaDeviceList *list );
+static void DisposeDeviceList( PaAlsaDeviceList *list );
+static struct PaAlsaDeviceCache *DeviceCache_New( void );
+static void DeviceCache_Delete( struct PaAlsaDeviceCache *cache );
+static void StartDeviceMonitor( PaAlsaHostApiRepresentation *alsaApi );
+static void StopDeviceMonitor( PaAlsaHostApiRepresentation *alsaApi );
 static int SetApproximateSampleRate( snd_pcm_t *pcm, snd_pcm_hw_params_t *hwParams, double sampleRate );
 static int GetExactSampleRate( snd_pcm_hw_params_t *hwParams, double *sampleRate );
 static PaUint32 PaAlsaVersionNum(void);
@@ -740,6 +796,7 @@ PaError PaAlsa_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
 {
     PaError result = paNoError;
     PaAlsaHostApiRepresentation *alsaHostApi = NULL;
+    PaAlsaDeviceList deviceList;
 
     /* Try loading Alsa library. */
     if (!PaAlsa_LoadLibrary())
@@ -747,7 +804,16 @@ PaError PaAlsa_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
 
     PA_UNLESS( alsaHostApi = (PaAlsaHostApiRepresentation*) PaUtil_AllocateMemory(
                 sizeof(PaAlsaHostApiRepresentation) ), paInsufficientMemory );
-    PA_UNLESS( alsaHostApi->allocations = PaUtil_CreateAllocationGroup(), paInsufficientMemory );
+    if( ( result = PaUnixMutex_Initialize( &alsaHostApi->capsMtx ) ) != paNoError )
+    {
+        PaUtil_FreeMemory( alsaHostApi );
+        return result;
+    }
+    alsaHostApi->allocations = NULL;
+    alsaHostApi->deviceMonitor = NULL;
+    alsaHostApi->probeTracker = NULL;
+    PA_UNLESS( alsaHostApi->deviceCache = DeviceCache_New(), paInsufficientMemory );
+    PA_ENSURE( PaUnixProbeTracker_New( &alsaHostApi->probeTracker ) );
     alsaHostApi->hostApiIndex = hostApiIndex;
     alsaHostApi->alsaLibVersion = PaAlsaVersionNum();
 
@@ -755,17 +821,24 @@ PaError PaAlsa_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
     (*hostApi)->info.structVersion = 1;
     (*hostApi)->info.type = paALSA;
     (*hostApi)->info.name = "ALSA";
+    (*hostApi)->info.deviceCount = 0;
+    (*hostApi)->deviceInfos = NULL;
 
     (*hostApi)->Terminate = Terminate;
     (*hostApi)->OpenStream = OpenStream;
     (*hostApi)->IsFormatSupported = IsFormatSupported;
+    (*hostApi)->ScanDeviceInfos = ScanDeviceInfos;
+    (*hostApi)->CommitDeviceInfos = CommitDeviceInfos;
+    (*hostApi)->DisposeDeviceInfos = DisposeDeviceInfos;
+    (*hostApi)->GetNativeSampleFormats = GetNativeSampleFormats;
 
     /** If AlsaErrorHandler is to be used, do not forget to unregister callback pointer in
         Terminate function.
     */
     /*ENSURE_( snd_lib_error_set_handler(AlsaErrorHandler), paUnanticipatedHostError );*/
 
-    PA_ENSURE( BuildDeviceList( alsaHostApi ) );
+    PA_ENSURE( BuildDeviceList( alsaHostApi, &deviceList ) );
+    CommitDeviceList( alsaHostApi, &deviceList );
 
     PaUtil_InitializeStreamInterface( &alsaHostApi->callbackStreamInterface,
                                       CloseStream, StartStream,
@@ -787,6 +860,8 @@ PaError PaAlsa_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
 
     PA_ENSURE( PaUnixThreading_Initialize() );
 
+    StartDeviceMonitor( alsaHostApi );
+
     return result;
 
 error:
@@ -797,6 +872,11 @@ error:
             PaUtil_FreeAllAllocations( alsaHostApi->allocations );
             PaUtil_DestroyAllocationGroup( alsaHostApi->allocations );
         }
+        if( alsaHostApi->deviceCache )
+            DeviceCache_Delete( alsaHostApi->deviceCache );
+        if( alsaHostApi->probeTracker )
+            PaUnixProbeTracker_Release( alsaHostApi->probeTracker );
+        PaUnixMutex_Terminate( &alsaHostApi->capsMtx );
 
         PaUtil_FreeMemory( alsaHostApi );
     }
@@ -807,6 +887,7 @@ error:
 static void Terminate( struct PaUtilHostApiRepresentation *hostApi )
 {
     PaAlsaHostApiRepresentation *alsaHostApi = (PaAlsaHostApiRepresentation*)hostApi;
+    int abandonedProbes;
 
     assert( hostApi );
 
@@ -814,13 +895,28 @@ static void Terminate( struct PaUtilHostApiRepresentation *hostApi )
     */
     /*snd_lib_error_set_handler(NULL);*/
 
+    StopDeviceMonitor( alsaHostApi );
+
     if( alsaHostApi->allocations )
     {
         PaUtil_FreeAllAllocations( alsaHostApi->allocations );
         PaUtil_DestroyAllocationGroup( alsaHostApi->allocations );
     }
+    DeviceCache_Delete( alsaHostApi->deviceCache );
+    PaUnixMutex_Terminate( &alsaHostApi->capsMtx );
 
+    /* A probe that timed out may still be inside alsa-lib, give it another timeout's worth to return. If it doesn't,
+     * the library stays loaded and configured for good rather than pulled from under it. */
+    abandonedProbes = PaUnixProbeTracker_WaitForAbandoned( alsaHostApi->probeTracker, probeTimeout_ );
+    PaUnixProbeTracker_Release( alsaHostApi->probeTracker );
     PaUtil_FreeMemory( alsaHostApi );
+    if( abandonedProbes > 0 )
+    {
+        PA_DEBUG(( "%s: %d device probes still running, leaving the ALSA library loaded\n", __FUNCTION__,
+                    abandonedProbes ));
+        return;
+    }
+
     alsa_snd_config_update_free_global();
 
     /* Close Alsa library. */
@@ -1043,7 +1139,7 @@ static const HwDevInfo *FindDeviceName( const char *name )
     return NULL;
 }
 
-static PaError PaAlsa_StrDup( PaAlsaHostApiRepresentation *alsaApi,
+static PaError PaAlsa_StrDup( PaUtilAllocationGroup *allocations,
         char **dst,
         const char *src)
 {
@@ -1052,7 +1148,7 @@ static PaError PaAlsa_StrDup( PaAlsaHostApiRepresentation *alsaApi,
 
     /* PA_DEBUG(("PaStrDup %s %d\n", src, len)); */
 
-    PA_UNLESS( *dst = (char *)PaUtil_GroupAllocateMemory( alsaApi->allocations, len ),
+    PA_UNLESS( *dst = (char *)PaUtil_GroupAllocateMemory( allocations, len ),
             paInsufficientMemory );
     strncpy( *dst, src, len );
 
@@ -1151,51 +1247,747 @@ static int OpenPcm( snd_pcm_t **pcmp, const char *name, snd_pcm_stream_t stream,
     return ret;
 }
 
-static PaError FillInDevInfo( PaAlsaHostApiRepresentation *alsaApi, HwDevInfo* deviceHwInfo, int blocking,
-        PaAlsaDeviceInfo* devInfo, int* devIdx )
+/* Device capability cache
+ *
+ * Groping a device means opening it and walking its configuration space, which for a box with many cards is most of
+ * the time Pa_Initialize takes. The results of groping are therefore kept for as long as the host API lives, so that
+ * rescans only grope new or changed devices, and optionally in a file under $XDG_CACHE_HOME, one line per device.
+ * Each entry carries a fingerprint built from what /proc/asound says about the device, which is cheap to read, and a
+ * device is only groped again when its fingerprint changes. A change of kernel, ALSA driver or alsa-lib version
+ * discards the whole file.
+ */
+
+#define PA_ALSA_CACHE_MAGIC "PortAudio ALSA device cache 1"
+
+typedef struct
+{
+    char *alsaName;
+    PaUint64 fingerprint;
+    int seen;   /* Still present in this enumeration, otherwise dropped when saving */
+
+    int minInputChannels, maxInputChannels, minOutputChannels, maxOutputChannels;
+    double defaultLowInputLatency, defaultHighInputLatency;
+    double defaultLowOutputLatency, defaultHighOutputLatency;
+    double defaultSampleRate;
+} PaAlsaCacheEntry;
+
+typedef struct PaAlsaDeviceCache
+{
+    int persistent;     /* Kept in a file */
+    int dirty;
+    char *path;
+    PaUint64 systemKey;
+    PaUint64 configStamp;   /* ALSA configuration files, which plugin devices depend on */
+    char *cardsText;        /* /proc/asound/cards */
+
+    PaAlsaCacheEntry *entries;
+    int numEntries, maxEntries;
+} PaAlsaDeviceCache;
+
+static int useDeviceCache_ = 0;
+
+PaError PaAlsa_EnableDeviceCache( int enable )
+{
+    useDeviceCache_ = enable;
+    return paNoError;
+}
+
+/* 64 bit FNV-1a */
+static PaUint64 HashBytes( PaUint64 hash, const void *data, size_t len )
+{
+    const unsigned char *p = (const unsigned char *)data;
+    size_t i;
+
+    if( hash == 0 )
+        hash = 14695981039346656037ULL;
+    for( i = 0; i < len; ++i )
+    {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static PaUint64 HashString( PaUint64 hash, const char *s )
+{
+    return HashBytes( hash, s ? s : "", s ? strlen( s ) + 1 : 1 );
+}
+
+/* Hash a (/proc) text file, leaving out lines starting with skipPrefix, which change while the device is in use */
+static PaUint64 HashFile( PaUint64 hash, const char *path, const char *skipPrefix )
+{
+    char line[256];
+    FILE *f = fopen( path, "r" );
+
+    if( !f )
+        return HashString( hash, "<none>" );
+
+    while( fgets( line, sizeof (line), f ) )
+    {
+        if( skipPrefix && !strncmp( line, skipPrefix, strlen( skipPrefix ) ) )
+            continue;
+        hash = HashString( hash, line );
+    }
+    fclose( f );
+    return hash;
+}
+
+static PaUint64 HashFileStamp( PaUint64 hash, const char *path )
+{
+    struct stat st;
+
+    if( !path || stat( path, &st ) != 0 )
+        return HashString( hash, "<none>" );
+    hash = HashBytes( hash, &st.st_mtime, sizeof (st.st_mtime) );
+    return HashBytes( hash, &st.st_size, sizeof (st.st_size) );
+}
+
+static char *ReadTextFile( const char *path )
+{
+    char *text = NULL, *grown;
+    size_t len = 0, n;
+    FILE *f = fopen( path, "r" );
+
+    if( !f )
+        return NULL;
+
+    /* /proc files have no size, so read in chunks */
+    do
+    {
+        if( !( grown = (char *)realloc( text, len + 1025 ) ) )
+        {
+            free( text );
+            fclose( f );
+            return NULL;
+        }
+        text = grown;
+        n = fread( text + len, 1, 1024, f );
+        len += n;
+    } while( n == 1024 );
+    text[len] = '\0';
+
+    fclose( f );
+    return text;
+}
+
+/* mkdir -p for the directories leading up to path */
+static int MakeParentDirectories( char *path )
+{
+    char *p;
+
+    for( p = strchr( path + 1, '/' ); p; p = strchr( p + 1, '/' ) )
+    {
+        *p = '\0';
+        if( mkdir( path, 0700 ) != 0 && errno != EEXIST )
+        {
+            *p = '/';
+            return -1;
+        }
+        *p = '/';
+    }
+    return 0;
+}
+
+static char *DeviceCachePath( void )
+{
+    const char *base = getenv( "XDG_CACHE_HOME" ), *suffix = "/portaudio/alsa-devices";
+    const char *home = getenv( "HOME" );
+    char *path;
+    size_t len;
+
+    /* The XDG spec says relative paths are to be ignored */
+    if( !base || base[0] != '/' )
+    {
+        if( !home || home[0] != '/' )
+            return NULL;
+        base = home;
+        suffix = "/.cache/portaudio/alsa-devices";
+    }
+
+    len = strlen( base ) + strlen( suffix ) + 1;
+    if( ( path = (char *)malloc( len ) ) )
+        snprintf( path, len, "%s%s", base, suffix );
+    return path;
+}
+
+static PaUint64 SystemKey( void )
+{
+    struct utsname u;
+    PaUint64 hash = HashString( 0, PA_ALSA_CACHE_MAGIC );
+
+    if( uname( &u ) == 0 )
+        hash = HashString( hash, u.release );
+    hash = HashFile( hash, "/proc/asound/version", NULL );
+    hash = HashString( hash, alsa_snd_asoundlib_version() );
+    return hash;
+}
+
+static PaUint64 ConfigStamp( void )
+{
+    const char *home = getenv( "HOME" );
+    char rc[PATH_MAX];
+    PaUint64 hash = HashFileStamp( 0, "/etc/asound.conf" );
+
+    hash = HashFileStamp( hash, getenv( "ALSA_CONFIG_PATH" ) );
+    if( home )
+    {
+        snprintf( rc, sizeof (rc), "%s/.asoundrc", home );
+        hash = HashFileStamp( hash, rc );
+    }
+    return hash;
+}
+
+/* Hash the /proc/asound/cards entry for a card, its header line (index, id and driver) and the line after it */
+static PaUint64 HashCardEntry( PaUint64 hash, const char *cardsText, int card )
+{
+    const char *line = cardsText;
+    int index, lines;
+
+    while( line && *line )
+    {
+        if( sscanf( line, "%d [", &index ) == 1 && index == card )
+        {
+            for( lines = 0; lines < 2 && *line; ++lines )
+            {
+                const char *end = strchr( line, '\n' );
+                size_t len = end ? (size_t)( end - line ) : strlen( line );
+                hash = HashBytes( hash, line, len );
+                line += end ? len + 1 : len;
+            }
+            return hash;
+        }
+        line = strchr( line, '\n' );
+        if( line )
+            ++line;
+    }
+    return HashString( hash, "<gone>" );
+}
+
+/* Fingerprint of everything a device's capabilities depend on that can be looked up without opening it */
+static PaUint64 DeviceFingerprint( const PaAlsaDeviceCache *cache, const HwDevInfo *hwInfo )
+{
+    PaUint64 hash = HashString( 0, hwInfo->alsaName );
+    const char *name = hwInfo->alsaName;
+    int card, device;
+    char path[64];
+
+    hash = HashBytes( hash, &hwInfo->hasCapture, sizeof (int) );
+    hash = HashBytes( hash, &hwInfo->hasPlayback, sizeof (int) );
+
+    if( !strncmp( name, "plug", 4 ) )
+        name += 4;
+    if( !strncmp( name, "hw:", 3 ) && sscanf( name + 3, "%d,%d", &card, &device ) == 2 )
+    {
+        hash = HashCardEntry( hash, cache->cardsText ? cache->cardsText : "", card );
+        snprintf( path, sizeof (path), "/proc/asound/card%d/pcm%dc/info", card, device );
+        hash = HashFile( hash, path, "subdevices_avail" );
+        snprintf( path, sizeof (path), "/proc/asound/card%d/pcm%dp/info", card, device );
+        hash = HashFile( hash, path, "subdevices_avail" );
+    }
+    else
+    {
+        /* A plugin, which may sit on top of any card */
+        hash = HashString( hash, cache->cardsText );
+        hash = HashBytes( hash, &cache->configStamp, sizeof (cache->configStamp) );
+    }
+    return hash;
+}
+
+static PaAlsaCacheEntry *DeviceCache_Find( PaAlsaDeviceCache *cache, const char *alsaName )
+{
+    int i;
+
+    for( i = 0; i < cache->numEntries; ++i )
+    {
+        if( !strcmp( cache->entries[i].alsaName, alsaName ) )
+            return &cache->entries[i];
+    }
+    return NULL;
+}
+
+static PaAlsaCacheEntry *DeviceCache_Add( PaAlsaDeviceCache *cache, const char *alsaName )
+{
+    PaAlsaCacheEntry *entry;
+
+    if( cache->numEntries == cache->maxEntries )
+    {
+        int maxEntries = cache->maxEntries ? cache->maxEntries * 2 : 16;
+        PaAlsaCacheEntry *entries = (PaAlsaCacheEntry *)realloc( cache->entries, maxEntries * sizeof (PaAlsaCacheEntry) );
+        if( !entries )
+            return NULL;
+        cache->entries = entries;
+        cache->maxEntries = maxEntries;
+    }
+
+    entry = &cache->entries[cache->numEntries];
+    memset( entry, 0, sizeof (PaAlsaCacheEntry) );
+    if( !( entry->alsaName = strdup( alsaName ) ) )
+        return NULL;
+    ++cache->numEntries;
+    return entry;
+}
+
+/** Read the cache file, if caching is enabled. A missing, unreadable or outdated file just leaves the cache empty. */
+static void DeviceCache_Load( PaAlsaDeviceCache *cache )
+{
+    char line[512], magic[64];
+    unsigned long long systemKey;
+    FILE *f;
+
+    memset( cache, 0, sizeof (PaAlsaDeviceCache) );
+
+    cache->persistent = useDeviceCache_;
+    if( getenv( "PA_ALSA_DEVICE_CACHE" ) )
+        cache->persistent = atoi( getenv( "PA_ALSA_DEVICE_CACHE" ) );
+    if( !cache->persistent || !( cache->path = DeviceCachePath() ) )
+    {
+        cache->persistent = 0;
+        return;
+    }
+
+    cache->systemKey = SystemKey();
+
+    if( !( f = fopen( cache->path, "r" ) ) )
+        return;
+
+    snprintf( magic, sizeof (magic), "%s\n", PA_ALSA_CACHE_MAGIC );
+    if( !fgets( line, sizeof (line), f ) || strcmp( line, magic )
+            || !fgets( line, sizeof (line), f ) || sscanf( line, "system %llx", &systemKey ) != 1
+            || (PaUint64)systemKey != cache->systemKey )
+    {
+        PA_DEBUG(( "%s: Discarding outdated device cache %s\n", __FUNCTION__, cache->path ));
+        fclose( f );
+        return;
+    }
+
+    while( fgets( line, sizeof (line), f ) )
+    {
+        PaAlsaCacheEntry e, *entry;
+        unsigned long long fingerprint;
+        int nameStart = 0;
+        char *name;
+
+        if( sscanf( line, "%llx %d %d %d %d %lg %lg %lg %lg %lg %n", &fingerprint,
+                    &e.minInputChannels, &e.maxInputChannels, &e.minOutputChannels, &e.maxOutputChannels,
+                    &e.defaultLowInputLatency, &e.defaultHighInputLatency,
+                    &e.defaultLowOutputLatency, &e.defaultHighOutputLatency, &e.defaultSampleRate, &nameStart ) != 10
+                || nameStart == 0 )
+            continue;
+
+        name = line + nameStart;
+        name[strcspn( name, "\n" )] = '\0';
+        if( !*name || DeviceCache_Find( cache, name ) || !( entry = DeviceCache_Add( cache, name ) ) )
+            continue;
+
+        e.alsaName = entry->alsaName;
+        e.fingerprint = (PaUint64)fingerprint;
+        e.seen = 0;
+        *entry = e;
+    }
+    fclose( f );
+
+    PA_DEBUG(( "%s: Loaded %d devices from %s\n", __FUNCTION__, cache->numEntries, cache->path ));
+}
+
+/** Re-read what fingerprints depend on, before building a device list. */
+static void DeviceCache_Refresh( PaAlsaDeviceCache *cache )
+{
+    int i;
+
+    free( cache->cardsText );
+    cache->configStamp = ConfigStamp();
+    cache->cardsText = ReadTextFile( "/proc/asound/cards" );
+    for( i = 0; i < cache->numEntries; ++i )
+        cache->entries[i].seen = 0;
+}
+
+/** Fill in devInfo's capabilities from the cache. Returns 1 if the device was cached and has not changed. */
+static int DeviceCache_Lookup( PaAlsaDeviceCache *cache, const HwDevInfo *hwInfo, PaAlsaDeviceInfo *devInfo )
 {
-    PaError result = 0;
     PaDeviceInfo *baseDeviceInfo = &devInfo->baseDeviceInfo;
-    snd_pcm_t *pcm = NULL;
-    PaUtilHostApiRepresentation *baseApi = &alsaApi->baseHostApiRep;
+    PaAlsaCacheEntry *entry;
 
-    PA_DEBUG(( "%s: Filling device info for: %s\n", __FUNCTION__, deviceHwInfo->name ));
+    if( !( entry = DeviceCache_Find( cache, hwInfo->alsaName ) ) )
+        return 0;
+    if( entry->fingerprint != DeviceFingerprint( cache, hwInfo ) )
+        return 0;
 
-    /* Zero fields */
-    InitializeDeviceInfo( baseDeviceInfo );
+    entry->seen = 1;
+    devInfo->minInputChannels = entry->minInputChannels;
+    devInfo->minOutputChannels = entry->minOutputChannels;
+    baseDeviceInfo->maxInputChannels = entry->maxInputChannels;
+    baseDeviceInfo->maxOutputChannels = entry->maxOutputChannels;
+    baseDeviceInfo->defaultLowInputLatency = entry->defaultLowInputLatency;
+    baseDeviceInfo->defaultHighInputLatency = entry->defaultHighInputLatency;
+    baseDeviceInfo->defaultLowOutputLatency = entry->defaultLowOutputLatency;
+    baseDeviceInfo->defaultHighOutputLatency = entry->defaultHighOutputLatency;
+    baseDeviceInfo->defaultSampleRate = entry->defaultSampleRate;
+    return 1;
+}
 
-    /* To determine device capabilities, we must open the device and query the
-     * hardware parameter configuration space */
+/** Remember the capabilities FillInDevInfo found for a device. */
+static void DeviceCache_Store( PaAlsaDeviceCache *cache, const HwDevInfo *hwInfo, const PaAlsaDeviceInfo *devInfo )
+{
+    const PaDeviceInfo *baseDeviceInfo = &devInfo->baseDeviceInfo;
+    PaAlsaCacheEntry *entry;
+
+    if( !( entry = DeviceCache_Find( cache, hwInfo->alsaName ) ) && !( entry = DeviceCache_Add( cache, hwInfo->alsaName ) ) )
+        return;
+
+    entry->fingerprint = DeviceFingerprint( cache, hwInfo );
+    entry->seen = 1;
+    entry->minInputChannels = devInfo->minInputChannels;
+    entry->minOutputChannels = devInfo->minOutputChannels;
+    entry->maxInputChannels = baseDeviceInfo->maxInputChannels;
+    entry->maxOutputChannels = baseDeviceInfo->maxOutputChannels;
+    entry->defaultLowInputLatency = baseDeviceInfo->defaultLowInputLatency;
+    entry->defaultHighInputLatency = baseDeviceInfo->defaultHighInputLatency;
+    entry->defaultLowOutputLatency = baseDeviceInfo->defaultLowOutputLatency;
+    entry->defaultHighOutputLatency = baseDeviceInfo->defaultHighOutputLatency;
+    entry->defaultSampleRate = baseDeviceInfo->defaultSampleRate;
+    cache->dirty = 1;
+}
+
+/** Write the cache file back if anything changed, leaving out devices that have gone. */
+static void DeviceCache_Save( PaAlsaDeviceCache *cache )
+{
+    int i, numSeen = 0;
+
+    for( i = 0; i < cache->numEntries; ++i )
+        numSeen += cache->entries[i].seen;
 
-    /* Query capture */
-    if( deviceHwInfo->hasCapture &&
-        OpenPcm( &pcm, deviceHwInfo->alsaName, SND_PCM_STREAM_CAPTURE, blocking, 0 ) >= 0 )
+    if( cache->persistent && ( cache->dirty || numSeen != cache->numEntries ) )
     {
-        if( GropeDevice( pcm, deviceHwInfo->isPlug, StreamDirection_In, blocking, devInfo ) != paNoError )
+        size_t len = strlen( cache->path ) + 16;
+        char *tmpPath = (char *)malloc( len );
+        FILE *f = NULL;
+
+        /* Write a private temporary and rename it over the old file, so readers never see a partial cache */
+        if( tmpPath )
         {
-            /* Error */
-            PA_DEBUG(( "%s: Failed groping %s for capture\n", __FUNCTION__, deviceHwInfo->alsaName ));
-            goto end;
+            snprintf( tmpPath, len, "%s.%d", cache->path, (int)getpid() );
+            if( MakeParentDirectories( tmpPath ) == 0 )
+                f = fopen( tmpPath, "w" );
         }
+        if( f )
+        {
+            int ok;
+
+            fprintf( f, "%s\nsystem %016llx\n", PA_ALSA_CACHE_MAGIC, (unsigned long long)cache->systemKey );
+            for( i = 0; i < cache->numEntries; ++i )
+            {
+                const PaAlsaCacheEntry *e = &cache->entries[i];
+                if( !e->seen )
+                    continue;
+                fprintf( f, "%016llx %d %d %d %d %.17g %.17g %.17g %.17g %.17g %s\n",
+                        (unsigned long long)e->fingerprint,
+                        e->minInputChannels, e->maxInputChannels, e->minOutputChannels, e->maxOutputChannels,
+                        e->defaultLowInputLatency, e->defaultHighInputLatency,
+                        e->defaultLowOutputLatency, e->defaultHighOutputLatency, e->defaultSampleRate, e->alsaName );
+            }
+            ok = !ferror( f );
+            ok = ( fclose( f ) == 0 ) && ok;
+            if( !ok || rename( tmpPath, cache->path ) != 0 )
+            {
+                PA_DEBUG(( "%s: Failed writing device cache %s\n", __FUNCTION__, cache->path ));
+                remove( tmpPath );
+            }
+        }
+        free( tmpPath );
+        cache->dirty = 0;
+    }
+}
+
+/** Create the cache of a host API, reading the cache file if one is in use. */
+static PaAlsaDeviceCache *DeviceCache_New( void )
+{
+    PaAlsaDeviceCache *cache = (PaAlsaDeviceCache *)PaUtil_AllocateMemory( sizeof (PaAlsaDeviceCache) );
+
+    if( cache )
+        DeviceCache_Load( cache );
+    return cache;
+}
+
+static void DeviceCache_Delete( PaAlsaDeviceCache *cache )
+{
+    int i;
+
+    for( i = 0; i < cache->numEntries; ++i )
+        free( cache->entries[i].alsaName );
+    free( cache->entries );
+    free( cache->cardsText );
+    free( cache->path );
+    PaUtil_FreeMemory( cache );
+}
+
+/* Parallel device probing
+ *
+ * Groping waits on the device, which for USB interfaces or busy devices can take tens of milliseconds each, so
+ * BuildDeviceList gropes on a pool of threads (see PaUnix_RunProbes). A hw device cannot be opened twice, and plugins
+ * may route to any card, so only hardware is groped concurrently: one job per card, whose devices are groped in turn.
+ * Plugins are groped one at a time as before, but like everything else under a timeout, so that a hung device only
+ * loses itself. Probes work on private copies and the results are merged in list order, keeping device indices stable.
+ */
+
+typedef enum
+{
+    ProbeSet_Hardware,
+    ProbeSet_Plugins,
+    ProbeSet_Dmix       /* The 'dmix' and 'default' plugins, which may keep hardware busy after closing */
+} PaAlsaProbeSet;
+
+typedef struct
+{
+    char *alsaName;
+    int isPlug;
+    int hasPlayback;
+    int hasCapture;
+    PaAlsaDeviceInfo devInfo;
+    int groped;     /* Capabilities were determined */
+    int busy;
+} PaAlsaProbedDevice;
+
+typedef struct
+{
+    int blocking;
+    int firstCandidate;
+    int numDevices;
+    PaAlsaProbedDevice *devices;
+} PaAlsaProbeJob;
+
+/* The card a hw device (hw:X,Y or plughw:X,Y) belongs to, -1 for plugins */
+static int HwDevInfoCard( const HwDevInfo *hwInfo )
+{
+    const char *name = hwInfo->alsaName;
+    int card;
+
+    if( !strncmp( name, "plug", 4 ) )
+        name += 4;
+    if( sscanf( name, "hw:%d,", &card ) != 1 )
+        return -1;
+    return card;
+}
+
+static int IsInProbeSet( const HwDevInfo *hwInfo, PaAlsaProbeSet set )
+{
+    int isDmix = !strcmp( hwInfo->name, "dmix" ) || !strcmp( hwInfo->name, "default" );
+
+    switch( set )
+    {
+        case ProbeSet_Hardware:
+            return HwDevInfoCard( hwInfo ) >= 0;
+        case ProbeSet_Plugins:
+            return HwDevInfoCard( hwInfo ) < 0 && !isDmix;
+        default:
+            return isDmix;
     }
+}
 
-    /* Query playback */
-    if( deviceHwInfo->hasPlayback &&
-        OpenPcm( &pcm, deviceHwInfo->alsaName, SND_PCM_STREAM_PLAYBACK, blocking, 0 ) >= 0 )
+/* PaUnix_RunProbes probe, may run on any thread and must only touch the job */
+static void ProbeDevice( void *data )
+{
+    PaAlsaProbeJob *job = (PaAlsaProbeJob *)data;
+    int i;
+
+    for( i = 0; i < job->numDevices; ++i )
     {
-        if( GropeDevice( pcm, deviceHwInfo->isPlug, StreamDirection_Out, blocking, devInfo ) != paNoError )
+        PaAlsaProbedDevice *dev = &job->devices[i];
+        snd_pcm_t *pcm = NULL;
+        int ret;
+
+        /* To determine device capabilities, we must open the device and query the
+         * hardware parameter configuration space */
+
+        /* Query capture */
+        if( dev->hasCapture &&
+            ( ret = OpenPcm( &pcm, dev->alsaName, SND_PCM_STREAM_CAPTURE, job->blocking, 0 ) ) >= 0 )
         {
-            /* Error */
-            PA_DEBUG(( "%s: Failed groping %s for playback\n", __FUNCTION__, deviceHwInfo->alsaName ));
-            goto end;
+            if( GropeDevice( pcm, dev->isPlug, StreamDirection_In, job->blocking, &dev->devInfo ) != paNoError )
+            {
+                /* Error */
+                PA_DEBUG(( "%s: Failed groping %s for capture\n", __FUNCTION__, dev->alsaName ));
+                continue;
+            }
         }
+        else if( dev->hasCapture )
+            dev->busy |= -EBUSY == ret;
+
+        /* Query playback */
+        if( dev->hasPlayback &&
+            ( ret = OpenPcm( &pcm, dev->alsaName, SND_PCM_STREAM_PLAYBACK, job->blocking, 0 ) ) >= 0 )
+        {
+            if( GropeDevice( pcm, dev->isPlug, StreamDirection_Out, job->blocking, &dev->devInfo ) != paNoError )
+            {
+                /* Error */
+                PA_DEBUG(( "%s: Failed groping %s for playback\n", __FUNCTION__, dev->alsaName ));
+                continue;
+            }
+        }
+        else if( dev->hasPlayback )
+            dev->busy |= -EBUSY == ret;
+
+        dev->groped = 1;
     }
+}
+
+static void FreeProbeJob( void *data )
+{
+    PaAlsaProbeJob *job = (PaAlsaProbeJob *)data;
+    int i;
+
+    for( i = 0; i < job->numDevices; ++i )
+        free( job->devices[i].alsaName );
+    free( job );
+}
+
+/* The entry of a device in the host API's current device list, if it has one */
+static const PaAlsaDeviceInfo *FindListedDevice( const PaUtilHostApiRepresentation *baseApi, const char *alsaName )
+{
+    int i;
+
+    for( i = 0; i < baseApi->info.deviceCount; ++i )
+    {
+        const PaAlsaDeviceInfo *devInfo = GetDeviceInfo( baseApi, i );
+        if( !strcmp( devInfo->alsaName, alsaName ) )
+            return devInfo;
+    }
+    return NULL;
+}
+
+/** Determine the capabilities of the devices in a probe set, from the cache or by groping them on up to numThreads
+ * threads. Fills in deviceInfoArray and sets probed for each device whose capabilities are known. A device that turns
+ * out to be busy, perhaps with one of our own streams, keeps the capabilities it is listed with in listedApi.
+ */
+static PaError ProbeDevices( HwDevInfo *hwDevInfos, int numDevices, PaAlsaProbeSet set, int numThreads, int blocking,
+        PaAlsaDeviceInfo *deviceInfoArray, int *probed, PaAlsaDeviceCache *cache,
+        const PaUtilHostApiRepresentation *listedApi, PaUnixProbeTracker *tracker )
+{
+    PaError result = paNoError;
+    int *candidates = NULL, *finished = NULL;
+    PaAlsaProbeJob **jobs = NULL;
+    int numCandidates = 0, numJobs = 0, c, end, i, j;
+
+    PA_UNLESS( candidates = (int *)calloc( numDevices + 1, sizeof (int) ), paInsufficientMemory );
+    PA_UNLESS( finished = (int *)calloc( numDevices + 1, sizeof (int) ), paInsufficientMemory );
+    PA_UNLESS( jobs = (PaAlsaProbeJob **)calloc( numDevices + 1, sizeof (PaAlsaProbeJob *) ), paInsufficientMemory );
+
+    for( i = 0; i < numDevices; ++i )
+    {
+        PaAlsaDeviceInfo *devInfo = &deviceInfoArray[i];
+
+        if( !IsInProbeSet( &hwDevInfos[i], set ) )
+            continue;
+
+        PA_DEBUG(( "%s: Filling device info for: %s\n", __FUNCTION__, hwDevInfos[i].name ));
+
+        /* Zero fields */
+        InitializeDeviceInfo( &devInfo->baseDeviceInfo );
+
+        if( DeviceCache_Lookup( cache, &hwDevInfos[i], devInfo ) )
+        {
+            PA_DEBUG(( "%s: Using cached capabilities for %s\n", __FUNCTION__, hwDevInfos[i].alsaName ));
+            probed[i] = 1;
+            continue;
+        }
+        candidates[numCandidates++] = i;
+    }
+
+    /* The devices of a card are listed together */
+    for( c = 0; c < numCandidates; c = end )
+    {
+        PaAlsaProbeJob *job;
+
+        for( end = c + 1; set == ProbeSet_Hardware && end < numCandidates &&
+                HwDevInfoCard( &hwDevInfos[candidates[end]] ) == HwDevInfoCard( &hwDevInfos[candidates[c]] ); ++end )
+            ;
+
+        PA_UNLESS( job = (PaAlsaProbeJob *)calloc( 1, sizeof (PaAlsaProbeJob) + ( end - c ) * sizeof (PaAlsaProbedDevice) ),
+                paInsufficientMemory );
+        jobs[numJobs++] = job;
+        job->blocking = blocking;
+        job->firstCandidate = c;
+        job->devices = (PaAlsaProbedDevice *)( job + 1 );
+        for( j = c; j < end; ++j )
+        {
+            /* Copies, since a probe that times out may outlive the device list */
+            const HwDevInfo *hwInfo = &hwDevInfos[candidates[j]];
+            PaAlsaProbedDevice *dev = &job->devices[job->numDevices];
+
+            PA_UNLESS( dev->alsaName = strdup( hwInfo->alsaName ), paInsufficientMemory );
+            ++job->numDevices;
+            dev->isPlug = hwInfo->isPlug;
+            dev->hasPlayback = hwInfo->hasPlayback;
+            dev->hasCapture = hwInfo->hasCapture;
+            InitializeDeviceInfo( &dev->devInfo.baseDeviceInfo );
+        }
+    }
+
+    PA_ENSURE( PaUnix_RunProbes( (void **)jobs, numJobs, ProbeDevice, FreeProbeJob, numThreads, probeTimeout_,
+                tracker, finished ) );
+
+    for( j = 0; j < numJobs; ++j )
+    {
+        if( !finished[j] )
+        {
+            PA_DEBUG(( "%s: Gave up on %s after %g seconds\n", __FUNCTION__,
+                        hwDevInfos[candidates[jobs[j]->firstCandidate]].alsaName, probeTimeout_ ));
+            jobs[j] = NULL;     /* Now owned by its probe thread */
+            continue;
+        }
+
+        for( c = 0; c < jobs[j]->numDevices; ++c )
+        {
+            const PaAlsaProbedDevice *dev = &jobs[j]->devices[c];
+            const PaAlsaDeviceInfo *listed;
+
+            i = candidates[jobs[j]->firstCandidate + c];
+            if( dev->busy && ( listed = FindListedDevice( listedApi, dev->alsaName ) ) )
+            {
+                PA_DEBUG(( "%s: %s is busy, keeping its listed capabilities\n", __FUNCTION__, dev->alsaName ));
+                deviceInfoArray[i] = *listed;
+                probed[i] = 1;
+                continue;
+            }
+            if( !dev->groped )
+                continue;
+
+            deviceInfoArray[i] = dev->devInfo;
+            probed[i] = 1;
+
+            /* A busy device may well have more to offer next time */
+            if( !dev->busy )
+                DeviceCache_Store( cache, &hwDevInfos[i], &deviceInfoArray[i] );
+        }
+    }
+
+error:
+    if( jobs )
+    {
+        for( j = 0; j < numJobs; ++j )
+        {
+            if( jobs[j] )
+                FreeProbeJob( jobs[j] );
+        }
+    }
+    free( jobs );
+    free( finished );
+    free( candidates );
+    return result;
+}
+
+/* Fill in the identity of a device whose capabilities have been determined, and add it if it has any channels */
+static void FillInDevInfo( PaAlsaHostApiRepresentation *alsaApi, PaAlsaDeviceList *list, HwDevInfo* deviceHwInfo,
+        PaAlsaDeviceInfo* devInfo, int* devIdx )
+{
+    PaDeviceInfo *baseDeviceInfo = &devInfo->baseDeviceInfo;
 
     baseDeviceInfo->structVersion = 2;
     baseDeviceInfo->hostApi = alsaApi->hostApiIndex;
     baseDeviceInfo->name = deviceHwInfo->name;
     devInfo->alsaName = deviceHwInfo->alsaName;
     devInfo->isPlug = deviceHwInfo->isPlug;
+    /* Capabilities are queried afresh with each device list, a listed device's belong to the list it came from */
+    devInfo->caps[StreamDirection_In] = devInfo->caps[StreamDirection_Out] = NULL;
 
     /* A: Storing pointer to PaAlsaDeviceInfo object as pointer to PaDeviceInfo object.
      * Should now be safe to add device info, unless the device supports neither capture nor playback
@@ -1203,33 +1995,31 @@ static PaError FillInDevInfo( PaAlsaHostApiRepresentation *alsaApi, HwDevInfo* d
     if( baseDeviceInfo->maxInputChannels > 0 || baseDeviceInfo->maxOutputChannels > 0 )
     {
         /* Make device default if there isn't already one or it is the ALSA "default" device */
-        if( ( baseApi->info.defaultInputDevice == paNoDevice ||
+        if( ( list->defaultInputDevice == paNoDevice ||
             !strcmp( deviceHwInfo->alsaName, "default" ) ) && baseDeviceInfo->maxInputChannels > 0 )
         {
-            baseApi->info.defaultInputDevice = *devIdx;
+            list->defaultInputDevice = *devIdx;
             PA_DEBUG(( "Default input device: %s\n", deviceHwInfo->name ));
         }
-        if( ( baseApi->info.defaultOutputDevice == paNoDevice ||
+        if( ( list->defaultOutputDevice == paNoDevice ||
             !strcmp( deviceHwInfo->alsaName, "default" ) ) && baseDeviceInfo->maxOutputChannels > 0 )
         {
-            baseApi->info.defaultOutputDevice = *devIdx;
+            list->defaultOutputDevice = *devIdx;
             PA_DEBUG(( "Default output device: %s\n", deviceHwInfo->name ));
         }
         PA_DEBUG(( "%s: Adding device %s: %d\n", __FUNCTION__, deviceHwInfo->name, *devIdx ));
-        baseApi->deviceInfos[*devIdx] = (PaDeviceInfo *) devInfo;
+        list->deviceInfos[*devIdx] = (PaDeviceInfo *) devInfo;
         (*devIdx) += 1;
     }
     else
     {
         PA_DEBUG(( "%s: Skipped device: %s, all channels == 0\n", __FUNCTION__, deviceHwInfo->name ));
     }
-
-end:
-    return result;
 }
 
-/* Build PaDeviceInfo list, ignore devices for which we cannot determine capabilities (possibly busy, sigh) */
-static PaError BuildDeviceList( PaAlsaHostApiRepresentation *alsaApi )
+/* Build PaDeviceInfo list, ignore devices for which we cannot determine capabilities (possibly busy, sigh). The host
+ * API's current device list is left alone, see CommitDeviceList. */
+static PaError BuildDeviceList( PaAlsaHostApiRepresentation *alsaApi, PaAlsaDeviceList *list )
 {
     PaUtilHostApiRepresentation *baseApi = &alsaApi->baseHostApiRep;
     PaAlsaDeviceInfo *deviceInfoArray;
@@ -1245,6 +2035,9 @@ static PaError BuildDeviceList( PaAlsaHostApiRepresentation *alsaApi )
     int usePlughw = 0;
     char *hwPrefix = "";
     char alsaCardName[50];
+    PaAlsaDeviceCache *cache = alsaApi->deviceCache;
+    int *probed = NULL;
+    int numThreads = probeThreads_;
 #ifdef PA_ENABLE_DEBUG_OUTPUT
     PaTime startTime = PaUtil_GetTime();
 #endif
@@ -1261,8 +2054,12 @@ static PaError BuildDeviceList( PaAlsaHostApiRepresentation *alsaApi )
     }
 
     /* These two will be set to the first working input and output device, respectively */
-    baseApi->info.defaultInputDevice = paNoDevice;
-    baseApi->info.defaultOutputDevice = paNoDevice;
+    memset( list, 0, sizeof (PaAlsaDeviceList) );
+    list->defaultInputDevice = paNoDevice;
+    list->defaultOutputDevice = paNoDevice;
+    PA_UNLESS( list->allocations = PaUtil_CreateAllocationGroup(), paInsufficientMemory );
+
+    DeviceCache_Refresh( cache );
 
     /* Gather info about hw devices
 
@@ -1293,7 +2090,7 @@ static PaError BuildDeviceList( PaAlsaHostApiRepresentation *alsaApi )
         }
         alsa_snd_ctl_card_info( ctl, cardInfo );
 
-        PA_ENSURE( PaAlsa_StrDup( alsaApi, &cardName, alsa_snd_ctl_card_info_get_name( cardInfo )) );
+        PA_ENSURE( PaAlsa_StrDup( list->allocations, &cardName, alsa_snd_ctl_card_info_get_name( cardInfo )) );
 
         while( alsa_snd_ctl_pcm_next_device( ctl, &devIdx ) == 0 && devIdx >= 0 )
         {
@@ -1328,7 +2125,7 @@ static PaError BuildDeviceList( PaAlsaHostApiRepresentation *alsaApi )
 
             /* The length of the string written by snprintf plus terminating 0 */
             len = snprintf( NULL, 0, "%s: %s (%s)", cardName, infoName, buf ) + 1;
-            PA_UNLESS( deviceName = (char *)PaUtil_GroupAllocateMemory( alsaApi->allocations, len ),
+            PA_UNLESS( deviceName = (char *)PaUtil_GroupAllocateMemory( list->allocations, len ),
                     paInsufficientMemory );
             snprintf( deviceName, len, "%s: %s (%s)", cardName, infoName, buf );
 
@@ -1342,7 +2139,7 @@ static PaError BuildDeviceList( PaAlsaHostApiRepresentation *alsaApi )
                         paInsufficientMemory );
             }
 
-            PA_ENSURE( PaAlsa_StrDup( alsaApi, &alsaDeviceName, buf ) );
+            PA_ENSURE( PaAlsa_StrDup( list->allocations, &alsaDeviceName, buf ) );
 
             hwDevInfos[ numDeviceNames - 1 ].alsaName = alsaDeviceName;
             hwDevInfos[ numDeviceNames - 1 ].name = deviceName;
@@ -1393,10 +2190,10 @@ static PaError BuildDeviceList( PaAlsaHostApiRepresentation *alsaApi )
             }
             PA_DEBUG(( "%s: Found plugin [%s] of type [%s]\n", __FUNCTION__, idStr, tpStr ));
 
-            PA_UNLESS( alsaDeviceName = (char*)PaUtil_GroupAllocateMemory( alsaApi->allocations,
+            PA_UNLESS( alsaDeviceName = (char*)PaUtil_GroupAllocateMemory( list->allocations,
                                                             strlen(idStr) + 6 ), paInsufficientMemory );
             strcpy( alsaDeviceName, idStr );
-            PA_UNLESS( deviceName = (char*)PaUtil_GroupAllocateMemory( alsaApi->allocations,
+            PA_UNLESS( deviceName = (char*)PaUtil_GroupAllocateMemory( list->allocations,
                                                             strlen(idStr) + 1 ), paInsufficientMemory );
             strcpy( deviceName, idStr );
 
@@ -1430,12 +2227,18 @@ static PaError BuildDeviceList( PaAlsaHostApiRepresentation *alsaApi )
         PA_DEBUG(( "%s: Iterating over ALSA plugins failed: %s\n", __FUNCTION__, alsa_snd_strerror( res ) ));
 
     /* allocate deviceInfo memory based on the number of devices */
-    PA_UNLESS( baseApi->deviceInfos = (PaDeviceInfo**)PaUtil_GroupAllocateMemory(
-            alsaApi->allocations, sizeof(PaDeviceInfo*) * (numDeviceNames) ), paInsufficientMemory );
+    PA_UNLESS( list->deviceInfos = (PaDeviceInfo**)PaUtil_GroupAllocateMemory(
+            list->allocations, sizeof(PaDeviceInfo*) * (numDeviceNames) ), paInsufficientMemory );
 
     /* allocate all device info structs in a contiguous block */
     PA_UNLESS( deviceInfoArray = (PaAlsaDeviceInfo*)PaUtil_GroupAllocateMemory(
-            alsaApi->allocations, sizeof(PaAlsaDeviceInfo) * numDeviceNames ), paInsufficientMemory );
+            list->allocations, sizeof(PaAlsaDeviceInfo) * numDeviceNames ), paInsufficientMemory );
+
+    PA_UNLESS( probed = (int *)calloc( numDeviceNames + 1, sizeof (int) ), paInsufficientMemory );
+
+    /* alsa-lib can only be used from several threads at once from 1.1.2 on */
+    if( alsaApi->alsaLibVersion < ALSA_VERSION_INT( 1, 1, 2 ) )
+        numThreads = 0;
 
     /* Loop over list of cards, filling in info. If a device is deemed unavailable (can't get name),
      * it's ignored.
@@ -1446,46 +2249,256 @@ static PaError BuildDeviceList( PaAlsaHostApiRepresentation *alsaApi )
      * for this.
      */
     PA_DEBUG(( "%s: Filling device info for %d devices\n", __FUNCTION__, numDeviceNames ));
+    PA_ENSURE( ProbeDevices( hwDevInfos, (int)numDeviceNames, ProbeSet_Hardware, numThreads, blocking,
+                deviceInfoArray, probed, cache, baseApi, alsaApi->probeTracker ) );
+    PA_ENSURE( ProbeDevices( hwDevInfos, (int)numDeviceNames, ProbeSet_Plugins, PA_MIN( numThreads, 1 ), blocking,
+                deviceInfoArray, probed, cache, baseApi, alsaApi->probeTracker ) );
     for( i = 0, devIdx = 0; i < numDeviceNames; ++i )
     {
-        PaAlsaDeviceInfo* devInfo = &deviceInfoArray[i];
-        HwDevInfo* hwInfo = &hwDevInfos[i];
-        if( !strcmp( hwInfo->name, "dmix" ) || !strcmp( hwInfo->name, "default" ) )
-        {
-            continue;
-        }
-
-        PA_ENSURE( FillInDevInfo( alsaApi, hwInfo, blocking, devInfo, &devIdx ) );
+        if( probed[i] && !IsInProbeSet( &hwDevInfos[i], ProbeSet_Dmix ) )
+            FillInDevInfo( alsaApi, list, &hwDevInfos[i], &deviceInfoArray[i], &devIdx );
     }
     assert( devIdx <= numDeviceNames );
     /* Now inspect 'dmix' and 'default' plugins */
+    PA_ENSURE( ProbeDevices( hwDevInfos, (int)numDeviceNames, ProbeSet_Dmix, PA_MIN( numThreads, 1 ), blocking,
+                deviceInfoArray, probed, cache, baseApi, alsaApi->probeTracker ) );
     for( i = 0; i < numDeviceNames; ++i )
     {
-        PaAlsaDeviceInfo* devInfo = &deviceInfoArray[i];
-        HwDevInfo* hwInfo = &hwDevInfos[i];
-        if( strcmp( hwInfo->name, "dmix" ) && strcmp( hwInfo->name, "default" ) )
-        {
-            continue;
-        }
-
-        PA_ENSURE( FillInDevInfo( alsaApi, hwInfo, blocking, devInfo, &devIdx ) );
+        if( probed[i] && IsInProbeSet( &hwDevInfos[i], ProbeSet_Dmix ) )
+            FillInDevInfo( alsaApi, list, &hwDevInfos[i], &deviceInfoArray[i], &devIdx );
     }
-    free( hwDevInfos );
-
-    baseApi->info.deviceCount = devIdx;   /* Number of successfully queried devices */
+    list->deviceCount = devIdx;   /* Number of successfully queried devices */
 
 #ifdef PA_ENABLE_DEBUG_OUTPUT
     PA_DEBUG(( "%s: Building device list took %f seconds\n", __FUNCTION__, PaUtil_GetTime() - startTime ));
 #endif
 
 end:
+    free( hwDevInfos );
+    free( probed );
+    DeviceCache_Save( cache );
     return result;
 
 error:
-    /* No particular action */
+    if( list->allocations )
+    {
+        PaUtil_FreeAllAllocations( list->allocations );
+        PaUtil_DestroyAllocationGroup( list->allocations );
+        list->allocations = NULL;
+    }
     goto end;
 }
 
+/* Make a built device list the host API's device list, freeing the previous one */
+static void CommitDeviceList( PaAlsaHostApiRepresentation *alsaApi, PaAlsaDeviceList *list )
+{
+    PaUtilHostApiRepresentation *baseApi = &alsaApi->baseHostApiRep;
+
+    if( alsaApi->allocations )
+    {
+        PaUtil_FreeAllAllocations( alsaApi->allocations );
+        PaUtil_DestroyAllocationGroup( alsaApi->allocations );
+    }
+    alsaApi->allocations = list->allocations;
+    baseApi->deviceInfos = list->deviceInfos;
+    baseApi->info.deviceCount = list->deviceCount;
+    baseApi->info.defaultInputDevice = list->defaultInputDevice;
+    baseApi->info.defaultOutputDevice = list->defaultOutputDevice;
+    list->allocations = NULL;
+}
+
+static void DisposeDeviceList( PaAlsaDeviceList *list )
+{
+    if( list->allocations )
+    {
+        PaUtil_FreeAllAllocations( list->allocations );
+        PaUtil_DestroyAllocationGroup( list->allocations );
+        list->allocations = NULL;
+    }
+}
+
+/* Hot-plugging
+ *
+ * Pa_UpdateAvailableDeviceList rescans through ScanDeviceInfos, which builds a complete new device list while the
+ * current one stays in place, and CommitDeviceInfos, which swaps it in. Thanks to the device cache only new or
+ * changed devices are groped, and a device that is busy with one of our own streams keeps its listed capabilities.
+ * Streams copy what they need from the device list when they are opened, so open streams are not disturbed.
+ *
+ * The device monitor watches /dev/snd with inotify, where a sound card coming or going creates or removes its control
+ * device controlC<card>, and reports changes through PaUtil_DevicesChanged once the burst of device nodes that udev
+ * creates for a card has settled. It never touches the device list itself. Setting the environment variable
+ * PA_ALSA_DEVICE_MONITOR to 0 turns it off.
+ */
+
+static PaError ScanDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, PaHostApiIndex index,
+        void **scanResults, int *newDeviceCount )
+{
+    PaAlsaHostApiRepresentation *alsaApi = (PaAlsaHostApiRepresentation*)hostApi;
+    PaAlsaDeviceList *list;
+    PaError result;
+
+    (void)index;    /* Same as alsaApi->hostApiIndex */
+
+    if( !( list = (PaAlsaDeviceList *)PaUtil_AllocateMemory( sizeof (PaAlsaDeviceList) ) ) )
+        return paInsufficientMemory;
+    if( ( result = BuildDeviceList( alsaApi, list ) ) != paNoError )
+    {
+        PaUtil_FreeMemory( list );
+        return result;
+    }
+
+    *scanResults = list;
+    *newDeviceCount = list->deviceCount;
+    return paNoError;
+}
+
+static void CommitDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, PaHostApiIndex index,
+        void *scanResults, int deviceCount )
+{
+    (void)index;
+    (void)deviceCount;
+
+    CommitDeviceList( (PaAlsaHostApiRepresentation*)hostApi, (PaAlsaDeviceList *)scanResults );
+    PaUtil_FreeMemory( scanResults );
+}
+
+static void DisposeDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, void *scanResults, int deviceCount )
+{
+    (void)hostApi;
+    (void)deviceCount;
+
+    DisposeDeviceList( (PaAlsaDeviceList *)scanResults );
+    PaUtil_FreeMemory( scanResults );
+}
+
+#define PA_ALSA_MONITOR_SETTLE_MSEC 250
+#define PA_ALSA_MONITOR_EVENTS ( IN_CREATE | IN_DELETE )
+
+typedef struct PaAlsaDeviceMonitor
+{
+    pthread_t thread;
+    int inotifyFd;
+    int sndWatch;       /* Watch on /dev/snd, -1 while it does not exist */
+    int stopPipe[2];
+} PaAlsaDeviceMonitor;
+
+static void *DeviceMonitorThreadFunc( void *userData )
+{
+    PaAlsaDeviceMonitor *monitor = (PaAlsaDeviceMonitor *)userData;
+    union
+    {
+        struct inotify_event event;
+        char bytes[4096];
+    } buf;
+    int changed = 0;
+
+    for( ;; )
+    {
+        struct pollfd pfds[2];
+        const struct inotify_event *event;
+        ssize_t len;
+        char *p;
+        int ret;
+
+        pfds[0].fd = monitor->stopPipe[0];
+        pfds[0].events = POLLIN;
+        pfds[1].fd = monitor->inotifyFd;
+        pfds[1].events = POLLIN;
+        ret = poll( pfds, 2, changed ? PA_ALSA_MONITOR_SETTLE_MSEC : -1 );
+        if( ret < 0 && errno == EINTR )
+            continue;
+        if( ret < 0 || pfds[0].revents )
+            break;
+        if( ret == 0 )
+        {
+            PA_DEBUG(( "%s: Sound cards have come or gone\n", __FUNCTION__ ));
+            changed = 0;
+            PaUtil_DevicesChanged();
+            continue;
+        }
+
+        if( ( len = read( monitor->inotifyFd, buf.bytes, sizeof (buf.bytes) ) ) <= 0 )
+            continue;
+        for( p = buf.bytes; p < buf.bytes + len; p += sizeof (struct inotify_event) + event->len )
+        {
+            event = (const struct inotify_event *)p;
+            if( event->wd == monitor->sndWatch )
+            {
+                if( event->mask & IN_IGNORED )
+                {
+                    /* /dev/snd itself went away */
+                    monitor->sndWatch = -1;
+                    changed = 1;
+                }
+                else if( event->len && !strncmp( event->name, "controlC", 8 ) )
+                    changed = 1;
+            }
+            else if( monitor->sndWatch < 0 && event->len && !strcmp( event->name, "snd" ) )
+            {
+                monitor->sndWatch = inotify_add_watch( monitor->inotifyFd, "/dev/snd", PA_ALSA_MONITOR_EVENTS );
+                changed = 1;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void CloseDeviceMonitor( PaAlsaDeviceMonitor *monitor )
+{
+    if( monitor->inotifyFd >= 0 )
+        close( monitor->inotifyFd );
+    if( monitor->stopPipe[0] >= 0 )
+        close( monitor->stopPipe[0] );
+    if( monitor->stopPipe[1] >= 0 )
+        close( monitor->stopPipe[1] );
+    PaUtil_FreeMemory( monitor );
+}
+
+/* Failing to monitor devices is not an error, hot-plugged devices then only show when the application rescans */
+static void StartDeviceMonitor( PaAlsaHostApiRepresentation *alsaApi )
+{
+    PaAlsaDeviceMonitor *monitor;
+
+    if( getenv( "PA_ALSA_DEVICE_MONITOR" ) && !atoi( getenv( "PA_ALSA_DEVICE_MONITOR" ) ) )
+        return;
+    if( !( monitor = (PaAlsaDeviceMonitor *)PaUtil_AllocateMemory( sizeof (PaAlsaDeviceMonitor) ) ) )
+        return;
+
+    monitor->stopPipe[0] = monitor->stopPipe[1] = -1;
+    /* /dev is watched for /dev/snd appearing after the first card */
+    if( ( monitor->inotifyFd = inotify_init1( IN_CLOEXEC ) ) < 0 || pipe( monitor->stopPipe ) < 0
+            || inotify_add_watch( monitor->inotifyFd, "/dev", IN_CREATE | IN_ONLYDIR ) < 0 )
+    {
+        PA_DEBUG(( "%s: Not monitoring devices: %s\n", __FUNCTION__, strerror( errno ) ));
+        CloseDeviceMonitor( monitor );
+        return;
+    }
+    monitor->sndWatch = inotify_add_watch( monitor->inotifyFd, "/dev/snd", PA_ALSA_MONITOR_EVENTS );
+
+    if( pthread_create( &monitor->thread, NULL, DeviceMonitorThreadFunc, monitor ) != 0 )
+    {
+        PA_DEBUG(( "%s: Failed creating device monitor thread\n", __FUNCTION__ ));
+        CloseDeviceMonitor( monitor );
+        return;
+    }
+    alsaApi->deviceMonitor = monitor;
+}
+
+static void StopDeviceMonitor( PaAlsaHostApiRepresentation *alsaApi )
+{
+    PaAlsaDeviceMonitor *monitor = alsaApi->deviceMonitor;
+
+    if( !monitor )
+        return;
+
+    while( write( monitor->stopPipe[1], "", 1 ) < 0 && errno == EINTR )
+        ;
+    pthread_join( monitor->thread, NULL );
+    CloseDeviceMonitor( monitor );
+    alsaApi->deviceMonitor = NULL;
+}
+
 /* Check against known device capabilities */
 static PaError ValidateParameters( const PaStreamParameters *parameters, PaUtilHostApiRepresentation *hostApi, StreamDirection mode )
 {
@@ -1750,11 +2763,183 @@ error:
     goto end;
 }
 
-static PaError TestParameters( const PaUtilHostApiRepresentation *hostApi, const PaStreamParameters *parameters,
+/* Capability matrices
+ *
+ * Pa_IsFormatSupported used to open the device for every query. Now the first query for a device and direction opens
+ * it once and records which rates, channel counts and host formats its configuration space admits, together with
+ * its period and buffer size limits, and later queries are answered from that record. Rates are recorded at the
+ * standard rates below; queries for other rates, or for more than PA_ALSA_CAPS_MAX_CHANNELS channels, open the device
+ * as before. The matrices belong to the device list, so a device list update, on hot-plugging for instance, discards
+ * them.
+ */
+
+static const unsigned int capsRates_[] = { 8000, 11025, 16000, 22050, 32000, 44100, 48000, 64000, 88200, 96000,
+    176400, 192000, 352800, 384000 };
+#define PA_ALSA_CAPS_NUM_RATES (int)(sizeof (capsRates_) / sizeof (capsRates_[0]))
+#define PA_ALSA_CAPS_MAX_CHANNELS 32
+
+typedef struct PaAlsaDeviceCaps
+{
+    PaAlsaDeviceCapabilities limits;
+    int interleaved;        /* Whether the device takes interleaved buffers */
+    unsigned int rates;     /* Bit per entry of capsRates_ the device takes */
+    /* The host formats the device takes at each standard rate and channel count (channel count - 1), zero where it
+     * doesn't take the channel count at that rate. All host formats fit in a byte. */
+    unsigned char formats[PA_ALSA_CAPS_NUM_RATES][PA_ALSA_CAPS_MAX_CHANNELS];
+}
+PaAlsaDeviceCaps;
+
+static int FindCapsRate( double sampleRate )
+{
+    int i;
+    for( i = 0; i < PA_ALSA_CAPS_NUM_RATES; ++i )
+    {
+        if( capsRates_[i] == sampleRate )
+            return i;
+    }
+    return -1;
+}
+
+/* Fill in caps from the configuration space of an open pcm */
+static void ProbeDeviceCaps( snd_pcm_t *pcm, PaAlsaDeviceCaps *caps )
+{
+    static const PaSampleFormat hostFormats[] = { paFloat32, paInt32, paInt24, paInt16, paInt8, paUInt8 };
+    snd_pcm_hw_params_t *anyParams, *rateParams, *chanParams;
+    unsigned int minChans = 1, maxChans = 1, minRate = 0, maxRate = 0, chans;
+    snd_pcm_uframes_t minPeriod = 0, maxPeriod = 0, minBuffer = 0, maxBuffer = 0;
+    unsigned int lastChans;
+    int dir, r, f;
+
+    alsa_snd_pcm_hw_params_alloca( &anyParams );
+    alsa_snd_pcm_hw_params_alloca( &rateParams );
+    alsa_snd_pcm_hw_params_alloca( &chanParams );
+    memset( caps, 0, sizeof (PaAlsaDeviceCaps) );
+
+    alsa_snd_pcm_hw_params_any( pcm, anyParams );
+    alsa_snd_pcm_hw_params_get_channels_min( anyParams, &minChans );
+    alsa_snd_pcm_hw_params_get_channels_max( anyParams, &maxChans );
+    dir = 0;
+    alsa_snd_pcm_hw_params_get_rate_min( anyParams, &minRate, &dir );
+    dir = 0;
+    alsa_snd_pcm_hw_params_get_rate_max( anyParams, &maxRate, &dir );
+    dir = 0;
+    alsa_snd_pcm_hw_params_get_period_size_min( anyParams, &minPeriod, &dir );
+    dir = 0;
+    alsa_snd_pcm_hw_params_get_period_size_max( anyParams, &maxPeriod, &dir );
+    alsa_snd_pcm_hw_params_get_buffer_size_min( anyParams, &minBuffer );
+    alsa_snd_pcm_hw_params_get_buffer_size_max( anyParams, &maxBuffer );
+
+    caps->limits.minChannels = (int)minChans;
+    caps->limits.maxChannels = (int)PA_MIN( maxChans, (unsigned int)INT_MAX );
+    caps->limits.sampleFormats = GetAvailableFormats( pcm );
+    caps->interleaved = alsa_snd_pcm_hw_params_test_access( pcm, anyParams, SND_PCM_ACCESS_MMAP_INTERLEAVED ) >= 0 ||
+        alsa_snd_pcm_hw_params_test_access( pcm, anyParams, SND_PCM_ACCESS_RW_INTERLEAVED ) >= 0;
+    caps->limits.minSampleRate = minRate;
+    caps->limits.maxSampleRate = maxRate;
+    caps->limits.minPeriodFrames = minPeriod;
+    caps->limits.maxPeriodFrames = maxPeriod;
+    caps->limits.minBufferFrames = minBuffer;
+    caps->limits.maxBufferFrames = maxBuffer;
+    lastChans = PA_MIN( maxChans, (unsigned int)PA_ALSA_CAPS_MAX_CHANNELS );
+
+    for( r = 0; r < PA_ALSA_CAPS_NUM_RATES; ++r )
+    {
+        /* Accept the rate as SetApproximateSampleRate would */
+        unsigned int setRate = capsRates_[r];
+        alsa_snd_pcm_hw_params_copy( rateParams, anyParams );
+        if( alsa_snd_pcm_hw_params_set_rate_near( pcm, rateParams, &setRate, NULL ) < 0 ||
+                abs( (int)setRate - (int)capsRates_[r] ) * RATE_MAX_DEVIATE_RATIO > capsRates_[r] )
+            continue;
+        caps->rates |= 1u << r;
+
+        for( chans = PA_MAX( minChans, 1 ); chans <= lastChans; ++chans )
+        {
+            if( alsa_snd_pcm_hw_params_test_channels( pcm, rateParams, chans ) < 0 )
+                continue;
+            alsa_snd_pcm_hw_params_copy( chanParams, rateParams );
+            alsa_snd_pcm_hw_params_set_channels( pcm, chanParams, chans );
+            for( f = 0; f < (int)(sizeof (hostFormats) / sizeof (hostFormats[0])); ++f )
+            {
+                if( ( caps->limits.sampleFormats & hostFormats[f] ) &&
+                        alsa_snd_pcm_hw_params_test_format( pcm, chanParams, Pa2AlsaFormat( hostFormats[f] ) ) >= 0 )
+                    caps->formats[r][chans - 1] |= (unsigned char)hostFormats[f];
+            }
+        }
+    }
+}
+
+/* The capability matrix of a device in one direction, built on its first query. Returns NULL if the device can't be
+ * opened, the next query tries again. Queries may come from several threads at once, so the matrix is built and
+ * allocated from the device list's group under capsMtx; once built it never changes. */
+static const PaAlsaDeviceCaps *GetDeviceCaps( PaAlsaHostApiRepresentation *alsaApi, PaDeviceIndex device,
+        StreamDirection streamDir )
+{
+    PaAlsaDeviceInfo *devInfo = (PaAlsaDeviceInfo *)alsaApi->baseHostApiRep.deviceInfos[device];
+    PaAlsaDeviceCaps *caps;
+    PaStreamParameters params;
+    snd_pcm_t *pcm = NULL;
+
+    if( PaUnixMutex_Lock( &alsaApi->capsMtx ) != paNoError )
+        return NULL;
+    if( ( caps = devInfo->caps[streamDir] ) )
+        goto done;
+
+    memset( &params, 0, sizeof (params) );
+    params.device = device;
+    if( AlsaOpen( &alsaApi->baseHostApiRep, &params, streamDir, &pcm ) != paNoError )
+        goto done;
+    if( ( caps = (PaAlsaDeviceCaps *)PaUtil_GroupAllocateMemory( alsaApi->allocations, sizeof (PaAlsaDeviceCaps) ) ) )
+    {
+        ProbeDeviceCaps( pcm, caps );
+        devInfo->caps[streamDir] = caps;
+    }
+    alsa_snd_pcm_close( pcm );
+
+done:
+    PaUnixMutex_Unlock( &alsaApi->capsMtx );
+    return caps;
+}
+
+/* Answer a TestParameters query from a capability matrix, the way TestParameters would. Whether the device is free
+ * at the moment isn't part of the answer, Pa_OpenStream still reports paDeviceUnavailable. */
+static PaError TestDeviceCaps( const PaAlsaDeviceCaps *caps, int rateIdx, unsigned int numHostChannels,
+        PaSampleFormat sampleFormat )
+{
+    PaSampleFormat hostFormat;
+
+    if( !( caps->rates & ( 1u << rateIdx ) ) )
+        return paInvalidSampleRate;
+    if( !caps->formats[rateIdx][numHostChannels - 1] )
+        return paInvalidChannelCount;
+
+    hostFormat = PaUtil_SelectClosestAvailableFormat( caps->limits.sampleFormats, sampleFormat );
+    if( hostFormat == (PaSampleFormat)paSampleFormatNotSupported )
+        return paSampleFormatNotSupported;
+    if( !( caps->formats[rateIdx][numHostChannels - 1] & hostFormat ) )
+        return paBadIODeviceCombination;
+
+    return paNoError;
+}
+
+static PaError GetNativeSampleFormats( struct PaUtilHostApiRepresentation *hostApi, PaDeviceIndex device, int isInput,
+        PaSampleFormat *sampleFormats )
+{
+    const PaAlsaDeviceCaps *caps = GetDeviceCaps( (PaAlsaHostApiRepresentation *)hostApi, device,
+            isInput ? StreamDirection_In : StreamDirection_Out );
+
+    if( !caps )
+        return paDeviceUnavailable;
+    *sampleFormats = caps->limits.sampleFormats | ( caps->interleaved ? 0 : paNonInterleaved );
+    return paNoError;
+}
+
+static PaError TestParameters( PaUtilHostApiRepresentation *hostApi, const PaStreamParameters *parameters,
         double sampleRate, StreamDirection streamDir )
 {
     PaError result = paNoError;
     snd_pcm_t *pcm = NULL;
+    const PaAlsaDeviceCaps *caps;
+    int rateIdx;
     PaSampleFormat availableFormats;
     /* We are able to adapt to a number of channels less than what the device supports */
     unsigned int numHostChannels;
@@ -1767,6 +2952,10 @@ static PaError TestParameters( const PaUtilHostApiRepresentation *hostApi, const
         const PaAlsaDeviceInfo *devInfo = GetDeviceInfo( hostApi, parameters->device );
         numHostChannels = PA_MAX( parameters->channelCount, StreamDirection_In == streamDir ?
                 devInfo->minInputChannels : devInfo->minOutputChannels );
+
+        if( ( rateIdx = FindCapsRate( sampleRate ) ) >= 0 && numHostChannels <= PA_ALSA_CAPS_MAX_CHANNELS &&
+                ( caps = GetDeviceCaps( (PaAlsaHostApiRepresentation *)hostApi, parameters->device, streamDir ) ) )
+            return TestDeviceCaps( caps, rateIdx, numHostChannels, parameters->sampleFormat );
     }
     else
         numHostChannels = parameters->channelCount;
@@ -1876,7 +3065,7 @@ error:
 
 
 static PaError PaAlsaStreamComponent_Initialize( PaAlsaStreamComponent *self, PaAlsaHostApiRepresentation *alsaApi,
-        const PaStreamParameters *params, StreamDirection streamDir, int callbackMode )
+        const PaStreamParameters *params, StreamDirection streamDir )
 {
     PaError result = paNoError;
     PaSampleFormat userSampleFormat = params->sampleFormat, hostSampleFormat = paNoError;
@@ -1912,6 +3101,7 @@ static PaError PaAlsaStreamComponent_Initialize( PaAlsaStreamComponent *self, Pa
     PA_ENSURE( hostSampleFormat = PaUtil_SelectClosestAvailableFormat( GetAvailableFormats( self->pcm ), userSampleFormat ) );
 
     self->hostSampleFormat = hostSampleFormat;
+    self->userSampleFormat = userSampleFormat & ~paNonInterleaved;
     self->nativeFormat = Pa2AlsaFormat( hostSampleFormat );
     self->hostInterleaved = self->userInterleaved = !( userSampleFormat & paNonInterleaved );
     self->numUserChannels = params->channelCount;
@@ -1920,9 +3110,9 @@ static PaError PaAlsaStreamComponent_Initialize( PaAlsaStreamComponent *self, Pa
     self->nonMmapBuffer = NULL;
     self->nonMmapBufferSize = 0;
 
-    if( !callbackMode && !self->userInterleaved )
+    if( !self->userInterleaved )
     {
-        /* Pre-allocate non-interleaved user provided buffers */
+        /* Pre-allocate non-interleaved user provided buffers, or in callback mode the pointers for zero-copy */
         PA_UNLESS( self->userBuffers = PaUtil_AllocateMemory( sizeof (void *) * self->numUserChannels ),
                 paInsufficientMemory );
     }
@@ -2072,6 +3262,51 @@ error:
  * As part of this method, the component's alsaBufferSize attribute will be set.
  * @param latency: The latency for this component.
  */
+/** Ask for status timestamps on the clock PaUtil_GetTime() reads, so that the time info handed to the
+ * callback, Pa_GetStreamTime() and PaUtil_GetTime() share one monotonic timebase.
+ *
+ * @return Non-zero if the timestamps are on that timebase.
+ */
+static int SetTimestampType( snd_pcm_t *pcm, snd_pcm_sw_params_t *swParams )
+{
+#ifdef HAVE_CLOCK_GETTIME
+#if SND_LIB_VERSION >= ALSA_VERSION_INT( 1, 0, 29 )
+    snd_pcm_tstamp_type_t type;
+
+    switch( PaUnixClock_GetClockId() )
+    {
+    case CLOCK_MONOTONIC:
+        type = SND_PCM_TSTAMP_TYPE_MONOTONIC;
+        break;
+#ifdef CLOCK_MONOTONIC_RAW
+    case CLOCK_MONOTONIC_RAW:
+        type = SND_PCM_TSTAMP_TYPE_MONOTONIC_RAW;
+        break;
+#endif
+    default:
+        type = SND_PCM_TSTAMP_TYPE_GETTIMEOFDAY;
+        break;
+    }
+
+    if( alsa_snd_pcm_sw_params_set_tstamp_type && alsa_snd_pcm_sw_params_set_tstamp_type( pcm, swParams, type ) >= 0 )
+        return 1;
+
+    PA_DEBUG(( "%s: could not select timestamp type %d, using PaUtil_GetTime()\n", __FUNCTION__, type ));
+    return type == SND_PCM_TSTAMP_TYPE_GETTIMEOFDAY;
+#else
+    return PaUnixClock_GetClockId() == CLOCK_REALTIME;
+#endif
+#else
+    /* PaUtil_GetTime() uses gettimeofday(), as ALSA does by default */
+    return 1;
+#endif
+}
+
+static PaTime TimestampToPaTime( const snd_htimestamp_t *t )
+{
+    return t->tv_sec + (PaTime)t->tv_nsec * 1e-9;
+}
+
 static PaError PaAlsaStreamComponent_FinishConfigure( PaAlsaStreamComponent *self, snd_pcm_hw_params_t* hwParams,
         const PaStreamParameters *params, int primeBuffers, double sampleRate, PaTime* latency )
 {
@@ -2128,6 +3363,7 @@ static PaError PaAlsaStreamComponent_FinishConfigure( PaAlsaStreamComponent *sel
     ENSURE_( alsa_snd_pcm_sw_params_set_avail_min( self->pcm, swParams, self->framesPerPeriod ), paUnanticipatedHostError );
     ENSURE_( alsa_snd_pcm_sw_params_set_xfer_align( self->pcm, swParams, 1 ), paUnanticipatedHostError );
     ENSURE_( alsa_snd_pcm_sw_params_set_tstamp_mode( self->pcm, swParams, SND_PCM_TSTAMP_ENABLE ), paUnanticipatedHostError );
+    self->tstampOnPaClock = SetTimestampType( self->pcm, swParams );
 
     /* Set the parameters! */
     ENSURE_( alsa_snd_pcm_sw_params( self->pcm, swParams ), paUnanticipatedHostError );
@@ -2170,11 +3406,11 @@ static PaError PaAlsaStream_Initialize( PaAlsaStream *self, PaAlsaHostApiReprese
     memset( &self->playback, 0, sizeof (PaAlsaStreamComponent) );
     if( inParams )
     {
-        PA_ENSURE( PaAlsaStreamComponent_Initialize( &self->capture, alsaApi, inParams, StreamDirection_In, NULL != callback ) );
+        PA_ENSURE( PaAlsaStreamComponent_Initialize( &self->capture, alsaApi, inParams, StreamDirection_In ) );
     }
     if( outParams )
     {
-        PA_ENSURE( PaAlsaStreamComponent_Initialize( &self->playback, alsaApi, outParams, StreamDirection_Out, NULL != callback ) );
+        PA_ENSURE( PaAlsaStreamComponent_Initialize( &self->playback, alsaApi, outParams, StreamDirection_Out ) );
     }
 
     assert( self->capture.nfds || self->playback.nfds );
@@ -2183,6 +3419,7 @@ static PaError PaAlsaStream_Initialize( PaAlsaStream *self, PaAlsaHostApiReprese
                     self->playback.nfds ) * sizeof( struct pollfd ) ), paInsufficientMemory );
 
     PaUtil_InitializeCpuLoadMeasurer( &self->cpuLoadMeasurer, sampleRate );
+    self->streamRepresentation.cpuLoadMeasurer = &self->cpuLoadMeasurer;
     ASSERT_CALL_( PaUnixMutex_Initialize( &self->stateMtx ), paNoError );
 
 error:
@@ -2998,7 +4235,9 @@ static PaError StartStream( PaStream *s )
 
     if( stream->callbackMode )
     {
-        PA_ENSURE( PaUnixThread_New( &stream->thread, &CallbackThreadFunc, stream, 1., stream->rtSched ) );
+        PA_ENSURE( PaUnixThread_New( &stream->thread, &CallbackThreadFunc, stream, 1., stream->rtSched,
+                    &stream->streamRepresentation.threadPolicy,
+                    stream->maxFramesPerHostBuffer / stream->streamRepresentation.streamInfo.sampleRate ) );
     }
     else
     {
@@ -3160,8 +4399,13 @@ static PaTime GetStreamTime( PaStream *s )
 {
     PaAlsaStream *stream = (PaAlsaStream*)s;
 
-    snd_timestamp_t timestamp;
+    snd_htimestamp_t timestamp;
     snd_pcm_status_t* status;
+    PaAlsaStreamComponent *component = stream->capture.pcm ? &stream->capture : &stream->playback;
+
+    if( !component->tstampOnPaClock )
+        return PaUtil_GetTime();
+
     alsa_snd_pcm_status_alloca( &status );
 
     /* TODO: what if we have both?  does it really matter? */
@@ -3179,8 +4423,8 @@ static PaTime GetStreamTime( PaStream *s )
         alsa_snd_pcm_status( stream->playback.pcm, status );
     }
 
-    alsa_snd_pcm_status_get_tstamp( status, &timestamp );
-    return timestamp.tv_sec + (PaTime)timestamp.tv_usec / 1e6;
+    alsa_snd_pcm_status_get_htstamp( status, &timestamp );
+    return TimestampToPaTime( &timestamp );
 }
 
 static double GetStreamCpuLoad( PaStream* s )
@@ -3265,18 +4509,20 @@ static PaError PaAlsaStream_HandleXrun( PaAlsaStream *self )
     PaError result = paNoError;
     snd_pcm_status_t *st;
     PaTime now = PaUtil_GetTime();
-    snd_timestamp_t t;
+    snd_htimestamp_t t;
     int restartAlsa = 0; /* do not restart Alsa by default */
 
     alsa_snd_pcm_status_alloca( &st );
 
+    PaUtil_TraceEvent( paTraceXrunRecoveryBegin, 0, 0 );
+
     if( self->playback.pcm )
     {
         alsa_snd_pcm_status( self->playback.pcm, st );
         if( alsa_snd_pcm_status_get_state( st ) == SND_PCM_STATE_XRUN )
         {
-            alsa_snd_pcm_status_get_trigger_tstamp( st, &t );
-            self->underrun = now * 1000 - ( (PaTime)t.tv_sec * 1000 + (PaTime)t.tv_usec / 1000 );
+            alsa_snd_pcm_status_get_trigger_htstamp( st, &t );
+            self->underrun = self->playback.tstampOnPaClock ? ( now - TimestampToPaTime( &t ) ) * 1000 : 0.;
 
             if( !self->playback.canMmap )
             {
@@ -3295,8 +4541,8 @@ static PaError PaAlsaStream_HandleXrun( PaAlsaStream *self )
         alsa_snd_pcm_status( self->capture.pcm, st );
         if( alsa_snd_pcm_status_get_state( st ) == SND_PCM_STATE_XRUN )
         {
-            alsa_snd_pcm_status_get_trigger_tstamp( st, &t );
-            self->overrun = now * 1000 - ((PaTime) t.tv_sec * 1000 + (PaTime) t.tv_usec / 1000);
+            alsa_snd_pcm_status_get_trigger_htstamp( st, &t );
+            self->overrun = self->capture.tstampOnPaClock ? ( now - TimestampToPaTime( &t ) ) * 1000 : 0.;
 
             if (!self->capture.canMmap)
             {
@@ -3318,6 +4564,7 @@ static PaError PaAlsaStream_HandleXrun( PaAlsaStream *self )
     }
 
 end:
+    PaUtil_TraceEvent( paTraceXrunRecoveryEnd, result, 0 );
     return result;
 error:
     goto end;
@@ -3409,7 +4656,7 @@ static void OnExit( void *data )
 static void CalculateTimeInfo( PaAlsaStream *stream, PaStreamCallbackTimeInfo *timeInfo )
 {
     snd_pcm_status_t *capture_status, *playback_status;
-    snd_timestamp_t capture_timestamp, playback_timestamp;
+    snd_htimestamp_t capture_timestamp, playback_timestamp;
     PaTime capture_time = 0., playback_time = 0.;
 
     alsa_snd_pcm_status_alloca( &capture_status );
@@ -3420,10 +4667,9 @@ static void CalculateTimeInfo( PaAlsaStream *stream, PaStreamCallbackTimeInfo *t
         snd_pcm_sframes_t capture_delay;
 
         alsa_snd_pcm_status( stream->capture.pcm, capture_status );
-        alsa_snd_pcm_status_get_tstamp( capture_status, &capture_timestamp );
+        alsa_snd_pcm_status_get_htstamp( capture_status, &capture_timestamp );
 
-        capture_time = capture_timestamp.tv_sec +
-            ( (PaTime)capture_timestamp.tv_usec / 1000000.0 );
+        capture_time = stream->capture.tstampOnPaClock ? TimestampToPaTime( &capture_timestamp ) : PaUtil_GetTime();
         timeInfo->currentTime = capture_time;
 
         capture_delay = alsa_snd_pcm_status_get_delay( capture_status );
@@ -3435,10 +4681,9 @@ static void CalculateTimeInfo( PaAlsaStream *stream, PaStreamCallbackTimeInfo *t
         snd_pcm_sframes_t playback_delay;
 
         alsa_snd_pcm_status( stream->playback.pcm, playback_status );
-        alsa_snd_pcm_status_get_tstamp( playback_status, &playback_timestamp );
+        alsa_snd_pcm_status_get_htstamp( playback_status, &playback_timestamp );
 
-        playback_time = playback_timestamp.tv_sec +
-            ((PaTime)playback_timestamp.tv_usec / 1000000.0);
+        playback_time = stream->playback.tstampOnPaClock ? TimestampToPaTime( &playback_timestamp ) : PaUtil_GetTime();
 
         if( stream->capture.pcm ) /* Full duplex */
         {
@@ -4004,12 +5249,15 @@ static PaError PaAlsaStreamComponent_RegisterChannels( PaAlsaStreamComponent* se
         unsigned int bufferSize = self->numHostChannels * alsa_snd_pcm_format_size( self->nativeFormat, *numFrames );
         if( bufferSize > self->nonMmapBufferSize )
         {
-            self->nonMmapBuffer = realloc( self->nonMmapBuffer, ( self->nonMmapBufferSize = bufferSize ) );
-            if( !self->nonMmapBuffer )
+            /* PaUtil_AllocateMemory has no realloc, and the old contents aren't needed */
+            PaUtil_FreeMemory( self->nonMmapBuffer );
+            self->nonMmapBufferSize = 0;
+            if( !( self->nonMmapBuffer = PaUtil_AllocateMemory( bufferSize ) ) )
             {
                 result = paInsufficientMemory;
                 goto error;
             }
+            self->nonMmapBufferSize = bufferSize;
         }
     }
 
@@ -4191,6 +5439,52 @@ error:
     return result;
 }
 
+/** Decide if this chunk can be processed in place.
+ *
+ * Only whole chunks of the size the callback expects are, and in full duplex only when both directions are ready,
+ * so that the buffer processor never has partial state to carry over.
+ */
+static int PaAlsaStream_CanZeroCopy( const PaAlsaStream *self, unsigned long numFrames )
+{
+    return self->zeroCopy
+        && ( !self->capture.pcm || self->capture.ready )
+        && ( !self->playback.pcm || self->playback.ready )
+        && ( self->framesPerUserBuffer == paFramesPerBufferUnspecified || numFrames == self->framesPerUserBuffer );
+}
+
+/** The buffer pointer to pass to the callback for the mmapped area set up by PaAlsaStreamComponent_RegisterChannels.
+ */
+static void *PaAlsaStreamComponent_GetMmapBuffer( PaAlsaStreamComponent *self )
+{
+    int i;
+
+    if( self->hostInterleaved )
+        return ExtractAddress( self->channelAreas, self->offset );
+
+    for( i = 0; i < self->numHostChannels; ++i )
+        self->userBuffers[i] = ExtractAddress( self->channelAreas + i, self->offset );
+    return self->userBuffers;
+}
+
+/** Call the stream callback directly on the mmapped buffers, instead of through the buffer processor.
+ *
+ * PaAlsaStream_SetUpBuffers must have been called for numFrames, and PaAlsaStream_CanZeroCopy must hold.
+ */
+static int PaAlsaStream_ZeroCopyProcess( PaAlsaStream *self, unsigned long numFrames,
+        PaStreamCallbackTimeInfo *timeInfo, PaStreamCallbackFlags cbFlags )
+{
+    const void *input = self->capture.pcm ? PaAlsaStreamComponent_GetMmapBuffer( &self->capture ) : NULL;
+    void *output = self->playback.pcm ? PaAlsaStreamComponent_GetMmapBuffer( &self->playback ) : NULL;
+    int callbackResult;
+
+    PaUtil_TraceEvent( paTraceUserCallbackBegin, (int)numFrames, (int)cbFlags );
+    callbackResult = self->streamRepresentation.streamCallback( input, output, numFrames, timeInfo, cbFlags,
+            self->streamRepresentation.userData );
+    PaUtil_TraceEvent( paTraceUserCallbackEnd, callbackResult, 0 );
+
+    return callbackResult;
+}
+
 /** Callback thread's function.
  *
  * Roughly, the workflow can be described in the following way: The number of available frames that can be processed
@@ -4207,12 +5501,15 @@ static void *CallbackThreadFunc( void *userData )
     snd_pcm_sframes_t startThreshold = 0;
     int callbackResult = paContinue;
     PaStreamCallbackFlags cbFlags = 0;  /* We might want to keep state across iterations */
+    PaStreamCallbackFlags chunkFlags;
     int streamStarted = 0;
 
     assert( stream );
     /* Not implemented */
     assert( !stream->primeBuffers );
 
+    PaUtil_TraceSetThreadName( "ALSA callback" );
+
     /* Execute OnExit when exiting */
     pthread_cleanup_push( &OnExit, stream );
 #ifdef PTHREAD_CANCELED
@@ -4339,10 +5636,12 @@ static void *CallbackThreadFunc( void *userData )
 
             CalculateTimeInfo( stream, &timeInfo );
             PaUtil_BeginBufferProcessing( &stream->bufferProcessor, &timeInfo, cbFlags );
+            chunkFlags = cbFlags;
             cbFlags = 0;
 
             /* CPU load measurement should include processing activity external to the stream callback */
             PaUtil_BeginCpuLoadMeasurement( &stream->cpuLoadMeasurer );
+            PaUtil_TraceEvent( paTraceCallbackBegin, (int)framesAvail, 0 );
 
             framesGot = framesAvail;
             if( paUtilFixedHostBufferSize == stream->bufferProcessor.hostBufferSizeMode )
@@ -4356,17 +5655,25 @@ static void *CallbackThreadFunc( void *userData )
                 assert( paUtilBoundedHostBufferSize == stream->bufferProcessor.hostBufferSizeMode );
                 framesGot = PA_MIN( framesGot, stream->maxFramesPerHostBuffer );
             }
+            PaUtil_TraceEvent( paTraceHostBufferAcquireBegin, (int)framesGot, 0 );
             PA_ENSURE( PaAlsaStream_SetUpBuffers( stream, &framesGot, &xrun ) );
+            PaUtil_TraceEvent( paTraceHostBufferAcquireEnd, (int)framesGot, 0 );
             /* Check the host buffer size against the buffer processor configuration */
             framesAvail -= framesGot;
 
             if( framesGot > 0 )
             {
                 assert( !xrun );
-                PaUtil_EndBufferProcessing( &stream->bufferProcessor, &callbackResult );
+                if( PaAlsaStream_CanZeroCopy( stream, framesGot ) )
+                    callbackResult = PaAlsaStream_ZeroCopyProcess( stream, framesGot, &timeInfo, chunkFlags );
+                else
+                    PaUtil_EndBufferProcessing( &stream->bufferProcessor, &callbackResult );
+                PaUtil_TraceEvent( paTraceHostBufferCommitBegin, (int)framesGot, 0 );
                 PA_ENSURE( PaAlsaStream_EndProcessing( stream, framesGot, &xrun ) );
+                PaUtil_TraceEvent( paTraceHostBufferCommitEnd, xrun, 0 );
             }
             PaUtil_EndCpuLoadMeasurement( &stream->cpuLoadMeasurer, framesGot );
+            PaUtil_TraceEvent( paTraceCallbackEnd, (int)framesGot, 0 );
 
             if( 0 == framesGot )
             {
@@ -4581,38 +5888,42 @@ void PaAlsa_InitializeStreamInfo( PaAlsaStreamInfo *info )
     info->deviceString = NULL;
 }
 
-void PaAlsa_EnableRealtimeScheduling( PaStream *s, int enable )
-{
-    PaAlsaStream *stream = (PaAlsaStream *) s;
-    stream->rtSched = enable;
-}
-
-#if 0
-void PaAlsa_EnableWatchdog( PaStream *s, int enable )
-{
-    PaAlsaStream *stream = (PaAlsaStream *) s;
-    stream->thread.useWatchdog = enable;
-}
-#endif
-
+/* Resolve the client's stream handle s, see PaUtil_GetStreamRepresentation */
 static PaError GetAlsaStreamPointer( PaStream* s, PaAlsaStream** stream )
 {
     PaError result = paNoError;
     PaUtilHostApiRepresentation* hostApi;
     PaAlsaHostApiRepresentation* alsaHostApi;
+    PaUtilStreamRepresentation* streamRepresentation;
 
-    PA_ENSURE( PaUtil_ValidateStreamPointer( s ) );
+    PA_ENSURE( PaUtil_GetStreamRepresentation( s, &streamRepresentation ) );
     PA_ENSURE( PaUtil_GetHostApiRepresentation( &hostApi, paALSA ) );
     alsaHostApi = (PaAlsaHostApiRepresentation*)hostApi;
 
-    PA_UNLESS( PA_STREAM_REP( s )->streamInterface == &alsaHostApi->callbackStreamInterface
-            || PA_STREAM_REP( s )->streamInterface == &alsaHostApi->blockingStreamInterface,
+    PA_UNLESS( streamRepresentation->streamInterface == &alsaHostApi->callbackStreamInterface
+            || streamRepresentation->streamInterface == &alsaHostApi->blockingStreamInterface,
         paIncompatibleStreamHostApi );
 
-    *stream = (PaAlsaStream*)s;
+    *stream = (PaAlsaStream*)streamRepresentation;
 error:
-    return paNoError;
+    return result;
+}
+
+void PaAlsa_EnableRealtimeScheduling( PaStream *s, int enable )
+{
+    PaAlsaStream *stream;
+
+    if( GetAlsaStreamPointer( s, &stream ) == paNoError )
+        stream->rtSched = enable;
+}
+
+#if 0
+void PaAlsa_EnableWatchdog( PaStream *s, int enable )
+{
+    PaAlsaStream *stream = (PaAlsaStream *) s;
+    stream->thread.useWatchdog = enable;
 }
+#endif
 
 PaError PaAlsa_GetStreamInputCard( PaStream* s, int* card )
 {
@@ -4652,8 +5963,87 @@ error:
     return result;
 }
 
+PaError PaAlsa_GetDeviceCapabilities( PaDeviceIndex device, int isInput, PaAlsaDeviceCapabilities *capabilities )
+{
+    PaError result = paNoError;
+    PaUtilHostApiRepresentation *hostApi;
+    PaDeviceIndex hostApiDevice;
+    const PaAlsaDeviceInfo *devInfo;
+    const PaAlsaDeviceCaps *caps;
+    StreamDirection streamDir = isInput ? StreamDirection_In : StreamDirection_Out;
+
+    PA_ENSURE( PaUtil_GetHostApiRepresentation( &hostApi, paALSA ) );
+    PA_ENSURE( PaUtil_DeviceIndexToHostApiDeviceIndex( &hostApiDevice, device, hostApi ) );
+
+    devInfo = GetDeviceInfo( hostApi, hostApiDevice );
+    PA_UNLESS( ( isInput ? devInfo->baseDeviceInfo.maxInputChannels : devInfo->baseDeviceInfo.maxOutputChannels ) > 0,
+            paInvalidChannelCount );
+    PA_UNLESS( caps = GetDeviceCaps( (PaAlsaHostApiRepresentation *)hostApi, hostApiDevice, streamDir ),
+            paDeviceUnavailable );
+    *capabilities = caps->limits;
+
+error:
+    return result;
+}
+
+PaError PaAlsa_EnableZeroCopy( PaStream *s, int enable )
+{
+    PaAlsaStream *stream;
+    PaError result = paNoError;
+    PaAlsaStreamComponent *components[2];
+    int i;
+
+    PA_ENSURE( GetAlsaStreamPointer( s, &stream ) );
+    PA_UNLESS( IsStreamStopped( (PaStream *)stream ), paStreamIsNotStopped );
+
+    if( !enable )
+    {
+        stream->zeroCopy = 0;
+        goto error;
+    }
+
+    /* The callback gets the host buffers as they are, so the buffer processor must have nothing to do: no
+     * conversion, no channel adaption and no block adaption */
+    PA_UNLESS( stream->callbackMode, paInvalidFlag );
+    PA_UNLESS( stream->bufferProcessor.useNonAdaptingProcess, paInvalidFlag );
+    PA_UNLESS( stream->framesPerUserBuffer == paFramesPerBufferUnspecified
+            || stream->framesPerUserBuffer == stream->maxFramesPerHostBuffer, paInvalidFlag );
+
+    components[0] = stream->capture.pcm ? &stream->capture : NULL;
+    components[1] = stream->playback.pcm ? &stream->playback : NULL;
+    for( i = 0; i < 2; ++i )
+    {
+        if( !components[i] )
+            continue;
+
+        PA_UNLESS( components[i]->canMmap, paInvalidFlag );
+        PA_UNLESS( components[i]->hostSampleFormat == components[i]->userSampleFormat, paSampleFormatNotSupported );
+        PA_UNLESS( components[i]->hostInterleaved == components[i]->userInterleaved, paSampleFormatNotSupported );
+        PA_UNLESS( components[i]->numHostChannels == components[i]->numUserChannels, paInvalidChannelCount );
+    }
+
+    stream->zeroCopy = 1;
+
+error:
+    return result;
+}
+
 PaError PaAlsa_SetRetriesBusy( int retries )
 {
     busyRetries_ = retries;
     return paNoError;
 }
+
+PaError PaAlsa_SetProbeThreads( int numThreads )
+{
+    probeThreads_ = numThreads;
+    return paNoError;
+}
+
+PaError PaAlsa_SetProbeTimeout( double seconds )
+{
+    if( seconds <= 0. )
+        return paInvalidFlag;
+    probeTimeout_ = seconds;
+    return paNoError;
+}
@@ -1156,6 +1156,7 @@ static PaError InitPaDeviceInfoFromAsioDriver( PaAsioHostApiRepresentation *asio
 error_unload:
     UnloadAsioDriver();
 
+    /* the group's last block, so its space is reused for the next driver's */
     if( asioDeviceInfo->asioChannelInfos ){
         PaUtil_GroupFreeMemory( asioHostApi->allocations, asioDeviceInfo->asioChannelInfos );
         asioDeviceInfo->asioChannelInfos = 0;
@@ -1359,6 +1360,10 @@ PaError PaAsio_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
     (*hostApi)->Terminate = Terminate;
     (*hostApi)->OpenStream = OpenStream;
     (*hostApi)->IsFormatSupported = IsFormatSupported;
+    (*hostApi)->ScanDeviceInfos = NULL;
+    (*hostApi)->CommitDeviceInfos = NULL;
+    (*hostApi)->DisposeDeviceInfos = NULL;
+    (*hostApi)->GetNativeSampleFormats = NULL;
 
     PaUtil_InitializeStreamInterface( &asioHostApi->callbackStreamInterface, CloseStream, StartStream,
                                       StopStream, AbortStream, IsStreamStopped, IsStreamActive,
@@ -2219,6 +2224,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
 
 
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
 
     stream->asioBufferInfos = (ASIOBufferInfo*)PaUtil_AllocateMemory(
@@ -4214,8 +4220,10 @@ static PaError GetAsioStreamPointer( PaAsioStream **stream, PaStream *s )
     PaError result;
     PaUtilHostApiRepresentation *hostApi;
     PaAsioHostApiRepresentation *asioHostApi;
+    PaUtilStreamRepresentation *streamRepresentation;
 
-    result = PaUtil_ValidateStreamPointer( s );
+    /* s is the client's handle, see PaUtil_GetStreamRepresentation */
+    result = PaUtil_GetStreamRepresentation( s, &streamRepresentation );
     if( result != paNoError )
         return result;
 
@@ -4225,11 +4233,11 @@ static PaError GetAsioStreamPointer( PaAsioStream **stream, PaStream *s )
 
     asioHostApi = (PaAsioHostApiRepresentation*)hostApi;
 
-    if( PA_STREAM_REP( s )->streamInterface == &asioHostApi->callbackStreamInterface
-            || PA_STREAM_REP( s )->streamInterface == &asioHostApi->blockingStreamInterface )
+    if( streamRepresentation->streamInterface == &asioHostApi->callbackStreamInterface
+            || streamRepresentation->streamInterface == &asioHostApi->blockingStreamInterface )
     {
         /* s is an ASIO  stream */
-        *stream = (PaAsioStream *)s;
+        *stream = (PaAsioStream *)streamRepresentation;
         return paNoError;
     }
     else
@@ -238,20 +238,40 @@ PaError PaMacCore_GetBufferSizeRange( PaDeviceIndex device,
 }
 
 
+/* Resolve the client's stream handle s, see PaUtil_GetStreamRepresentation. Returns NULL if it isn't an open
+   Core Audio stream. */
+static PaMacCoreStream *GetMacCoreStream( PaStream* s )
+{
+    PaUtilStreamRepresentation *streamRepresentation;
+    PaUtilHostApiRepresentation *hostApi;
+    PaMacAUHAL *macCoreHostApi;
+
+    if( PaUtil_GetStreamRepresentation( s, &streamRepresentation ) != paNoError
+            || PaUtil_GetHostApiRepresentation( &hostApi, paCoreAudio ) != paNoError )
+        return NULL;
+
+    macCoreHostApi = (PaMacAUHAL*)hostApi;
+    if( streamRepresentation->streamInterface != &macCoreHostApi->callbackStreamInterface
+            && streamRepresentation->streamInterface != &macCoreHostApi->blockingStreamInterface )
+        return NULL;
+
+    return (PaMacCoreStream*)streamRepresentation;
+}
+
 AudioDeviceID PaMacCore_GetStreamInputDevice( PaStream* s )
 {
-    PaMacCoreStream *stream = (PaMacCoreStream*)s;
+    PaMacCoreStream *stream = GetMacCoreStream( s );
     VVDBUG(("PaMacCore_GetStreamInputHandle()\n"));
 
-    return ( stream->inputDevice );
+    return stream ? stream->inputDevice : kAudioDeviceUnknown;
 }
 
 AudioDeviceID PaMacCore_GetStreamOutputDevice( PaStream* s )
 {
-    PaMacCoreStream *stream = (PaMacCoreStream*)s;
+    PaMacCoreStream *stream = GetMacCoreStream( s );
     VVDBUG(("PaMacCore_GetStreamOutputHandle()\n"));
 
-    return ( stream->outputDevice );
+    return stream ? stream->outputDevice : kAudioDeviceUnknown;
 }
 
 #ifdef __cplusplus
@@ -827,6 +847,10 @@ PaError PaMacCore_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIn
     (*hostApi)->Terminate = Terminate;
     (*hostApi)->OpenStream = OpenStream;
     (*hostApi)->IsFormatSupported = IsFormatSupported;
+    (*hostApi)->ScanDeviceInfos = NULL;
+    (*hostApi)->CommitDeviceInfos = NULL;
+    (*hostApi)->DisposeDeviceInfos = NULL;
+    (*hostApi)->GetNativeSampleFormats = NULL;
 
     PaUtil_InitializeStreamInterface( &auhalHostApi->callbackStreamInterface,
                                       CloseStream, StartStream,
@@ -1838,6 +1862,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     }
 
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     
     if( inputParameters )
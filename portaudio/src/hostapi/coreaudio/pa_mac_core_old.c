@@ -664,6 +664,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
                                              : &macCoreHostApi->blockingStreamInterface ),
                                            streamCallback, userData );
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
     
     *s = (PaStream*)stream;
     PaMacClientData *clientData = PaUtil_AllocateMemory(sizeof(PaMacClientData));
@@ -890,6 +891,10 @@ PaError PaMacCore_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIn
     (*hostApi)->Terminate = Terminate;
     (*hostApi)->OpenStream = OpenStream;
     (*hostApi)->IsFormatSupported = IsFormatSupported;
+    (*hostApi)->ScanDeviceInfos = NULL;
+    (*hostApi)->CommitDeviceInfos = NULL;
+    (*hostApi)->DisposeDeviceInfos = NULL;
+    (*hostApi)->GetNativeSampleFormats = NULL;
     
     PaUtil_InitializeStreamInterface( &macCoreHostApi->callbackStreamInterface, CloseStream, StartStream,
                                       StopStream, AbortStream, IsStreamStopped, IsStreamActive,
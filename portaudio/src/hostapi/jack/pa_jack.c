@@ -57,12 +57,16 @@
 #include <errno.h>  /* EBUSY */
 #include <signal.h> /* sig_atomic_t */
 #include <math.h>
+#include <limits.h> /* INT_MAX */
 #include <semaphore.h>
+#include <time.h>
 
 #include <jack/types.h>
 #include <jack/jack.h>
+#include <jack/thread.h>
 
 #include "pa_util.h"
+#include "pa_unix_util.h"
 #include "pa_hostapi.h"
 #include "pa_stream.h"
 #include "pa_process.h"
@@ -70,12 +74,15 @@
 #include "pa_cpuload.h"
 #include "pa_ringbuffer.h"
 #include "pa_debugprint.h"
+#include "pa_trace.h"
+#include "pa_memorybarrier.h"
 
 #include "pa_jack.h"
 
 static pthread_t mainThread_;
 static char *jackErr_ = NULL;
 static const char* clientName_ = "PortAudio";
+static int processThreads_ = 0;
 
 #define STRINGIZE_HELPER(expr) #expr
 #define STRINGIZE(expr) STRINGIZE_HELPER(expr)
@@ -156,7 +163,30 @@ static double GetStreamCpuLoad( PaStream* stream );
 
 struct PaJackStream;
 
-typedef struct
+/* The streams the process callback runs. A table is never modified once the process thread may see it: adding or
+ * removing a stream publishes a new table, and the old one is freed after the process thread has picked up the new
+ * one. Once JACK's shutdown callback may be walking a table, replaced tables are retired instead and freed by
+ * Terminate(). */
+typedef struct PaJackStreamTable
+{
+    struct PaJackStreamTable *retired;
+    int count;
+    struct PaJackStream *streams[1];
+}
+PaJackStreamTable;
+
+/* A thread that runs some of the streams in each JACK cycle, alongside JACK's process thread */
+typedef struct PaJackWorker
+{
+    struct PaJackHostApiRepresentation *hostApi;
+    int index;              /* Streams whose worker is index run here, 0 being JACK's process thread */
+    pthread_t thread;
+    sem_t wake;             /* Posted by the process thread to start a cycle */
+    int busy;               /* Has streams to run in this cycle */
+}
+PaJackWorker;
+
+typedef struct PaJackHostApiRepresentation
 {
     PaUtilHostApiRepresentation commonHostApiRep;
     PaUtilStreamInterface callbackStreamInterface;
@@ -168,15 +198,27 @@ typedef struct
     int jack_buffer_size;
     PaHostApiIndex hostApiIndex;
 
-    pthread_mutex_t mtx;
-    pthread_cond_t cond;
+    pthread_mutex_t mtx;    /* Serializes requests to the process thread, which never takes it */
+    sem_t processAck;       /* Posted by the process thread when it has acted on a request */
     unsigned long inputBase, outputBase;
 
     /* For dealing with the process thread */
     volatile int xrun;     /* Received xrun notification from JACK? */
-    struct PaJackStream * volatile toAdd, * volatile toRemove;
-    struct PaJackStream *processQueue;
+    PaJackStreamTable * volatile processTable;
+    PaJackStreamTable * volatile seenTable;    /* The table the process thread is using */
+    volatile sig_atomic_t shuttingDown;        /* Set by JackOnShutdown() before it reads processTable */
+    PaJackStreamTable *retiredTables;          /* Replaced while shuttingDown, freed by Terminate() */
     volatile sig_atomic_t jackIsDown;
+
+    /* Workers, see PaJack_SetProcessThreads(). workers[0] stands for the process thread itself */
+    PaJackWorker *workers;
+    int numWorkers;
+    volatile int workersQuit;
+    PaJackStreamTable *cycleTable;
+    jack_nframes_t cycleFrames;
+    volatile int workersPending;
+    volatile PaError workersResult;
+    sem_t workersDone;      /* Posted by the last worker to finish a cycle */
 }
 PaJackHostApiRepresentation;
 
@@ -230,7 +272,7 @@ typedef struct PaJackStream
     int                     bytesPerFrame;
     int                     samplesPerFrame;
 
-    struct PaJackStream *next;
+    int worker;     /* The worker that runs the stream, for as long as it is open */
 }
 PaJackStream;
 
@@ -664,38 +706,35 @@ static void JackErrorCallback( const char *msg )
 static void JackOnShutdown( void *arg )
 {
     PaJackHostApiRepresentation *jackApi = (PaJackHostApiRepresentation *)arg;
-    PaJackStream *stream = jackApi->processQueue;
+    PaJackStreamTable *table;
+    int i;
 
     PA_DEBUG(( "%s: JACK server is shutting down\n", __FUNCTION__ ));
-    for( ; stream; stream = stream->next )
+
+    /* From here on ReplaceStreamTable() retires the tables it replaces rather than freeing them, so the one read
+     * below stays valid while it is walked */
+    jackApi->shuttingDown = 1;
+    PaUtil_FullMemoryBarrier();
+    table = jackApi->processTable;
+    PaUtil_ReadMemoryBarrier();     /* The table before the streams it holds */
+    for( i = 0; table && i < table->count; ++i )
     {
-        stream->is_active = 0;
+        table->streams[i]->is_active = 0;
     }
 
-    /* Make sure that the main thread doesn't get stuck waiting on the condition */
-    ASSERT_CALL( pthread_mutex_lock( &jackApi->mtx ), 0 );
+    /* Make sure that the main thread doesn't get stuck waiting for the process thread */
+    PaUtil_FullMemoryBarrier();
     jackApi->jackIsDown = 1;
-    ASSERT_CALL( pthread_cond_signal( &jackApi->cond ), 0 );
-    ASSERT_CALL( pthread_mutex_unlock( &jackApi->mtx ), 0 );
-
+    ASSERT_CALL( sem_post( &jackApi->processAck ), 0 );
 }
 
 static int JackSrCb( jack_nframes_t nframes, void *arg )
 {
-    PaJackHostApiRepresentation *jackApi = (PaJackHostApiRepresentation *)arg;
-    double sampleRate = (double)nframes;
-    PaJackStream *stream = jackApi->processQueue;
+    (void)nframes; /* unused */
+    (void)arg; /* unused */
 
-    /* Update all streams in process queue */
-    PA_DEBUG(( "%s: Acting on change in JACK samplerate: %f\n", __FUNCTION__, sampleRate ));
-    for( ; stream; stream = stream->next )
-    {
-        if( stream->streamRepresentation.streamInfo.sampleRate != sampleRate )
-        {
-            PA_DEBUG(( "%s: Updating samplerate\n", __FUNCTION__ ));
-            UpdateSampleRate( stream, sampleRate );
-        }
-    }
+    /* The process thread updates each stream when it next runs it */
+    PA_DEBUG(( "%s: Acting on change in JACK samplerate: %f\n", __FUNCTION__, (double)nframes ));
 
     return 0;
 }
@@ -704,10 +743,101 @@ static int JackXRunCb(void *arg) {
     PaJackHostApiRepresentation *hostApi = (PaJackHostApiRepresentation *)arg;
     assert( hostApi );
     hostApi->xrun = TRUE;
+    PaUtil_TraceEvent( paTraceXrun, 0, 0 );
     PA_DEBUG(( "%s: JACK signalled xrun\n", __FUNCTION__ ));
     return 0;
 }
 
+static PaError ProcessStreams( PaJackStreamTable *table, int worker, jack_nframes_t frames );
+
+static void *JackWorkerThread( void *arg )
+{
+    PaJackWorker *worker = (PaJackWorker *)arg;
+    PaJackHostApiRepresentation *hostApi = worker->hostApi;
+    PaError result;
+
+    PaUtil_TraceSetThreadName( "JACK worker" );
+
+    for( ;; )
+    {
+        while( sem_wait( &worker->wake ) != 0 )
+            assert( errno == EINTR );
+        if( hostApi->workersQuit )
+            break;
+
+        result = ProcessStreams( hostApi->cycleTable, worker->index, hostApi->cycleFrames );
+        if( result != paNoError )
+            hostApi->workersResult = result;
+
+        /* The last one done lets the process thread return */
+        if( __sync_sub_and_fetch( &hostApi->workersPending, 1 ) == 0 )
+            ASSERT_CALL( sem_post( &hostApi->workersDone ), 0 );
+    }
+
+    return NULL;
+}
+
+/* Spawn the workers, at the priority of JACK's process thread. Worker 0 is the process thread itself, and isn't
+ * spawned. */
+static PaError StartWorkers( PaJackHostApiRepresentation *jackApi, int numThreads )
+{
+    PaError result = paNoError;
+    int i;
+
+    jackApi->numWorkers = 1;
+    jackApi->workersQuit = 0;
+    UNLESS( jackApi->workers = (PaJackWorker *)PaUtil_AllocateMemory( (numThreads + 1) * sizeof (PaJackWorker) ),
+            paInsufficientMemory );
+    ASSERT_CALL( sem_init( &jackApi->workersDone, 0, 0 ), 0 );
+    jackApi->workers[0].hostApi = jackApi;
+    jackApi->workers[0].index = 0;
+    jackApi->workers[0].busy = 0;
+
+    for( i = 1; i <= numThreads; ++i )
+    {
+        PaJackWorker *worker = &jackApi->workers[i];
+
+        worker->hostApi = jackApi;
+        worker->index = i;
+        worker->busy = 0;
+        ASSERT_CALL( sem_init( &worker->wake, 0, 0 ), 0 );
+        if( jack_client_create_thread( jackApi->jack_client, &worker->thread,
+                    jack_client_real_time_priority( jackApi->jack_client ), jack_is_realtime( jackApi->jack_client ),
+                    JackWorkerThread, worker ) != 0 )
+        {
+            /* Make do with the workers we have */
+            PA_DEBUG(( "%s: Couldn't create JACK worker %d\n", __FUNCTION__, i ));
+            sem_destroy( &worker->wake );
+            break;
+        }
+        ++jackApi->numWorkers;
+    }
+
+error:
+    return result;
+}
+
+static void StopWorkers( PaJackHostApiRepresentation *jackApi )
+{
+    int i;
+
+    if( !jackApi->workers )
+        return;
+
+    jackApi->workersQuit = 1;
+    for( i = 1; i < jackApi->numWorkers; ++i )
+    {
+        ASSERT_CALL( sem_post( &jackApi->workers[i].wake ), 0 );
+        ASSERT_CALL( pthread_join( jackApi->workers[i].thread, NULL ), 0 );
+        ASSERT_CALL( sem_destroy( &jackApi->workers[i].wake ), 0 );
+    }
+    ASSERT_CALL( sem_destroy( &jackApi->workersDone ), 0 );
+
+    PaUtil_FreeMemory( jackApi->workers );
+    jackApi->workers = NULL;
+    jackApi->numWorkers = 0;
+}
+
 PaError PaJack_Initialize( PaUtilHostApiRepresentation **hostApi,
                            PaHostApiIndex hostApiIndex )
 {
@@ -723,7 +853,8 @@ PaError PaJack_Initialize( PaUtilHostApiRepresentation **hostApi,
 
     mainThread_ = pthread_self();
     ASSERT_CALL( pthread_mutex_init( &jackHostApi->mtx, NULL ), 0 );
-    ASSERT_CALL( pthread_cond_init( &jackHostApi->cond, NULL ), 0 );
+    ASSERT_CALL( sem_init( &jackHostApi->processAck, 0, 0 ), 0 );
+    jackHostApi->workers = NULL;
 
     /* Try to become a client of the JACK server.  If we cannot do
      * this, then this API cannot be used.
@@ -758,6 +889,10 @@ PaError PaJack_Initialize( PaUtilHostApiRepresentation **hostApi,
     (*hostApi)->Terminate = Terminate;
     (*hostApi)->OpenStream = OpenStream;
     (*hostApi)->IsFormatSupported = IsFormatSupported;
+    (*hostApi)->ScanDeviceInfos = NULL;
+    (*hostApi)->CommitDeviceInfos = NULL;
+    (*hostApi)->DisposeDeviceInfos = NULL;
+    (*hostApi)->GetNativeSampleFormats = NULL;
 
     PaUtil_InitializeStreamInterface( &jackHostApi->callbackStreamInterface,
                                       CloseStream, StartStream,
@@ -776,8 +911,9 @@ PaError PaJack_Initialize( PaUtilHostApiRepresentation **hostApi,
 
     jackHostApi->inputBase = jackHostApi->outputBase = 0;
     jackHostApi->xrun = 0;
-    jackHostApi->toAdd = jackHostApi->toRemove = NULL;
-    jackHostApi->processQueue = NULL;
+    jackHostApi->processTable = jackHostApi->seenTable = NULL;
+    jackHostApi->shuttingDown = 0;
+    jackHostApi->retiredTables = NULL;
     jackHostApi->jackIsDown = 0;
 
     jack_on_shutdown( jackHostApi->jack_client, JackOnShutdown, jackHostApi );
@@ -786,6 +922,7 @@ PaError PaJack_Initialize( PaUtilHostApiRepresentation **hostApi,
     /* Don't check for error, may not be supported (deprecated in at least jackdmp) */
     jack_set_sample_rate_callback( jackHostApi->jack_client, JackSrCb, jackHostApi );
     UNLESS( !jack_set_xrun_callback( jackHostApi->jack_client, JackXRunCb, jackHostApi ), paUnanticipatedHostError );
+    ENSURE_PA( StartWorkers( jackHostApi, processThreads_ ) );
     UNLESS( !jack_set_process_callback( jackHostApi->jack_client, JackCallback, jackHostApi ), paUnanticipatedHostError );
     UNLESS( !jack_activate( jackHostApi->jack_client ), paUnanticipatedHostError );
     activated = 1;
@@ -798,6 +935,8 @@ error:
 
     if( jackHostApi )
     {
+        StopWorkers( jackHostApi );
+
         if( jackHostApi->jack_client )
             ASSERT_CALL( jack_client_close( jackHostApi->jack_client ), 0 );
 
@@ -820,12 +959,21 @@ static void Terminate( struct PaUtilHostApiRepresentation *hostApi )
     /* note: this automatically disconnects all ports, since a deactivated
      * client is not allowed to have any ports connected */
     ASSERT_CALL( jack_deactivate( jackHostApi->jack_client ), 0 );
+    StopWorkers( jackHostApi );
 
     ASSERT_CALL( pthread_mutex_destroy( &jackHostApi->mtx ), 0 );
-    ASSERT_CALL( pthread_cond_destroy( &jackHostApi->cond ), 0 );
+    ASSERT_CALL( sem_destroy( &jackHostApi->processAck ), 0 );
 
     ASSERT_CALL( jack_client_close( jackHostApi->jack_client ), 0 );
 
+    PaUtil_FreeMemory( jackHostApi->processTable );
+    while( jackHostApi->retiredTables )
+    {
+        PaJackStreamTable *retired = jackHostApi->retiredTables;
+        jackHostApi->retiredTables = retired->retired;
+        PaUtil_FreeMemory( retired );
+    }
+
     if( jackHostApi->deviceInfoMemory )
     {
         PaUtil_FreeAllAllocations( jackHostApi->deviceInfoMemory );
@@ -1003,26 +1151,114 @@ static void CleanUpStream( PaJackStream *stream, int terminateStreamRepresentati
     PaUtil_FreeMemory( stream );
 }
 
-static PaError WaitCondition( PaJackHostApiRepresentation *hostApi )
+/* Forget acknowledgements left over from earlier requests, before making a new one. Called with hostApi->mtx held. */
+static void ResetProcessAck( PaJackHostApiRepresentation *hostApi )
+{
+    while( sem_trywait( &hostApi->processAck ) == 0 )
+        ;
+}
+
+static void GetProcessAckDeadline( struct timespec *deadline )
+{
+    clock_gettime( CLOCK_REALTIME, deadline );
+    deadline->tv_sec += 10 * 60; /* 10 minutes */
+}
+
+/* Wait for the process thread to act on a request, the caller checks whether it has acted on its own. */
+static PaError WaitForProcessThread( PaJackHostApiRepresentation *hostApi, const struct timespec *deadline )
 {
     PaError result = paNoError;
-    int err = 0;
-    PaTime pt = PaUtil_GetTime();
-    struct timespec ts;
+    int err;
 
-    ts.tv_sec = (time_t) floor( pt + 10 * 60 /* 10 minutes */ );
-    ts.tv_nsec = (long) ((pt - floor( pt )) * 1000000000);
-    /* XXX: Best enclose in loop, in case of spurious wakeups? */
-    err = pthread_cond_timedwait( &hostApi->cond, &hostApi->mtx, &ts );
+    while( (err = sem_timedwait( &hostApi->processAck, deadline )) != 0 && errno == EINTR )
+        ;
 
     /* Make sure we didn't time out */
-    UNLESS( err != ETIMEDOUT, paTimedOut );
+    UNLESS( !err || errno != ETIMEDOUT, paTimedOut );
     UNLESS( !err, paInternalError );
 
 error:
     return result;
 }
 
+/* Publish a new stream table for the process thread, with stream add appended and stream remove left out, and free the
+ * table it replaces once the process thread has moved on to the new one. Called with hostApi->mtx held. */
+static PaError ReplaceStreamTable( PaJackHostApiRepresentation *hostApi, PaJackStream *add, PaJackStream *remove )
+{
+    PaError result = paNoError;
+    PaJackStreamTable *old = hostApi->processTable, *table = NULL;
+    int count = old ? old->count : 0;
+    int i, removed = 0;
+    struct timespec deadline;
+
+    UNLESS( table = (PaJackStreamTable *)PaUtil_AllocateMemory( sizeof (PaJackStreamTable) +
+                count * sizeof (PaJackStream *) ), paInsufficientMemory );
+    table->retired = NULL;
+    table->count = 0;
+    for( i = 0; i < count; ++i )
+    {
+        if( old->streams[i] == remove )
+            removed = 1;
+        else
+            table->streams[table->count++] = old->streams[i];
+    }
+    UNLESS( !remove || removed, paInternalError );
+    if( add )
+        table->streams[table->count++] = add;
+
+    ResetProcessAck( hostApi );
+    PaUtil_WriteMemoryBarrier();    /* The streams before the table that holds them */
+    hostApi->processTable = table;
+    PaUtil_FullMemoryBarrier();
+    table = NULL;
+
+    /* On failure the old table is left alone, the process thread may still be using it */
+    GetProcessAckDeadline( &deadline );
+    while( hostApi->seenTable != hostApi->processTable && !hostApi->jackIsDown )
+        ENSURE_PA( WaitForProcessThread( hostApi, &deadline ) );
+
+    /* The full barrier above orders this read after publishing the table, so that either JackOnShutdown() walks the
+     * new table or the old one is retired here */
+    if( old && hostApi->shuttingDown )
+    {
+        old->retired = hostApi->retiredTables;
+        hostApi->retiredTables = old;
+    }
+    else
+        PaUtil_FreeMemory( old );
+
+    if( removed )
+    {
+        PA_DEBUG(( "%s: Removed stream from processing queue\n", __FUNCTION__ ));
+    }
+
+error:
+    PaUtil_FreeMemory( table );
+    return result;
+}
+
+/* Pick the worker with the fewest streams for a stream about to be added, the lowest numbered one among equals. The
+ * stream stays with it until it is removed. Called with the mutex held. */
+static int ChooseWorker( PaJackHostApiRepresentation *hostApi )
+{
+    const PaJackStreamTable *table = hostApi->processTable;
+    int worker, best = 0, bestCount = INT_MAX;
+
+    for( worker = 0; worker < hostApi->numWorkers; ++worker )
+    {
+        int count = 0, s;
+        for( s = 0; table && s < table->count; ++s )
+            count += table->streams[s]->worker == worker;
+        if( count < bestCount )
+        {
+            best = worker;
+            bestCount = count;
+        }
+    }
+
+    return best;
+}
+
 static PaError AddStream( PaJackStream *stream )
 {
     PaError result = paNoError;
@@ -1031,9 +1267,12 @@ static PaError AddStream( PaJackStream *stream )
     ASSERT_CALL( pthread_mutex_lock( &hostApi->mtx ), 0 );
     if( !hostApi->jackIsDown )
     {
-        hostApi->toAdd = stream;
-        /* Unlock mutex and await signal from processing thread */
-        result = WaitCondition( stream->hostApi );
+        stream->worker = ChooseWorker( hostApi );
+        result = ReplaceStreamTable( hostApi, stream, NULL );
+
+        /* The stream is about to be freed, and the process thread won't run again */
+        if( result == paNoError && hostApi->jackIsDown )
+            ReplaceStreamTable( hostApi, NULL, stream );
     }
     ASSERT_CALL( pthread_mutex_unlock( &hostApi->mtx ), 0 );
     ENSURE_PA( result );
@@ -1050,14 +1289,9 @@ static PaError RemoveStream( PaJackStream *stream )
     PaError result = paNoError;
     PaJackHostApiRepresentation *hostApi = stream->hostApi;
 
-    /* Add to queue over streams that should be processed */
+    /* Once JACK is down the process thread is gone, and the stream is removed without waiting */
     ASSERT_CALL( pthread_mutex_lock( &hostApi->mtx ), 0 );
-    if( !hostApi->jackIsDown )
-    {
-        hostApi->toRemove = stream;
-        /* Unlock mutex and await signal from processing thread */
-        result = WaitCondition( stream->hostApi );
-    }
+    result = ReplaceStreamTable( hostApi, NULL, stream );
     ASSERT_CALL( pthread_mutex_unlock( &hostApi->mtx ), 0 );
     ENSURE_PA( result );
 
@@ -1203,6 +1437,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     }
     srInitialized = 1;
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, jackSr );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     /* create the JACK ports.  We cannot connect them until audio
      * processing begins */
@@ -1373,6 +1608,7 @@ static PaError RealProcess( PaJackStream *stream, jack_nframes_t frames )
             / sr;
 
     PaUtil_BeginCpuLoadMeasurement( &stream->cpuLoadMeasurer );
+    PaUtil_TraceEvent( paTraceCallbackBegin, (int)frames, 0 );
 
     if( stream->xrun )
     {
@@ -1388,6 +1624,7 @@ static PaError RealProcess( PaJackStream *stream, jack_nframes_t frames )
     if( stream->num_outgoing_connections > 0 )
         PaUtil_SetOutputFrameCount( &stream->bufferProcessor, frames );
 
+    PaUtil_TraceEvent( paTraceHostBufferAcquireBegin, (int)frames, 0 );
     for( chn = 0; chn < stream->num_incoming_connections; chn++ )
     {
         jack_default_audio_sample_t *channel_buf = (jack_default_audio_sample_t*)
@@ -1409,6 +1646,7 @@ static PaError RealProcess( PaJackStream *stream, jack_nframes_t frames )
                 chn,
                 channel_buf );
     }
+    PaUtil_TraceEvent( paTraceHostBufferAcquireEnd, (int)frames, 0 );
 
     framesProcessed = PaUtil_EndBufferProcessing( &stream->bufferProcessor,
             &stream->callbackResult );
@@ -1416,130 +1654,115 @@ static PaError RealProcess( PaJackStream *stream, jack_nframes_t frames )
     assert( framesProcessed == frames );
 
     PaUtil_EndCpuLoadMeasurement( &stream->cpuLoadMeasurer, framesProcessed );
+    PaUtil_TraceEvent( paTraceCallbackEnd, framesProcessed, 0 );
 
 end:
     return result;
 }
 
-/* Update the JACK callback's stream processing queue. */
-static PaError UpdateQueue( PaJackHostApiRepresentation *hostApi )
+/* Pick up the stream table last published for the JACK callback, and acknowledge it so that the table used until now
+ * can be freed. Runs on the process thread, and never waits. */
+static PaJackStreamTable *UpdateQueue( PaJackHostApiRepresentation *hostApi )
 {
-    PaError result = paNoError;
-    int queueModified = 0;
-    const double jackSr = jack_get_sample_rate( hostApi->jack_client );
-    int err;
+    PaJackStreamTable *table = hostApi->processTable;
 
-    if( (err = pthread_mutex_trylock( &hostApi->mtx )) != 0 )
+    PaUtil_ReadMemoryBarrier();     /* The table before the streams it holds */
+    if( table != hostApi->seenTable )
     {
-        assert( err == EBUSY );
-        return paNoError;
+        hostApi->seenTable = table;
+        ASSERT_CALL( sem_post( &hostApi->processAck ), 0 );
     }
 
-    if( hostApi->toAdd )
+    return table;
+}
+
+/* Process one stream for this cycle, or silence its output once it has gone inactive. */
+static PaError ProcessStream( PaJackStream *stream, jack_nframes_t frames )
+{
+    PaError result = paNoError;
+
+    if( stream->is_active )
+        ENSURE_PA( RealProcess( stream, frames ) );
+    /* If we have just entered inactive state, silence output */
+    if( !stream->is_active && !stream->isSilenced )
     {
-        if( hostApi->processQueue )
-        {
-            PaJackStream *node = hostApi->processQueue;
-            /* Advance to end of queue */
-            while( node->next )
-                node = node->next;
+        int i;
 
-            node->next = hostApi->toAdd;
-        }
-        else
+        /* Silence buffer after entering inactive state */
+        PA_DEBUG(( "Silencing the output\n" ));
+        for( i = 0; i < stream->num_outgoing_connections; ++i )
         {
-            /* The only queue entry. */
-            hostApi->processQueue = (PaJackStream *)hostApi->toAdd;
+            jack_default_audio_sample_t *buffer = jack_port_get_buffer( stream->local_output_ports[i], frames );
+            memset( buffer, 0, sizeof (jack_default_audio_sample_t) * frames );
         }
 
-        /* If necessary, update stream state */
-        if( hostApi->toAdd->streamRepresentation.streamInfo.sampleRate != jackSr )
-            UpdateSampleRate( hostApi->toAdd, jackSr );
-
-        hostApi->toAdd = NULL;
-        queueModified = 1;
+        stream->isSilenced = 1;
     }
-    if( hostApi->toRemove )
-    {
-        int removed = 0;
-        PaJackStream *node = hostApi->processQueue, *prev = NULL;
-        assert( hostApi->processQueue );
 
-        while( node )
-        {
-            if( node == hostApi->toRemove )
-            {
-                if( prev )
-                    prev->next = node->next;
-                else
-                    hostApi->processQueue = (PaJackStream *)node->next;
-
-                removed = 1;
-                break;
-            }
+error:
+    return result;
+}
 
-            prev = node;
-            node = node->next;
-        }
-        UNLESS( removed, paInternalError );
-        hostApi->toRemove = NULL;
-        PA_DEBUG(( "%s: Removed stream from processing queue\n", __FUNCTION__ ));
-        queueModified = 1;
-    }
+/* Process the streams of the table assigned to one worker. */
+static PaError ProcessStreams( PaJackStreamTable *table, int worker, jack_nframes_t frames )
+{
+    PaError result = paNoError;
+    int s;
 
-    if( queueModified )
+    for( s = 0; table && s < table->count; ++s )
     {
-        /* Signal that we've done what was asked of us */
-        ASSERT_CALL( pthread_cond_signal( &hostApi->cond ), 0 );
+        if( table->streams[s]->worker == worker )
+            ENSURE_PA( ProcessStream( table->streams[s], frames ) );
     }
 
 error:
-    ASSERT_CALL( pthread_mutex_unlock( &hostApi->mtx ), 0 );
-
     return result;
 }
 
-/* Audio processing callback invoked periodically from JACK. */
+/* Audio processing callback invoked periodically from JACK.
+ *
+ * Starting and stopping streams is handled here, on the process thread, before and after the streams are processed.
+ * The streams themselves are processed by the worker they were assigned, the process thread being worker 0, and the
+ * callback doesn't return before all workers are done. */
 static int JackCallback( jack_nframes_t frames, void *userData )
 {
     PaError result = paNoError;
     PaJackHostApiRepresentation *hostApi = (PaJackHostApiRepresentation *)userData;
+    PaJackStreamTable *table = NULL;
     PaJackStream *stream = NULL;
+    const double sampleRate = jack_get_sample_rate( hostApi->jack_client );
     int xrun = hostApi->xrun;
+    int s, i, pending = 0;
     hostApi->xrun = 0;
 
     assert( hostApi );
 
-    ENSURE_PA( UpdateQueue( hostApi ) );
+    PaUtil_TraceSetThreadName( "JACK process" );
+
+    table = UpdateQueue( hostApi );
 
-    /* Process each stream */
-    stream = hostApi->processQueue;
-    for( ; stream; stream = stream->next )
+    for( s = 0; table && s < table->count; ++s )
     {
+        stream = table->streams[s];
+
         if( xrun )  /* Don't override if already set */
             stream->xrun = 1;
 
+        if( stream->streamRepresentation.streamInfo.sampleRate != sampleRate )
+        {
+            PA_DEBUG(( "%s: Updating samplerate\n", __FUNCTION__ ));
+            UpdateSampleRate( stream, sampleRate );
+        }
+
         /* See if this stream is to be started */
         if( stream->doStart )
         {
-            /* If we can't obtain a lock, we'll try next time */
-            int err = pthread_mutex_trylock( &stream->hostApi->mtx );
-            if( !err )
-            {
-                if( stream->doStart )   /* Could potentially change before obtaining the lock */
-                {
-                    stream->is_active = 1;
-                    stream->doStart = 0;
-                    PA_DEBUG(( "%s: Starting stream\n", __FUNCTION__ ));
-                    ASSERT_CALL( pthread_cond_signal( &stream->hostApi->cond ), 0 );
-                    stream->callbackResult = paContinue;
-                    stream->isSilenced = 0;
-                }
-
-                ASSERT_CALL( pthread_mutex_unlock( &stream->hostApi->mtx ), 0 );
-            }
-            else
-                assert( err == EBUSY );
+            stream->callbackResult = paContinue;
+            stream->isSilenced = 0;
+            stream->is_active = 1;
+            stream->doStart = 0;
+            PA_DEBUG(( "%s: Starting stream\n", __FUNCTION__ ));
+            ASSERT_CALL( sem_post( &hostApi->processAck ), 0 );
         }
         else if( stream->doStop || stream->doAbort )    /* Should we stop/abort stream? */
         {
@@ -1550,39 +1773,50 @@ static int JackCallback( jack_nframes_t frames, void *userData )
             }
         }
 
-        if( stream->is_active )
-            ENSURE_PA( RealProcess( stream, frames ) );
-        /* If we have just entered inactive state, silence output */
-        if( !stream->is_active && !stream->isSilenced )
+        if( stream->worker > 0 && !hostApi->workers[stream->worker].busy )
         {
-            int i;
+            hostApi->workers[stream->worker].busy = 1;
+            ++pending;
+        }
+    }
 
-            /* Silence buffer after entering inactive state */
-            PA_DEBUG(( "Silencing the output\n" ));
-            for( i = 0; i < stream->num_outgoing_connections; ++i )
+    /* Process each stream, waking only the workers that have streams */
+    if( pending )
+    {
+        hostApi->cycleTable = table;
+        hostApi->cycleFrames = frames;
+        hostApi->workersResult = paNoError;
+        hostApi->workersPending = pending;
+        for( i = 1; i < hostApi->numWorkers; ++i )
+        {
+            if( hostApi->workers[i].busy )
             {
-                jack_default_audio_sample_t *buffer = jack_port_get_buffer( stream->local_output_ports[i], frames );
-                memset( buffer, 0, sizeof (jack_default_audio_sample_t) * frames );
+                hostApi->workers[i].busy = 0;
+                ASSERT_CALL( sem_post( &hostApi->workers[i].wake ), 0 );
             }
-
-            stream->isSilenced = 1;
         }
+    }
+    result = ProcessStreams( table, 0, frames );
+    if( pending )
+    {
+        while( sem_wait( &hostApi->workersDone ) != 0 )
+            assert( errno == EINTR );
+        if( result == paNoError )
+            result = hostApi->workersResult;
+    }
+    ENSURE_PA( result );
+
+    for( s = 0; table && s < table->count; ++s )
+    {
+        stream = table->streams[s];
 
         if( stream->doStop || stream->doAbort )
         {
             /* See if RealProcess has acted on the request */
             if( !stream->is_active )   /* Ok, signal to the main thread that we've carried out the operation */
             {
-                /* If we can't obtain a lock, we'll try next time */
-                int err = pthread_mutex_trylock( &stream->hostApi->mtx );
-                if( !err )
-                {
-                    stream->doStop = stream->doAbort = 0;
-                    ASSERT_CALL( pthread_cond_signal( &stream->hostApi->cond ), 0 );
-                    ASSERT_CALL( pthread_mutex_unlock( &stream->hostApi->mtx ), 0 );
-                }
-                else
-                    assert( err == EBUSY );
+                stream->doStop = stream->doAbort = 0;
+                ASSERT_CALL( sem_post( &hostApi->processAck ), 0 );
             }
         }
     }
@@ -1596,6 +1830,7 @@ static PaError StartStream( PaStream *s )
 {
     PaError result = paNoError;
     PaJackStream *stream = (PaJackStream*)s;
+    struct timespec deadline;
     int i;
 
     /* Ready the processor */
@@ -1629,16 +1864,15 @@ static PaError StartStream( PaStream *s )
     /* Enable processing */
 
     ASSERT_CALL( pthread_mutex_lock( &stream->hostApi->mtx ), 0 );
+    ResetProcessAck( stream->hostApi );
     stream->doStart = 1;
 
     /* Wait for stream to be started */
-    result = WaitCondition( stream->hostApi );
-    /*
-    do
-    {
-        err = pthread_cond_timedwait( &stream->hostApi->cond, &stream->hostApi->mtx, &ts );
-    } while( !stream->is_active && !err );
-    */
+    GetProcessAckDeadline( &deadline );
+    while( stream->doStart && !stream->hostApi->jackIsDown && result == paNoError )
+        result = WaitForProcessThread( stream->hostApi, &deadline );
+    if( result == paNoError && stream->doStart )
+        result = paDeviceUnavailable;
     if( result != paNoError )   /* Something went wrong, call off the stream start */
     {
         stream->doStart = 0;
@@ -1658,19 +1892,23 @@ error:
 static PaError RealStop( PaJackStream *stream, int abort )
 {
     PaError result = paNoError;
+    struct timespec deadline;
     int i;
 
     if( stream->isBlockingStream )
         BlockingWaitEmpty ( stream );
 
     ASSERT_CALL( pthread_mutex_lock( &stream->hostApi->mtx ), 0 );
+    ResetProcessAck( stream->hostApi );
     if( abort )
         stream->doAbort = 1;
     else
         stream->doStop = 1;
 
     /* Wait for stream to be stopped */
-    result = WaitCondition( stream->hostApi );
+    GetProcessAckDeadline( &deadline );
+    while( (stream->doStop || stream->doAbort) && !stream->hostApi->jackIsDown && result == paNoError )
+        result = WaitForProcessThread( stream->hostApi, &deadline );
     ASSERT_CALL( pthread_mutex_unlock( &stream->hostApi->mtx ), 0 );
     ENSURE_PA( result );
 
@@ -1758,6 +1996,14 @@ PaError PaJack_SetClientName( const char* name )
     return paNoError;
 }
 
+PaError PaJack_SetProcessThreads( int numThreads )
+{
+    if( numThreads < 0 )
+        return paInvalidFlag;
+    processThreads_ = numThreads;
+    return paNoError;
+}
+
 PaError PaJack_GetClientName(const char** clientName)
 {
     PaError result = paNoError;
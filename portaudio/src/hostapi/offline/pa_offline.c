@@ -0,0 +1,980 @@
+/*
+ * $Id$
+ * Portable Audio I/O Library offline host API implementation
+ * drives streams without audio hardware, for batch rendering and
+ * benchmarking
+ *
+ * Based on the Open Source API proposed by Ross Bencina
+ * Copyright (c) 1999-2002 Ross Bencina, Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+/** @file
+ @ingroup hostapi_src
+
+ @brief Offline host API: virtual devices driven without audio hardware.
+
+ Each stream owns a pair of interleaved host buffers in the device's native
+ format. A callback stream runs a thread which feeds silence in through
+ PaUtil_BeginBufferProcessing()/PaUtil_EndBufferProcessing() and discards
+ what comes out, so the full conversion and adaption path is exercised.
+ Streams either run free, processing buffers back to back, or are paced so
+ that stream time follows the wall clock (optionally scaled). Stream time
+ is simulated: it is the number of frames processed divided by the sample
+ rate, starting from zero each time the stream is started.
+*/
+
+
+#include <string.h> /* strlen() */
+#include <time.h>   /* nanosleep() */
+
+#include "pa_util.h"
+#include "pa_allocation.h"
+#include "pa_hostapi.h"
+#include "pa_stream.h"
+#include "pa_cpuload.h"
+#include "pa_process.h"
+#include "pa_converters.h"
+#include "pa_unix_util.h"
+#include "pa_debugprint.h"
+#include "pa_trace.h"
+
+#include "pa_offline.h"
+
+
+/* prototypes for functions declared in this file */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+PaError PaOffline_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+
+static void Terminate( struct PaUtilHostApiRepresentation *hostApi );
+static PaError IsFormatSupported( struct PaUtilHostApiRepresentation *hostApi,
+                                  const PaStreamParameters *inputParameters,
+                                  const PaStreamParameters *outputParameters,
+                                  double sampleRate );
+static PaError GetNativeSampleFormats( struct PaUtilHostApiRepresentation *hostApi,
+                                       PaDeviceIndex device,
+                                       int isInput,
+                                       PaSampleFormat *sampleFormats );
+static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
+                           PaStream** s,
+                           const PaStreamParameters *inputParameters,
+                           const PaStreamParameters *outputParameters,
+                           double sampleRate,
+                           unsigned long framesPerBuffer,
+                           PaStreamFlags streamFlags,
+                           PaStreamCallback *streamCallback,
+                           void *userData );
+static PaError CloseStream( PaStream* stream );
+static PaError StartStream( PaStream *stream );
+static PaError StopStream( PaStream *stream );
+static PaError AbortStream( PaStream *stream );
+static PaError IsStreamStopped( PaStream *s );
+static PaError IsStreamActive( PaStream *stream );
+static PaTime GetStreamTime( PaStream *stream );
+static double GetStreamCpuLoad( PaStream* stream );
+static PaError ReadStream( PaStream* stream, void *buffer, unsigned long frames );
+static PaError WriteStream( PaStream* stream, const void *buffer, unsigned long frames );
+static signed long GetStreamReadAvailable( PaStream* stream );
+static signed long GetStreamWriteAvailable( PaStream* stream );
+
+
+/* host buffer size used when neither framesPerBuffer nor a suggested latency pins it down */
+#define PA_OFFLINE_DEFAULT_HOST_FRAMES_ (256)
+#define PA_OFFLINE_MIN_HOST_FRAMES_     (16)
+#define PA_OFFLINE_MAX_HOST_FRAMES_     (65536)
+
+/* longest single sleep while pacing, so stop and abort requests are noticed promptly */
+#define PA_OFFLINE_MAX_SLEEP_NANOS_     (10000000)
+
+
+static const PaOfflineDeviceInfo defaultDevices_[] =
+{
+    { "Offline Float32", 8, 8, 48000., 8000., 384000., paFloat32 | paInt32 | paInt24 | paInt16 },
+    { "Offline Int16", 2, 2, 44100., 8000., 192000., paInt16 }
+};
+
+static const PaOfflineDeviceInfo *devices_ = defaultDevices_;
+static int deviceCount_ = sizeof(defaultDevices_) / sizeof(defaultDevices_[0]);
+
+
+PaError PaOffline_SetDevices( const PaOfflineDeviceInfo *devices, int deviceCount )
+{
+    int i;
+
+    if( !devices || deviceCount <= 0 )
+    {
+        devices_ = defaultDevices_;
+        deviceCount_ = sizeof(defaultDevices_) / sizeof(defaultDevices_[0]);
+        return paNoError;
+    }
+
+    for( i=0; i < deviceCount; ++i )
+    {
+        const PaOfflineDeviceInfo *device = &devices[i];
+
+        if( !device->name )
+            return paInvalidDevice;
+        if( device->maxInputChannels < 0 || device->maxOutputChannels < 0
+                || device->maxInputChannels + device->maxOutputChannels == 0 )
+            return paInvalidChannelCount;
+        if( device->minSampleRate <= 0. || device->maxSampleRate < device->minSampleRate
+                || device->defaultSampleRate < device->minSampleRate
+                || device->defaultSampleRate > device->maxSampleRate )
+            return paInvalidSampleRate;
+        if( (device->nativeSampleFormats & ~paNonInterleaved & ~paCustomFormat) == 0 )
+            return paSampleFormatNotSupported;
+    }
+
+    devices_ = devices;
+    deviceCount_ = deviceCount;
+    return paNoError;
+}
+
+
+void PaOffline_InitializeStreamInfo( PaOfflineStreamInfo *info, PaOfflinePacing pacing )
+{
+    info->size = sizeof(PaOfflineStreamInfo);
+    info->hostApiType = paOffline;
+    info->version = 1;
+    info->pacing = pacing;
+    info->clockRate = 1.;
+}
+
+
+/* PaOfflineHostApiRepresentation - host api datastructure specific to this implementation */
+
+typedef struct
+{
+    PaUtilHostApiRepresentation inheritedHostApiRep;
+    PaUtilStreamInterface callbackStreamInterface;
+    PaUtilStreamInterface blockingStreamInterface;
+
+    PaUtilAllocationGroup *allocations;
+}
+PaOfflineHostApiRepresentation;
+
+
+/* PaOfflineDevice - PaDeviceInfo extended with what OpenStream needs to validate against */
+
+typedef struct
+{
+    PaDeviceInfo baseDeviceInfo;
+
+    double minSampleRate;
+    double maxSampleRate;
+    PaSampleFormat nativeSampleFormats;
+}
+PaOfflineDevice;
+
+
+PaError PaOffline_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex hostApiIndex )
+{
+    PaError result = paNoError;
+    int i, deviceCount = deviceCount_;
+    PaOfflineHostApiRepresentation *offlineHostApi;
+    PaOfflineDevice *deviceArray;
+
+    offlineHostApi = (PaOfflineHostApiRepresentation*)PaUtil_AllocateMemory( sizeof(PaOfflineHostApiRepresentation) );
+    if( !offlineHostApi )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    offlineHostApi->allocations = PaUtil_CreateAllocationGroup();
+    if( !offlineHostApi->allocations )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    *hostApi = &offlineHostApi->inheritedHostApiRep;
+    (*hostApi)->info.structVersion = 1;
+    (*hostApi)->info.type = paOffline;
+    (*hostApi)->info.name = "Offline";
+
+    (*hostApi)->info.defaultInputDevice = paNoDevice;
+    (*hostApi)->info.defaultOutputDevice = paNoDevice;
+
+    (*hostApi)->info.deviceCount = 0;
+
+    (*hostApi)->deviceInfos = (PaDeviceInfo**)PaUtil_GroupAllocateMemory(
+            offlineHostApi->allocations, sizeof(PaDeviceInfo*) * deviceCount );
+    if( !(*hostApi)->deviceInfos )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    /* allocate all device info structs in a contiguous block */
+    deviceArray = (PaOfflineDevice*)PaUtil_GroupAllocateMemory(
+            offlineHostApi->allocations, sizeof(PaOfflineDevice) * deviceCount );
+    if( !deviceArray )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+
+    for( i=0; i < deviceCount; ++i )
+    {
+        const PaOfflineDeviceInfo *source = &devices_[i];
+        PaOfflineDevice *device = &deviceArray[i];
+        PaDeviceInfo *deviceInfo = &device->baseDeviceInfo;
+        char *deviceName;
+
+        deviceInfo->structVersion = 2;
+        deviceInfo->hostApi = hostApiIndex;
+
+        deviceName = (char*)PaUtil_GroupAllocateMemory( offlineHostApi->allocations, strlen(source->name) + 1 );
+        if( !deviceName )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+        strcpy( deviceName, source->name );
+        deviceInfo->name = deviceName;
+
+        deviceInfo->maxInputChannels = source->maxInputChannels;
+        deviceInfo->maxOutputChannels = source->maxOutputChannels;
+
+        /* latency here is only the host buffer size OpenStream will pick for it */
+        deviceInfo->defaultLowInputLatency = PA_OFFLINE_DEFAULT_HOST_FRAMES_ / source->defaultSampleRate;
+        deviceInfo->defaultLowOutputLatency = PA_OFFLINE_DEFAULT_HOST_FRAMES_ / source->defaultSampleRate;
+        deviceInfo->defaultHighInputLatency = 8 * PA_OFFLINE_DEFAULT_HOST_FRAMES_ / source->defaultSampleRate;
+        deviceInfo->defaultHighOutputLatency = 8 * PA_OFFLINE_DEFAULT_HOST_FRAMES_ / source->defaultSampleRate;
+
+        deviceInfo->defaultSampleRate = source->defaultSampleRate;
+
+        device->minSampleRate = source->minSampleRate;
+        device->maxSampleRate = source->maxSampleRate;
+        device->nativeSampleFormats = source->nativeSampleFormats & ~paNonInterleaved & ~paCustomFormat;
+
+        if( deviceInfo->maxInputChannels > 0 && (*hostApi)->info.defaultInputDevice == paNoDevice )
+            (*hostApi)->info.defaultInputDevice = i;
+        if( deviceInfo->maxOutputChannels > 0 && (*hostApi)->info.defaultOutputDevice == paNoDevice )
+            (*hostApi)->info.defaultOutputDevice = i;
+
+        (*hostApi)->deviceInfos[i] = deviceInfo;
+        ++(*hostApi)->info.deviceCount;
+    }
+
+    (*hostApi)->Terminate = Terminate;
+    (*hostApi)->OpenStream = OpenStream;
+    (*hostApi)->IsFormatSupported = IsFormatSupported;
+    (*hostApi)->ScanDeviceInfos = NULL;
+    (*hostApi)->CommitDeviceInfos = NULL;
+    (*hostApi)->DisposeDeviceInfos = NULL;
+    (*hostApi)->GetNativeSampleFormats = GetNativeSampleFormats;
+
+    PaUtil_InitializeStreamInterface( &offlineHostApi->callbackStreamInterface, CloseStream, StartStream,
+                                      StopStream, AbortStream, IsStreamStopped, IsStreamActive,
+                                      GetStreamTime, GetStreamCpuLoad,
+                                      PaUtil_DummyRead, PaUtil_DummyWrite,
+                                      PaUtil_DummyGetReadAvailable, PaUtil_DummyGetWriteAvailable );
+
+    PaUtil_InitializeStreamInterface( &offlineHostApi->blockingStreamInterface, CloseStream, StartStream,
+                                      StopStream, AbortStream, IsStreamStopped, IsStreamActive,
+                                      GetStreamTime, PaUtil_DummyGetCpuLoad,
+                                      ReadStream, WriteStream, GetStreamReadAvailable, GetStreamWriteAvailable );
+
+    return result;
+
+error:
+    if( offlineHostApi )
+    {
+        if( offlineHostApi->allocations )
+        {
+            PaUtil_FreeAllAllocations( offlineHostApi->allocations );
+            PaUtil_DestroyAllocationGroup( offlineHostApi->allocations );
+        }
+
+        PaUtil_FreeMemory( offlineHostApi );
+    }
+    return result;
+}
+
+
+static void Terminate( struct PaUtilHostApiRepresentation *hostApi )
+{
+    PaOfflineHostApiRepresentation *offlineHostApi = (PaOfflineHostApiRepresentation*)hostApi;
+
+    if( offlineHostApi->allocations )
+    {
+        PaUtil_FreeAllAllocations( offlineHostApi->allocations );
+        PaUtil_DestroyAllocationGroup( offlineHostApi->allocations );
+    }
+
+    PaUtil_FreeMemory( offlineHostApi );
+}
+
+
+/* Validate one direction of a stream against its virtual device. On success
+   *hostSampleFormat is set to the native format the host buffer will use. */
+static PaError ValidateParameters( struct PaUtilHostApiRepresentation *hostApi,
+                                   const PaStreamParameters *parameters,
+                                   double sampleRate, int isInput,
+                                   PaSampleFormat *hostSampleFormat )
+{
+    const PaOfflineDevice *device;
+    const PaOfflineStreamInfo *streamInfo;
+    int maxChannels;
+
+    /* all standard sample formats are supported by the buffer adapter,
+        this implementation doesn't support any custom sample formats */
+    if( parameters->sampleFormat & paCustomFormat )
+        return paSampleFormatNotSupported;
+
+    if( parameters->device == paUseHostApiSpecificDeviceSpecification )
+        return paInvalidDevice;
+
+    device = (const PaOfflineDevice*)hostApi->deviceInfos[ parameters->device ];
+    maxChannels = isInput ? device->baseDeviceInfo.maxInputChannels : device->baseDeviceInfo.maxOutputChannels;
+    if( parameters->channelCount > maxChannels )
+        return paInvalidChannelCount;
+
+    if( sampleRate < device->minSampleRate || sampleRate > device->maxSampleRate )
+        return paInvalidSampleRate;
+
+    streamInfo = (const PaOfflineStreamInfo*)parameters->hostApiSpecificStreamInfo;
+    if( streamInfo && ( streamInfo->size != sizeof(PaOfflineStreamInfo)
+                || streamInfo->hostApiType != paOffline || streamInfo->version != 1
+                || ( streamInfo->pacing == paOfflinePaced && streamInfo->clockRate <= 0. ) ) )
+        return paIncompatibleHostApiSpecificStreamInfo;
+
+    *hostSampleFormat = PaUtil_SelectClosestAvailableFormat( device->nativeSampleFormats, parameters->sampleFormat );
+    if( *hostSampleFormat == (PaSampleFormat)paSampleFormatNotSupported )
+        return paSampleFormatNotSupported;
+
+    return paNoError;
+}
+
+
+static PaError IsFormatSupported( struct PaUtilHostApiRepresentation *hostApi,
+                                  const PaStreamParameters *inputParameters,
+                                  const PaStreamParameters *outputParameters,
+                                  double sampleRate )
+{
+    PaError result;
+    PaSampleFormat hostSampleFormat;
+
+    if( inputParameters )
+    {
+        result = ValidateParameters( hostApi, inputParameters, sampleRate, 1, &hostSampleFormat );
+        if( result != paNoError )
+            return result;
+    }
+
+    if( outputParameters )
+    {
+        result = ValidateParameters( hostApi, outputParameters, sampleRate, 0, &hostSampleFormat );
+        if( result != paNoError )
+            return result;
+    }
+
+    return paFormatIsSupported;
+}
+
+
+static PaError GetNativeSampleFormats( struct PaUtilHostApiRepresentation *hostApi,
+                                       PaDeviceIndex device,
+                                       int isInput,
+                                       PaSampleFormat *sampleFormats )
+{
+    (void)isInput;
+
+    /* host buffers are always interleaved */
+    *sampleFormats = ((const PaOfflineDevice*)hostApi->deviceInfos[ device ])->nativeSampleFormats;
+    return paNoError;
+}
+
+/* PaOfflineStream - a stream data structure specifically for this implementation */
+
+typedef struct PaOfflineStream
+{
+    PaUtilStreamRepresentation streamRepresentation;
+    PaUtilCpuLoadMeasurer cpuLoadMeasurer;
+    PaUtilBufferProcessor bufferProcessor;
+    PaUtilThreading threading;
+
+    void *hostInputBuffer;
+    void *hostOutputBuffer;
+    void **userInputBuffers;  /* scratch channel pointers for non-interleaved blocking reads */
+    void **userOutputBuffers; /* scratch channel pointers for non-interleaved blocking writes */
+    int inputChannelCount;
+    int outputChannelCount;
+    int userInputInterleaved;
+    int userOutputInterleaved;
+    unsigned long framesPerHostBuffer;
+    double sampleRate;
+
+    PaOfflinePacing pacing;
+    double clockRate;
+    PaInt64 startNanoseconds;
+
+    /* stream time in frames, advanced by the callback thread or by the
+       blocking calls. blocking reads on a full duplex stream keep their own
+       count so that only writes advance the clock */
+    volatile PaInt64 framesProcessed;
+    PaInt64 framesRead;
+
+    int threadRunning;
+    volatile int isActive;
+    volatile int isStopped;
+    volatile int stopRequested;
+    volatile int abortRequested;
+}
+PaOfflineStream;
+
+
+/* see pa_hostapi.h for a list of validity guarantees made about OpenStream parameters */
+
+static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
+                           PaStream** s,
+                           const PaStreamParameters *inputParameters,
+                           const PaStreamParameters *outputParameters,
+                           double sampleRate,
+                           unsigned long framesPerBuffer,
+                           PaStreamFlags streamFlags,
+                           PaStreamCallback *streamCallback,
+                           void *userData )
+{
+    PaError result = paNoError;
+    PaOfflineHostApiRepresentation *offlineHostApi = (PaOfflineHostApiRepresentation*)hostApi;
+    PaOfflineStream *stream = 0;
+    unsigned long framesPerHostBuffer;
+    int inputChannelCount, outputChannelCount;
+    PaSampleFormat inputSampleFormat, outputSampleFormat;
+    PaSampleFormat hostInputSampleFormat, hostOutputSampleFormat;
+    PaTime suggestedLatency = 0.;
+    const PaOfflineStreamInfo *streamInfo = 0;
+
+    if( inputParameters )
+    {
+        result = ValidateParameters( hostApi, inputParameters, sampleRate, 1, &hostInputSampleFormat );
+        if( result != paNoError )
+            return result;
+
+        inputChannelCount = inputParameters->channelCount;
+        inputSampleFormat = inputParameters->sampleFormat;
+        suggestedLatency = inputParameters->suggestedLatency;
+        streamInfo = (const PaOfflineStreamInfo*)inputParameters->hostApiSpecificStreamInfo;
+    }
+    else
+    {
+        inputChannelCount = 0;
+        inputSampleFormat = hostInputSampleFormat = paInt16; /* Suppress 'uninitialised var' warnings. */
+    }
+
+    if( outputParameters )
+    {
+        result = ValidateParameters( hostApi, outputParameters, sampleRate, 0, &hostOutputSampleFormat );
+        if( result != paNoError )
+            return result;
+
+        outputChannelCount = outputParameters->channelCount;
+        outputSampleFormat = outputParameters->sampleFormat;
+        suggestedLatency = PA_MAX( suggestedLatency, outputParameters->suggestedLatency );
+        if( outputParameters->hostApiSpecificStreamInfo )
+            streamInfo = (const PaOfflineStreamInfo*)outputParameters->hostApiSpecificStreamInfo;
+    }
+    else
+    {
+        outputChannelCount = 0;
+        outputSampleFormat = hostOutputSampleFormat = paInt16; /* Suppress 'uninitialized var' warnings. */
+    }
+
+    /* validate platform specific flags */
+    if( (streamFlags & paPlatformSpecificFlags) != 0 )
+        return paInvalidFlag; /* unexpected platform specific flag */
+
+    /* a fixed request is honoured exactly, so the buffer processor never has
+       to adapt, otherwise the host buffer follows the suggested latency */
+    if( framesPerBuffer != paFramesPerBufferUnspecified )
+    {
+        framesPerHostBuffer = framesPerBuffer;
+    }
+    else if( suggestedLatency > 0. )
+    {
+        framesPerHostBuffer = (unsigned long)(suggestedLatency * sampleRate);
+        framesPerHostBuffer = PA_MAX( framesPerHostBuffer, PA_OFFLINE_MIN_HOST_FRAMES_ );
+        framesPerHostBuffer = PA_MIN( framesPerHostBuffer, PA_OFFLINE_MAX_HOST_FRAMES_ );
+    }
+    else
+    {
+        framesPerHostBuffer = PA_OFFLINE_DEFAULT_HOST_FRAMES_;
+    }
+
+    stream = (PaOfflineStream*)PaUtil_AllocateMemory( sizeof(PaOfflineStream) );
+    if( !stream )
+    {
+        result = paInsufficientMemory;
+        goto error;
+    }
+    memset( stream, 0, sizeof(PaOfflineStream) );
+
+    if( streamCallback )
+    {
+        PaUtil_InitializeStreamRepresentation( &stream->streamRepresentation,
+                                               &offlineHostApi->callbackStreamInterface, streamCallback, userData );
+    }
+    else
+    {
+        PaUtil_InitializeStreamRepresentation( &stream->streamRepresentation,
+                                               &offlineHostApi->blockingStreamInterface, streamCallback, userData );
+    }
+
+    PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
+    PaUtil_InitializeThreading( &stream->threading );
+
+    if( inputChannelCount > 0 )
+    {
+        stream->hostInputBuffer = PaUtil_AllocateMemory(
+                framesPerHostBuffer * inputChannelCount * Pa_GetSampleSize( hostInputSampleFormat ) );
+        stream->userInputBuffers = (void**)PaUtil_AllocateMemory( sizeof(void*) * inputChannelCount );
+        if( !stream->hostInputBuffer || !stream->userInputBuffers )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+        /* the virtual input captures silence */
+        PaUtil_SelectZeroer( hostInputSampleFormat )( stream->hostInputBuffer, 1,
+                framesPerHostBuffer * inputChannelCount );
+    }
+
+    if( outputChannelCount > 0 )
+    {
+        stream->hostOutputBuffer = PaUtil_AllocateMemory(
+                framesPerHostBuffer * outputChannelCount * Pa_GetSampleSize( hostOutputSampleFormat ) );
+        stream->userOutputBuffers = (void**)PaUtil_AllocateMemory( sizeof(void*) * outputChannelCount );
+        if( !stream->hostOutputBuffer || !stream->userOutputBuffers )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+    }
+
+    result =  PaUtil_InitializeBufferProcessor( &stream->bufferProcessor,
+              inputChannelCount, inputSampleFormat, hostInputSampleFormat,
+              outputChannelCount, outputSampleFormat, hostOutputSampleFormat,
+              sampleRate, streamFlags, framesPerBuffer,
+              framesPerHostBuffer, paUtilFixedHostBufferSize,
+              streamCallback, userData );
+    if( result != paNoError )
+        goto error;
+
+    stream->streamRepresentation.streamInfo.inputLatency = inputChannelCount > 0 ?
+            (PaTime)(PaUtil_GetBufferProcessorInputLatencyFrames( &stream->bufferProcessor )
+                    + framesPerHostBuffer) / sampleRate : 0.;
+    stream->streamRepresentation.streamInfo.outputLatency = outputChannelCount > 0 ?
+            (PaTime)(PaUtil_GetBufferProcessorOutputLatencyFrames( &stream->bufferProcessor )
+                    + framesPerHostBuffer) / sampleRate : 0.;
+    stream->streamRepresentation.streamInfo.sampleRate = sampleRate;
+
+    stream->inputChannelCount = inputChannelCount;
+    stream->outputChannelCount = outputChannelCount;
+    stream->userInputInterleaved = !(inputSampleFormat & paNonInterleaved);
+    stream->userOutputInterleaved = !(outputSampleFormat & paNonInterleaved);
+    stream->framesPerHostBuffer = framesPerHostBuffer;
+    stream->sampleRate = sampleRate;
+    stream->pacing = streamInfo ? streamInfo->pacing : paOfflineFreeRunning;
+    stream->clockRate = streamInfo && streamInfo->pacing == paOfflinePaced ? streamInfo->clockRate : 1.;
+    stream->isStopped = 1;
+
+    *s = (PaStream*)stream;
+
+    return result;
+
+error:
+    if( stream )
+    {
+        if( stream->hostInputBuffer )
+            PaUtil_FreeMemory( stream->hostInputBuffer );
+        if( stream->userInputBuffers )
+            PaUtil_FreeMemory( stream->userInputBuffers );
+        if( stream->hostOutputBuffer )
+            PaUtil_FreeMemory( stream->hostOutputBuffer );
+        if( stream->userOutputBuffers )
+            PaUtil_FreeMemory( stream->userOutputBuffers );
+        PaUtil_FreeMemory( stream );
+    }
+
+    return result;
+}
+
+
+/* Block until the wall clock reaches the simulated time of the given frame.
+   Free running streams return immediately. */
+static void PaceStream( PaOfflineStream *stream, PaInt64 frame )
+{
+    PaInt64 deadline, remaining;
+
+    if( stream->pacing != paOfflinePaced )
+        return;
+
+    deadline = stream->startNanoseconds
+            + (PaInt64)(frame * 1e9 / (stream->sampleRate * stream->clockRate));
+
+    while( !stream->stopRequested && !stream->abortRequested
+            && (remaining = deadline - PaUtil_GetTimeNanoseconds()) > 0 )
+    {
+        struct timespec ts;
+
+        remaining = PA_MIN( remaining, PA_OFFLINE_MAX_SLEEP_NANOS_ );
+        ts.tv_sec = 0;
+        ts.tv_nsec = (long)remaining;
+        nanosleep( &ts, NULL );
+    }
+}
+
+
+/* Frames the simulated clock has reached on the wall clock. Only meaningful when paced. */
+static PaInt64 FramesDue( PaOfflineStream *stream )
+{
+    return (PaInt64)((PaUtil_GetTimeNanoseconds() - stream->startNanoseconds)
+            * 1e-9 * stream->sampleRate * stream->clockRate);
+}
+
+
+static void SetUpBuffers( PaOfflineStream *stream )
+{
+    if( stream->inputChannelCount > 0 )
+    {
+        PaUtil_SetInputFrameCount( &stream->bufferProcessor, stream->framesPerHostBuffer );
+        PaUtil_SetInterleavedInputChannels( &stream->bufferProcessor, 0, stream->hostInputBuffer, 0 );
+    }
+
+    if( stream->outputChannelCount > 0 )
+    {
+        PaUtil_SetOutputFrameCount( &stream->bufferProcessor, stream->framesPerHostBuffer );
+        PaUtil_SetInterleavedOutputChannels( &stream->bufferProcessor, 0, stream->hostOutputBuffer, 0 );
+    }
+}
+
+
+/** Thread procedure for callback streams.
+
+ Runs one host buffer per iteration until the callback completes (and the
+ buffer processor has drained), or until StopStream()/AbortStream() ask it
+ to finish. The stream becomes inactive, and the stream finished callback is
+ called, from this thread.
+*/
+static void *OfflineThreadProc( void *userData )
+{
+    PaOfflineStream *stream = (PaOfflineStream*)userData;
+    PaStreamCallbackTimeInfo timeInfo = {0,0,0};
+    int callbackResult = paContinue;
+    unsigned long framesProcessed;
+
+    PaUtil_TraceSetThreadName( "Offline callback" );
+
+    while( !stream->abortRequested )
+    {
+        if( stream->stopRequested && callbackResult == paContinue )
+            callbackResult = paComplete;
+
+        PaceStream( stream, stream->framesProcessed );
+
+        timeInfo.currentTime = (PaTime)stream->framesProcessed / stream->sampleRate;
+        timeInfo.inputBufferAdcTime = timeInfo.currentTime - stream->streamRepresentation.streamInfo.inputLatency;
+        timeInfo.outputBufferDacTime = timeInfo.currentTime + stream->streamRepresentation.streamInfo.outputLatency;
+
+        PaUtil_BeginCpuLoadMeasurement( &stream->cpuLoadMeasurer );
+        PaUtil_TraceEvent( paTraceCallbackBegin, (int)stream->framesPerHostBuffer, 0 );
+
+        PaUtil_BeginBufferProcessing( &stream->bufferProcessor, &timeInfo, 0 );
+        SetUpBuffers( stream );
+        framesProcessed = PaUtil_EndBufferProcessing( &stream->bufferProcessor, &callbackResult );
+
+        PaUtil_EndCpuLoadMeasurement( &stream->cpuLoadMeasurer, framesProcessed );
+        PaUtil_TraceEvent( paTraceCallbackEnd, (int)framesProcessed, 0 );
+
+        stream->framesProcessed += stream->framesPerHostBuffer;
+
+        if( callbackResult != paContinue
+                && ( callbackResult == paAbort || PaUtil_IsBufferProcessorOutputEmpty( &stream->bufferProcessor ) ) )
+            break;
+    }
+
+    PaUtil_ResetCpuLoadMeasurer( &stream->cpuLoadMeasurer );
+    stream->isActive = 0;
+
+    if( stream->streamRepresentation.streamFinishedCallback != 0 )
+        stream->streamRepresentation.streamFinishedCallback( stream->streamRepresentation.userData );
+
+    return NULL;
+}
+
+
+/*
+    When CloseStream() is called, the multi-api layer ensures that
+    the stream has already been stopped or aborted.
+*/
+static PaError CloseStream( PaStream* s )
+{
+    PaError result = paNoError;
+    PaOfflineStream *stream = (PaOfflineStream*)s;
+
+    PaUtil_TerminateThreading( &stream->threading );
+    PaUtil_TerminateBufferProcessor( &stream->bufferProcessor );
+    PaUtil_TerminateStreamRepresentation( &stream->streamRepresentation );
+
+    if( stream->hostInputBuffer )
+        PaUtil_FreeMemory( stream->hostInputBuffer );
+    if( stream->userInputBuffers )
+        PaUtil_FreeMemory( stream->userInputBuffers );
+    if( stream->hostOutputBuffer )
+        PaUtil_FreeMemory( stream->hostOutputBuffer );
+    if( stream->userOutputBuffers )
+        PaUtil_FreeMemory( stream->userOutputBuffers );
+    PaUtil_FreeMemory( stream );
+
+    return result;
+}
+
+
+static PaError StartStream( PaStream *s )
+{
+    PaError result = paNoError;
+    PaOfflineStream *stream = (PaOfflineStream*)s;
+
+    PaUtil_ResetBufferProcessor( &stream->bufferProcessor );
+
+    stream->framesProcessed = 0;
+    stream->framesRead = 0;
+    stream->stopRequested = 0;
+    stream->abortRequested = 0;
+    stream->startNanoseconds = PaUtil_GetTimeNanoseconds();
+    stream->isStopped = 0;
+    stream->isActive = 1;
+
+    if( stream->bufferProcessor.streamCallback )
+    {
+        PA_ENSURE( PaUtil_StartThreading( &stream->threading, &OfflineThreadProc, stream,
+                    &stream->streamRepresentation.threadPolicy, stream->framesPerHostBuffer / stream->sampleRate ) );
+        stream->threadRunning = 1;
+    }
+
+    return result;
+
+error:
+    stream->isActive = 0;
+    stream->isStopped = 1;
+    return result;
+}
+
+
+static PaError RealStop( PaOfflineStream *stream, int abort )
+{
+    PaError result = paNoError;
+
+    if( stream->threadRunning )
+    {
+        if( abort )
+            stream->abortRequested = 1;
+        else
+            stream->stopRequested = 1;
+
+        /* the thread polls the request flags, so it is always joined rather than cancelled */
+        result = PaUtil_CancelThreading( &stream->threading, 1, NULL );
+        stream->threadRunning = 0;
+    }
+
+    stream->isActive = 0;
+    stream->isStopped = 1;
+
+    return result;
+}
+
+
+static PaError StopStream( PaStream *s )
+{
+    return RealStop( (PaOfflineStream*)s, 0 );
+}
+
+
+static PaError AbortStream( PaStream *s )
+{
+    return RealStop( (PaOfflineStream*)s, 1 );
+}
+
+
+static PaError IsStreamStopped( PaStream *s )
+{
+    PaOfflineStream *stream = (PaOfflineStream*)s;
+
+    return stream->isStopped;
+}
+
+
+static PaError IsStreamActive( PaStream *s )
+{
+    PaOfflineStream *stream = (PaOfflineStream*)s;
+
+    return stream->isActive;
+}
+
+
+static PaTime GetStreamTime( PaStream *s )
+{
+    PaOfflineStream *stream = (PaOfflineStream*)s;
+
+    return (PaTime)stream->framesProcessed / stream->sampleRate;
+}
+
+
+static double GetStreamCpuLoad( PaStream* s )
+{
+    PaOfflineStream *stream = (PaOfflineStream*)s;
+
+    return PaUtil_GetCpuLoad( &stream->cpuLoadMeasurer );
+}
+
+
+/*
+    As separate stream interfaces are used for blocking and callback
+    streams, the following functions can be guaranteed to only be called
+    for blocking streams.
+*/
+
+static PaError ReadStream( PaStream* s,
+                           void *buffer,
+                           unsigned long frames )
+{
+    PaOfflineStream *stream = (PaOfflineStream*)s;
+    void *userBuffer;
+
+    if( stream->inputChannelCount == 0 )
+        return paCanNotReadFromAnOutputOnlyStream;
+
+    if( stream->userInputInterleaved )
+    {
+        userBuffer = buffer;
+    }
+    else
+    {
+        /* PaUtil_CopyInput() advances the channel pointers, so work on a copy */
+        userBuffer = stream->userInputBuffers;
+        memcpy( userBuffer, buffer, sizeof(void*) * stream->inputChannelCount );
+    }
+
+    while( frames > 0 )
+    {
+        unsigned long framesToCopy = PA_MIN( frames, stream->framesPerHostBuffer );
+
+        PaceStream( stream, stream->framesRead + framesToCopy );
+
+        PaUtil_SetInputFrameCount( &stream->bufferProcessor, framesToCopy );
+        PaUtil_SetInterleavedInputChannels( &stream->bufferProcessor, 0, stream->hostInputBuffer, 0 );
+        PaUtil_CopyInput( &stream->bufferProcessor, &userBuffer, framesToCopy );
+
+        stream->framesRead += framesToCopy;
+        if( stream->outputChannelCount == 0 )
+            stream->framesProcessed = stream->framesRead;
+        frames -= framesToCopy;
+    }
+
+    return paNoError;
+}
+
+
+static PaError WriteStream( PaStream* s,
+                            const void *buffer,
+                            unsigned long frames )
+{
+    PaOfflineStream *stream = (PaOfflineStream*)s;
+    const void *userBuffer;
+
+    if( stream->outputChannelCount == 0 )
+        return paCanNotWriteToAnInputOnlyStream;
+
+    if( stream->userOutputInterleaved )
+    {
+        userBuffer = buffer;
+    }
+    else
+    {
+        /* PaUtil_CopyOutput() advances the channel pointers, so work on a copy */
+        memcpy( (void*)stream->userOutputBuffers, buffer, sizeof(void*) * stream->outputChannelCount );
+        userBuffer = stream->userOutputBuffers;
+    }
+
+    while( frames > 0 )
+    {
+        unsigned long framesToCopy = PA_MIN( frames, stream->framesPerHostBuffer );
+
+        PaceStream( stream, stream->framesProcessed );
+
+        PaUtil_SetOutputFrameCount( &stream->bufferProcessor, framesToCopy );
+        PaUtil_SetInterleavedOutputChannels( &stream->bufferProcessor, 0, stream->hostOutputBuffer, 0 );
+        PaUtil_CopyOutput( &stream->bufferProcessor, &userBuffer, framesToCopy );
+
+        stream->framesProcessed += framesToCopy;
+        frames -= framesToCopy;
+    }
+
+    return paNoError;
+}
+
+
+static signed long GetStreamReadAvailable( PaStream* s )
+{
+    PaOfflineStream *stream = (PaOfflineStream*)s;
+
+    if( stream->pacing == paOfflinePaced )
+        return (signed long)PA_MAX( FramesDue( stream ) - stream->framesRead, 0 );
+
+    return (signed long)stream->framesPerHostBuffer;
+}
+
+
+static signed long GetStreamWriteAvailable( PaStream* s )
+{
+    PaOfflineStream *stream = (PaOfflineStream*)s;
+
+    /* one host buffer may always be queued ahead of the simulated clock */
+    if( stream->pacing == paOfflinePaced )
+        return (signed long)PA_MAX( FramesDue( stream ) - stream->framesProcessed, 0 )
+                + (signed long)stream->framesPerHostBuffer;
+
+    return (signed long)stream->framesPerHostBuffer;
+}
@@ -256,6 +256,10 @@ PaError PaOSS_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
     (*hostApi)->Terminate = Terminate;
     (*hostApi)->OpenStream = OpenStream;
     (*hostApi)->IsFormatSupported = IsFormatSupported;
+    (*hostApi)->ScanDeviceInfos = NULL;
+    (*hostApi)->CommitDeviceInfos = NULL;
+    (*hostApi)->DisposeDeviceInfos = NULL;
+    (*hostApi)->GetNativeSampleFormats = NULL;
 
     PA_ENSURE( BuildDeviceList( ossHostApi ) );
 
@@ -447,22 +451,34 @@ error:
     return result;
 }
 
-/** Query OSS device.
- *
- * This is where PaDeviceInfo objects are constructed and filled in with relevant information.
+/** Capabilities of a potential OSS device, determined by ProbeDevice.
  *
- * Aspect DeviceCapabilities: The inferred device capabilities are recorded in a PaDeviceInfo object that is constructed
- * in place.
+ * Probes run on a pool of threads (see PaUnix_RunProbes) and only touch their own PaOssDeviceProbe, since one that
+ * times out is abandoned to its thread.
  */
-static PaError QueryDevice( char *deviceName, PaOSSHostApiRepresentation *ossApi, PaDeviceInfo **deviceInfo )
+typedef struct
 {
-    PaError result = paNoError;
-    double sampleRate = -1.;
+    char deviceName[32];
+    PaError result;
+    double sampleRate;
     int maxInputChannels, maxOutputChannels;
     PaTime defaultLowInputLatency, defaultLowOutputLatency, defaultHighInputLatency, defaultHighOutputLatency;
+} PaOssDeviceProbe;
+
+/** Probe OSS device.
+ *
+ * Aspect DeviceCapabilities: The inferred device capabilities are recorded in the probe, QueryDevice turns them into
+ * a PaDeviceInfo object.
+ */
+static void ProbeDevice( void *data )
+{
+    PaOssDeviceProbe *probe = (PaOssDeviceProbe *)data;
+    const char *deviceName = probe->deviceName;
     PaError tmpRes = paNoError;
     int busy = 0;
-    *deviceInfo = NULL;
+
+    probe->result = paNoError;
+    probe->sampleRate = -1.;
 
     /* douglas:
        we have to do this querying in a slightly different order. apparently
@@ -475,8 +491,8 @@ static PaError QueryDevice( char *deviceName, PaOSSHostApiRepresentation *ossApi
      * opened in, it may have more channels available for capture than playback and vice versa. Therefore
      * we will open the device in both read- and write-only mode to determine the supported number.
      */
-    if( (tmpRes = QueryDirection( deviceName, StreamMode_In, &sampleRate, &maxInputChannels, &defaultLowInputLatency,
-                &defaultHighInputLatency )) != paNoError )
+    if( (tmpRes = QueryDirection( deviceName, StreamMode_In, &probe->sampleRate, &probe->maxInputChannels,
+                &probe->defaultLowInputLatency, &probe->defaultHighInputLatency )) != paNoError )
     {
         if( tmpRes != paDeviceUnavailable )
         {
@@ -485,8 +501,8 @@ static PaError QueryDevice( char *deviceName, PaOSSHostApiRepresentation *ossApi
         }
         ++busy;
     }
-    if( (tmpRes = QueryDirection( deviceName, StreamMode_Out, &sampleRate, &maxOutputChannels, &defaultLowOutputLatency,
-                &defaultHighOutputLatency )) != paNoError )
+    if( (tmpRes = QueryDirection( deviceName, StreamMode_Out, &probe->sampleRate, &probe->maxOutputChannels,
+                &probe->defaultLowOutputLatency, &probe->defaultHighOutputLatency )) != paNoError )
     {
         if( tmpRes != paDeviceUnavailable )
         {
@@ -498,22 +514,43 @@ static PaError QueryDevice( char *deviceName, PaOSSHostApiRepresentation *ossApi
     assert( 0 <= busy && busy <= 2 );
     if( 2 == busy )     /* Both directions are unavailable to us */
     {
-        result = paDeviceUnavailable;
-        goto error;
+        probe->result = paDeviceUnavailable;
     }
+}
+
+/** Query OSS device.
+ *
+ * This is where PaDeviceInfo objects are constructed and filled in with the capabilities found by ProbeDevice.
+ *
+ * Aspect DeviceCapabilities: The inferred device capabilities are recorded in a PaDeviceInfo object that is constructed
+ * in place.
+ */
+static PaError QueryDevice( const PaOssDeviceProbe *probe, PaOSSHostApiRepresentation *ossApi, PaDeviceInfo **deviceInfo )
+{
+    PaError result = paNoError;
+    *deviceInfo = NULL;
+
+    if( probe->result != paNoError )
+        return probe->result;
 
     PA_UNLESS( *deviceInfo = PaUtil_GroupAllocateMemory( ossApi->allocations, sizeof (PaDeviceInfo) ), paInsufficientMemory );
-    PA_ENSURE( PaUtil_InitializeDeviceInfo( *deviceInfo, deviceName, ossApi->hostApiIndex, maxInputChannels, maxOutputChannels,
-                defaultLowInputLatency, defaultLowOutputLatency, defaultHighInputLatency, defaultHighOutputLatency, sampleRate,
+    PA_ENSURE( PaUtil_InitializeDeviceInfo( *deviceInfo, probe->deviceName, ossApi->hostApiIndex, probe->maxInputChannels,
+                probe->maxOutputChannels, probe->defaultLowInputLatency, probe->defaultLowOutputLatency,
+                probe->defaultHighInputLatency, probe->defaultHighOutputLatency, probe->sampleRate,
                 ossApi->allocations ) );
 
 error:
     return result;
 }
 
+static void FreeDeviceProbe( void *data )
+{
+    PaUtil_FreeMemory( data );
+}
+
 /** Query host devices.
  *
- * Loop over host devices and query their capabilitiesu
+ * Probe the potential host devices concurrently, then query their capabilities in order
  *
  * Aspect DeviceCapabilities: This function calls QueryDevice on each device entry and receives a filled in PaDeviceInfo object
  * per device, these are placed in the host api representation's deviceInfos array.
@@ -525,6 +562,10 @@ static PaError BuildDeviceList( PaOSSHostApiRepresentation *ossApi )
     int i;
     int numDevices = 0, maxDeviceInfos = 1;
     PaDeviceInfo **deviceInfos = NULL;
+    /* A: Set an arbitrary of 100 devices, should probably be a smarter way. */
+    PaOssDeviceProbe *probes[101];
+    int finished[101];
+    const int numProbes = sizeof (probes) / sizeof (probes[0]);
 
     /* These two will be set to the first working input and output device, respectively */
     commonApi->info.defaultInputDevice = paNoDevice;
@@ -532,22 +573,41 @@ static PaError BuildDeviceList( PaOSSHostApiRepresentation *ossApi )
 
     /* Find devices by calling QueryDevice on each
      * potential device names.  When we find a valid one,
-     * add it to a linked list.
-     * A: Set an arbitrary of 100 devices, should probably be a smarter way. */
+     * add it to a linked list. */
 
-    for( i = -1; i < 100; i++ )
+    memset( probes, 0, sizeof (probes) );
+    for( i = 0; i < numProbes; i++ )
+    {
+        PA_UNLESS( probes[i] = (PaOssDeviceProbe *)PaUtil_AllocateMemory( sizeof (PaOssDeviceProbe) ),
+                paInsufficientMemory );
+        memset( probes[i], 0, sizeof (PaOssDeviceProbe) );
+        if( i == 0 )
+            snprintf(probes[i]->deviceName, sizeof (probes[i]->deviceName), "%s", DEVICE_NAME_BASE);
+        else
+            snprintf(probes[i]->deviceName, sizeof (probes[i]->deviceName), "%s%d", DEVICE_NAME_BASE, i - 1);
+    }
+
+    /* DEVICE_NAME_BASE is usually an alias of one of the numbered devices, probe it on its own so the two opens
+     * can not collide */
+    PA_ENSURE( PaUnix_RunProbes( (void **)probes, 1, ProbeDevice, FreeDeviceProbe, 1, PA_UNIX_PROBE_TIMEOUT,
+                NULL, finished ) );
+    PA_ENSURE( PaUnix_RunProbes( (void **)probes + 1, numProbes - 1, ProbeDevice, FreeDeviceProbe,
+                PA_UNIX_PROBE_THREADS, PA_UNIX_PROBE_TIMEOUT, NULL, finished + 1 ) );
+
+    for( i = 0; i < numProbes; i++ )
     {
-        char deviceName[32];
         PaDeviceInfo *deviceInfo;
         int testResult;
 
-        if( i == -1 )
-            snprintf(deviceName, sizeof (deviceName), "%s", DEVICE_NAME_BASE);
-        else
-            snprintf(deviceName, sizeof (deviceName), "%s%d", DEVICE_NAME_BASE, i);
+        if( !finished[i] )
+        {
+            PA_DEBUG(( "%s: Gave up on device %s\n", __FUNCTION__, probes[i]->deviceName ));
+            probes[i] = NULL;   /* Now owned by its probe thread */
+            continue;
+        }
 
-        /* PA_DEBUG(("%s: trying device %s\n", __FUNCTION__, deviceName )); */
-        if( (testResult = QueryDevice( deviceName, ossApi, &deviceInfo )) != paNoError )
+        /* PA_DEBUG(("%s: trying device %s\n", __FUNCTION__, probes[i]->deviceName )); */
+        if( (testResult = QueryDevice( probes[i], ossApi, &deviceInfo )) != paNoError )
         {
             if( testResult != paDeviceUnavailable )
                 PA_ENSURE( testResult );
@@ -584,6 +644,8 @@ static PaError BuildDeviceList( PaOSSHostApiRepresentation *ossApi )
     commonApi->info.deviceCount = numDevices;
 
 error:
+    for( i = 0; i < numProbes; i++ )
+        PaUtil_FreeMemory( probes[i] );
     free( deviceInfos );
 
     return result;
@@ -1250,6 +1312,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     PA_ENSURE( PaOssStream_Configure( stream, sampleRate, framesPerBuffer, &inLatency, &outLatency ) );
 
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     if( inputParameters )
     {
@@ -1808,7 +1871,8 @@ static PaError StartStream( PaStream *s )
     /* only use the thread for callback streams */
     if( stream->bufferProcessor.streamCallback )
     {
-        PA_ENSURE( PaUtil_StartThreading( &stream->threading, &PaOSS_AudioThreadProc, stream ) );
+        PA_ENSURE( PaUtil_StartThreading( &stream->threading, &PaOSS_AudioThreadProc, stream,
+                    &stream->streamRepresentation.threadPolicy, stream->framesPerHostBuffer / stream->sampleRate ) );
         sem_wait( &stream->semaphore );
     }
     else
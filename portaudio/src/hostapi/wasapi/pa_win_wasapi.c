@@ -1801,7 +1801,7 @@ static void NotifyStateChanged(PaWasapiStream *stream, UINT32 flags, HRESULT hr)
     if (FAILED(hr))
         flags |= paWasapiStreamStateError;
     
-    stream->fnStateHandler((PaStream *)stream, flags, hr, stream->pStateHandlerUserData);
+    stream->fnStateHandler(stream->streamRepresentation.openStreamHandle, flags, hr, stream->pStateHandlerUserData);
 }
 
 // ------------------------------------------------------------------------------------------
@@ -2352,6 +2352,10 @@ PaError PaWasapi_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiInd
     (*hostApi)->Terminate                = Terminate;
     (*hostApi)->OpenStream               = OpenStream;
     (*hostApi)->IsFormatSupported        = IsFormatSupported;
+    (*hostApi)->ScanDeviceInfos          = NULL;
+    (*hostApi)->CommitDeviceInfos        = NULL;
+    (*hostApi)->DisposeDeviceInfos       = NULL;
+    (*hostApi)->GetNativeSampleFormats   = NULL;
 
     // Fill the device list
     if ((result = CreateDeviceList(paWasapi, hostApiIndex)) != paNoError)
@@ -2453,10 +2457,30 @@ static PaWasapiHostApiRepresentation *_GetHostApi(PaError *ret)
     return (PaWasapiHostApiRepresentation *)pApi;
 }
 
+// ------------------------------------------------------------------------------------------
+// Resolves the client's stream handle, see PaUtil_GetStreamRepresentation. Returns NULL if it
+// is not an open WASAPI stream.
+static PaWasapiStream *_GetStream(PaStream *pStream)
+{
+    PaUtilStreamRepresentation *streamRepresentation;
+    PaWasapiHostApiRepresentation *paWasapi;
+
+    if (PaUtil_GetStreamRepresentation(pStream, &streamRepresentation) != paNoError)
+        return NULL;
+
+    if ((paWasapi = _GetHostApi(NULL)) == NULL)
+        return NULL;
+
+    if ((streamRepresentation->streamInterface != &paWasapi->callbackStreamInterface) &&
+        (streamRepresentation->streamInterface != &paWasapi->blockingStreamInterface))
+        return NULL;
+
+    return (PaWasapiStream *)streamRepresentation;
+}
+
 // ------------------------------------------------------------------------------------------
 static PaError UpdateDeviceList()
 {
-    int i;
     PaError ret;
     PaWasapiHostApiRepresentation *paWasapi;
     PaUtilHostApiRepresentation *hostApi;
@@ -2473,22 +2497,16 @@ static PaError UpdateDeviceList()
     // Release WASAPI internal device info list
     ReleaseWasapiDeviceInfoList(paWasapi);
 
-    // Release external device info list
-    if (hostApi->deviceInfos != NULL)
-    {
-        for (i = 0; i < hostApi->info.deviceCount; ++i)
-        {
-            PaUtil_GroupFreeMemory(paWasapi->allocations, (void *)hostApi->deviceInfos[i]->name);
-        }
-        PaUtil_GroupFreeMemory(paWasapi->allocations, hostApi->deviceInfos[0]);
-        PaUtil_GroupFreeMemory(paWasapi->allocations, hostApi->deviceInfos);
+    // Release external device info list. The group holds nothing but the device list, so free all of it:
+    // freeing block by block would keep the regions of names allocated for skipped devices, and every
+    // update would allocate the new list after them
+    PaUtil_FreeAllAllocations(paWasapi->allocations);
 
-        // Be ready for a device list reinitialization and if its creation is failed pointers must not be dangling
-        hostApi->deviceInfos = NULL;
-        hostApi->info.deviceCount = 0;
-        hostApi->info.defaultInputDevice = paNoDevice;
-        hostApi->info.defaultOutputDevice = paNoDevice;
-    }
+    // Be ready for a device list reinitialization and if its creation is failed pointers must not be dangling
+    hostApi->deviceInfos = NULL;
+    hostApi->info.deviceCount = 0;
+    hostApi->info.defaultInputDevice = paNoDevice;
+    hostApi->info.defaultOutputDevice = paNoDevice;
 
     // Fill possibly updated device list
     if ((ret = CreateDeviceList(paWasapi, Pa_HostApiTypeIdToHostApiIndex(paWASAPI))) != paNoError)
@@ -2513,7 +2531,7 @@ int PaWasapi_GetDeviceCurrentFormat( PaStream *pStream, void *pFormat, unsigned
     UINT32 size;
     WAVEFORMATEXTENSIBLE *format;
 
-    PaWasapiStream *stream = (PaWasapiStream *)pStream;
+    PaWasapiStream *stream = _GetStream(pStream);
     if (stream == NULL)
         return paBadStreamPtr;
     
@@ -2617,7 +2635,7 @@ int PaWasapi_GetDeviceRole( PaDeviceIndex device )
 // ------------------------------------------------------------------------------------------
 PaError PaWasapi_GetFramesPerHostBuffer( PaStream *pStream, unsigned int *pInput, unsigned int *pOutput )
 {
-    PaWasapiStream *stream = (PaWasapiStream *)pStream;
+    PaWasapiStream *stream = _GetStream(pStream);
     if (stream == NULL)
         return paBadStreamPtr;
 
@@ -4051,6 +4069,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
 
     // Initialize CPU measurer
     PaUtil_InitializeCpuLoadMeasurer(&stream->cpuLoadMeasurer, sampleRate);
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     if (outputParameters && inputParameters)
     {
@@ -5440,7 +5459,7 @@ error:
 // ------------------------------------------------------------------------------------------
 PaError PaWasapi_GetAudioClient(PaStream *pStream, void **pAudioClient, int bOutput)
 {
-    PaWasapiStream *stream = (PaWasapiStream *)pStream;
+    PaWasapiStream *stream = _GetStream(pStream);
     if (stream == NULL)
         return paBadStreamPtr;
 
@@ -5557,7 +5576,7 @@ PaError PaWasapiWinrt_PopulateDeviceList( const unsigned short **pId, const unsi
 // ------------------------------------------------------------------------------------------
 PaError PaWasapi_SetStreamStateHandler( PaStream *pStream, PaWasapiStreamStateCallback fnStateHandler, void *pUserData )
 {
-    PaWasapiStream *stream = (PaWasapiStream *)pStream;
+    PaWasapiStream *stream = _GetStream(pStream);
     if (stream == NULL)
         return paBadStreamPtr;
 
@@ -341,7 +341,7 @@ typedef struct __PaWinWdmHostApiRepresentation
     PaUtilStreamInterface        callbackStreamInterface;
     PaUtilStreamInterface        blockingStreamInterface;
 
-    PaUtilAllocationGroup*       allocations;
+    struct __PaWinWDMScanDeviceInfosResults* deviceList; /* The committed device list, owns its allocation group */
     int                          deviceCount;
 }
 PaWinWdmHostApiRepresentation;
@@ -435,6 +435,7 @@ struct __PaProcessThreadInfo
 /* Used for transferring device infos during scanning / rescanning */
 typedef struct __PaWinWDMScanDeviceInfosResults
 { 
+    PaUtilAllocationGroup *allocations; /* Holds these results and the device infos, freed as a whole */
     PaDeviceInfo **deviceInfos;
     PaDeviceIndex defaultInputDevice;
     PaDeviceIndex defaultOutputDevice;
@@ -3457,10 +3458,10 @@ static unsigned GetNameIndex(PaNameHashObject* obj, const wchar_t* name, const B
 
 static PaError ScanDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, PaHostApiIndex hostApiIndex, void **scanResults, int *newDeviceCount )
 {
-    PaWinWdmHostApiRepresentation *wdmHostApi = (PaWinWdmHostApiRepresentation*)hostApi;
     PaError result = paNoError;
     PaWinWdmFilter** ppFilters = 0;
     PaWinWDMScanDeviceInfosResults *outArgument = 0;
+    PaUtilAllocationGroup *allocations = 0;
     int filterCount = 0;
     int totalDeviceCount = 0;
     int idxDevice = 0;
@@ -3494,20 +3495,30 @@ static PaError ScanDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, PaH
         int i;
         unsigned devIsDefaultIn = 0, devIsDefaultOut = 0;
 
+        /* Each device list gets a group of its own, so that replacing the list frees all of it */
+        allocations = PaUtil_CreateAllocationGroup();
+        if( !allocations )
+        {
+            result = paInsufficientMemory;
+            goto error;
+        }
+
         /* Allocate the out param for all the info we need */
         outArgument = (PaWinWDMScanDeviceInfosResults *) PaUtil_GroupAllocateMemory(
-            wdmHostApi->allocations, sizeof(PaWinWDMScanDeviceInfosResults) );
+            allocations, sizeof(PaWinWDMScanDeviceInfosResults) );
         if( !outArgument )
         {
             result = paInsufficientMemory;
             goto error;
         }
 
+        outArgument->allocations = allocations;
+        outArgument->deviceInfos = 0;
         outArgument->defaultInputDevice  = paNoDevice;
         outArgument->defaultOutputDevice = paNoDevice;
 
         outArgument->deviceInfos = (PaDeviceInfo**)PaUtil_GroupAllocateMemory(
-            wdmHostApi->allocations, sizeof(PaDeviceInfo*) * totalDeviceCount );
+            allocations, sizeof(PaDeviceInfo*) * totalDeviceCount );
         if( !outArgument->deviceInfos )
         {
             result = paInsufficientMemory;
@@ -3516,7 +3527,7 @@ static PaError ScanDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, PaH
 
         /* allocate all device info structs in a contiguous block */
         deviceInfoArray = (PaWinWdmDeviceInfo*)PaUtil_GroupAllocateMemory(
-            wdmHostApi->allocations, sizeof(PaWinWdmDeviceInfo) * totalDeviceCount );
+            allocations, sizeof(PaWinWdmDeviceInfo) * totalDeviceCount );
         if( !deviceInfoArray )
         {
             result = paInsufficientMemory;
@@ -3710,7 +3721,10 @@ static PaError ScanDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, PaH
     return result;
 
 error:
-    result = DisposeDeviceInfos(hostApi, outArgument, totalDeviceCount);
+    if( outArgument )
+        DisposeDeviceInfos(hostApi, outArgument, totalDeviceCount);
+    else if( allocations )
+        PaUtil_DestroyAllocationGroup( allocations );
 
     return result;
 }
@@ -3719,21 +3733,17 @@ static PaError CommitDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, P
 {
     PaWinWdmHostApiRepresentation *wdmHostApi = (PaWinWdmHostApiRepresentation*)hostApi;
 
+    /* Free the old device list, filters and all */
+    if( wdmHostApi->deviceList )
+    {
+        DisposeDeviceInfos(hostApi, wdmHostApi->deviceList, hostApi->info.deviceCount);
+        wdmHostApi->deviceList = NULL;
+    }
+
     hostApi->info.deviceCount = 0;
     hostApi->info.defaultInputDevice = paNoDevice;
     hostApi->info.defaultOutputDevice = paNoDevice;
-
-    /* Free any old memory which might be in the device info */
-    if( hostApi->deviceInfos )
-    {
-        PaWinWDMScanDeviceInfosResults* localScanResults = (PaWinWDMScanDeviceInfosResults*)PaUtil_GroupAllocateMemory(
-            wdmHostApi->allocations, sizeof(PaWinWDMScanDeviceInfosResults));
-        localScanResults->deviceInfos = hostApi->deviceInfos;
-
-        DisposeDeviceInfos(hostApi, &localScanResults, hostApi->info.deviceCount);
-
-        hostApi->deviceInfos = NULL;
-    }
+    hostApi->deviceInfos = NULL;
 
     if( scanResults != NULL )
     {
@@ -3750,7 +3760,8 @@ static PaError CommitDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, P
             hostApi->info.deviceCount = deviceCount;
         }
 
-        PaUtil_GroupFreeMemory( wdmHostApi->allocations, scanDeviceInfosResults );
+        /* kept until the list is replaced, it owns the list's allocation group */
+        wdmHostApi->deviceList = scanDeviceInfosResults;
     }
 
     return paNoError;
@@ -3759,11 +3770,10 @@ static PaError CommitDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, P
 
 static PaError DisposeDeviceInfos( struct PaUtilHostApiRepresentation *hostApi, void *scanResults, int deviceCount )
 {
-    PaWinWdmHostApiRepresentation *winDsHostApi = (PaWinWdmHostApiRepresentation*)hostApi;
-
     if( scanResults != NULL )
     {
         PaWinWDMScanDeviceInfosResults *scanDeviceInfosResults = ( PaWinWDMScanDeviceInfosResults * ) scanResults;
+        PaUtilAllocationGroup *allocations = scanDeviceInfosResults->allocations;
 
         if( scanDeviceInfosResults->deviceInfos )
         {
@@ -3776,12 +3786,11 @@ static PaError DisposeDeviceInfos( struct PaUtilHostApiRepresentation *hostApi,
                     FilterFree(pDevice->filter);
                 }
             }
-
-            PaUtil_GroupFreeMemory( winDsHostApi->allocations, scanDeviceInfosResults->deviceInfos[0] ); /* all device info structs are allocated in a block so we can destroy them here */
-            PaUtil_GroupFreeMemory( winDsHostApi->allocations, scanDeviceInfosResults->deviceInfos );
         }
 
-        PaUtil_GroupFreeMemory( winDsHostApi->allocations, scanDeviceInfosResults );
+        /* the results, the device info pointers and the device info structs all go with the group */
+        PaUtil_FreeAllAllocations( allocations );
+        PaUtil_DestroyAllocationGroup( allocations );
     }
 
     return paNoError;
@@ -3837,12 +3846,7 @@ PaError PaWinWdm_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiInd
         goto error;
     }
 
-    wdmHostApi->allocations = PaUtil_CreateAllocationGroup();
-    if( !wdmHostApi->allocations )
-    {
-        result = paInsufficientMemory;
-        goto error;
-    }
+    wdmHostApi->deviceList = NULL;
 
     *hostApi = &wdmHostApi->inheritedHostApiRep;
     (*hostApi)->info.structVersion = 1;
@@ -3866,6 +3870,10 @@ PaError PaWinWdm_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiInd
     (*hostApi)->Terminate = Terminate;
     (*hostApi)->OpenStream = OpenStream;
     (*hostApi)->IsFormatSupported = IsFormatSupported;
+    (*hostApi)->ScanDeviceInfos = NULL;
+    (*hostApi)->CommitDeviceInfos = NULL;
+    (*hostApi)->DisposeDeviceInfos = NULL;
+    (*hostApi)->GetNativeSampleFormats = NULL;
     /* In preparation for hotplug
     (*hostApi)->ScanDeviceInfos = ScanDeviceInfos;
     (*hostApi)->CommitDeviceInfos = CommitDeviceInfos;
@@ -3913,16 +3921,9 @@ static void Terminate( struct PaUtilHostApiRepresentation *hostApi )
 
     if( wdmHostApi)
     {
-        PaWinWDMScanDeviceInfosResults* localScanResults = (PaWinWDMScanDeviceInfosResults*)PaUtil_GroupAllocateMemory(
-            wdmHostApi->allocations, sizeof(PaWinWDMScanDeviceInfosResults));
-        localScanResults->deviceInfos = hostApi->deviceInfos;
-        DisposeDeviceInfos(hostApi, localScanResults, hostApi->info.deviceCount);
+        if( wdmHostApi->deviceList )
+            DisposeDeviceInfos(hostApi, wdmHostApi->deviceList, hostApi->info.deviceCount);
 
-        if( wdmHostApi->allocations )
-        {
-            PaUtil_FreeAllAllocations( wdmHostApi->allocations );
-            PaUtil_DestroyAllocationGroup( wdmHostApi->allocations );
-        }
         PaUtil_FreeMemory( wdmHostApi );
     }
     PA_LOGL_;
@@ -4461,6 +4462,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     }
 
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
     /* Instantiate the input pin if necessary */
     if(userInputChannels > 0)
@@ -1134,6 +1134,10 @@ PaError PaWinMme_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiInd
     (*hostApi)->Terminate = Terminate;
     (*hostApi)->OpenStream = OpenStream;
     (*hostApi)->IsFormatSupported = IsFormatSupported;
+    (*hostApi)->ScanDeviceInfos = NULL;
+    (*hostApi)->CommitDeviceInfos = NULL;
+    (*hostApi)->DisposeDeviceInfos = NULL;
+    (*hostApi)->GetNativeSampleFormats = NULL;
 
     PaUtil_InitializeStreamInterface( &winMmeHostApi->callbackStreamInterface, CloseStream, StartStream,
                                       StopStream, AbortStream, IsStreamStopped, IsStreamActive,
@@ -2491,6 +2495,7 @@ static PaError OpenStream( struct PaUtilHostApiRepresentation *hostApi,
     streamRepresentationIsInitialized = 1;
 
     PaUtil_InitializeCpuLoadMeasurer( &stream->cpuLoadMeasurer, sampleRate );
+    stream->streamRepresentation.cpuLoadMeasurer = &stream->cpuLoadMeasurer;
 
 
     if( inputParameters && outputParameters ) /* full duplex */
@@ -3952,8 +3957,10 @@ static PaError GetWinMMEStreamPointer( PaWinMmeStream **stream, PaStream *s )
     PaError result;
     PaUtilHostApiRepresentation *hostApi;
     PaWinMmeHostApiRepresentation *winMmeHostApi;
+    PaUtilStreamRepresentation *streamRepresentation;
 
-    result = PaUtil_ValidateStreamPointer( s );
+    /* s is the client's handle, see PaUtil_GetStreamRepresentation */
+    result = PaUtil_GetStreamRepresentation( s, &streamRepresentation );
     if( result != paNoError )
         return result;
 
@@ -3966,11 +3973,11 @@ static PaError GetWinMMEStreamPointer( PaWinMmeStream **stream, PaStream *s )
     /* note, the following would be easier if there was a generic way of testing
         that a stream belongs to a specific host API */
 
-    if( PA_STREAM_REP( s )->streamInterface == &winMmeHostApi->callbackStreamInterface
-            || PA_STREAM_REP( s )->streamInterface == &winMmeHostApi->blockingStreamInterface )
+    if( streamRepresentation->streamInterface == &winMmeHostApi->callbackStreamInterface
+            || streamRepresentation->streamInterface == &winMmeHostApi->blockingStreamInterface )
     {
         /* s is a WinMME stream */
-        *stream = (PaWinMmeStream *)s;
+        *stream = (PaWinMmeStream *)streamRepresentation;
         return paNoError;
     }
     else
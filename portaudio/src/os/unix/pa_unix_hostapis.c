@@ -51,8 +51,10 @@ PaError PaSGI_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex
 PaError PaAsiHpi_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
 PaError PaMacCore_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
 PaError PaSkeleton_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
+PaError PaOffline_Initialize( PaUtilHostApiRepresentation **hostApi, PaHostApiIndex index );
 
 /** Note that on Linux, ALSA is placed before OSS so that the former is preferred over the latter.
+    The offline host API comes last so that it never becomes the default while real hardware exists.
  */
 
 PaUtilHostApiInitializer *paHostApiInitializers[] =
@@ -99,5 +101,60 @@ PaUtilHostApiInitializer *paHostApiInitializers[] =
         PaSkeleton_Initialize,
 #endif
 
+#if PA_USE_OFFLINE
+        PaOffline_Initialize,
+#endif
+
         0   /* NULL terminated array */
     };
+
+const PaHostApiTypeId paHostApiInitializerTypes[] =
+    {
+#ifdef __linux__
+
+#if PA_USE_ALSA
+        paALSA,
+#endif
+
+#if PA_USE_OSS
+        paOSS,
+#endif
+
+#else   /* __linux__ */
+
+#if PA_USE_OSS
+        paOSS,
+#endif
+
+#if PA_USE_ALSA
+        paALSA,
+#endif
+
+#endif  /* __linux__ */
+
+#if PA_USE_JACK
+        paJACK,
+#endif
+
+#if PA_USE_SGI
+        paAL,
+#endif
+
+#if PA_USE_ASIHPI
+        paAudioScienceHPI,
+#endif
+
+#if PA_USE_COREAUDIO
+        paCoreAudio,
+#endif
+
+#if PA_USE_SKELETON
+        paInDevelopment,
+#endif
+
+#if PA_USE_OFFLINE
+        paOffline,
+#endif
+
+        paInDevelopment /* keeps the array non-empty, never read */
+    };
@@ -46,10 +46,17 @@
 #include <stdlib.h>
 #include <time.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <assert.h>
 #include <string.h> /* For memset */
 #include <math.h>
 #include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #if defined(__APPLE__) && !defined(HAVE_MACH_ABSOLUTE_TIME)
 #define HAVE_MACH_ABSOLUTE_TIME
@@ -71,22 +78,113 @@ static int numAllocations_ = 0;
 #endif
 
 
+/* The allocator installed with Pa_SetAllocator(), NULL for the system's */
+static const PaUtilAllocator *allocator_ = NULL;
+
+/* Every block is preceded by a header naming the allocator it came from, padded
+    so the block is aligned as the allocator's memory is */
+typedef union PaUtilBlockHeader
+{
+    struct
+    {
+        const PaUtilAllocator *allocator;
+        long size; /* including the header */
+    } block;
+    long double alignLongDouble;
+    void *alignPointer;
+} PaUtilBlockHeader;
+
+
+/* Fault in and lock the pages of a block allocated with paRealTimeAllocator */
+static void PrefaultAndLock( void *block, long size )
+{
+    static int warned = 0;
+    long pageSize = sysconf( _SC_PAGESIZE );
+    char *first, *end;
+
+    if( pageSize <= 0 )
+        pageSize = 4096;
+
+    memset( block, 0, size );
+
+    first = (char *)((size_t)block / pageSize * pageSize);
+    end = (char *)block + size;
+    if( mlock( first, end - first ) != 0 && !warned )
+    {
+        PA_DEBUG(( "%s: mlock failed (%s), memory is not locked\n", __FUNCTION__, strerror( errno ) ));
+        warned = 1;
+    }
+}
+
+
+/* Unlock the pages lying wholly within a paRealTimeAllocator block that is
+    about to be freed. Pages it shares with other blocks stay locked: mlock()
+    doesn't nest, so unlocking them would unlock those blocks too. */
+static void UnlockBlock( void *block, long size )
+{
+    long pageSize = sysconf( _SC_PAGESIZE );
+    size_t first, end;
+
+    if( pageSize <= 0 )
+        pageSize = 4096;
+
+    first = ((size_t)block + pageSize - 1) / pageSize * pageSize;
+    end = ((size_t)block + size) / pageSize * pageSize;
+    if( first < end )
+        munlock( (void *)first, end - first );
+}
+
+
+void PaUtil_SetAllocator( const PaUtilAllocator *allocator )
+{
+    allocator_ = allocator;
+}
+
+
 void *PaUtil_AllocateMemory( long size )
 {
-    void *result = malloc( size );
+    const PaUtilAllocator *allocator = allocator_;
+    long blockSize = (long)sizeof(PaUtilBlockHeader) + size;
+    PaUtilBlockHeader *header;
+
+    if( allocator != NULL && allocator->allocate != NULL )
+        header = (PaUtilBlockHeader *)allocator->allocate( (unsigned long)blockSize, allocator->userData );
+    else
+        header = (PaUtilBlockHeader *)malloc( blockSize );
+
+    if( header == NULL )
+        return NULL;
+
+    if( allocator != NULL && (allocator->flags & paRealTimeAllocator) )
+        PrefaultAndLock( header, blockSize );
+
+    header->block.allocator = allocator;
+    header->block.size = blockSize;
 
 #if PA_TRACK_MEMORY
-    if( result != NULL ) numAllocations_ += 1;
+    numAllocations_ += 1;
 #endif
-    return result;
+    return header + 1;
 }
 
 
 void PaUtil_FreeMemory( void *block )
 {
+    PaUtilBlockHeader *header;
+    const PaUtilAllocator *allocator;
+
     if( block != NULL )
     {
-        free( block );
+        header = (PaUtilBlockHeader *)block - 1;
+        allocator = header->block.allocator;
+
+        if( allocator != NULL && (allocator->flags & paRealTimeAllocator) )
+            UnlockBlock( header, header->block.size );
+
+        if( allocator != NULL && allocator->free != NULL )
+            allocator->free( header, (unsigned long)header->block.size, allocator->userData );
+        else
+            free( header );
 #if PA_TRACK_MEMORY
         numAllocations_ -= 1;
 #endif
@@ -105,9 +203,101 @@ int PaUtil_CountCurrentlyAllocatedBlocks( void )
 }
 
 
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Regions at least this big may be backed by huge pages, they are rounded up to a multiple of it when they are */
+#define PA_HUGE_PAGE_SIZE_ (2 * 1024 * 1024)
+
+void *PaUtil_AllocateRegion( long *size, unsigned long flags )
+{
+    long pageSize = sysconf( _SC_PAGESIZE );
+    long length, i;
+    void *result = MAP_FAILED;
+
+    if( allocator_ != NULL && allocator_->allocate != NULL )
+        return NULL;
+    if( allocator_ != NULL && (allocator_->flags & paRealTimeAllocator) )
+        flags |= paUtilRegionPrefault;
+
+    if( pageSize <= 0 )
+        pageSize = 4096;
+    length = (*size + pageSize - 1) / pageSize * pageSize;
+
+#ifdef MAP_HUGETLB
+    if( (flags & paUtilRegionHugePages) && length >= PA_HUGE_PAGE_SIZE_ )
+    {
+        long hugeLength = (length + PA_HUGE_PAGE_SIZE_ - 1) / PA_HUGE_PAGE_SIZE_ * PA_HUGE_PAGE_SIZE_;
+
+        /* fails unless huge pages have been set aside, see /proc/sys/vm/nr_hugepages */
+        result = mmap( NULL, hugeLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+        if( result != MAP_FAILED )
+            length = hugeLength;
+    }
+#endif
+
+    if( result == MAP_FAILED )
+    {
+        result = mmap( NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if( result == MAP_FAILED )
+            return NULL;
+
+#ifdef MADV_HUGEPAGE
+        /* ask for transparent huge pages instead, before the pages are faulted in */
+        if( (flags & paUtilRegionHugePages) && length >= PA_HUGE_PAGE_SIZE_ )
+            madvise( result, length, MADV_HUGEPAGE );
+#endif
+    }
+
+    if( flags & paUtilRegionPrefault )
+    {
+        for( i = 0; i < length; i += pageSize )
+            ((volatile char *)result)[i] = 0;
+    }
+
+    if( allocator_ != NULL && (allocator_->flags & paRealTimeAllocator) && mlock( result, length ) != 0 )
+    {
+        PA_DEBUG(( "%s: mlock failed (%s), region is not locked\n", __FUNCTION__, strerror( errno ) ));
+    }
+
+#if PA_TRACK_MEMORY
+    numAllocations_ += 1;
+#endif
+    *size = length;
+    return result;
+}
+
+
+void PaUtil_FreeRegion( void *region, long size )
+{
+    if( region != NULL )
+    {
+        munmap( region, size );
+#if PA_TRACK_MEMORY
+        numAllocations_ -= 1;
+#endif
+    }
+}
+
+
 void Pa_Sleep( long msec )
 {
-#ifdef HAVE_NANOSLEEP
+#if defined(HAVE_CLOCK_NANOSLEEP) && defined(HAVE_CLOCK_GETTIME)
+    /* Sleep until an absolute deadline on the monotonic clock, so that
+       neither wall clock steps nor signals change how long we sleep. */
+    struct timespec deadline;
+    clock_gettime( CLOCK_MONOTONIC, &deadline );
+    deadline.tv_sec += msec / 1000;
+    deadline.tv_nsec += (msec % 1000) * 1000000L;
+    if( deadline.tv_nsec >= 1000000000L )
+    {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL ) == EINTR )
+        ;
+#elif defined(HAVE_NANOSLEEP)
     struct timespec req = {0}, rem = {0};
     PaTime time = msec / 1.e3;
     req.tv_sec = (time_t)time;
@@ -141,6 +331,71 @@ void Pa_Sleep( long msec )
 
 /* Scaler to convert the result of mach_absolute_time to seconds */
 static double machSecondsConversionScaler_ = 0.0;
+static mach_timebase_info_data_t machTimebase_ = { 1, 1 };
+
+#elif defined(HAVE_CLOCK_GETTIME)
+/*
+    The clock PaUtil_GetTime() reads. CLOCK_MONOTONIC is the default: it never
+    steps when the wall clock is set, and on Linux it is read through the vDSO
+    without entering the kernel. It is slewed by NTP, so it runs at real time.
+
+    The PA_UNIX_CLOCK environment variable, read by PaUtil_InitializeClock(),
+    selects something else:
+      "monotonic_raw" - the unslewed hardware clock (vDSO from Linux 5.3 on).
+      "tsc"           - x86 only, with an invariant TSC: the cycle counter,
+                        calibrated against CLOCK_MONOTONIC once and reported
+                        on its timebase. Falls back to CLOCK_MONOTONIC if the
+                        TSC is not invariant.
+*/
+static clockid_t paUnixClockId_ = CLOCK_MONOTONIC;
+
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+#define PA_HAVE_TSC_CLOCK
+#include <cpuid.h>
+#include <x86intrin.h>
+
+static int useTsc_ = 0;
+static PaUint64 tscBase_;
+static PaInt64 tscBaseNanos_;
+static double tscNanosPerTick_;
+
+static PaInt64 TimespecToNanoseconds( const struct timespec *tp )
+{
+    return (PaInt64)tp->tv_sec * 1000000000 + tp->tv_nsec;
+}
+
+static int InitializeTscClock( void )
+{
+    unsigned int eax, ebx, ecx, edx;
+    struct timespec tp, sleepTime = { 0, 10000000 }; /* 10ms */
+    PaInt64 nanos0, nanos1;
+    PaUint64 tsc0, tsc1;
+
+    /* CPUID.80000007H:EDX[8] says the TSC ticks at a constant rate in all
+       P-, C- and T-states, which is what makes it usable as a clock. */
+    if( !__get_cpuid( 0x80000000, &eax, &ebx, &ecx, &edx ) || eax < 0x80000007 )
+        return 0;
+    __get_cpuid( 0x80000007, &eax, &ebx, &ecx, &edx );
+    if( !(edx & (1 << 8)) )
+        return 0;
+
+    clock_gettime( CLOCK_MONOTONIC, &tp );
+    tsc0 = __rdtsc();
+    nanos0 = TimespecToNanoseconds( &tp );
+    nanosleep( &sleepTime, NULL );
+    clock_gettime( CLOCK_MONOTONIC, &tp );
+    tsc1 = __rdtsc();
+    nanos1 = TimespecToNanoseconds( &tp );
+
+    if( tsc1 <= tsc0 )
+        return 0;
+
+    tscNanosPerTick_ = (double)(nanos1 - nanos0) / (double)(tsc1 - tsc0);
+    tscBase_ = tsc1;
+    tscBaseNanos_ = nanos1;
+    return 1;
+}
+#endif /* PA_HAVE_TSC_CLOCK */
 #endif
 
 void PaUtil_InitializeClock( void )
@@ -149,7 +404,26 @@ void PaUtil_InitializeClock( void )
     mach_timebase_info_data_t info;
     kern_return_t err = mach_timebase_info( &info );
     if( err == 0  )
+    {
         machSecondsConversionScaler_ = 1e-9 * (double) info.numer / (double) info.denom;
+        machTimebase_ = info;
+    }
+#elif defined(HAVE_CLOCK_GETTIME)
+    const char *clockName = getenv( "PA_UNIX_CLOCK" );
+    struct timespec tp;
+
+    paUnixClockId_ = CLOCK_MONOTONIC;
+#ifdef CLOCK_MONOTONIC_RAW
+    if( clockName && strcmp( clockName, "monotonic_raw" ) == 0
+            && clock_gettime( CLOCK_MONOTONIC_RAW, &tp ) == 0 )
+        paUnixClockId_ = CLOCK_MONOTONIC_RAW;
+#endif
+#ifdef PA_HAVE_TSC_CLOCK
+    useTsc_ = clockName && strcmp( clockName, "tsc" ) == 0 && InitializeTscClock();
+#endif
+    if( clock_gettime( paUnixClockId_, &tp ) != 0 )
+        paUnixClockId_ = CLOCK_REALTIME; /* should not happen on any system we support */
+    PA_DEBUG(( "%s: using clock %s\n", __FUNCTION__, clockName ? clockName : "monotonic" ));
 #endif
 }
 
@@ -160,7 +434,11 @@ PaTime PaUtil_GetTime( void )
     return mach_absolute_time() * machSecondsConversionScaler_;
 #elif defined(HAVE_CLOCK_GETTIME)
     struct timespec tp;
-    clock_gettime(CLOCK_REALTIME, &tp);
+#ifdef PA_HAVE_TSC_CLOCK
+    if( useTsc_ )
+        return PaUtil_GetTimeNanoseconds() * 1e-9;
+#endif
+    clock_gettime( paUnixClockId_, &tp );
     return (PaTime)(tp.tv_sec + tp.tv_nsec * 1e-9);
 #else
     struct timeval tv;
@@ -169,6 +447,37 @@ PaTime PaUtil_GetTime( void )
 #endif
 }
 
+
+PaInt64 PaUtil_GetTimeNanoseconds( void )
+{
+#ifdef HAVE_MACH_ABSOLUTE_TIME
+    PaUint64 ticks = mach_absolute_time();
+    /* split the multiply so it does not overflow for large tick counts */
+    return (PaInt64)((ticks / machTimebase_.denom) * machTimebase_.numer
+            + (ticks % machTimebase_.denom) * machTimebase_.numer / machTimebase_.denom);
+#elif defined(HAVE_CLOCK_GETTIME)
+    struct timespec tp;
+#ifdef PA_HAVE_TSC_CLOCK
+    if( useTsc_ )
+        return tscBaseNanos_ + (PaInt64)((PaInt64)(__rdtsc() - tscBase_) * tscNanosPerTick_);
+#endif
+    clock_gettime( paUnixClockId_, &tp );
+    return (PaInt64)tp.tv_sec * 1000000000 + tp.tv_nsec;
+#else
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return (PaInt64)tv.tv_sec * 1000000000 + (PaInt64)tv.tv_usec * 1000;
+#endif
+}
+
+
+#if defined(HAVE_CLOCK_GETTIME) && !defined(HAVE_MACH_ABSOLUTE_TIME)
+clockid_t PaUnixClock_GetClockId( void )
+{
+    return paUnixClockId_;
+}
+#endif
+
 PaError PaUtil_InitializeThreading( PaUtilThreading *threading )
 {
     (void) paUtilErr_;
@@ -179,10 +488,10 @@ void PaUtil_TerminateThreading( PaUtilThreading *threading )
 {
 }
 
-PaError PaUtil_StartThreading( PaUtilThreading *threading, void *(*threadRoutine)(void *), void *data )
+PaError PaUtil_StartThreading( PaUtilThreading *threading, void *(*threadRoutine)(void *), void *data,
+        const PaThreadPolicy *policy, PaTime period )
 {
-    pthread_create( &threading->callbackThread, NULL, threadRoutine, data );
-    return paNoError;
+    return PaUnixThread_Spawn( &threading->callbackThread, NULL, threadRoutine, data, policy, period );
 }
 
 PaError PaUtil_CancelThreading( PaUtilThreading *threading, int wait, PaError *exitResult )
@@ -265,8 +574,234 @@ error:
     return result;
 }
 
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+/* The kernel's struct sched_attr, which not every libc declares */
+typedef struct
+{
+    uint32_t size;
+    uint32_t schedPolicy;
+    uint64_t schedFlags;
+    int32_t schedNice;
+    uint32_t schedPriority;
+    uint64_t schedRuntime;
+    uint64_t schedDeadline;
+    uint64_t schedPeriod;
+} PaUnixSchedAttr;
+
+/* Pin the calling thread to the policy's CPUs, returns an errno value */
+static int SetThreadAffinity( const PaThreadPolicy *policy )
+{
+#if defined(__linux__) && defined(SYS_sched_setaffinity)
+    unsigned long mask[1024 / (8 * sizeof (unsigned long))];
+    const int bitsPerWord = 8 * sizeof (unsigned long);
+    int i;
+
+    memset( mask, 0, sizeof (mask) );
+    for( i = 0; i < policy->cpuCount; ++i )
+    {
+        if( policy->cpus[i] >= (int)(8 * sizeof (mask)) )
+            return EINVAL;
+        mask[policy->cpus[i] / bitsPerWord] |= 1UL << (policy->cpus[i] % bitsPerWord);
+    }
+    return syscall( SYS_sched_setaffinity, 0, sizeof (mask), mask ) == 0 ? 0 : errno;
+#else
+    (void) policy;
+    return ENOSYS;
+#endif
+}
+
+/* Run the calling thread under SCHED_DEADLINE, with the buffer period as period and deadline, returns an errno value */
+static int SetThreadDeadline( const PaThreadPolicy *policy, PaTime period )
+{
+#if defined(__linux__) && defined(SYS_sched_setattr)
+    PaUnixSchedAttr attr;
+    const double fraction = policy->runtimeFraction > 0. ? policy->runtimeFraction : .5;
+
+    if( period <= 0. )
+        return EINVAL;
+
+    memset( &attr, 0, sizeof (attr) );
+    attr.size = sizeof (attr);
+    attr.schedPolicy = SCHED_DEADLINE;
+    attr.schedPeriod = attr.schedDeadline = (uint64_t)(period * 1e9);
+    attr.schedRuntime = (uint64_t)(period * fraction * 1e9);
+    return syscall( SYS_sched_setattr, 0, &attr, 0 ) == 0 ? 0 : errno;
+#else
+    (void) policy;
+    (void) period;
+    return ENOSYS;
+#endif
+}
+
+/* Run the calling thread under SCHED_FIFO or SCHED_RR, at a lower priority if RLIMIT_RTPRIO demands it and fallback
+ * is allowed, returns an errno value */
+static int SetThreadRealtime( const PaThreadPolicy *policy, int rtPolicy, int fallback )
+{
+    struct sched_param spm = { 0 };
+    int err;
+
+    spm.sched_priority = policy->priority ? policy->priority
+        : (sched_get_priority_min( rtPolicy ) + sched_get_priority_max( rtPolicy )) / 2;
+    err = pthread_setschedparam( pthread_self(), rtPolicy, &spm );
+
+#ifdef RLIMIT_RTPRIO
+    if( err == EPERM && fallback )
+    {
+        struct rlimit limit;
+        if( !getrlimit( RLIMIT_RTPRIO, &limit ) && limit.rlim_cur > 0
+                && limit.rlim_cur < (rlim_t)spm.sched_priority )
+        {
+            PA_DEBUG(( "%s: Lowering priority to RLIMIT_RTPRIO (%d)\n", __FUNCTION__, (int)limit.rlim_cur ));
+            spm.sched_priority = (int)limit.rlim_cur;
+            err = pthread_setschedparam( pthread_self(), rtPolicy, &spm );
+        }
+    }
+#else
+    (void) fallback;
+#endif
+
+    return err;
+}
+
+/* Without any real-time priority, run the calling thread at the lowest nice value permitted */
+static void RaiseThreadNice( void )
+{
+#if defined(__linux__) && defined(SYS_gettid)
+    const int tid = (int)syscall( SYS_gettid );
+    struct rlimit limit;
+
+    if( setpriority( PRIO_PROCESS, tid, -20 ) == 0 )
+        return;
+    /* RLIMIT_NICE allows nice values down to 20 - the limit */
+    if( !getrlimit( RLIMIT_NICE, &limit ) && limit.rlim_cur > 0 && limit.rlim_cur < 40 )
+    {
+        const int nice = 20 - (int)limit.rlim_cur;
+        if( nice < getpriority( PRIO_PROCESS, tid ) && setpriority( PRIO_PROCESS, tid, nice ) == 0 )
+        {
+            PA_DEBUG(( "%s: Running at nice %d\n", __FUNCTION__, nice ));
+        }
+    }
+#endif
+}
+
+/* Apply a thread policy to the calling thread */
+static PaError ApplyThreadPolicy( const PaThreadPolicy *policy, PaTime period )
+{
+    const int fallback = 0 != (policy->flags & paThreadPolicyFallback);
+    PaThreadSchedulingPolicy schedPolicy = policy->policy;
+    int err;
+
+    if( policy->cpuCount > 0 && (err = SetThreadAffinity( policy )) )
+    {
+        PA_DEBUG(( "%s: Couldn't set CPU affinity: %s\n", __FUNCTION__, strerror( err ) ));
+        if( !fallback )
+            return paThreadPolicyFailed;
+    }
+
+    /* a pinned thread can't have SCHED_DEADLINE, Pa_SetStreamThreadPolicy only lets that through with fallback */
+    if( schedPolicy == paSchedulingDeadline && policy->cpuCount > 0 )
+        schedPolicy = paSchedulingFifo;
+
+    if( schedPolicy == paSchedulingDeadline )
+    {
+        if( !(err = SetThreadDeadline( policy, period )) )
+            return paNoError;
+        PA_DEBUG(( "%s: Couldn't set SCHED_DEADLINE: %s\n", __FUNCTION__, strerror( err ) ));
+        if( !fallback )
+            return paThreadPolicyFailed;
+        schedPolicy = paSchedulingFifo;
+    }
+
+    if( schedPolicy == paSchedulingFifo || schedPolicy == paSchedulingRoundRobin )
+    {
+        if( !(err = SetThreadRealtime( policy, schedPolicy == paSchedulingFifo ? SCHED_FIFO : SCHED_RR, fallback )) )
+            return paNoError;
+        PA_DEBUG(( "%s: Couldn't set real-time priority: %s\n", __FUNCTION__, strerror( err ) ));
+        if( !fallback )
+            return paThreadPolicyFailed;
+        RaiseThreadNice();
+    }
+
+    return paNoError;
+}
+
+typedef struct
+{
+    void *(*threadFunc)( void* );
+    void *threadArg;
+    const PaThreadPolicy *policy;
+    PaTime period;
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+    int applied;
+    PaError result;
+} PaUnixThreadStart;
+
+static void *PolicyThreadFunc( void *arg )
+{
+    PaUnixThreadStart *start = (PaUnixThreadStart *)arg;
+    void *(*threadFunc)( void* ) = start->threadFunc;
+    void *threadArg = start->threadArg;
+    PaError result = ApplyThreadPolicy( start->policy, start->period );
+
+    pthread_mutex_lock( &start->mtx );
+    start->result = result;
+    start->applied = 1;
+    pthread_cond_signal( &start->cond );
+    pthread_mutex_unlock( &start->mtx );
+    /* The spawning thread owns start again */
+
+    return result == paNoError ? threadFunc( threadArg ) : NULL;
+}
+
+PaError PaUnixThread_Spawn( pthread_t *thread, const pthread_attr_t *attr, void *(*threadFunc)( void* ),
+        void *threadArg, const PaThreadPolicy *policy, PaTime period )
+{
+    PaError result = paNoError;
+    PaUnixThreadStart start;
+
+    if( !policy || (policy->policy == paSchedulingDefault && policy->cpuCount == 0) )
+    {
+        PA_UNLESS( !pthread_create( thread, attr, threadFunc, threadArg ), paInternalError );
+        return result;
+    }
+
+    start.threadFunc = threadFunc;
+    start.threadArg = threadArg;
+    start.policy = policy;
+    start.period = period;
+    start.applied = 0;
+    start.result = paNoError;
+    PA_ENSURE_SYSTEM( pthread_mutex_init( &start.mtx, NULL ), 0 );
+    PA_ENSURE_SYSTEM( pthread_cond_init( &start.cond, NULL ), 0 );
+
+    if( pthread_create( thread, attr, PolicyThreadFunc, &start ) != 0 )
+    {
+        result = paInternalError;
+    }
+    else
+    {
+        pthread_mutex_lock( &start.mtx );
+        while( !start.applied )
+            pthread_cond_wait( &start.cond, &start.mtx );
+        pthread_mutex_unlock( &start.mtx );
+
+        if( (result = start.result) != paNoError )
+            pthread_join( *thread, NULL );
+    }
+
+    pthread_cond_destroy( &start.cond );
+    pthread_mutex_destroy( &start.mtx );
+
+error:
+    return result;
+}
+
 PaError PaUnixThread_New( PaUnixThread* self, void* (*threadFunc)( void* ), void* threadArg, PaTime waitForChild,
-        int rtSched )
+        int rtSched, const PaThreadPolicy *policy, PaTime period )
 {
     PaError result = paNoError;
     pthread_attr_t attr;
@@ -274,7 +809,7 @@ PaError PaUnixThread_New( PaUnixThread* self, void* (*threadFunc)( void* ), void
 
     memset( self, 0, sizeof (PaUnixThread) );
     PaUnixMutex_Initialize( &self->mtx );
-    PA_ASSERT_CALL( pthread_cond_init( &self->cond, NULL ), 0 );
+    PA_ENSURE( PaUnixCondition_Initialize( &self->cond ) );
 
     self->parentWaiting = 0 != waitForChild;
 
@@ -302,10 +837,11 @@ PaError PaUnixThread_New( PaUnixThread* self, void* (*threadFunc)( void* ), void
     /* Priority relative to other processes */
     PA_UNLESS( !pthread_attr_setscope( &attr, PTHREAD_SCOPE_SYSTEM ), paInternalError );
 
-    PA_UNLESS( !pthread_create( &self->thread, &attr, threadFunc, threadArg ), paInternalError );
+    PA_ENSURE( PaUnixThread_Spawn( &self->thread, &attr, threadFunc, threadArg, policy, period ) );
     started = 1;
 
-    if( rtSched )
+    /* An explicit scheduling policy replaces the priority boost */
+    if( rtSched && (!policy || policy->policy == paSchedulingDefault) )
     {
 #if 0
         if( self->useWatchdog )
@@ -353,23 +889,18 @@ PaError PaUnixThread_New( PaUnixThread* self, void* (*threadFunc)( void* ), void
 
     if( self->parentWaiting )
     {
-        PaTime till;
         struct timespec ts;
         int res = 0;
-        PaTime now;
 
         PA_ENSURE( PaUnixMutex_Lock( &self->mtx ) );
 
         /* Wait for stream to be started */
-        now = PaUtil_GetTime();
-        till = now + waitForChild;
+        PaUnixCondition_GetDeadline( waitForChild, &ts );
 
         while( self->parentWaiting && !res )
         {
             if( waitForChild > 0 )
             {
-                ts.tv_sec = (time_t) floor( till );
-                ts.tv_nsec = (long) ((till - floor( till )) * 1e9);
                 res = pthread_cond_timedwait( &self->cond, &self->mtx.mtx, &ts );
             }
             else
@@ -511,6 +1042,47 @@ PaError PaUnixMutex_Terminate( PaUnixMutex* self )
     return result;
 }
 
+#if defined(HAVE_CLOCK_GETTIME) && !defined(HAVE_MACH_ABSOLUTE_TIME) && defined(_POSIX_MONOTONIC_CLOCK)
+#define PA_CONDITION_CLOCK CLOCK_MONOTONIC
+#endif
+
+PaError PaUnixCondition_Initialize( pthread_cond_t* cond )
+{
+    PaError result = paNoError;
+#ifdef PA_CONDITION_CLOCK
+    pthread_condattr_t attr;
+    PA_ENSURE_SYSTEM( pthread_condattr_init( &attr ), 0 );
+    PA_ENSURE_SYSTEM( pthread_condattr_setclock( &attr, PA_CONDITION_CLOCK ), 0 );
+    PA_ENSURE_SYSTEM( pthread_cond_init( cond, &attr ), 0 );
+    pthread_condattr_destroy( &attr );
+#else
+    PA_ENSURE_SYSTEM( pthread_cond_init( cond, NULL ), 0 );
+#endif
+
+error:
+    return result;
+}
+
+void PaUnixCondition_GetDeadline( PaTime seconds, struct timespec* deadline )
+{
+    PaTime whole = floor( seconds );
+#ifdef PA_CONDITION_CLOCK
+    clock_gettime( PA_CONDITION_CLOCK, deadline );
+#else
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    deadline->tv_sec = tv.tv_sec;
+    deadline->tv_nsec = tv.tv_usec * 1000;
+#endif
+    deadline->tv_sec += (time_t)whole;
+    deadline->tv_nsec += (long)((seconds - whole) * 1e9);
+    if( deadline->tv_nsec >= 1000000000L )
+    {
+        deadline->tv_sec += 1;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
 /** Lock mutex.
  *
  * We're disabling thread cancellation while the thread is holding a lock, so mutexes are
@@ -549,6 +1121,305 @@ error:
 }
 
 
+/* Probe pool
+ *
+ * The pool is shared between PaUnix_RunProbes and its threads and reference counted, since a thread whose probe
+ * timed out outlives the call that started it. The tracker outlives every pool that refers to it.
+ */
+
+struct PaUnixProbeTracker
+{
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+    int numAbandoned;   /* Abandoned probes whose job has not been released yet */
+    int refCount;
+};
+
+PaError PaUnixProbeTracker_New( PaUnixProbeTracker **tracker )
+{
+    PaError result = paNoError;
+    PaUnixProbeTracker *t;
+
+    PA_UNLESS( t = (PaUnixProbeTracker *)PaUtil_AllocateMemory( sizeof (PaUnixProbeTracker) ), paInsufficientMemory );
+    if( pthread_mutex_init( &t->mtx, NULL ) != 0 )
+    {
+        PaUtil_FreeMemory( t );
+        PA_ENSURE( paInternalError );
+    }
+    if( ( result = PaUnixCondition_Initialize( &t->cond ) ) != paNoError )
+    {
+        pthread_mutex_destroy( &t->mtx );
+        PaUtil_FreeMemory( t );
+        goto error;
+    }
+    t->numAbandoned = 0;
+    t->refCount = 1;
+    *tracker = t;
+
+error:
+    return result;
+}
+
+int PaUnixProbeTracker_WaitForAbandoned( PaUnixProbeTracker *tracker, PaTime timeout )
+{
+    struct timespec deadline;
+    int numAbandoned;
+
+    PaUnixCondition_GetDeadline( timeout, &deadline );
+    pthread_mutex_lock( &tracker->mtx );
+    while( tracker->numAbandoned > 0
+            && pthread_cond_timedwait( &tracker->cond, &tracker->mtx, &deadline ) != ETIMEDOUT )
+        ;
+    numAbandoned = tracker->numAbandoned;
+    pthread_mutex_unlock( &tracker->mtx );
+
+    return numAbandoned;
+}
+
+void PaUnixProbeTracker_Release( PaUnixProbeTracker *tracker )
+{
+    int last;
+
+    pthread_mutex_lock( &tracker->mtx );
+    last = --tracker->refCount == 0;
+    pthread_mutex_unlock( &tracker->mtx );
+    if( last )
+    {
+        pthread_cond_destroy( &tracker->cond );
+        pthread_mutex_destroy( &tracker->mtx );
+        PaUtil_FreeMemory( tracker );
+    }
+}
+
+typedef enum
+{
+    ProbePending,
+    ProbeRunning,
+    ProbeFinished,
+    ProbeAbandoned
+} PaUnixProbeState;
+
+typedef struct
+{
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+    void (*probe)( void *job );
+    void (*release)( void *job );
+    PaTime timeout;
+    int numJobs;
+    int nextJob;
+    int numWorkers;     /* Threads that will still pick up pending jobs */
+    int refCount;
+    PaUnixProbeTracker *tracker;
+    void **jobs;
+    PaUnixProbeState *states;
+    PaTime *deadlines;
+} PaUnixProbePool;
+
+/* Drop a reference to the pool, whose mutex must be held, and free it once nobody uses it. */
+static void ReleaseProbePool( PaUnixProbePool *pool )
+{
+    int last = --pool->refCount == 0;
+
+    pthread_mutex_unlock( &pool->mtx );
+    if( last )
+    {
+        if( pool->tracker )
+            PaUnixProbeTracker_Release( pool->tracker );
+        pthread_cond_destroy( &pool->cond );
+        pthread_mutex_destroy( &pool->mtx );
+        PaUtil_FreeMemory( pool );
+    }
+}
+
+static void *ProbeThreadFunc( void *data )
+{
+    PaUnixProbePool *pool = (PaUnixProbePool *)data;
+    int job, abandoned = 0;
+
+    pthread_mutex_lock( &pool->mtx );
+    while( pool->nextJob < pool->numJobs )
+    {
+        job = pool->nextJob++;
+        pool->states[job] = ProbeRunning;
+        pool->deadlines[job] = PaUtil_GetTime() + pool->timeout;
+        pthread_mutex_unlock( &pool->mtx );
+
+        pool->probe( pool->jobs[job] );
+
+        pthread_mutex_lock( &pool->mtx );
+        if( ProbeAbandoned == pool->states[job] )
+        {
+            /* The caller has given up on this job and started another thread in our place */
+            pthread_mutex_unlock( &pool->mtx );
+            pool->release( pool->jobs[job] );
+            if( pool->tracker )
+            {
+                pthread_mutex_lock( &pool->tracker->mtx );
+                if( --pool->tracker->numAbandoned == 0 )
+                    pthread_cond_broadcast( &pool->tracker->cond );
+                pthread_mutex_unlock( &pool->tracker->mtx );
+            }
+            pthread_mutex_lock( &pool->mtx );
+            abandoned = 1;
+            break;
+        }
+        pool->states[job] = ProbeFinished;
+        pthread_cond_signal( &pool->cond );
+    }
+    if( !abandoned )
+        --pool->numWorkers;
+    ReleaseProbePool( pool );
+
+    return NULL;
+}
+
+/* Start a detached probe thread, the pool's mutex must be held. Returns 0 on failure. */
+static int StartProbeThread( PaUnixProbePool *pool )
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    int res;
+
+    if( pthread_attr_init( &attr ) != 0 )
+        return 0;
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    res = pthread_create( &thread, &attr, ProbeThreadFunc, pool );
+    pthread_attr_destroy( &attr );
+    if( res != 0 )
+    {
+        PA_DEBUG(( "%s: Failed starting probe thread: %s\n", __FUNCTION__, strerror( res ) ));
+        return 0;
+    }
+
+    ++pool->numWorkers;
+    ++pool->refCount;
+    return 1;
+}
+
+PaError PaUnix_RunProbes( void **jobs, int numJobs, void (*probe)( void *job ), void (*release)( void *job ),
+        int numThreads, PaTime timeout, PaUnixProbeTracker *tracker, int *finished )
+{
+    PaError result = paNoError;
+    PaUnixProbePool *pool = NULL;
+    int i, unfinished;
+    char *block;
+
+    if( numThreads < 1 || numJobs < 1 )
+    {
+        for( i = 0; i < numJobs; ++i )
+        {
+            probe( jobs[i] );
+            finished[i] = 1;
+        }
+        return result;
+    }
+
+    PA_UNLESS( block = (char *)PaUtil_AllocateMemory( sizeof (PaUnixProbePool) + numJobs * ( sizeof (void *) +
+                    sizeof (PaUnixProbeState) + sizeof (PaTime) ) ), paInsufficientMemory );
+    pool = (PaUnixProbePool *)block;
+    memset( pool, 0, sizeof (PaUnixProbePool) );
+    pool->deadlines = (PaTime *)( block + sizeof (PaUnixProbePool) );
+    pool->jobs = (void **)( pool->deadlines + numJobs );
+    pool->states = (PaUnixProbeState *)( pool->jobs + numJobs );
+    for( i = 0; i < numJobs; ++i )
+    {
+        pool->jobs[i] = jobs[i];
+        pool->states[i] = ProbePending;
+    }
+    pool->probe = probe;
+    pool->release = release;
+    pool->timeout = timeout;
+    pool->numJobs = numJobs;
+    pool->refCount = 1;
+    pool->tracker = NULL;
+
+    if( pthread_mutex_init( &pool->mtx, NULL ) != 0 )
+    {
+        PaUtil_FreeMemory( pool );
+        PA_ENSURE( paInternalError );
+    }
+    if( ( result = PaUnixCondition_Initialize( &pool->cond ) ) != paNoError )
+    {
+        pthread_mutex_destroy( &pool->mtx );
+        PaUtil_FreeMemory( pool );
+        goto error;
+    }
+    if( tracker )
+    {
+        pthread_mutex_lock( &tracker->mtx );
+        ++tracker->refCount;
+        pthread_mutex_unlock( &tracker->mtx );
+        pool->tracker = tracker;
+    }
+
+    pthread_mutex_lock( &pool->mtx );
+    for( i = 0; i < PA_MIN( numThreads, numJobs ); ++i )
+    {
+        if( !StartProbeThread( pool ) )
+            break;
+    }
+
+    for( ;; )
+    {
+        PaTime now = PaUtil_GetTime(), nextDeadline = -1.;
+
+        unfinished = 0;
+        for( i = 0; i < numJobs; ++i )
+        {
+            if( ProbeRunning == pool->states[i] && pool->deadlines[i] <= now )
+            {
+                PA_DEBUG(( "%s: Probe %d timed out after %g seconds, abandoning it\n", __FUNCTION__, i, timeout ));
+                pool->states[i] = ProbeAbandoned;
+                --pool->numWorkers;
+                if( tracker )
+                {
+                    pthread_mutex_lock( &tracker->mtx );
+                    ++tracker->numAbandoned;
+                    pthread_mutex_unlock( &tracker->mtx );
+                }
+            }
+            if( ProbeRunning == pool->states[i] && ( nextDeadline < 0. || pool->deadlines[i] < nextDeadline ) )
+                nextDeadline = pool->deadlines[i];
+            unfinished += ProbePending == pool->states[i] || ProbeRunning == pool->states[i];
+        }
+        if( !unfinished )
+            break;
+
+        /* Keep pending jobs moving, replacing threads lost to hung probes */
+        while( pool->numWorkers < PA_MIN( numThreads, pool->numJobs - pool->nextJob ) && StartProbeThread( pool ) )
+            ;
+        if( 0 == pool->numWorkers && pool->nextJob < numJobs )
+        {
+            /* No thread to run it on, fall back to probing here */
+            i = pool->nextJob++;
+            pthread_mutex_unlock( &pool->mtx );
+            probe( jobs[i] );
+            pthread_mutex_lock( &pool->mtx );
+            pool->states[i] = ProbeFinished;
+            continue;
+        }
+
+        if( nextDeadline >= 0. )
+        {
+            struct timespec deadline;
+
+            PaUnixCondition_GetDeadline( nextDeadline - now, &deadline );
+            pthread_cond_timedwait( &pool->cond, &pool->mtx, &deadline );
+        }
+        else
+            pthread_cond_wait( &pool->cond, &pool->mtx );
+    }
+
+    for( i = 0; i < numJobs; ++i )
+        finished[i] = ProbeFinished == pool->states[i];
+    ReleaseProbePool( pool );
+
+error:
+    return result;
+}
+
+
 #if 0
 static void OnWatchdogExit( void *userData )
 {
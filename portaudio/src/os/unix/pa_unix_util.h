@@ -48,6 +48,7 @@
 #include <assert.h>
 #include <pthread.h>
 #include <signal.h>
+#include <time.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -109,13 +110,22 @@ static PaError paUtilErr_;          /* Used with PA_ENSURE */
         } \
     } while( 0 );
 
+#if defined(HAVE_CLOCK_GETTIME) && !defined(__APPLE__)
+/** The POSIX clock whose timebase PaUtil_GetTime() reports on, chosen by
+ PaUtil_InitializeClock(). Host APIs use it to request device timestamps on
+ the same clock, so stream times and PaUtil_GetTime() can be compared. */
+clockid_t PaUnixClock_GetClockId( void );
+#endif
+
 typedef struct {
     pthread_t callbackThread;
 } PaUtilThreading;
 
 PaError PaUtil_InitializeThreading( PaUtilThreading *threading );
 void PaUtil_TerminateThreading( PaUtilThreading *threading );
-PaError PaUtil_StartThreading( PaUtilThreading *threading, void *(*threadRoutine)(void *), void *data );
+/** Start the callback thread, see PaUnixThread_Spawn for policy and period. */
+PaError PaUtil_StartThreading( PaUtilThreading *threading, void *(*threadRoutine)(void *), void *data,
+        const PaThreadPolicy *policy, PaTime period );
 PaError PaUtil_CancelThreading( PaUtilThreading *threading, int wait, PaError *exitResult );
 
 /* State accessed by utility functions */
@@ -144,6 +154,56 @@ PaError PaUnixMutex_Terminate( PaUnixMutex* self );
 PaError PaUnixMutex_Lock( PaUnixMutex* self );
 PaError PaUnixMutex_Unlock( PaUnixMutex* self );
 
+/** Initialize a condition variable whose timed waits are measured on a monotonic clock where
+ * available, so wall clock steps do not shorten or stretch them. Compute the deadlines for
+ * pthread_cond_timedwait() on it with PaUnixCondition_GetDeadline().
+ */
+PaError PaUnixCondition_Initialize( pthread_cond_t* cond );
+
+/** Fill in the absolute deadline seconds from now, on the clock used by conditions initialized
+ * with PaUnixCondition_Initialize().
+ */
+void PaUnixCondition_GetDeadline( PaTime seconds, struct timespec* deadline );
+
+/** Default number of threads and per-device timeout, in seconds, for probing devices with PaUnix_RunProbes.
+ */
+#define PA_UNIX_PROBE_THREADS 8
+#define PA_UNIX_PROBE_TIMEOUT 2.
+
+/** Counts the probes abandoned by PaUnix_RunProbes that are still running.
+ *
+ * An abandoned probe is still inside whatever library it was calling into, so whoever owns that library must not
+ * unload it or free its global state while the count is nonzero. The tracker is reference counted, since an abandoned
+ * probe may well outlive its owner.
+ */
+typedef struct PaUnixProbeTracker PaUnixProbeTracker;
+
+PaError PaUnixProbeTracker_New( PaUnixProbeTracker **tracker );
+
+/** Wait for up to timeout seconds for the abandoned probes to return.
+ * @return The number of abandoned probes still running.
+ */
+int PaUnixProbeTracker_WaitForAbandoned( PaUnixProbeTracker *tracker, PaTime timeout );
+
+/** Drop the owner's reference, the tracker is freed once no abandoned probe refers to it either.
+ */
+void PaUnixProbeTracker_Release( PaUnixProbeTracker *tracker );
+
+/** Run probe( jobs[i] ) for each job on a bounded pool of threads.
+ *
+ * Intended for device enumeration, where each probe may block on a slow or busy device. Returns once every job has
+ * either finished or run for longer than timeout seconds. The results of finished jobs can be merged in whatever
+ * order the caller likes, which keeps device indices independent of probe timing. A job that timed out is abandoned to
+ * its thread, which hands it to release if its probe ever returns; the caller must not touch it again.
+ * @param numThreads: The maximum number of probes to run concurrently. Less than 1 means probe on the calling thread,
+ * without a timeout.
+ * @param tracker: Counts the abandoned jobs until release has returned for them, may be NULL. See
+ * PaUnixProbeTracker.
+ * @param finished: Receives nonzero for each job that finished.
+ */
+PaError PaUnix_RunProbes( void **jobs, int numJobs, void (*probe)( void *job ), void (*release)( void *job ),
+        int numThreads, PaTime timeout, PaUnixProbeTracker *tracker, int *finished );
+
 typedef struct
 {
     pthread_t thread;
@@ -179,6 +239,18 @@ PaError PaUnixThreading_Initialize( void );
         pthread_exit( pres ); \
     } while (0);
 
+/** Create a thread that applies a stream's thread policy to itself before it calls threadFunc.
+ *
+ * Doesn't return before the policy is applied, so the thread never runs threadFunc under any other policy. If the
+ * policy can't be applied and allows no fallback, threadFunc isn't called, the thread is joined and
+ * paThreadPolicyFailed returned.
+ * @param attr: Attributes to create the thread with, may be NULL.
+ * @param policy: The policy, NULL or one with paSchedulingDefault and no CPUs to leave the thread as created.
+ * @param period: The stream's buffer period in seconds, the period and deadline under SCHED_DEADLINE.
+ */
+PaError PaUnixThread_Spawn( pthread_t *thread, const pthread_attr_t *attr, void *(*threadFunc)( void* ),
+        void *threadArg, const PaThreadPolicy *policy, PaTime period );
+
 /** Spawn a thread.
  *
  * Intended for spawning the callback thread from the main thread. This function can even block (for a certain
@@ -187,11 +259,13 @@ PaError PaUnixThreading_Initialize( void );
  * @param threadFunc: The function to be executed in the child thread.
  * @param waitForChild: If not 0, wait for child thread to call PaUnixThread_NotifyParent. Less than 0 means
  * wait for ever, greater than 0 wait for the specified time.
- * @param rtSched: Enable realtime scheduling?
+ * @param rtSched: Enable realtime scheduling? Ignored if policy has a scheduling policy of its own.
+ * @param policy: The stream's thread policy, may be NULL, see PaUnixThread_Spawn.
+ * @param period: The stream's buffer period in seconds.
  * @return: If timed out waiting on child, paTimedOut.
  */
 PaError PaUnixThread_New( PaUnixThread* self, void* (*threadFunc)( void* ), void* threadArg, PaTime waitForChild,
-        int rtSched );
+        int rtSched, const PaThreadPolicy *policy, PaTime period );
 
 /** Terminate thread.
  *
@@ -99,4 +99,34 @@ PaUtilHostApiInitializer *paHostApiInitializers[] =
         0   /* NULL terminated array */
     };
 
+const PaHostApiTypeId paHostApiInitializerTypes[] =
+    {
+
+#if PA_USE_WMME
+        paMME,
+#endif
+
+#if PA_USE_DS
+        paDirectSound,
+#endif
+
+#if PA_USE_ASIO
+        paASIO,
+#endif
+
+#if PA_USE_WASAPI
+        paWASAPI,
+#endif
+
+#if PA_USE_WDMKS
+        paWDMKS,
+#endif
+
+#if PA_USE_SKELETON
+        paInDevelopment,
+#endif
+
+        paInDevelopment /* keeps the array non-empty, never read */
+    };
+
 
@@ -44,6 +44,7 @@
 */
 
 #include <windows.h>
+#include <string.h> /* memset() */
 
 #if defined(WINAPI_FAMILY) && (WINAPI_FAMILY == WINAPI_FAMILY_APP)
     #include <sys/timeb.h> /* for _ftime_s() */
@@ -65,22 +66,99 @@ static int numAllocations_ = 0;
 #endif
 
 
+/* The allocator installed with Pa_SetAllocator(), NULL for the system's */
+static const PaUtilAllocator *allocator_ = NULL;
+
+/* Every block is preceded by a header naming the allocator it came from, padded
+    so the block is aligned as the allocator's memory is */
+typedef union PaUtilBlockHeader
+{
+    struct
+    {
+        const PaUtilAllocator *allocator;
+        long size; /* including the header */
+    } block;
+    long double alignLongDouble;
+    void *alignPointer;
+} PaUtilBlockHeader;
+
+
+/* Fault in and lock the pages of a block allocated with paRealTimeAllocator.
+    VirtualLock fails once the process working set is exhausted, see
+    SetProcessWorkingSetSize */
+static void PrefaultAndLock( void *block, long size )
+{
+    memset( block, 0, size );
+    VirtualLock( block, size );
+}
+
+
+/* Unlock the pages lying wholly within a paRealTimeAllocator block that is
+    about to be freed. Pages it shares with other blocks stay locked, so that
+    unlocking this block doesn't unlock those too. */
+static void UnlockBlock( void *block, long size )
+{
+    SYSTEM_INFO systemInfo;
+    size_t first, end;
+
+    GetSystemInfo( &systemInfo );
+    first = ((size_t)block + systemInfo.dwPageSize - 1) / systemInfo.dwPageSize * systemInfo.dwPageSize;
+    end = ((size_t)block + size) / systemInfo.dwPageSize * systemInfo.dwPageSize;
+    if( first < end )
+        VirtualUnlock( (void *)first, end - first );
+}
+
+
+void PaUtil_SetAllocator( const PaUtilAllocator *allocator )
+{
+    allocator_ = allocator;
+}
+
+
 void *PaUtil_AllocateMemory( long size )
 {
-    void *result = GlobalAlloc( GPTR, size );
+    const PaUtilAllocator *allocator = allocator_;
+    long blockSize = (long)sizeof(PaUtilBlockHeader) + size;
+    PaUtilBlockHeader *header;
+
+    if( allocator != NULL && allocator->allocate != NULL )
+        header = (PaUtilBlockHeader *)allocator->allocate( (unsigned long)blockSize, allocator->userData );
+    else
+        header = (PaUtilBlockHeader *)GlobalAlloc( GPTR, blockSize );
+
+    if( header == NULL )
+        return NULL;
+
+    if( allocator != NULL && (allocator->flags & paRealTimeAllocator) )
+        PrefaultAndLock( header, blockSize );
+
+    header->block.allocator = allocator;
+    header->block.size = blockSize;
 
 #if PA_TRACK_MEMORY
-    if( result != NULL ) numAllocations_ += 1;
+    numAllocations_ += 1;
 #endif
-    return result;
+    return header + 1;
 }
 
 
 void PaUtil_FreeMemory( void *block )
 {
+    PaUtilBlockHeader *header;
+    const PaUtilAllocator *allocator;
+
     if( block != NULL )
     {
-        GlobalFree( block );
+        header = (PaUtilBlockHeader *)block - 1;
+        allocator = header->block.allocator;
+
+        if( allocator != NULL && (allocator->flags & paRealTimeAllocator) )
+            UnlockBlock( header, header->block.size );
+
+        if( allocator != NULL && allocator->free != NULL )
+            allocator->free( header, (unsigned long)header->block.size, allocator->userData );
+        else
+            GlobalFree( header );
 #if PA_TRACK_MEMORY
         numAllocations_ -= 1;
 #endif
@@ -99,6 +177,76 @@ int PaUtil_CountCurrentlyAllocatedBlocks( void )
 }
 
 
+void *PaUtil_AllocateRegion( long *size, unsigned long flags )
+{
+    SYSTEM_INFO systemInfo;
+    SIZE_T length;
+    SIZE_T i;
+    void *result = NULL;
+
+    if( allocator_ != NULL && allocator_->allocate != NULL )
+        return NULL;
+    if( allocator_ != NULL && (allocator_->flags & paRealTimeAllocator) )
+        flags |= paUtilRegionPrefault;
+
+    GetSystemInfo( &systemInfo );
+    length = ((SIZE_T)*size + systemInfo.dwPageSize - 1) / systemInfo.dwPageSize * systemInfo.dwPageSize;
+
+#if !(defined(WINAPI_FAMILY) && (WINAPI_FAMILY == WINAPI_FAMILY_APP))
+    if( flags & paUtilRegionHugePages )
+    {
+        SIZE_T largePageSize = GetLargePageMinimum();
+
+        /* fails unless the process holds SeLockMemoryPrivilege. large pages are always resident. */
+        if( largePageSize != 0 && length >= largePageSize )
+        {
+            SIZE_T largeLength = (length + largePageSize - 1) / largePageSize * largePageSize;
+
+            result = VirtualAlloc( NULL, largeLength, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+            if( result != NULL )
+                length = largeLength;
+        }
+    }
+#endif
+
+    if( result == NULL )
+    {
+        result = VirtualAlloc( NULL, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+        if( result == NULL )
+            return NULL;
+
+        if( flags & paUtilRegionPrefault )
+        {
+            for( i = 0; i < length; i += systemInfo.dwPageSize )
+                ((volatile char *)result)[i] = 0;
+        }
+
+        if( allocator_ != NULL && (allocator_->flags & paRealTimeAllocator) )
+            VirtualLock( result, length );
+    }
+
+#if PA_TRACK_MEMORY
+    numAllocations_ += 1;
+#endif
+    *size = (long)length;
+    return result;
+}
+
+
+void PaUtil_FreeRegion( void *region, long size )
+{
+    (void)size; /* unused, VirtualFree releases the whole region */
+
+    if( region != NULL )
+    {
+        VirtualFree( region, 0, MEM_RELEASE );
+#if PA_TRACK_MEMORY
+        numAllocations_ -= 1;
+#endif
+    }
+}
+
+
 void Pa_Sleep( long msec )
 {
     Sleep( msec );
@@ -106,6 +254,7 @@ void Pa_Sleep( long msec )
 
 static int usePerformanceCounter_;
 static double secondsPerTick_;
+static LONGLONG ticksPerSecond_;
 
 void PaUtil_InitializeClock( void )
 {
@@ -115,6 +264,7 @@ void PaUtil_InitializeClock( void )
     {
         usePerformanceCounter_ = 1;
         secondsPerTick_ = 1.0 / (double)ticksPerSecond.QuadPart;
+        ticksPerSecond_ = ticksPerSecond.QuadPart;
     }
     else
     {
@@ -158,3 +308,21 @@ double PaUtil_GetTime( void )
 #endif
     }
 }
+
+
+PaInt64 PaUtil_GetTimeNanoseconds( void )
+{
+    LARGE_INTEGER time;
+
+    if( usePerformanceCounter_ )
+    {
+        QueryPerformanceCounter( &time );
+        /* split the multiply so it does not overflow for large tick counts */
+        return (time.QuadPart / ticksPerSecond_) * 1000000000
+            + (time.QuadPart % ticksPerSecond_) * 1000000000 / ticksPerSecond_;
+    }
+    else
+    {
+        return (PaInt64)(PaUtil_GetTime() * 1e9);
+    }
+}
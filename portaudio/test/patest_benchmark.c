@@ -0,0 +1,516 @@
+/** @file patest_benchmark.c
+    @ingroup test_src
+    @brief Measure the throughput of the sample format converters, zeroers and
+    the buffer processor, and print the results as JSON.
+
+    Every entry in paConverters and paZeroers is timed at several strides and
+    frame counts. PaUtil_EndBufferProcessing() is timed through
+    NonAdaptingProcess() (host buffer a multiple of the user buffer) and
+    AdaptingProcess() (it is not) for full duplex streams at several channel
+    counts. Each case is repeated BENCHMARK_REPETITIONS times and reported as
+    min, median and 99th percentile nanoseconds per sample, where a sample is
+    one channel of one frame in one direction.
+
+    Pa_Initialize() is called first, so the converters measured are the ones
+    streams would use, including SIMD kernels selected at run time. Set PA_SIMD
+    to compare instruction sets. An optional argument restricts the run to
+    cases whose name contains it.
+
+    Usage: patest_benchmark [name-filter] > results.json
+*/
+/*
+ * $Id: $
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2008 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h> /* offsetof */
+#include <math.h>
+
+#include "portaudio.h"
+#include "pa_util.h"
+#include "pa_converters.h"
+#include "pa_converters_simd.h"
+#include "pa_dither.h"
+#include "pa_process.h"
+
+#ifndef M_PI
+#define M_PI  (3.14159265)
+#endif
+
+#define BENCHMARK_REPETITIONS       (101)   /* odd, so the median is a measured value */
+#define SAMPLES_PER_MEASUREMENT     (16384) /* calls are batched to about this many samples */
+#define MAX_FRAME_COUNT             (4096)
+#define MAX_CHANNEL_COUNT           (8)
+
+static const int strides_[] = { 1, 2, 8 };
+static const unsigned long frameCounts_[] = { 64, 512, 4096 };
+static const int channelCounts_[] = { 1, 2, 8 };
+
+#define COUNT_OF( a ) ( sizeof(a) / sizeof((a)[0]) )
+
+
+/* converters are looked up by field so that adding one to PaUtilConverterTable
+   without listing it here is the only way to miss it */
+
+typedef struct
+{
+    const char *name;
+    PaSampleFormat sourceFormat;
+    PaSampleFormat destinationFormat;
+    size_t offset;
+    int noiseShaped;
+}
+ConverterEntry;
+
+#define CONVERTER_( name, sourceFormat, destinationFormat ) \
+    { #name, sourceFormat, destinationFormat, offsetof( PaUtilConverterTable, name ), 0 }
+#define NOISE_SHAPED_CONVERTER_( name, destinationFormat ) \
+    { #name, paFloat32, destinationFormat, offsetof( PaUtilConverterTable, name ), 1 }
+
+static const ConverterEntry converters_[] =
+{
+    CONVERTER_( Float32_To_Int32, paFloat32, paInt32 ),
+    CONVERTER_( Float32_To_Int32_Dither, paFloat32, paInt32 ),
+    CONVERTER_( Float32_To_Int32_Clip, paFloat32, paInt32 ),
+    CONVERTER_( Float32_To_Int32_DitherClip, paFloat32, paInt32 ),
+    CONVERTER_( Float32_To_Int24, paFloat32, paInt24 ),
+    CONVERTER_( Float32_To_Int24_Dither, paFloat32, paInt24 ),
+    CONVERTER_( Float32_To_Int24_Clip, paFloat32, paInt24 ),
+    CONVERTER_( Float32_To_Int24_DitherClip, paFloat32, paInt24 ),
+    CONVERTER_( Float32_To_Int16, paFloat32, paInt16 ),
+    CONVERTER_( Float32_To_Int16_Dither, paFloat32, paInt16 ),
+    CONVERTER_( Float32_To_Int16_Clip, paFloat32, paInt16 ),
+    CONVERTER_( Float32_To_Int16_DitherClip, paFloat32, paInt16 ),
+    CONVERTER_( Float32_To_Int8, paFloat32, paInt8 ),
+    CONVERTER_( Float32_To_Int8_Dither, paFloat32, paInt8 ),
+    CONVERTER_( Float32_To_Int8_Clip, paFloat32, paInt8 ),
+    CONVERTER_( Float32_To_Int8_DitherClip, paFloat32, paInt8 ),
+    CONVERTER_( Float32_To_UInt8, paFloat32, paUInt8 ),
+    CONVERTER_( Float32_To_UInt8_Dither, paFloat32, paUInt8 ),
+    CONVERTER_( Float32_To_UInt8_Clip, paFloat32, paUInt8 ),
+    CONVERTER_( Float32_To_UInt8_DitherClip, paFloat32, paUInt8 ),
+    NOISE_SHAPED_CONVERTER_( Float32_To_Int16_NoiseShaped, paInt16 ),
+    NOISE_SHAPED_CONVERTER_( Float32_To_Int8_NoiseShaped, paInt8 ),
+    NOISE_SHAPED_CONVERTER_( Float32_To_UInt8_NoiseShaped, paUInt8 ),
+    CONVERTER_( Int32_To_Float32, paInt32, paFloat32 ),
+    CONVERTER_( Int32_To_Int24, paInt32, paInt24 ),
+    CONVERTER_( Int32_To_Int24_Dither, paInt32, paInt24 ),
+    CONVERTER_( Int32_To_Int16, paInt32, paInt16 ),
+    CONVERTER_( Int32_To_Int16_Dither, paInt32, paInt16 ),
+    CONVERTER_( Int32_To_Int8, paInt32, paInt8 ),
+    CONVERTER_( Int32_To_Int8_Dither, paInt32, paInt8 ),
+    CONVERTER_( Int32_To_UInt8, paInt32, paUInt8 ),
+    CONVERTER_( Int32_To_UInt8_Dither, paInt32, paUInt8 ),
+    CONVERTER_( Int24_To_Float32, paInt24, paFloat32 ),
+    CONVERTER_( Int24_To_Int32, paInt24, paInt32 ),
+    CONVERTER_( Int24_To_Int16, paInt24, paInt16 ),
+    CONVERTER_( Int24_To_Int16_Dither, paInt24, paInt16 ),
+    CONVERTER_( Int24_To_Int8, paInt24, paInt8 ),
+    CONVERTER_( Int24_To_Int8_Dither, paInt24, paInt8 ),
+    CONVERTER_( Int24_To_UInt8, paInt24, paUInt8 ),
+    CONVERTER_( Int24_To_UInt8_Dither, paInt24, paUInt8 ),
+    CONVERTER_( Int16_To_Float32, paInt16, paFloat32 ),
+    CONVERTER_( Int16_To_Int32, paInt16, paInt32 ),
+    CONVERTER_( Int16_To_Int24, paInt16, paInt24 ),
+    CONVERTER_( Int16_To_Int8, paInt16, paInt8 ),
+    CONVERTER_( Int16_To_Int8_Dither, paInt16, paInt8 ),
+    CONVERTER_( Int16_To_UInt8, paInt16, paUInt8 ),
+    CONVERTER_( Int16_To_UInt8_Dither, paInt16, paUInt8 ),
+    CONVERTER_( Int8_To_Float32, paInt8, paFloat32 ),
+    CONVERTER_( Int8_To_Int32, paInt8, paInt32 ),
+    CONVERTER_( Int8_To_Int24, paInt8, paInt24 ),
+    CONVERTER_( Int8_To_Int16, paInt8, paInt16 ),
+    CONVERTER_( Int8_To_UInt8, paInt8, paUInt8 ),
+    CONVERTER_( UInt8_To_Float32, paUInt8, paFloat32 ),
+    CONVERTER_( UInt8_To_Int32, paUInt8, paInt32 ),
+    CONVERTER_( UInt8_To_Int24, paUInt8, paInt24 ),
+    CONVERTER_( UInt8_To_Int16, paUInt8, paInt16 ),
+    CONVERTER_( UInt8_To_Int8, paUInt8, paInt8 ),
+    CONVERTER_( Copy_8_To_8, paInt8, paInt8 ),
+    CONVERTER_( Copy_16_To_16, paInt16, paInt16 ),
+    CONVERTER_( Copy_24_To_24, paInt24, paInt24 ),
+    CONVERTER_( Copy_32_To_32, paInt32, paInt32 )
+};
+
+
+typedef struct
+{
+    const char *name;
+    PaSampleFormat format;
+    size_t offset;
+}
+ZeroerEntry;
+
+#define ZEROER_( name, format ) { #name, format, offsetof( PaUtilZeroerTable, name ) }
+
+static const ZeroerEntry zeroers_[] =
+{
+    ZEROER_( ZeroU8, paUInt8 ),
+    ZEROER_( Zero8, paInt8 ),
+    ZEROER_( Zero16, paInt16 ),
+    ZEROER_( Zero24, paInt24 ),
+    ZEROER_( Zero32, paInt32 )
+};
+
+
+/* host formats the buffer processor is measured with, the user format is always paFloat32 */
+static const PaSampleFormat hostFormats_[] = { paInt16, paInt24, paFloat32 };
+static const char *hostFormatNames_[] = { "paInt16", "paInt24", "paFloat32" };
+
+
+static const char *nameFilter_ = 0;
+static int firstResult_ = 1;
+
+
+static int CompareDoubles( const void *a, const void *b )
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+
+/* Sort the measurements (ns per sample) and print them as one JSON object.
+   extraFields are already formatted as "key": value pairs. */
+static void ReportResult( const char *kind, const char *name, const char *extraFields,
+        double *nsPerSample, int count )
+{
+    int p99 = (count * 99) / 100;
+
+    qsort( nsPerSample, count, sizeof(double), CompareDoubles );
+    if( p99 >= count )
+        p99 = count - 1;
+
+    printf( "%s\n    { \"kind\": \"%s\", \"name\": \"%s\", %s, "
+            "\"min_ns\": %.4f, \"median_ns\": %.4f, \"p99_ns\": %.4f }",
+            firstResult_ ? "" : ",", kind, name, extraFields,
+            nsPerSample[0], nsPerSample[count / 2], nsPerSample[p99] );
+    firstResult_ = 0;
+    fflush( stdout );
+}
+
+
+static int IsSelected( const char *name )
+{
+    return !nameFilter_ || strstr( name, nameFilter_ ) != 0;
+}
+
+
+/* Fill a buffer with a full scale sine (slightly over, so clippers clip) in the
+   given format. Integer formats get the same shape scaled to their range. */
+static void FillSource( PaSampleFormat format, void *buffer, unsigned long sampleCount )
+{
+    unsigned long i;
+
+    for( i=0; i < sampleCount; ++i )
+    {
+        double value = 1.1 * sin( (double)i * 2. * M_PI / 97. );
+        if( value > 1. ) value = 1.; /* integers saturate, only floats exceed full scale */
+
+        switch( format )
+        {
+        case paFloat32:
+            ((float*)buffer)[i] = (float)(1.1 * sin( (double)i * 2. * M_PI / 97. ));
+            break;
+        case paInt32:
+            ((PaInt32*)buffer)[i] = (PaInt32)(value * 0x7FFFFFFF);
+            break;
+        case paInt24:
+            {
+                PaInt32 temp = (PaInt32)(value * 0x7FFFFF);
+                unsigned char *out = (unsigned char*)buffer + i * 3;
+                out[0] = (unsigned char)(temp & 0xFF); /* byte order does not matter for timing */
+                out[1] = (unsigned char)((temp >> 8) & 0xFF);
+                out[2] = (unsigned char)((temp >> 16) & 0xFF);
+            }
+            break;
+        case paInt16:
+            ((PaInt16*)buffer)[i] = (PaInt16)(value * 0x7FFF);
+            break;
+        case paInt8:
+            ((signed char*)buffer)[i] = (signed char)(value * 0x7F);
+            break;
+        case paUInt8:
+            ((unsigned char*)buffer)[i] = (unsigned char)(128 + value * 0x7F);
+            break;
+        }
+    }
+}
+
+
+static unsigned long CallsPerMeasurement( unsigned long samplesPerCall )
+{
+    unsigned long calls = SAMPLES_PER_MEASUREMENT / samplesPerCall;
+    return calls > 0 ? calls : 1;
+}
+
+
+static void BenchmarkConverters( void *source, void *destination )
+{
+    double nsPerSample[ BENCHMARK_REPETITIONS ];
+    PaUtilNoiseShaper shaper;
+    char fields[ 128 ];
+    size_t c, s, f;
+    unsigned long call, calls;
+    int r;
+
+    PaUtil_InitializeNoiseShaper( &shaper, 2, 0 );
+
+    for( c=0; c < COUNT_OF(converters_); ++c )
+    {
+        const ConverterEntry *entry = &converters_[c];
+        PaUtilConverter *converter = *(PaUtilConverter**)((char*)&paConverters + entry->offset);
+
+        if( !converter || !IsSelected( entry->name ) )
+            continue;
+
+        FillSource( entry->sourceFormat, source, MAX_FRAME_COUNT * MAX_CHANNEL_COUNT );
+
+        for( s=0; s < COUNT_OF(strides_); ++s )
+        {
+            for( f=0; f < COUNT_OF(frameCounts_); ++f )
+            {
+                unsigned long frames = frameCounts_[f];
+                calls = CallsPerMeasurement( frames );
+
+                for( r=0; r < BENCHMARK_REPETITIONS; ++r )
+                {
+                    PaInt64 start = PaUtil_GetTimeNanoseconds();
+                    for( call=0; call < calls; ++call )
+                    {
+                        (*converter)( destination, strides_[s], source, strides_[s], frames,
+                                &shaper.ditherGenerator );
+                    }
+                    nsPerSample[r] = (double)(PaUtil_GetTimeNanoseconds() - start) / (double)(calls * frames);
+                }
+
+                sprintf( fields, "\"stride\": %d, \"frames\": %lu, \"channels\": 1", strides_[s], frames );
+                ReportResult( "converter", entry->name, fields, nsPerSample, BENCHMARK_REPETITIONS );
+            }
+        }
+    }
+}
+
+
+static void BenchmarkZeroers( void *destination )
+{
+    double nsPerSample[ BENCHMARK_REPETITIONS ];
+    char fields[ 128 ];
+    size_t z, s, f;
+    unsigned long call, calls;
+    int r;
+
+    for( z=0; z < COUNT_OF(zeroers_); ++z )
+    {
+        const ZeroerEntry *entry = &zeroers_[z];
+        PaUtilZeroer *zeroer = *(PaUtilZeroer**)((char*)&paZeroers + entry->offset);
+
+        if( !zeroer || !IsSelected( entry->name ) )
+            continue;
+
+        for( s=0; s < COUNT_OF(strides_); ++s )
+        {
+            for( f=0; f < COUNT_OF(frameCounts_); ++f )
+            {
+                unsigned long frames = frameCounts_[f];
+                calls = CallsPerMeasurement( frames );
+
+                for( r=0; r < BENCHMARK_REPETITIONS; ++r )
+                {
+                    PaInt64 start = PaUtil_GetTimeNanoseconds();
+                    for( call=0; call < calls; ++call )
+                        (*zeroer)( destination, strides_[s], frames );
+                    nsPerSample[r] = (double)(PaUtil_GetTimeNanoseconds() - start) / (double)(calls * frames);
+                }
+
+                sprintf( fields, "\"stride\": %d, \"frames\": %lu, \"channels\": 1", strides_[s], frames );
+                ReportResult( "zeroer", entry->name, fields, nsPerSample, BENCHMARK_REPETITIONS );
+            }
+        }
+    }
+}
+
+
+static int NullCallback( const void *input, void *output,
+                         unsigned long frameCount,
+                         const PaStreamCallbackTimeInfo* timeInfo,
+                         PaStreamCallbackFlags statusFlags,
+                         void *userData )
+{
+    (void) input; /* Prevent unused variable warnings. */
+    (void) output;
+    (void) frameCount;
+    (void) timeInfo;
+    (void) statusFlags;
+    (void) userData;
+
+    return paContinue;
+}
+
+
+/* Time full duplex PaUtil_EndBufferProcessing() with a callback that does no
+   work. The user buffer is the whole host buffer for NonAdaptingProcess(), and
+   three quarters of it (so the two never line up) for AdaptingProcess(). */
+static PaError BenchmarkBufferProcessor( void *hostInput, void *hostOutput )
+{
+    static const char *pathNames[2] = { "NonAdaptingProcess", "AdaptingProcess" };
+    double nsPerSample[ BENCHMARK_REPETITIONS ];
+    PaStreamCallbackTimeInfo timeInfo = { 0, 0, 0 };
+    PaUtilBufferProcessor bufferProcessor;
+    char fields[ 160 ];
+    size_t h, c, f;
+    int path, r;
+    unsigned long call, calls;
+    PaError result;
+
+    for( path=0; path < 2; ++path )
+    {
+        if( !IsSelected( pathNames[path] ) )
+            continue;
+
+        for( h=0; h < COUNT_OF(hostFormats_); ++h )
+        {
+            for( c=0; c < COUNT_OF(channelCounts_); ++c )
+            {
+                for( f=0; f < COUNT_OF(frameCounts_); ++f )
+                {
+                    int channels = channelCounts_[c];
+                    unsigned long frames = frameCounts_[f];
+                    unsigned long framesPerUserBuffer = path == 0 ? frames : frames * 3 / 4;
+                    int callbackResult = paContinue;
+
+                    result = PaUtil_InitializeBufferProcessor( &bufferProcessor,
+                            channels, paFloat32, hostFormats_[h],
+                            channels, paFloat32, hostFormats_[h],
+                            48000., paNoFlag, framesPerUserBuffer,
+                            frames, paUtilFixedHostBufferSize,
+                            NullCallback, NULL );
+                    if( result != paNoError )
+                        return result;
+
+                    FillSource( hostFormats_[h], hostInput, frames * channels );
+                    calls = CallsPerMeasurement( frames * channels * 2 );
+
+                    for( r=0; r < BENCHMARK_REPETITIONS; ++r )
+                    {
+                        PaInt64 start = PaUtil_GetTimeNanoseconds();
+                        for( call=0; call < calls; ++call )
+                        {
+                            PaUtil_BeginBufferProcessing( &bufferProcessor, &timeInfo, 0 );
+                            PaUtil_SetInputFrameCount( &bufferProcessor, 0 );
+                            PaUtil_SetInterleavedInputChannels( &bufferProcessor, 0, hostInput, 0 );
+                            PaUtil_SetOutputFrameCount( &bufferProcessor, 0 );
+                            PaUtil_SetInterleavedOutputChannels( &bufferProcessor, 0, hostOutput, 0 );
+                            PaUtil_EndBufferProcessing( &bufferProcessor, &callbackResult );
+                        }
+                        nsPerSample[r] = (double)(PaUtil_GetTimeNanoseconds() - start)
+                                / (double)(calls * frames * channels * 2);
+                    }
+
+                    PaUtil_TerminateBufferProcessor( &bufferProcessor );
+
+                    sprintf( fields, "\"host_format\": \"%s\", \"user_format\": \"paFloat32\", "
+                            "\"frames\": %lu, \"user_frames\": %lu, \"channels\": %d",
+                            hostFormatNames_[h], frames, framesPerUserBuffer, channels );
+                    ReportResult( "buffer_processor", pathNames[path], fields, nsPerSample, BENCHMARK_REPETITIONS );
+                }
+            }
+        }
+    }
+
+    return paNoError;
+}
+
+
+/*******************************************************************/
+int main(int argc, char **argv);
+int main(int argc, char **argv)
+{
+    /* in PaUtilSimdCapability bit order */
+    static const char *simdNames[] = { "sse2", "ssse3", "avx2", "neon" };
+    void *source = 0, *destination = 0;
+    unsigned int simd;
+    size_t i;
+    PaError err;
+
+    if( argc > 1 )
+        nameFilter_ = argv[1];
+
+    err = Pa_Initialize();
+    if( err != paNoError ) goto error;
+
+    /* sized for the widest sample at the largest stride and frame count */
+    source = malloc( MAX_FRAME_COUNT * MAX_CHANNEL_COUNT * sizeof(PaInt32) );
+    destination = malloc( MAX_FRAME_COUNT * MAX_CHANNEL_COUNT * sizeof(PaInt32) );
+    if( !source || !destination )
+    {
+        err = paInsufficientMemory;
+        goto error;
+    }
+
+    printf( "{\n  \"version\": \"%s\",\n  \"simd\": [", Pa_GetVersionText() );
+    simd = PaUtil_GetSimdCapabilities();
+    for( i=0; i < COUNT_OF(simdNames); ++i )
+    {
+        if( simd & (1u << i) )
+        {
+            printf( "%s\"%s\"", (simd & ((1u << i) - 1)) ? ", " : " ", simdNames[i] );
+        }
+    }
+    printf( " ],\n  \"repetitions\": %d,\n  \"results\": [", BENCHMARK_REPETITIONS );
+
+    BenchmarkConverters( source, destination );
+    BenchmarkZeroers( destination );
+    err = BenchmarkBufferProcessor( source, destination );
+
+    printf( "\n  ]\n}\n" );
+    if( err != paNoError ) goto error;
+
+    free( source );
+    free( destination );
+    Pa_Terminate();
+    return 0;
+
+error:
+    free( source );
+    free( destination );
+    Pa_Terminate();
+    fprintf( stderr, "An error occurred while running the benchmark\n" );
+    fprintf( stderr, "Error number: %d\n", err );
+    fprintf( stderr, "Error message: %s\n", Pa_GetErrorText( err ) );
+    return err;
+}
@@ -0,0 +1,175 @@
+/** @file patest_hotplug.c
+    @ingroup test_src
+    @brief Play a sine wave while sound cards are plugged in and out, rescanning
+    the device list each time without disturbing the stream.
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "portaudio.h"
+
+#define NUM_SECONDS   (30)
+#define SAMPLE_RATE   (44100)
+#ifndef M_PI
+#define M_PI  (3.14159265)
+#endif
+#define TABLE_SIZE    (200)
+
+typedef struct
+{
+    float sine[TABLE_SIZE];
+    int phase;
+}
+paTestData;
+
+static volatile int devicesChanged = 0;
+
+static int sineCallback( const void *inputBuffer, void *outputBuffer,
+                         unsigned long framesPerBuffer,
+                         const PaStreamCallbackTimeInfo* timeInfo,
+                         PaStreamCallbackFlags statusFlags,
+                         void *userData )
+{
+    paTestData *data = (paTestData*)userData;
+    float *out = (float*)outputBuffer;
+    unsigned long i;
+    (void) inputBuffer; /* Prevent "unused variable" warnings. */
+    (void) timeInfo;
+    (void) statusFlags;
+
+    for( i = 0; i < framesPerBuffer; i++ )
+    {
+        *out++ = data->sine[data->phase];
+        data->phase = ( data->phase + 1 ) % TABLE_SIZE;
+    }
+    return paContinue;
+}
+
+/* Called on a host API thread, which must not call PortAudio */
+static void onDevicesChanged( void *userData )
+{
+    (void) userData;
+    devicesChanged = 1;
+}
+
+static void listDevices( void )
+{
+    int i, numDevices = Pa_GetDeviceCount();
+
+    printf( "%d devices:\n", numDevices );
+    for( i = 0; i < numDevices; i++ )
+    {
+        const PaDeviceInfo *info = Pa_GetDeviceInfo( i );
+        printf( "  %2d %-8s %s\n", i, Pa_GetHostApiInfo( info->hostApi )->name, info->name );
+    }
+    fflush( stdout );
+}
+
+int main(void);
+int main(void)
+{
+    PaStreamParameters outputParameters;
+    PaStream *stream = NULL;
+    PaError err;
+    paTestData data;
+    int i;
+
+    printf( "Plug sound cards in and out during the next %d seconds.\n", NUM_SECONDS );
+
+    for( i = 0; i < TABLE_SIZE; i++ )
+        data.sine[i] = (float) ( 0.2 * sin( ( (double)i / (double)TABLE_SIZE ) * M_PI * 2. ) );
+    data.phase = 0;
+
+    err = Pa_Initialize();
+    if( err != paNoError ) goto error;
+    err = Pa_SetDevicesChangedCallback( NULL, onDevicesChanged );
+    if( err != paNoError ) goto error;
+    listDevices();
+
+    outputParameters.device = Pa_GetDefaultOutputDevice();
+    if( outputParameters.device == paNoDevice )
+    {
+        fprintf( stderr, "Error: No default output device.\n" );
+        goto error;
+    }
+    outputParameters.channelCount = 1;
+    outputParameters.sampleFormat = paFloat32;
+    outputParameters.suggestedLatency = Pa_GetDeviceInfo( outputParameters.device )->defaultHighOutputLatency;
+    outputParameters.hostApiSpecificStreamInfo = NULL;
+
+    err = Pa_OpenStream( &stream, NULL, &outputParameters, SAMPLE_RATE, paFramesPerBufferUnspecified,
+                         paClipOff, sineCallback, &data );
+    if( err != paNoError ) goto error;
+    err = Pa_StartStream( stream );
+    if( err != paNoError ) goto error;
+
+    for( i = 0; i < NUM_SECONDS * 10; i++ )
+    {
+        Pa_Sleep( 100 );
+        if( devicesChanged )
+        {
+            devicesChanged = 0;
+            err = Pa_UpdateAvailableDeviceList();
+            if( err != paNoError ) goto error;
+            listDevices();
+        }
+        if( Pa_IsStreamActive( stream ) != 1 )
+        {
+            fprintf( stderr, "Error: The stream stopped.\n" );
+            err = paInternalError;
+            goto error;
+        }
+    }
+
+    err = Pa_CloseStream( stream );
+    if( err != paNoError ) goto error;
+    Pa_Terminate();
+    printf( "Test finished.\n" );
+    return 0;
+
+error:
+    if( stream )
+        Pa_CloseStream( stream );
+    Pa_Terminate();
+    fprintf( stderr, "An error occurred while using the portaudio stream\n" );
+    fprintf( stderr, "Error number: %d\n", err );
+    fprintf( stderr, "Error message: %s\n", Pa_GetErrorText( err ) );
+    return err;
+}
@@ -0,0 +1,291 @@
+/** @file patest_offline.c
+    @ingroup test_src
+    @brief Render audio through the offline host API, free running and paced,
+    and report how much faster than real time it ran.
+*/
+/*
+ * $Id$
+ *
+ * This program uses the PortAudio Portable Audio Library.
+ * For more information see: http://www.portaudio.com/
+ * Copyright (c) 1999-2000 Ross Bencina and Phil Burk
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ * CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The text above constitutes the entire PortAudio license; however,
+ * the PortAudio community also makes the following non-binding requests:
+ *
+ * Any person wishing to distribute modifications to the Software is
+ * requested to send the modifications to the original developer so that
+ * they can be incorporated into the canonical version. It is also
+ * requested that these non-binding requests be included along with the
+ * license above.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include "portaudio.h"
+#include "pa_offline.h"
+
+#define SAMPLE_RATE         (44100)
+#define FRAMES_PER_BUFFER   (512)
+#define RENDER_SECONDS      (3600)  /* free running: one hour of audio */
+#define PACED_SECONDS       (2)     /* paced: stream seconds ... */
+#define PACED_CLOCK_RATE    (4.)    /* ... at four times real time */
+#define CHURN_STREAMS       (256)   /* streams open at once ... */
+#define CHURN_ROUNDS        (20)    /* ... half of them closed and reopened this often */
+
+#ifndef M_PI
+#define M_PI  (3.14159265)
+#endif
+
+#define TABLE_SIZE   (200)
+typedef struct
+{
+    float sine[TABLE_SIZE];
+    int phase;
+    unsigned long framesLeft;
+    PaTime lastCallbackTime;
+    int timeWentBackwards;
+}
+paTestData;
+
+static int patestCallback( const void *inputBuffer, void *outputBuffer,
+                            unsigned long framesPerBuffer,
+                            const PaStreamCallbackTimeInfo* timeInfo,
+                            PaStreamCallbackFlags statusFlags,
+                            void *userData )
+{
+    paTestData *data = (paTestData*)userData;
+    float *out = (float*)outputBuffer;
+    unsigned long i;
+
+    (void) inputBuffer; /* Prevent unused variable warnings. */
+    (void) statusFlags;
+
+    if( timeInfo->currentTime < data->lastCallbackTime )
+        data->timeWentBackwards = 1;
+    data->lastCallbackTime = timeInfo->currentTime;
+
+    for( i=0; i<framesPerBuffer; i++ )
+    {
+        *out++ = data->sine[data->phase];  /* left */
+        *out++ = data->sine[data->phase];  /* right */
+        data->phase += 1;
+        if( data->phase >= TABLE_SIZE ) data->phase -= TABLE_SIZE;
+    }
+
+    if( data->framesLeft <= framesPerBuffer )
+        return paComplete;
+    data->framesLeft -= framesPerBuffer;
+    return paContinue;
+}
+
+static PaDeviceIndex FindOfflineDevice( const char *name )
+{
+    PaHostApiIndex hostApi = Pa_HostApiTypeIdToHostApiIndex( paOffline );
+    const PaHostApiInfo *hostApiInfo;
+    int i;
+
+    if( hostApi < 0 )
+        return paNoDevice;
+
+    hostApiInfo = Pa_GetHostApiInfo( hostApi );
+    for( i=0; i<hostApiInfo->deviceCount; i++ )
+    {
+        PaDeviceIndex device = Pa_HostApiDeviceIndexToDeviceIndex( hostApi, i );
+        if( strcmp( Pa_GetDeviceInfo( device )->name, name ) == 0 )
+            return device;
+    }
+    return paNoDevice;
+}
+
+/* Run one stream to completion and return the wall clock seconds it took. */
+static PaError Render( PaStreamParameters *outputParameters, unsigned long seconds,
+                       double *wallSeconds, paTestData *data )
+{
+    PaStream *stream;
+    PaError err;
+
+    data->phase = 0;
+    data->framesLeft = seconds * SAMPLE_RATE;
+    data->lastCallbackTime = 0.;
+    data->timeWentBackwards = 0;
+
+    err = Pa_OpenStream( &stream, NULL, outputParameters, SAMPLE_RATE, FRAMES_PER_BUFFER,
+                         paNoFlag, patestCallback, data );
+    if( err != paNoError ) return err;
+
+    err = Pa_StartStream( stream );
+    if( err != paNoError ) return err;
+
+    /* Pa_GetStreamTime() is the simulated clock, so count wall time in sleeps */
+    *wallSeconds = 0.;
+    while( ( err = Pa_IsStreamActive( stream ) ) == 1 )
+    {
+        Pa_Sleep( 10 );
+        *wallSeconds += 0.01;
+    }
+    if( err < 0 ) return err;
+
+    printf( "  stream time %.1f s\n", Pa_GetStreamTime( stream ) );
+
+    err = Pa_StopStream( stream );
+    if( err != paNoError ) return err;
+    return Pa_CloseStream( stream );
+}
+
+/* Close a stream and open another, which takes the closed one's slot in the table of open streams and quite possibly
+   its memory: the closed stream's handle must be refused all the same. */
+static PaError StaleHandle( PaStreamParameters *outputParameters, paTestData *data )
+{
+    PaStream *closed, *stream;
+    PaError err;
+
+    err = Pa_OpenStream( &closed, NULL, outputParameters, SAMPLE_RATE, FRAMES_PER_BUFFER, paNoFlag,
+                         patestCallback, data );
+    if( err != paNoError ) return err;
+    err = Pa_CloseStream( closed );
+    if( err != paNoError ) return err;
+
+    err = Pa_OpenStream( &stream, NULL, outputParameters, SAMPLE_RATE, FRAMES_PER_BUFFER, paNoFlag,
+                         patestCallback, data );
+    if( err != paNoError ) return err;
+    if( stream == closed
+            || Pa_IsStreamStopped( closed ) != paBadStreamPtr
+            || Pa_StartStream( closed ) != paBadStreamPtr
+            || Pa_CloseStream( closed ) != paBadStreamPtr
+            || Pa_IsStreamStopped( stream ) != 1 )
+    {
+        Pa_CloseStream( stream );
+        return paInternalError;
+    }
+
+    return Pa_CloseStream( stream );
+}
+
+/* Open many streams, then keep closing and reopening half of them, checking every open one stays valid. The last
+   ones are left for Pa_Terminate() to close. */
+static PaError Churn( PaStreamParameters *outputParameters, paTestData *data )
+{
+    static PaStream *streams[CHURN_STREAMS];
+    PaError err;
+    int round, i;
+
+    for( round = 0; round <= CHURN_ROUNDS; ++round )
+    {
+        for( i = round % 2; i < CHURN_STREAMS; i += (round ? 2 : 1) )
+        {
+            err = Pa_OpenStream( &streams[i], NULL, outputParameters, SAMPLE_RATE, FRAMES_PER_BUFFER,
+                                 paNoFlag, patestCallback, data );
+            if( err != paNoError ) return err;
+        }
+        for( i = 0; i < CHURN_STREAMS; ++i )
+        {
+            if( Pa_IsStreamStopped( streams[i] ) != 1 ) return paInternalError;
+        }
+        if( round == CHURN_ROUNDS )
+            break;
+        for( i = (round + 1) % 2; i < CHURN_STREAMS; i += 2 )
+        {
+            err = Pa_CloseStream( streams[i] );
+            if( err != paNoError ) return err;
+        }
+    }
+
+    return paNoError;
+}
+
+/*******************************************************************/
+int main(void);
+int main(void)
+{
+    PaStreamParameters outputParameters;
+    PaOfflineStreamInfo pacedInfo;
+    paTestData data;
+    double wallSeconds;
+    PaError err;
+    int i;
+
+    /* initialise sinusoidal wavetable */
+    for( i=0; i<TABLE_SIZE; i++ )
+    {
+        data.sine[i] = (float) (0.5 * sin( ((double)i/(double)TABLE_SIZE) * M_PI * 2. ));
+    }
+
+    err = Pa_Initialize();
+    if( err != paNoError ) goto error;
+
+    /* the Int16 device makes the buffer processor convert and dither every sample */
+    outputParameters.device = FindOfflineDevice( "Offline Int16" );
+    if( outputParameters.device == paNoDevice )
+    {
+        fprintf( stderr, "Error: offline host API not available.\n" );
+        err = paHostApiNotFound;
+        goto error;
+    }
+    outputParameters.channelCount = 2;
+    outputParameters.sampleFormat = paFloat32;
+    outputParameters.suggestedLatency = 0.;
+    outputParameters.hostApiSpecificStreamInfo = NULL;
+
+    printf( "Free running, %d seconds of audio:\n", RENDER_SECONDS );
+    err = Render( &outputParameters, RENDER_SECONDS, &wallSeconds, &data );
+    if( err != paNoError ) goto error;
+    printf( "  took about %.2f s wall time\n", wallSeconds );
+    if( data.timeWentBackwards )
+    {
+        fprintf( stderr, "Error: callback time went backwards.\n" );
+        err = paInternalError;
+        goto error;
+    }
+
+    PaOffline_InitializeStreamInfo( &pacedInfo, paOfflinePaced );
+    pacedInfo.clockRate = PACED_CLOCK_RATE;
+    outputParameters.hostApiSpecificStreamInfo = &pacedInfo;
+
+    printf( "Paced at %.0fx, %d seconds of audio:\n", PACED_CLOCK_RATE, PACED_SECONDS );
+    err = Render( &outputParameters, PACED_SECONDS, &wallSeconds, &data );
+    if( err != paNoError ) goto error;
+    printf( "  took about %.2f s wall time (expected %.2f)\n", wallSeconds, PACED_SECONDS / PACED_CLOCK_RATE );
+
+    printf( "Reopening a closed stream's slot:\n" );
+    err = StaleHandle( &outputParameters, &data );
+    if( err != paNoError ) goto error;
+    printf( "  the closed stream's handle is refused\n" );
+
+    printf( "Churning %d open streams:\n", CHURN_STREAMS );
+    err = Churn( &outputParameters, &data );
+    if( err != paNoError ) goto error;
+    printf( "  %d streams opened\n", CHURN_STREAMS + CHURN_ROUNDS * CHURN_STREAMS / 2 );
+
+    Pa_Terminate();
+    printf( "Test finished.\n" );
+    return err;
+
+error:
+    Pa_Terminate();
+    fprintf( stderr, "An error occurred while using the portaudio stream\n" );
+    fprintf( stderr, "Error number: %d\n", err );
+    fprintf( stderr, "Error message: %s\n", Pa_GetErrorText( err ) );
+    return err;
+}